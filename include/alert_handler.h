@@ -1,30 +1,82 @@
 #pragma once
-#include <string>
+#include <Arduino.h>
 #include <ArduinoJson.h>
 #include "sensors/sensor_types.h"
-#include "wifi_manager.h"
+#include "config.h"
+#include "token_bucket.h"
+#include "payload_cache.h"
+#include "error_handler.h"
 
 namespace pooaway::alert
 {
     enum class HandlerType
     {
-        ALERT_ONLY,    // For handlers that should only act on alerts (buzzer)
-        DATA_PUBLISHER // For handlers that should always publish data (MQTT, API)
+        ALERT_ONLY,    // Local actuators (buzzer, LED): called on every alert edge with a reduced document
+        DATA_PUBLISHER // Network publishers (MQTT, API): called from the deferred tier once per interval
     };
 
+    struct MillisClock
+    {
+        static unsigned long now_ms() { return millis(); }
+    };
+
+    using RateLimiter = pooaway::TokenBucket<MillisClock>;
+    using pooaway::error::Code;
+    using pooaway::error::Result;
+
     class AlertHandler
     {
     public:
         virtual ~AlertHandler() = default;
-        virtual void init() = 0;
-        virtual void handle_alert(JsonDocument &alert_data) = 0;
+        // Failures are returned, never thrown: the firmware builds with -fno-exceptions.
+        // Skipping a call because of rate limiting is not a failure
+        virtual Result init() = 0;
+        // Local actuators: reduced alert document on every edge and interval
+        virtual Result handle_alert(JsonDocument & /*alert_data*/) { return Result::ok(); }
+        // Data publishers: the deferred telemetry document plus its encoded payloads, which are
+        // shared with the other publishers of the cycle. Defaults to handle_alert(telemetry)
+        virtual Result handle_telemetry(JsonDocument &telemetry, PayloadCache & /*payloads*/) { return handle_alert(telemetry); }
+        // Short label for logs and metrics
+        virtual const char *get_name() const = 0;
+        // Event start/close records; handlers that only care about telemetry ignore them
+        virtual Result handle_event(JsonDocument & /*event_data*/) { return Result::ok(); }
+        // Connection upkeep between sends (acknowledgements, keepalive), called on every network
+        // poll whether or not anything is published; must not block
+        virtual void poll() {}
         virtual bool is_available() const { return m_available; }
-        virtual std::string get_last_error() const { return m_last_error; }
+        // Handlers that talk to the network are initialized only once WiFi is up
+        virtual bool requires_network() const { return false; }
+        // Longest a handle_alert()/handle_telemetry() call should take; overruns make AlertManager back off
+        virtual unsigned long get_time_budget_ms() const { return config::alerts::DEFAULT_TIME_BUDGET_MS; }
+        bool is_initialized() const { return m_initialized; }
+        // Runs init() at most once; AlertManager uses this rather than calling init() directly
+        Result ensure_initialized()
+        {
+            if (m_initialized)
+            {
+                return Result::ok();
+            }
+            m_initialized = true;
+            return init();
+        }
         HandlerType get_type() const { return m_type; }
+        virtual pooaway::RateLimiterStats get_rate_stats() const { return m_rate_limiter.get_stats(); }
+
+        // AlertManager sets "transition" when the alert state changed since the previous document
+        static pooaway::TrafficClass traffic_class(const JsonDocument &data)
+        {
+            return data["transition"].as<bool>() ? pooaway::TrafficClass::TRANSITION
+                                                 : pooaway::TrafficClass::ROUTINE;
+        }
 
     protected:
+        // One message per rate_limit_ms, plus config::alerts::TRANSITION_BURST reserved for alert edges
+        explicit AlertHandler(unsigned long rate_limit_ms = 0)
+            : m_rate_limiter(rate_limit_ms, 1, config::alerts::TRANSITION_BURST) {}
+
+        RateLimiter m_rate_limiter;
         bool m_available{false};
-        std::string m_last_error;
+        bool m_initialized{false};
         HandlerType m_type{HandlerType::DATA_PUBLISHER}; // Default to data publisher
         static constexpr char const *TAG = "AlertHandler";
     };
@@ -2,8 +2,7 @@
 #include "alert_handler.h"
 #include <HTTPClient.h>
 #include <WiFi.h>
-#include <string>
-#include <map>
+#include <array>
 #include <ArduinoJson.h>
 #include <WiFiClientSecure.h>
 
@@ -13,27 +12,35 @@ namespace pooaway::alert
     {
     public:
         explicit ApiHandler(unsigned long rate_limit_ms = 0);
-        void init() override;
-        void handle_alert(JsonDocument &alert_data) override;
+        Result init() override;
+        const char *get_name() const override { return "api"; }
+        bool requires_network() const override { return true; }
+        unsigned long get_time_budget_ms() const override { return config::alerts::API_TIME_BUDGET_MS; }
+        Result handle_telemetry(JsonDocument &telemetry, PayloadCache &payloads) override;
+        pooaway::RateLimiterStats get_rate_stats() const override;
 
     private:
         HTTPClient m_http_client;
         WiFiClientSecure m_secure_client;
-        unsigned long m_last_request{0};
-        unsigned long m_rate_limit_ms{0};
         static constexpr int MAX_RETRIES = 3;
         static constexpr int RETRY_DELAY_MS = 1000;
         static constexpr char const *TAG = "ApiHandler";
 
+        static constexpr size_t URL_BYTES = 128;
+        static constexpr size_t RESPONSE_LOG_BYTES = 64; // Head of the response body kept for the log
+
         struct ChannelInfo
         {
-            String channel_id;
-            String write_api_key;
-            String read_api_key;
+            const char *channel_id;
+            const char *write_api_key;
+            RateLimiter limiter{config::thingspeak::UPDATE_INTERVAL_MS}; // Per-channel update interval
         };
-        std::map<String, ChannelInfo> m_channel_info{};
-        bool ensure_channel_exists(const char *name);
-        bool store_channel_info(const char *name, JsonDocument &response);
-        void send_sensor_data(JsonObjectConst sensor);
+        // Only the built-in sensors have a ThingSpeak channel: NH3, CH4
+        std::array<ChannelInfo, 2> m_channels{{{config::thingspeak::NH3_CHANNEL_ID, config::thingspeak::NH3_API_KEY},
+                                               {config::thingspeak::CH4_CHANNEL_ID, config::thingspeak::CH4_API_KEY}}};
+        ChannelInfo *find_channel(const char *name);
+        Result ensure_channel_exists(const char *name);
+        Result send_sensor_data(PayloadCache &payloads, size_t index, pooaway::TrafficClass traffic);
+        size_t drain_response(char *head, size_t head_size);
     };
 } // namespace pooaway::alert
@@ -1,5 +1,6 @@
 #pragma once
 #include "alert_handler.h"
+#include "pattern_player.h"
 
 namespace pooaway::alert
 {
@@ -8,13 +9,13 @@ namespace pooaway::alert
     {
     public:
         explicit LedHandler(unsigned long rate_limit_ms = 0);
-        void init() override;
-        void handle_alert(JsonDocument &alert_data) override;
+        Result init() override;
+        const char *get_name() const override { return "led"; }
+        Result handle_alert(JsonDocument &alert_data) override;
+        uint32_t get_programs() const { return m_player.get_programs(); }
 
     private:
-        bool m_led_state{false};
-        unsigned long m_last_request{0};
-        unsigned long m_rate_limit_ms;
+        pooaway::pattern::LedPlayer m_player;
         static constexpr char const *TAG = "LedHandler";
     };
 
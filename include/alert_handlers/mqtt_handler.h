@@ -1,27 +1,48 @@
 #pragma once
 #include "alert_handler.h"
+#include "mqtt_session.h"
 #include <WiFiClient.h>
-#include <PubSubClient.h>
 
 namespace pooaway::alert
 {
+    struct MqttClock
+    {
+        static uint32_t now_ms() { return millis(); }
+        static void idle() { delay(1); }
+    };
+
+    using MqttSession = pooaway::mqtt::Session<WiFiClient, MqttClock, config::mqtt::INFLIGHT_WINDOW,
+                                               config::mqtt::FRAME_BYTES>;
 
     class MqttHandler : public AlertHandler
     {
     public:
         explicit MqttHandler(unsigned long rate_limit_ms = 0);
-        void init() override;
-        void handle_alert(JsonDocument &alert_data) override;
+        Result init() override;
+        const char *get_name() const override { return "mqtt"; }
+        bool requires_network() const override { return true; }
+        unsigned long get_time_budget_ms() const override { return config::alerts::MQTT_TIME_BUDGET_MS; }
+        Result handle_telemetry(JsonDocument &telemetry, PayloadCache &payloads) override;
+        Result handle_event(JsonDocument &event_data) override;
+        void poll() override;
+
+        const pooaway::mqtt::SessionStats &get_session_stats() const { return m_session.get_stats(); }
 
     private:
-        bool connect();
+        Result connect();
+        Result ensure_session();
+        Result publish_sensors(PayloadCache &payloads);
+        Result publish_packed(PayloadCache &payloads);
+        Result publish(const char *topic, const pooaway::mqtt::PayloadPart *parts, size_t count);
+        void log_session_stats() const;
 
         WiFiClient m_wifi_client;
-        PubSubClient m_mqtt_client;
-        unsigned long m_last_request{0};
-        unsigned long m_rate_limit_ms;
+        MqttSession m_session;
+        unsigned long m_last_stats_log{0};
         static constexpr int MAX_RETRIES = 3;
         static constexpr int RETRY_DELAY_MS = 1000;
+        static constexpr size_t TOPIC_SIZE = 96;
+        static constexpr size_t EVENT_BYTES = 512; // Serialized event record, on the loop task's stack
         static constexpr char const *TAG = "MqttHandler";
     };
 
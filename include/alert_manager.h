@@ -1,6 +1,8 @@
 #pragma once
+#include <array>
 #include <vector>
 #include "sensors/sensor_types.h"
+#include "sensors/event_detector.h"
 #include "alert_handler.h"
 
 namespace pooaway::alert
@@ -14,17 +16,105 @@ namespace pooaway::alert
         AlertManager(const AlertManager &) = delete;
         AlertManager &operator=(const AlertManager &) = delete;
 
+        // Restores event state and initializes handlers that do not need the network
         void init();
-        void update(const bool alerts[pooaway::sensors::SENSOR_COUNT]);
+        // Initializes the remaining handlers; call once WiFi is connected
+        void init_network_handlers();
+        void update(const bool *alerts, size_t count);
+        // Runs every initialized handler's poll(); call from the network poll timer
+        void poll_handlers();
         void add_handler(AlertHandler *handler);
         void remove_handler(AlertHandler *handler);
-        [[nodiscard]] std::vector<std::string> get_handler_errors() const;
+
+        // Latency of one dispatch tier, measured from when the work became due until the
+        // handler returned; a local alert edge is due from the sensor read that raised it, and
+        // deferred work includes waiting behind other publishers
+        struct TierStats
+        {
+            uint32_t dispatches{0};
+            uint32_t last_us{0};
+            uint32_t max_us{0};
+            uint64_t total_us{0};
+        };
+
+        const TierStats &get_tier_stats(HandlerType tier) const;
+        const PayloadCache::Stats &get_payload_stats() const { return m_payloads.get_stats(); }
+        uint32_t get_thinned_telemetry() const { return m_thinned_telemetry; }
+        uint32_t get_alert_mask() const { return m_alert_mask; } // Channels alerting at the last update()
+        void log_dispatch_stats() const;
+
+        struct HandlerStats
+        {
+            const char *name;
+            HandlerType type;
+            pooaway::RateLimiterStats rate;
+            uint32_t overruns;      // Calls over the handler's time budget
+            uint32_t errors;        // Calls that returned a failed Result, init() included
+            const char *last_error; // Message of the latest failure, nullptr if none
+        };
+
+        bool is_event_open() const; // At any pair
+        const char *get_device_id() const { return m_device_id; } // Station MAC, read once by init()
+        uint32_t get_dropped_events() const { return m_events_dropped; }
+
+        size_t get_handler_count() const { return m_handlers.size(); }
+        HandlerStats get_handler_stats(size_t index) const;
 
     private:
+        struct HandlerSlot
+        {
+            AlertHandler *handler{nullptr};
+            bool pending{false};        // Deferred tier: owes a call with m_deferred_doc and m_payloads
+            uint32_t events_sent{0};    // Deferred tier: queued event records handed over so far
+            uint8_t backoff{0};         // Intervals to sit out after overrunning the time budget
+            unsigned long resume_ms{0};
+            uint32_t overruns{0};
+            uint32_t errors{0};
+            Result last_error;
+        };
+
         AlertManager();
+        void init_handlers(bool network_ready);
+        void queue_telemetry(unsigned long now, uint32_t alert_mask, const bool *alerts, size_t count);
+        void build_telemetry(JsonDocument &doc, unsigned long now, const bool *alerts, size_t count,
+                             bool with_diagnostics);
+        void reset_payloads();
+        void dispatch_local(unsigned long due_us, bool edge, const bool *alerts, size_t count);
+        void dispatch_deferred();
+        void record_latency(HandlerType tier, unsigned long due_us);
+        void record_result(HandlerSlot &slot, Result result);
+        void update_events(unsigned long now, const bool *alerts, size_t count);
+        void publish_event(const pooaway::sensors::EventRecord &record, bool closed);
+        void queue_event(const pooaway::sensors::EventRecord &record, bool closed);
+        void build_event(JsonDocument &doc, const pooaway::sensors::EventRecord &record, bool closed) const;
+
         static constexpr char const *TAG = "AlertManager";
         unsigned long m_last_alert{0};
-        std::vector<AlertHandler *> m_handlers;
+        unsigned long m_last_stats_log{0};
+        unsigned long m_last_diagnostics_export{0};
+        uint32_t m_alert_mask{0};
+        uint32_t m_published_mask{0}; // Alert mask of the last deferred document
+        unsigned long m_last_telemetry_ms{0};
+        uint32_t m_thinned_telemetry{0}; // Intervals without a document because an event was open
+        std::vector<HandlerSlot> m_handlers;
+        JsonDocument m_deferred_doc;
+        PayloadCache m_payloads; // Encoded once per interval from m_deferred_doc, shared by the publishers
+        unsigned long m_deferred_due_us{0};
+        int64_t m_deferred_captured_us{0}; // TimeService capture stamp of m_deferred_doc
+        std::array<TierStats, 2> m_tier_stats{}; // Indexed by HandlerType
+
+        // Event records waiting for the publishers, like telemetry, so no network call runs inline
+        struct QueuedEvent
+        {
+            pooaway::sensors::EventRecord record;
+            bool closed{false};
+            unsigned long queued_us{0};
+        };
+        std::array<QueuedEvent, config::events::QUEUE_DEPTH> m_event_queue{};
+        uint32_t m_events_queued{0}; // Records ever queued; entry n lives at n % QUEUE_DEPTH
+        uint32_t m_events_dropped{0};
+        char m_device_id[18]{}; // "AA:BB:CC:DD:EE:FF"
+        std::array<pooaway::sensors::EventDetector, pooaway::sensors::EventDetector::MAX_PAIRS> m_event_detectors{};
     };
 
 } // namespace pooaway::alert
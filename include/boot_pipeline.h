@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pooaway
+{
+    enum class StepStatus : uint8_t
+    {
+        WAITING, // Dependencies not finished yet
+        PENDING, // Started, polled again on the next pass
+        DONE,
+        FAILED,
+        SKIPPED // A dependency failed
+    };
+
+    enum class BootMilestone : uint8_t
+    {
+        FIRST_SAMPLE,  // First complete sensor scan
+        FIRST_PUBLISH, // First telemetry document handed to an available publisher
+        COUNT
+    };
+
+    /**
+     * @brief Dependency-ordered boot steps, each completed at most once
+     *
+     * A step function returns PENDING while it is waiting on something external (WiFi
+     * association, NTP) and is polled again on the next poll(), so steps that do not need
+     * the network keep running meanwhile. Step start/end times form a boot timeline:
+     * run_until_finished() logs the steps finished by the time it returns, and poll() logs
+     * the rest together with the milestones once everything has finished, so a step that
+     * never finishes (an unreachable AP) does not hide the local part.
+     */
+    class BootPipeline
+    {
+    public:
+        static constexpr size_t MAX_STEPS = 16;
+        using StepFn = StepStatus (*)();
+
+        struct StepRecord
+        {
+            const char *name{nullptr};
+            StepFn fn{nullptr};
+            uint32_t depends_on{0}; // Bit n set if the step waits for step n
+            unsigned long timeout_ms{0}; // 0 = poll until it finishes
+            unsigned long start_ms{0};
+            unsigned long end_ms{0};
+            StepStatus status{StepStatus::WAITING};
+        };
+
+        static BootPipeline &instance();
+
+        BootPipeline(const BootPipeline &) = delete;
+        BootPipeline &operator=(const BootPipeline &) = delete;
+
+        /**
+         * @brief Register a step
+         * @param depends_on Mask built with dependency() of steps that must be DONE first
+         * @param timeout_ms A PENDING step is failed after this long; 0 disables the timeout
+         * @return Step id, or -1 when MAX_STEPS is reached
+         */
+        int add_step(const char *name, StepFn fn, uint32_t depends_on = 0, unsigned long timeout_ms = 0);
+
+        static constexpr uint32_t dependency(int step) { return step >= 0 ? (1UL << step) : 0; }
+
+        // Run every ready step once; returns true when all steps have finished
+        bool poll();
+
+        // Block, polling, until every step in the dependency() mask has finished, then log
+        // the timeline of every step finished so far
+        void run_until_finished(uint32_t steps);
+
+        bool is_finished(int step) const;
+        bool is_complete() const { return m_complete; }
+
+        // Record a milestone the first time it is reached
+        void mark(BootMilestone milestone);
+        unsigned long get_milestone(BootMilestone milestone) const;
+
+        size_t get_step_count() const { return m_step_count; }
+        const StepRecord &get_step(size_t index) const { return m_steps[index]; }
+
+        // Log start/end of the steps in the dependency() mask, and the milestones if asked
+        void log_timeline(uint32_t steps, bool milestones) const;
+
+    private:
+        static constexpr char const *TAG = "BootPipeline";
+
+        std::array<StepRecord, MAX_STEPS> m_steps{};
+        std::array<unsigned long, static_cast<size_t>(BootMilestone::COUNT)> m_milestones{};
+        size_t m_step_count{0};
+        uint32_t m_logged{0}; // Steps already in a logged timeline
+        bool m_complete{false};
+
+        BootPipeline() = default;
+        void run_step(StepRecord &step, unsigned long now);
+        uint32_t finished_steps() const;
+    };
+} // namespace pooaway
@@ -1,14 +1,33 @@
 #pragma once
 #include <string>
-#include <WiFi.h>
 
 // Try to include private configuration if available
 #if __has_include("private.h")
 #include "private.h"
 #endif
 
+// Handlers and transports compiled into the firmware; override with -D in platformio.ini.
+// A disabled feature leaves out its sources and the libraries only it pulls in
+#ifndef POOAWAY_WITH_API
+#define POOAWAY_WITH_API 1 // ThingSpeak over HTTPS (HTTPClient, WiFiClientSecure)
+#endif
+#ifndef POOAWAY_WITH_MQTT
+#define POOAWAY_WITH_MQTT 0 // Adafruit IO over MQTT (WiFiClient)
+#endif
+#ifndef POOAWAY_WITH_METRICS
+#define POOAWAY_WITH_METRICS 1 // /metrics, /stream and /capture (WiFiServer)
+#endif
+// WiFi, SNTP and the network cache, whenever something above needs them
+#define POOAWAY_WITH_NETWORK (POOAWAY_WITH_API || POOAWAY_WITH_MQTT || POOAWAY_WITH_METRICS)
+
 namespace config
 {
+    namespace features
+    {
+        // Deferred telemetry, payloads and events have a consumer; for if constexpr and buffer sizes
+        constexpr bool DATA_PUBLISHERS = POOAWAY_WITH_API || POOAWAY_WITH_MQTT;
+    }
+
     namespace wifi
     {
 #ifndef WIFI_SSID
@@ -24,6 +43,16 @@ namespace config
 #endif
     }
 
+    namespace network
+    {
+        // Fast reconnect from the last association and DNS answers kept in NVS (NetworkCache)
+        constexpr bool FAST_RECONNECT = true;                  // Join the cached BSSID and channel without scanning
+        constexpr bool REUSE_IP_LEASE = false;                 // Also skip DHCP with the last lease; only with a DHCP reservation
+        constexpr unsigned long FAST_CONNECT_TIMEOUT_MS = 3000; // Then fall back to a full scan
+        constexpr unsigned long SCAN_CONNECT_TIMEOUT_MS = 10000; // A fallback scan still unjoined by then means the AP is away
+        constexpr uint32_t DNS_TTL_S = 3600;                   // lwIP does not pass record TTLs up, so one fixed TTL
+    }
+
     namespace mqtt
     {
 #ifndef MQTT_USERNAME
@@ -53,6 +82,17 @@ namespace config
         constexpr char const *BROKER = "io.adafruit.com";
         constexpr int PORT = 1883;
         constexpr unsigned long RATE_LIMIT_MS = 5000; // 5 seconds between MQTT publishes
+
+        // Publishing session (include/mqtt_session.h)
+        constexpr uint8_t QOS = 1;                    // 0: fire and forget, 1: acknowledged, resent until PUBACK
+        constexpr size_t INFLIGHT_WINDOW = 4;         // QoS 1 messages awaiting PUBACK at once; 1 is stop-and-wait.
+                                                      // Per-sensor mode needs one slot per sensor
+        constexpr size_t FRAME_BYTES = 1536;          // Largest frame, per window slot (packed frame with diagnostics)
+        constexpr uint32_t RETRANSMIT_MS = 5000;      // Resend an unacknowledged message after this long
+        constexpr uint8_t MAX_ATTEMPTS = 3;           // Sends per message before it is dropped
+        constexpr uint16_t KEEPALIVE_S = 15;
+        constexpr uint32_t CONNECT_TIMEOUT_MS = 3000; // Wait for CONNACK
+        constexpr bool PACK_SENSORS = false;          // true: one <prefix>/sensors frame per interval with every sensor
     }
 
     namespace adafruit_io
@@ -104,17 +144,132 @@ namespace config
         // ... Add sensor-specific thresholds here if needed
     }
 
+    namespace mux
+    {
+        // Analog multiplexer (CD74HC4067) for scanning several litter boxes from one ADC pin.
+        // Each extra box is an NH3/CH4 pair wired to mux inputs 2n (NH3) and 2n+1 (CH4).
+#ifndef POOAWAY_MUX_PAIRS
+        constexpr int PAIR_COUNT = 0;                   // Extra litter boxes on the mux (0 = no mux fitted)
+#else
+        constexpr int PAIR_COUNT = POOAWAY_MUX_PAIRS;
+#endif
+        constexpr int COM_PIN = 3;                      // Shared ADC pin (mux COM)
+        constexpr int SELECT_PINS[4] = {18, 19, 20, 21}; // S0..S3
+        constexpr int ENABLE_PIN = -1;                  // Active-low EN, -1 if tied to GND
+        constexpr unsigned long SETTLE_US = 2000;       // Settle time after switching inputs
+    }
+
     namespace alerts
     {
         // Rate Limiting
         // Alert Rate Limiting Configuration
         constexpr unsigned long API_RATE_LIMIT_MS = 30000;   // 30 seconds between API requests
         constexpr unsigned long MQTT_RATE_LIMIT_MS = 5000;   // 5 seconds between MQTT publishes
-        constexpr unsigned long LED_RATE_LIMIT_MS = 500;     // 500ms between LED state changes
-        constexpr unsigned long BUZZER_RATE_LIMIT_MS = 1000; // 1 second between buzzer alerts
+        constexpr uint8_t TRANSITION_BURST = 2;              // Extra tokens only alert edges may spend
 
         // Alert Configuration
         constexpr unsigned long ALERT_INTERVAL = 1000; // milliseconds
+
+        // Dispatch time budgets per handler call; an overrun backs the handler off exponentially
+        constexpr unsigned long DEFAULT_TIME_BUDGET_MS = 20;
+        constexpr unsigned long MQTT_TIME_BUDGET_MS = 250;
+        constexpr unsigned long API_TIME_BUDGET_MS = 3000;      // HTTPS round trip to ThingSpeak
+        constexpr uint8_t MAX_BACKOFF_INTERVALS = 64;           // Longest back-off, in ALERT_INTERVALs
+        constexpr unsigned long STATS_LOG_INTERVAL_MS = 300000; // Log dispatch latency every 5 minutes
+        constexpr unsigned long DIAGNOSTICS_INTERVAL_MS = 60000; // Attach sensor diagnostics every minute
+    }
+
+    namespace calibration
+    {
+        // Clean-air calibration samples Rs until the last CONVERGE_WINDOW readings settle
+        constexpr size_t CONVERGE_WINDOW = 16;
+        constexpr unsigned long CONVERGE_SAMPLE_MS = 40;    // A settled sensor converges in 16 x 40 ms
+        constexpr unsigned long CONVERGE_MAX_MS = 5000;     // Still drifting after this: refuse the R0
+        constexpr float CONVERGE_MAX_SPREAD = 0.02F;        // Relative standard deviation of Rs
+        constexpr float CONVERGE_MAX_TREND_PER_S = 0.02F;   // Relative Rs slope per second
+
+        // Background R0 tracking from a streaming quantile of Rs, fed from the normal scan
+        constexpr bool AUTO_R0_ENABLED = true;
+        constexpr unsigned long SAMPLE_INTERVAL_MS = 10000; // Rs sample fed to the estimator
+        constexpr unsigned long EPOCH_MS = 86400000;        // One R0 update per day
+        constexpr uint32_t MIN_EPOCH_SAMPLES = 4320;        // Half an epoch of samples
+        constexpr float CLEAN_AIR_QUANTILE = 0.25F;         // Gas-side quantile taken as clean air
+        constexpr float MAX_STEP_RATIO = 0.05F;             // Largest R0 change per epoch
+    }
+
+    namespace json
+    {
+        // Static arenas behind the ArduinoJson documents; check the peaks on /metrics before shrinking
+        // Without publishers the telemetry document and payloads are never built, so they keep a token size
+        constexpr size_t TELEMETRY_ARENA_BYTES = features::DATA_PUBLISHERS ? 8192 : 16; // Deferred telemetry document (all channels)
+        constexpr size_t SCRATCH_ARENA_BYTES = 4096;                                     // Local dispatch, per-sensor payloads, events
+        constexpr size_t PAYLOAD_BUFFER_BYTES = features::DATA_PUBLISHERS ? 3072 : 16;   // Encoded publisher payloads of one interval (PayloadCache)
+    }
+
+    namespace trace
+    {
+        // Deferred TRACE_LOGx records; the compile-time level is POOAWAY_TRACE_LEVEL
+        constexpr size_t RING_RECORDS = 64;   // 44 bytes each (power of two)
+        constexpr size_t DRAIN_PER_LOOP = 8;  // Records formatted per main-loop pass
+        constexpr bool BINARY_OUTPUT = false; // Raw frames on Serial for tools/tracelog instead of text
+    }
+
+    namespace metrics
+    {
+        // On-device HTTP endpoint: Prometheus text at /metrics, Server-Sent Events at /stream
+        constexpr uint16_t PORT = 80;
+        constexpr size_t RING_SIZE = 256;                  // Samples held for stream clients (power of two)
+        constexpr size_t MAX_STREAM_CLIENTS = 2;
+        constexpr size_t MAX_EVENTS_PER_POLL = 16;         // Per client and loop pass
+        constexpr unsigned long REQUEST_TIMEOUT_MS = 2000; // To receive the request headers
+        constexpr unsigned long KEEPALIVE_MS = 15000;      // SSE comment when there are no samples
+    }
+
+    namespace detection
+    {
+        // Alert engine per sensor type: CUSUM on the residual, or the tolerance/hold-time rule.
+        // CUSUM is the default: the EMA baseline follows a slow gas rise, so the threshold rule
+        // misses most events in tools/replay, and the event model is trained on CUSUM segmentation
+        constexpr bool NH3_USE_CUSUM = true;
+        constexpr bool CH4_USE_CUSUM = true;
+
+        // CUSUM tuning, in units of the learned residual noise; see tools/replay
+        constexpr float CUSUM_DRIFT_K = 0.75F;
+        constexpr float CUSUM_THRESHOLD_H = 10.0F;
+        constexpr float CUSUM_NOISE_ALPHA = 0.01F;
+        constexpr float CUSUM_MIN_SIGMA_RATIO = 0.02F;
+        constexpr float CUSUM_MAX_STEP = 4.0F;
+    }
+
+    namespace events
+    {
+        constexpr unsigned long CLOSE_HOLDOFF_MS = 10000;  // Quiet time before an event is closed
+        constexpr unsigned long MAX_DURATION_MS = 1800000; // Force-close events after 30 minutes
+        constexpr float MIN_CLASS_MARGIN = 1.0F;           // Log-odds below which a closed event's class is "unknown"
+        constexpr unsigned long TELEMETRY_INTERVAL_MS = 60000; // Telemetry while an event is open, alert transitions aside
+        constexpr size_t QUEUE_DEPTH = 4;                  // Event records a publisher may fall behind by before the oldest is dropped
+    }
+
+    namespace capture
+    {
+        // Raw ADC waveform around each alert edge, served at /capture and kept in NVS
+        constexpr bool ENABLED = true;
+        constexpr uint16_t SAMPLE_INTERVAL_MS = 200;            // Raw readings are averaged over each interval
+        constexpr size_t PRE_TRIGGER_SAMPLES = 150;             // 30 s before the alert edge
+        constexpr size_t POST_TRIGGER_SAMPLES = 150;            // 30 s after it
+        constexpr size_t RAM_BUDGET_BYTES = 24576;              // Ring plus blob buffer, checked at compile time
+        constexpr size_t MAX_SAVED_BYTES = 4000;                // Larger blobs are served but not written to NVS
+        constexpr unsigned long MIN_SAVE_INTERVAL_MS = 600000;  // NVS flash wear: at most one capture per 10 min
+    }
+
+    namespace storage
+    {
+        // Persisted state (R0, baselines, event ids); NVS flash wear bounds how often we write
+        constexpr unsigned long SNAPSHOT_INTERVAL_MS = 60000;     // Copy baselines into the RAM image
+        constexpr unsigned long MIN_COMMIT_INTERVAL_MS = 900000;  // Routine commits at most every 15 min
+        constexpr unsigned long URGENT_COMMIT_INTERVAL_MS = 5000; // After calibration
+        constexpr float BASELINE_DIRTY_RATIO = 0.02F;             // Baseline drift that warrants a write
+        constexpr uint32_t EVENT_ID_BLOCK = 16;                   // Event ids reserved per commit
     }
 
     namespace input
@@ -122,6 +277,15 @@ namespace config
         constexpr unsigned long DEBOUNCE_DELAY = 50; // Button debounce delay in milliseconds
     }
 
+    namespace scheduler
+    {
+        // Event-driven main loop: loop() sleeps until the next timer is due or the button interrupts
+        constexpr unsigned long SAMPLE_INTERVAL_MS = 100;       // Sensor scan, alert tick and persistence
+        constexpr unsigned long NETWORK_POLL_MS = 100;          // /metrics clients, /stream feed, pending boot steps
+        constexpr uint32_t SETTLE_SPIN_US = 2000;               // Mux settles shorter than two wheel ticks are busy-waited
+        constexpr unsigned long STATS_LOG_INTERVAL_MS = 300000; // Log wakeups/s and idle time every 5 minutes
+    }
+
     namespace system
     {
         // System-wide configurations
@@ -135,11 +299,14 @@ namespace config
         constexpr long GMT_OFFSET_SEC = 3600;                          // GMT+1 for Bratislava
         constexpr long DAYLIGHT_OFFSET_SEC = 3600;                     // +1 hour for daylight saving
         constexpr unsigned long SYNC_INTERVAL = 3600000;               // Resync every hour
+        constexpr unsigned long SYNC_TIMEOUT_MS = 5000;                // Give up waiting at boot
     }
 
     namespace thingspeak
     {
         constexpr char const *ENDPOINT = "https://api.thingspeak.com/update";
+        constexpr char const *HOST = "api.thingspeak.com";
+        constexpr uint16_t HTTPS_PORT = 443;
 
 #ifndef THINGSPEAK_USER_API_KEY
         constexpr char const *USER_API_KEY = "your_user_api_key";
@@ -1,30 +1,74 @@
 #pragma once
-#include <string>
-#include "esp_log.h"
+#include <cstdint>
 
 namespace pooaway::error
 {
-
-    class Error
+    enum class Code : uint8_t
     {
-    public:
-        explicit Error(std::string message) : m_message(std::move(message)) {}
-        [[nodiscard]] const std::string &what() const { return m_message; }
-
-    private:
-        std::string m_message;
+        OK,
+        NOT_READY,        // Not initialized yet, or disabled (low power)
+        NOT_CONNECTED,    // WiFi or broker link down
+        TIMEOUT,
+        REJECTED,         // The remote end refused the request
+        INVALID_ARGUMENT,
+        INVALID_DATA,     // Reading or value out of range
+        NOT_CONVERGED,    // Signal did not settle in time
+        NO_SPACE          // Buffer, frame or window full
     };
 
-    class HandlerError : public Error
+    inline const char *to_string(Code code)
     {
-    public:
-        explicit HandlerError(const std::string &message) : Error(message) {}
-    };
+        switch (code)
+        {
+        case Code::OK:
+            return "ok";
+        case Code::NOT_READY:
+            return "not ready";
+        case Code::NOT_CONNECTED:
+            return "not connected";
+        case Code::TIMEOUT:
+            return "timeout";
+        case Code::REJECTED:
+            return "rejected";
+        case Code::INVALID_ARGUMENT:
+            return "invalid argument";
+        case Code::INVALID_DATA:
+            return "invalid data";
+        case Code::NOT_CONVERGED:
+            return "not converged";
+        case Code::NO_SPACE:
+            return "no space";
+        default:
+            return "unknown";
+        }
+    }
 
-    class InitializationError : public Error
+    /**
+     * @brief Outcome of a handler or sensor operation: a code and a message, nothing else
+     *
+     * The firmware builds with -fno-exceptions, so failures travel as return values. A
+     * Result is two words and never allocates; the message must be a string literal (or
+     * otherwise outlive every copy), and details such as a sensor name go to the log at the
+     * failure site instead.
+     */
+    class [[nodiscard]] Result
     {
     public:
-        explicit InitializationError(const std::string &message) : Error(message) {}
+        constexpr Result() = default;
+
+        static constexpr Result ok() { return Result(); }
+        static constexpr Result fail(Code code, const char *message) { return Result(code, message); }
+
+        constexpr bool is_ok() const { return m_code == Code::OK; }
+        constexpr explicit operator bool() const { return is_ok(); }
+        constexpr Code code() const { return m_code; }
+        const char *message() const { return m_message ? m_message : to_string(m_code); }
+
+    private:
+        constexpr Result(Code code, const char *message) : m_code(code), m_message(message) {}
+
+        Code m_code{Code::OK};
+        const char *m_message{nullptr};
     };
 
-} // namespace pooaway::error
\ No newline at end of file
+} // namespace pooaway::error
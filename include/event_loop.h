@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "timer_wheel.h"
+
+namespace pooaway
+{
+    /**
+     * @brief Timer-driven main loop that sleeps until there is work
+     *
+     * Sampling, the alert tick and network polling are timers on a wheel with 1 ms ticks.
+     * run_once() blocks the loop task on a task notification until the earliest timer is
+     * due, so the CPU only wakes when something is scheduled. The calibration button raises
+     * a GPIO interrupt that only counts the edge and wakes the loop; debouncing happens on
+     * the loop side, where each edge restarts a quiet-time timer and the pin is read once
+     * it expires.
+     */
+    class EventLoop
+    {
+    public:
+        static constexpr size_t MAX_TIMERS = 8;
+        static constexpr size_t WHEEL_SLOTS = 256; // One revolution spans the sample interval
+        using TimerFn = void (*)();
+        using ButtonFn = void (*)();
+
+        struct Stats
+        {
+            uint32_t wakeups{0};        // Returns from a wait, by timeout or notification
+            uint32_t button_edges{0};   // Interrupts seen on the button pin
+            uint32_t timers_fired{0};
+            uint64_t idle_us{0};        // Time spent blocked in the wait
+        };
+
+        static EventLoop &instance();
+
+        EventLoop(const EventLoop &) = delete;
+        EventLoop &operator=(const EventLoop &) = delete;
+
+        // Bind to the calling (loop) task; call from setup() before adding timers
+        void begin();
+
+        /**
+         * @brief Register a timer, stopped
+         * @param period_ms Re-armed after each expiry; 0 for a one-shot timer
+         * @return Timer id, or -1 when MAX_TIMERS is reached
+         */
+        int add_timer(TimerFn fn, unsigned long period_ms);
+        void start_timer(int timer, unsigned long delay_ms = 0);
+        void stop_timer(int timer);
+
+        // Call on_press from the loop when the active-low button on pin settles pressed
+        void watch_button(uint8_t pin, ButtonFn on_press);
+
+        // Wait for the next due timer or button edge, then run everything that is due
+        void run_once();
+
+        // Skip the next wait, e.g. while deferred work is still queued
+        void request_pass() { m_pass_requested = true; }
+
+        const Stats &get_stats() const { return m_stats; }
+        // Over the last completed STATS_LOG_INTERVAL_MS window
+        float get_wakeups_per_s() const { return m_wakeups_per_s; }
+        float get_idle_ratio() const { return m_idle_ratio; }
+
+    private:
+        static constexpr char const *TAG = "EventLoop";
+
+        EventLoop() = default;
+        static void on_debounce();
+        void log_stats(unsigned long now);
+
+        TimerWheel<MAX_TIMERS, WHEEL_SLOTS> m_wheel;
+        Stats m_stats;
+        bool m_pass_requested{false};
+
+        uint8_t m_button_pin{0};
+        ButtonFn m_on_press{nullptr};
+        int m_debounce_timer{-1};
+        uint32_t m_seen_edges{0};
+        bool m_button_pressed{false};
+
+        unsigned long m_window_start_ms{0};
+        uint32_t m_window_wakeups{0};
+        uint64_t m_window_idle_us{0};
+        float m_wakeups_per_s{0.0F};
+        float m_idle_ratio{0.0F};
+    };
+} // namespace pooaway
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ArduinoJson.h>
+
+namespace pooaway
+{
+    /**
+     * @brief ArduinoJson allocator over a fixed static buffer that empties itself between uses
+     *
+     * Blocks are bump-allocated. Freeing the newest block gives its space back at once, and
+     * when the last live block is freed, for example when its document is cleared or
+     * destroyed, the arena starts over from the beginning. A document built and dropped once
+     * per cycle therefore never touches the heap. If a cycle needs more than the buffer, the
+     * overflow goes to the heap and is counted, and the high-water mark shows what size would
+     * have been enough. Not thread-safe; all documents live in the main loop.
+     */
+    class JsonArena : public ArduinoJson::Allocator
+    {
+    public:
+        struct Stats
+        {
+            size_t capacity{0};
+            size_t peak_used{0};      // High-water mark, including block headers
+            uint32_t resets{0};       // Times the arena emptied completely
+            uint32_t heap_fallbacks{0}; // Allocations that did not fit and went to the heap
+        };
+
+        // AlertManager's telemetry document, rebuilt once per alert interval
+        static JsonArena &telemetry();
+        // Short-lived documents built and dropped within one call (local dispatch, payloads, events)
+        static JsonArena &scratch();
+
+        JsonArena(const char *name, uint8_t *storage, size_t capacity);
+
+        JsonArena(const JsonArena &) = delete;
+        JsonArena &operator=(const JsonArena &) = delete;
+
+        void *allocate(size_t size) override;
+        void deallocate(void *pointer) override;
+        void *reallocate(void *pointer, size_t new_size) override;
+
+        const char *get_name() const { return m_name; }
+        const Stats &get_stats() const { return m_stats; }
+        size_t get_used() const { return m_used; }
+
+    private:
+        static constexpr size_t ALIGN = 8;
+        static constexpr size_t HEADER = ALIGN; // Block size, padded to keep the payload aligned
+
+        static size_t round_up(size_t size) { return (size + ALIGN - 1) & ~(ALIGN - 1); }
+        bool owns(const void *pointer) const;
+        uint32_t &block_size(void *pointer) const;
+
+        const char *m_name;
+        uint8_t *m_storage;
+        size_t m_used{0};
+        size_t m_last_block{0}; // Offset of the newest block's header, valid while m_live > 0
+        uint32_t m_live{0};
+        Stats m_stats;
+    };
+} // namespace pooaway
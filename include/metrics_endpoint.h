@@ -0,0 +1,578 @@
+#pragma once
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Pure C++ (no Arduino dependencies) so tools/metrics can serve the same endpoint over loopback
+
+namespace pooaway::metrics
+{
+    struct SampleRecord
+    {
+        uint32_t seq;
+        uint32_t time_ms;
+        float value;
+        float baseline;
+        uint8_t channel;
+        bool alert;
+    };
+
+    /**
+     * @brief The most recent samples in a fixed ring; readers follow it by sequence number
+     *
+     * The writer never waits for readers. A reader that falls more than N samples behind
+     * skips ahead to the oldest sample still held and is told how many it missed.
+     */
+    template <size_t N>
+    class SampleRing
+    {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
+    public:
+        void push(uint32_t time_ms, uint8_t channel, float value, float baseline, bool alert)
+        {
+            m_records[m_next_seq & (N - 1)] = SampleRecord{m_next_seq, time_ms, value, baseline, channel, alert};
+            m_next_seq++;
+        }
+
+        // Sequence number the next push() will get
+        uint32_t next_seq() const { return m_next_seq; }
+        uint32_t oldest_seq() const { return m_next_seq > N ? m_next_seq - N : 0; }
+
+        /**
+         * @brief Copy the sample at cursor and advance the cursor
+         * @param skipped Samples overwritten before this reader got to them
+         * @return false if the reader is up to date
+         */
+        bool read(uint32_t &cursor, SampleRecord &out, uint32_t &skipped) const
+        {
+            skipped = 0;
+            if (cursor < oldest_seq())
+            {
+                skipped = oldest_seq() - cursor;
+                cursor = oldest_seq();
+            }
+            if (cursor == m_next_seq)
+            {
+                return false;
+            }
+            out = m_records[cursor & (N - 1)];
+            cursor++;
+            return true;
+        }
+
+    private:
+        SampleRecord m_records[N]{};
+        uint32_t m_next_seq{0};
+    };
+
+    /**
+     * @brief Formats into a caller-owned buffer and hands it to a sink each time it fills up
+     *
+     * Responses of any length go out through one fixed buffer, without heap allocation.
+     * After the sink fails once, all further output is discarded.
+     */
+    class ChunkWriter
+    {
+    public:
+        using Sink = bool (*)(void *context, const char *data, size_t length);
+
+        ChunkWriter(char *buffer, size_t capacity, Sink sink, void *context)
+            : m_buffer(buffer), m_capacity(capacity), m_sink(sink), m_context(context) {}
+
+        ~ChunkWriter() { flush(); }
+
+        ChunkWriter(const ChunkWriter &) = delete;
+        ChunkWriter &operator=(const ChunkWriter &) = delete;
+
+        bool printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+        {
+            for (int attempt = 0; attempt < 2 && !m_failed; attempt++)
+            {
+                va_list args;
+                va_start(args, format);
+                const int written = std::vsnprintf(m_buffer + m_length, m_capacity - m_length, format, args);
+                va_end(args);
+
+                if (written < 0)
+                {
+                    break;
+                }
+                if (static_cast<size_t>(written) < m_capacity - m_length)
+                {
+                    m_length += static_cast<size_t>(written);
+                    return true;
+                }
+                flush(); // Did not fit: send what we have and retry into the empty buffer
+            }
+
+            m_buffer[m_length] = '\0'; // Drop the partial line
+            m_truncated = true;
+            return false;
+        }
+
+        bool flush()
+        {
+            if (m_length > 0 && !m_failed)
+            {
+                m_failed = !m_sink(m_context, m_buffer, m_length);
+            }
+            m_length = 0;
+            return !m_failed;
+        }
+
+        bool failed() const { return m_failed; }
+        bool truncated() const { return m_truncated; }
+
+    private:
+        char *m_buffer;
+        size_t m_capacity;
+        size_t m_length{0};
+        Sink m_sink;
+        void *m_context;
+        bool m_failed{false};
+        bool m_truncated{false};
+    };
+
+    // Prometheus text exposition: one HELP/TYPE header per family, then its samples
+    inline void write_family(ChunkWriter &out, const char *name, const char *type, const char *help)
+    {
+        out.printf("# HELP pooaway_%s %s\n# TYPE pooaway_%s %s\n", name, help, name, type);
+    }
+
+    inline void write_value(ChunkWriter &out, const char *name, const char *labels, double value)
+    {
+        if (labels && labels[0])
+        {
+            out.printf("pooaway_%s{%s} %.6g\n", name, labels, value);
+        }
+        else
+        {
+            out.printf("pooaway_%s %.6g\n", name, value);
+        }
+    }
+
+    // One Server-Sent Event per sample; the id lets a client see gaps after a reconnect
+    inline void write_sample_event(ChunkWriter &out, const SampleRecord &record, const char *sensor)
+    {
+        out.printf("id: %lu\nevent: sample\ndata: {\"t\":%lu,\"channel\":%u,\"sensor\":\"%s\","
+                   "\"value\":%.4g,\"baseline\":%.4g,\"alert\":%s}\n\n",
+                   static_cast<unsigned long>(record.seq), static_cast<unsigned long>(record.time_ms),
+                   static_cast<unsigned>(record.channel), sensor ? sensor : "", record.value, record.baseline,
+                   record.alert ? "true" : "false");
+    }
+
+    enum class Route : uint8_t
+    {
+        METRICS,
+        STREAM,
+        CAPTURE,
+        NOT_FOUND,
+        BAD_REQUEST
+    };
+
+    // Route from the HTTP request line, e.g. "GET /metrics HTTP/1.1"
+    inline Route route_request(const char *line)
+    {
+        if (std::strncmp(line, "GET ", 4) != 0)
+        {
+            return Route::BAD_REQUEST;
+        }
+
+        const char *path = line + 4;
+        const size_t length = std::strcspn(path, " ?");
+        const auto is = [&](const char *candidate)
+        { return length == std::strlen(candidate) && std::strncmp(path, candidate, length) == 0; };
+
+        if (is("/metrics"))
+        {
+            return Route::METRICS;
+        }
+        if (is("/stream"))
+        {
+            return Route::STREAM;
+        }
+        if (is("/capture"))
+        {
+            return Route::CAPTURE;
+        }
+        return Route::NOT_FOUND;
+    }
+
+    /**
+     * @brief Collects a request until the blank line that ends its headers
+     *
+     * Keeps only the request line; the headers are consumed but not stored, since closing a
+     * socket with unread input makes the TCP stack reset the connection.
+     */
+    class RequestReader
+    {
+    public:
+        static constexpr size_t MAX_LINE = 128;
+        static constexpr size_t MAX_REQUEST = 2048;
+
+        enum class State : uint8_t
+        {
+            READING,
+            COMPLETE,
+            TOO_LONG
+        };
+
+        void reset()
+        {
+            m_line_length = 0;
+            m_total = 0;
+            m_tail = 0;
+            m_line_done = false;
+            m_line[0] = '\0';
+        }
+
+        State feed(char c)
+        {
+            if (++m_total > MAX_REQUEST)
+            {
+                return State::TOO_LONG;
+            }
+
+            if (!m_line_done)
+            {
+                if (c == '\r' || c == '\n')
+                {
+                    m_line_done = true;
+                }
+                else if (m_line_length + 1 < MAX_LINE)
+                {
+                    m_line[m_line_length++] = c;
+                    m_line[m_line_length] = '\0';
+                }
+            }
+
+            // Last four bytes, to spot "\r\n\r\n" (or a bare "\n\n")
+            m_tail = (m_tail << 8) | static_cast<uint8_t>(c);
+            return (m_tail == 0x0D0A0D0AU || (m_tail & 0xFFFFU) == 0x0A0AU) ? State::COMPLETE
+                                                                                          : State::READING;
+        }
+
+        const char *line() const { return m_line; }
+
+    private:
+        char m_line[MAX_LINE]{};
+        size_t m_line_length{0};
+        size_t m_total{0};
+        uint32_t m_tail{0};
+        bool m_line_done{false};
+    };
+
+    struct EndpointStats
+    {
+        uint32_t requests{0};
+        uint32_t rejected{0};        // Bad, oversized, timed-out or refused requests
+        uint32_t streams_opened{0};
+        uint32_t samples_streamed{0};
+        uint32_t samples_skipped{0}; // Overwritten before a slow stream client read them
+    };
+
+    /**
+     * @brief HTTP/1.0 endpoint serving /metrics and an SSE /stream of every ring sample
+     *
+     * With set_capture(), /capture also serves the latest alert waveform as one binary blob.
+     *
+     * Single-threaded: accept() hands over new connections and poll() advances everything, so
+     * both must be called from the same task as the ring writer. All output goes through one
+     * member buffer. One request is read at a time; stream clients beyond MaxStreams are
+     * refused with 503.
+     *
+     * @tparam Client Connection with available(), read(), write(const uint8_t *, size_t),
+     *                connected() and stop(), e.g. WiFiClient
+     */
+    template <typename Client, size_t RingSize, size_t MaxStreams>
+    class Endpoint
+    {
+    public:
+        using MetricsFn = void (*)(ChunkWriter &out);
+        using NameFn = const char *(*)(uint8_t channel);
+        using BlobFn = size_t (*)(const uint8_t *&data); // Returns the length, 0 if there is nothing to serve
+
+        struct Limits
+        {
+            uint32_t request_timeout_ms;
+            uint32_t keepalive_ms;
+            size_t max_events_per_poll;
+        };
+
+        Endpoint(const SampleRing<RingSize> &ring, MetricsFn metrics, NameFn names, const Limits &limits)
+            : m_ring(ring), m_metrics(metrics), m_names(names), m_limits(limits) {}
+
+        void set_capture(BlobFn capture) { m_capture = capture; }
+
+        // Takes over a freshly accepted connection
+        void accept(const Client &client, uint32_t now_ms)
+        {
+            if (m_has_pending)
+            {
+                Client busy = client;
+                respond_status(busy, "503 Service Unavailable");
+                m_stats.rejected++;
+                return;
+            }
+            m_pending = client;
+            m_pending_since_ms = now_ms;
+            m_reader.reset();
+            m_has_pending = true;
+        }
+
+        void poll(uint32_t now_ms)
+        {
+            poll_request(now_ms);
+            for (auto &stream : m_streams)
+            {
+                if (stream.active)
+                {
+                    pump_stream(stream, now_ms);
+                }
+            }
+        }
+
+        size_t stream_count() const
+        {
+            size_t count = 0;
+            for (const auto &stream : m_streams)
+            {
+                count += stream.active ? 1 : 0;
+            }
+            return count;
+        }
+
+        const EndpointStats &get_stats() const { return m_stats; }
+
+        // Own counters, for MetricsFn implementations to append to /metrics
+        void write_stats(ChunkWriter &out) const
+        {
+            write_family(out, "http_requests_total", "counter", "Requests served by the metrics endpoint");
+            write_value(out, "http_requests_total", "", m_stats.requests);
+            write_family(out, "http_rejected_total", "counter", "Requests refused, malformed or timed out");
+            write_value(out, "http_rejected_total", "", m_stats.rejected);
+            write_family(out, "stream_clients", "gauge", "Connected /stream clients");
+            write_value(out, "stream_clients", "", static_cast<double>(stream_count()));
+            write_family(out, "stream_samples_total", "counter", "Samples sent to /stream clients");
+            write_value(out, "stream_samples_total", "", m_stats.samples_streamed);
+            write_family(out, "stream_skipped_total", "counter", "Samples overwritten before a client read them");
+            write_value(out, "stream_skipped_total", "", m_stats.samples_skipped);
+        }
+
+    private:
+        static constexpr size_t CHUNK_SIZE = 512;
+
+        struct Stream
+        {
+            Client client;
+            uint32_t cursor{0};
+            uint32_t last_write_ms{0};
+            bool active{false};
+        };
+
+        static bool write_to_client(void *context, const char *data, size_t length)
+        {
+            auto *client = static_cast<Client *>(context);
+            return client->write(reinterpret_cast<const uint8_t *>(data), length) == length;
+        }
+
+        void respond_status(Client &client, const char *status)
+        {
+            {
+                ChunkWriter out(m_chunk, CHUNK_SIZE, write_to_client, &client);
+                out.printf("HTTP/1.0 %s\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\n%s\n", status, status);
+            }
+            client.stop();
+        }
+
+        void poll_request(uint32_t now_ms)
+        {
+            if (!m_has_pending)
+            {
+                return;
+            }
+
+            auto state = RequestReader::State::READING;
+            while (state == RequestReader::State::READING && m_pending.available() > 0)
+            {
+                const int c = m_pending.read();
+                if (c < 0)
+                {
+                    break;
+                }
+                state = m_reader.feed(static_cast<char>(c));
+            }
+
+            if (state == RequestReader::State::READING)
+            {
+                if (now_ms - m_pending_since_ms >= m_limits.request_timeout_ms || !m_pending.connected())
+                {
+                    m_pending.stop();
+                    m_has_pending = false;
+                    m_stats.rejected++;
+                }
+                return;
+            }
+
+            m_has_pending = false;
+            if (state == RequestReader::State::TOO_LONG)
+            {
+                respond_status(m_pending, "431 Request Header Fields Too Large");
+                m_stats.rejected++;
+                return;
+            }
+
+            switch (route_request(m_reader.line()))
+            {
+            case Route::METRICS:
+                serve_metrics(m_pending);
+                m_stats.requests++;
+                break;
+            case Route::STREAM:
+                open_stream(m_pending, now_ms);
+                break;
+            case Route::CAPTURE:
+                serve_capture(m_pending);
+                m_stats.requests++;
+                break;
+            case Route::NOT_FOUND:
+                respond_status(m_pending, "404 Not Found");
+                m_stats.requests++;
+                break;
+            case Route::BAD_REQUEST:
+                respond_status(m_pending, "400 Bad Request");
+                m_stats.rejected++;
+                break;
+            }
+        }
+
+        void serve_metrics(Client &client)
+        {
+            {
+                ChunkWriter out(m_chunk, CHUNK_SIZE, write_to_client, &client);
+                out.printf("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+                m_metrics(out);
+                write_stats(out);
+            }
+            client.stop();
+        }
+
+        void serve_capture(Client &client)
+        {
+            const uint8_t *data = nullptr;
+            const size_t length = m_capture ? m_capture(data) : 0;
+            if (length == 0)
+            {
+                respond_status(client, "404 Not Found");
+                return;
+            }
+
+            // The blob is already in memory, so it goes out in one write after the headers
+            ChunkWriter out(m_chunk, CHUNK_SIZE, write_to_client, &client);
+            out.printf("HTTP/1.0 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %u\r\n"
+                       "Content-Disposition: attachment; filename=\"capture.bin\"\r\nConnection: close\r\n\r\n",
+                       static_cast<unsigned>(length));
+            if (out.flush())
+            {
+                client.write(data, length);
+            }
+            client.stop();
+        }
+
+        void open_stream(Client &client, uint32_t now_ms)
+        {
+            for (auto &stream : m_streams)
+            {
+                if (stream.active)
+                {
+                    continue;
+                }
+
+                stream.client = client;
+                stream.cursor = m_ring.next_seq(); // Live samples only
+                stream.last_write_ms = now_ms;
+                stream.active = true;
+                m_stats.requests++;
+                m_stats.streams_opened++;
+
+                ChunkWriter out(m_chunk, CHUNK_SIZE, write_to_client, &stream.client);
+                out.printf("HTTP/1.0 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                           "Connection: close\r\n\r\n: pooaway samples\n\n");
+                if (!out.flush())
+                {
+                    close_stream(stream);
+                }
+                return;
+            }
+
+            respond_status(client, "503 Service Unavailable");
+            m_stats.rejected++;
+        }
+
+        void pump_stream(Stream &stream, uint32_t now_ms)
+        {
+            if (!stream.client.connected())
+            {
+                close_stream(stream);
+                return;
+            }
+
+            ChunkWriter out(m_chunk, CHUNK_SIZE, write_to_client, &stream.client);
+            SampleRecord record{};
+            uint32_t skipped = 0;
+            size_t sent = 0;
+            while (sent < m_limits.max_events_per_poll && m_ring.read(stream.cursor, record, skipped))
+            {
+                if (skipped > 0)
+                {
+                    out.printf(": skipped %lu\n\n", static_cast<unsigned long>(skipped));
+                    m_stats.samples_skipped += skipped;
+                }
+                write_sample_event(out, record, m_names(record.channel));
+                sent++;
+            }
+
+            if (sent == 0 && now_ms - stream.last_write_ms >= m_limits.keepalive_ms)
+            {
+                out.printf(": keepalive\n\n");
+            }
+            else if (sent == 0)
+            {
+                return;
+            }
+
+            if (!out.flush())
+            {
+                close_stream(stream);
+                return;
+            }
+            stream.last_write_ms = now_ms;
+            m_stats.samples_streamed += static_cast<uint32_t>(sent);
+        }
+
+        void close_stream(Stream &stream)
+        {
+            stream.client.stop();
+            stream.client = Client();
+            stream.active = false;
+        }
+
+        const SampleRing<RingSize> &m_ring;
+        MetricsFn m_metrics;
+        NameFn m_names;
+        BlobFn m_capture{nullptr};
+        Limits m_limits;
+
+        Client m_pending;
+        RequestReader m_reader;
+        uint32_t m_pending_since_ms{0};
+        bool m_has_pending{false};
+
+        Stream m_streams[MaxStreams];
+        char m_chunk[CHUNK_SIZE]{};
+        EndpointStats m_stats;
+    };
+} // namespace pooaway::metrics
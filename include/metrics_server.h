@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <WiFi.h>
+#include "metrics_endpoint.h"
+#include "config.h"
+
+namespace pooaway
+{
+    /**
+     * @brief Embedded HTTP server with Prometheus metrics at /metrics and every sample at /stream
+     *
+     * /capture serves the latest alert waveform from WaveformCapture.
+     *
+     * Samples are recorded into a fixed ring by SensorManager and streamed from there, so
+     * serving clients needs no allocation and never stalls sampling. Everything runs from
+     * the main loop.
+     */
+    class MetricsServer
+    {
+    public:
+        static MetricsServer &instance();
+
+        MetricsServer(const MetricsServer &) = delete;
+        MetricsServer &operator=(const MetricsServer &) = delete;
+
+        // Start listening; call once WiFi is connected
+        void begin();
+        // Accept connections and feed stream clients; call from loop()
+        void poll();
+        void record_sample(uint8_t channel, float value, float baseline, bool alert);
+
+    private:
+        using Endpoint = metrics::Endpoint<WiFiClient, config::metrics::RING_SIZE, config::metrics::MAX_STREAM_CLIENTS>;
+
+        static constexpr char const *TAG = "MetricsServer";
+
+        MetricsServer();
+        static void write_metrics(metrics::ChunkWriter &out);
+        static const char *channel_name(uint8_t channel);
+
+        WiFiServer m_server;
+        metrics::SampleRing<config::metrics::RING_SIZE> m_ring;
+        Endpoint m_endpoint;
+        bool m_started{false};
+    };
+} // namespace pooaway
@@ -0,0 +1,586 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Pure C++ (no Arduino dependencies) so tools/mqtt can benchmark it against a loopback broker
+
+namespace pooaway::mqtt
+{
+    // MQTT 3.1.1 control packet types (upper nibble of the fixed header)
+    enum class PacketType : uint8_t
+    {
+        CONNECT = 1,
+        CONNACK = 2,
+        PUBLISH = 3,
+        PUBACK = 4,
+        PINGREQ = 12,
+        PINGRESP = 13,
+        DISCONNECT = 14
+    };
+
+    enum class PublishResult : uint8_t
+    {
+        SENT,          // QoS 0 frame written
+        IN_FLIGHT,     // QoS 1 frame written and held until its PUBACK
+        NOT_CONNECTED,
+        WINDOW_FULL,   // Every in-flight slot is waiting for a PUBACK
+        TOO_LARGE,     // Frame does not fit FrameBytes
+        WRITE_FAILED   // Connection dropped while writing
+    };
+
+    // Byte range of a payload; a publish may be assembled from several without copying them first
+    struct PayloadPart
+    {
+        const char *data;
+        size_t length;
+    };
+
+    struct SessionConfig
+    {
+        const char *client_id;
+        const char *username; // nullptr or "" to omit
+        const char *password;
+        uint16_t keepalive_s;
+        uint32_t connect_timeout_ms; // Wait for CONNACK
+        uint32_t retransmit_ms;      // Resend an unacknowledged QoS 1 frame after this long
+        uint8_t max_attempts;        // Sends per message, first one included, before it is dropped
+        uint8_t window;              // In-flight QoS 1 messages, at most the MaxWindow template argument
+    };
+
+    struct SessionStats
+    {
+        uint32_t connects{0};
+        uint32_t published{0};    // Frames accepted by publish(), any QoS
+        uint32_t acked{0};        // PUBACKs matched to an in-flight message
+        uint32_t retransmits{0};  // DUP resends, on timeout or after a reconnect
+        uint32_t expired{0};      // Messages dropped after max_attempts sends
+        uint32_t window_full{0};  // publish() calls refused for lack of a slot
+        uint32_t frames_written{0};
+        uint64_t bytes_written{0};
+        uint8_t max_in_flight{0};
+        uint32_t last_rtt_ms{0};  // First send to PUBACK
+        uint32_t max_rtt_ms{0};
+        uint64_t total_rtt_ms{0};
+    };
+
+    /**
+     * @brief MQTT 3.1.1 publishing session with a window of in-flight QoS 1 messages
+     *
+     * QoS 1 publishes do not wait for their PUBACK: each frame is written in one write() and
+     * kept in one of MaxWindow slots, and poll() matches PUBACKs as they arrive, so up to
+     * window messages are on the wire at once instead of one round trip each. A frame still
+     * unacknowledged after retransmit_ms is resent with DUP set, and dropped after
+     * max_attempts sends. Frames survive a lost connection and are resent when connect()
+     * succeeds again (clean session, so the broker may see them twice; QoS 1 is at least
+     * once). poll() also sends PINGREQ on an idle connection and closes it when the broker
+     * stops answering. Incoming PUBLISH packets are not expected (nothing is subscribed)
+     * and are skipped. No heap use; not thread-safe.
+     *
+     * @tparam Client Connection with connect(host, port), write(const uint8_t *, size_t),
+     *                available(), read(uint8_t *, size_t), connected() and stop(), e.g. WiFiClient
+     * @tparam Clock Type with static now_ms() returning a wrapping millisecond counter and
+     *               static idle() called while waiting for the CONNACK
+     */
+    template <typename Client, typename Clock, size_t MaxWindow, size_t FrameBytes>
+    class Session
+    {
+        static_assert(MaxWindow > 0 && MaxWindow <= 32, "Window must fit the 32-bit slot mask");
+
+    public:
+        Session(Client &client, const SessionConfig &config) : m_client(client), m_config(config)
+        {
+            if (m_config.window == 0 || m_config.window > MaxWindow)
+            {
+                m_config.window = MaxWindow;
+            }
+        }
+
+        Session(const Session &) = delete;
+        Session &operator=(const Session &) = delete;
+
+        // Opens the TCP connection and waits for the CONNACK, then resends what is still in flight
+        bool connect(const char *host, uint16_t port)
+        {
+            m_client.stop();
+            reset_receiver();
+            m_connack_code = -1;
+            if (!m_client.connect(host, port) || !write_connect())
+            {
+                m_client.stop();
+                return false;
+            }
+
+            const uint32_t start = Clock::now_ms();
+            while (m_connack_code < 0 && Clock::now_ms() - start < m_config.connect_timeout_ms)
+            {
+                if (!receive())
+                {
+                    break;
+                }
+                Clock::idle();
+            }
+
+            if (m_connack_code != 0)
+            {
+                m_client.stop();
+                return false;
+            }
+
+            m_stats.connects++;
+            m_ping_outstanding = false;
+            m_last_rx_ms = Clock::now_ms();
+            resend_in_flight();
+            return true;
+        }
+
+        bool connected() { return m_connack_code == 0 && m_client.connected(); }
+
+        // CONNACK return code of the last attempt: 0 accepted, 1-5 refused, -1 none received
+        int connack_code() const { return m_connack_code; }
+
+        void disconnect()
+        {
+            if (connected())
+            {
+                const uint8_t frame[] = {static_cast<uint8_t>(static_cast<uint8_t>(PacketType::DISCONNECT) << 4), 0};
+                write_frame(frame, sizeof(frame));
+            }
+            m_client.stop();
+            m_connack_code = -1;
+        }
+
+        PublishResult publish(const char *topic, const char *payload, size_t length, uint8_t qos)
+        {
+            const PayloadPart part{payload, length};
+            return publish(topic, &part, 1, qos);
+        }
+
+        // Writes one PUBLISH whose payload is the parts back to back
+        PublishResult publish(const char *topic, const PayloadPart *parts, size_t count, uint8_t qos)
+        {
+            if (!connected())
+            {
+                return PublishResult::NOT_CONNECTED;
+            }
+
+            qos = qos ? 1 : 0;
+            Slot *slot = nullptr;
+            if (qos)
+            {
+                slot = free_slot();
+                if (!slot)
+                {
+                    m_stats.window_full++;
+                    return PublishResult::WINDOW_FULL;
+                }
+            }
+
+            uint8_t *frame = slot ? slot->frame : m_tx;
+            const uint16_t packet_id = qos ? next_packet_id() : 0;
+            const size_t length = encode_publish(frame, topic, parts, count, qos, packet_id);
+            if (length == 0)
+            {
+                return PublishResult::TOO_LARGE;
+            }
+
+            if (!write_frame(frame, length))
+            {
+                return PublishResult::WRITE_FAILED;
+            }
+
+            m_stats.published++;
+            if (!slot)
+            {
+                return PublishResult::SENT;
+            }
+
+            slot->length = static_cast<uint16_t>(length);
+            slot->packet_id = packet_id;
+            slot->first_sent_ms = slot->last_sent_ms = Clock::now_ms();
+            slot->attempts = 1;
+            m_in_flight_mask |= 1UL << (slot - m_slots);
+            const uint8_t in_flight = static_cast<uint8_t>(this->in_flight());
+            m_stats.max_in_flight = in_flight > m_stats.max_in_flight ? in_flight : m_stats.max_in_flight;
+            return PublishResult::IN_FLIGHT;
+        }
+
+        // Reads acknowledgements, resends overdue frames and keeps the connection alive
+        void poll()
+        {
+            if (!connected())
+            {
+                return;
+            }
+
+            if (!receive())
+            {
+                m_client.stop();
+                return;
+            }
+
+            const uint32_t now = Clock::now_ms();
+            for (size_t i = 0; i < MaxWindow; i++)
+            {
+                Slot &slot = m_slots[i];
+                if (!(m_in_flight_mask & (1UL << i)) || now - slot.last_sent_ms < m_config.retransmit_ms)
+                {
+                    continue;
+                }
+                if (slot.attempts >= m_config.max_attempts)
+                {
+                    m_in_flight_mask &= ~(1UL << i);
+                    m_stats.expired++;
+                    continue;
+                }
+                resend(slot, now);
+            }
+
+            const uint32_t keepalive_ms = static_cast<uint32_t>(m_config.keepalive_s) * 1000;
+            if (keepalive_ms == 0)
+            {
+                return;
+            }
+            if (m_ping_outstanding && now - m_ping_sent_ms >= keepalive_ms)
+            {
+                m_client.stop(); // Broker stopped answering
+                return;
+            }
+            if (!m_ping_outstanding && now - m_last_tx_ms >= keepalive_ms)
+            {
+                const uint8_t frame[] = {static_cast<uint8_t>(static_cast<uint8_t>(PacketType::PINGREQ) << 4), 0};
+                if (write_frame(frame, sizeof(frame)))
+                {
+                    m_ping_outstanding = true;
+                    m_ping_sent_ms = now;
+                }
+            }
+        }
+
+        size_t in_flight() const
+        {
+            size_t count = 0;
+            for (uint32_t mask = m_in_flight_mask; mask; mask &= mask - 1)
+            {
+                count++;
+            }
+            return count;
+        }
+
+        size_t window() const { return m_config.window; }
+        const SessionStats &get_stats() const { return m_stats; }
+
+    private:
+        struct Slot
+        {
+            uint8_t frame[FrameBytes];
+            uint16_t length{0};
+            uint16_t packet_id{0};
+            uint32_t first_sent_ms{0};
+            uint32_t last_sent_ms{0};
+            uint8_t attempts{0};
+        };
+
+        Slot *free_slot()
+        {
+            if (in_flight() >= m_config.window)
+            {
+                return nullptr;
+            }
+            for (size_t i = 0; i < MaxWindow; i++)
+            {
+                if (!(m_in_flight_mask & (1UL << i)))
+                {
+                    return &m_slots[i];
+                }
+            }
+            return nullptr;
+        }
+
+        uint16_t next_packet_id()
+        {
+            // Non-zero and not used by a message still in flight
+            for (;;)
+            {
+                if (++m_packet_id == 0)
+                {
+                    m_packet_id = 1;
+                }
+                if (!find_in_flight(m_packet_id))
+                {
+                    return m_packet_id;
+                }
+            }
+        }
+
+        Slot *find_in_flight(uint16_t packet_id)
+        {
+            for (size_t i = 0; i < MaxWindow; i++)
+            {
+                if ((m_in_flight_mask & (1UL << i)) && m_slots[i].packet_id == packet_id)
+                {
+                    return &m_slots[i];
+                }
+            }
+            return nullptr;
+        }
+
+        void resend(Slot &slot, uint32_t now)
+        {
+            slot.frame[0] |= 0x08; // DUP
+            if (write_frame(slot.frame, slot.length))
+            {
+                slot.attempts++;
+                slot.last_sent_ms = now;
+                m_stats.retransmits++;
+            }
+        }
+
+        void resend_in_flight()
+        {
+            const uint32_t now = Clock::now_ms();
+            for (size_t i = 0; i < MaxWindow; i++)
+            {
+                if (m_in_flight_mask & (1UL << i))
+                {
+                    resend(m_slots[i], now);
+                }
+            }
+        }
+
+        static size_t put_remaining_length(uint8_t *out, size_t length)
+        {
+            size_t n = 0;
+            do
+            {
+                uint8_t digit = length % 128;
+                length /= 128;
+                if (length > 0)
+                {
+                    digit |= 0x80;
+                }
+                out[n++] = digit;
+            } while (length > 0);
+            return n;
+        }
+
+        static size_t put_string(uint8_t *out, const char *text, size_t length)
+        {
+            out[0] = static_cast<uint8_t>(length >> 8);
+            out[1] = static_cast<uint8_t>(length & 0xFF);
+            std::memcpy(out + 2, text, length);
+            return 2 + length;
+        }
+
+        // Builds a PUBLISH into frame; 0 if it does not fit
+        static size_t encode_publish(uint8_t *frame, const char *topic, const PayloadPart *parts, size_t count,
+                                     uint8_t qos, uint16_t packet_id)
+        {
+            const size_t topic_length = std::strlen(topic);
+            size_t remaining = 2 + topic_length + (qos ? 2 : 0);
+            for (size_t i = 0; i < count; i++)
+            {
+                remaining += parts[i].length;
+            }
+            if (1 + 4 + remaining > FrameBytes || topic_length > 0xFFFF)
+            {
+                return 0;
+            }
+
+            size_t n = 0;
+            frame[n++] = static_cast<uint8_t>((static_cast<uint8_t>(PacketType::PUBLISH) << 4) | (qos << 1));
+            n += put_remaining_length(frame + n, remaining);
+            n += put_string(frame + n, topic, topic_length);
+            if (qos)
+            {
+                frame[n++] = static_cast<uint8_t>(packet_id >> 8);
+                frame[n++] = static_cast<uint8_t>(packet_id & 0xFF);
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                std::memcpy(frame + n, parts[i].data, parts[i].length);
+                n += parts[i].length;
+            }
+            return n;
+        }
+
+        bool write_connect()
+        {
+            const char *id = m_config.client_id ? m_config.client_id : "";
+            const bool has_user = m_config.username && m_config.username[0];
+            const bool has_password = has_user && m_config.password && m_config.password[0];
+            const size_t id_length = std::strlen(id);
+            const size_t user_length = has_user ? std::strlen(m_config.username) : 0;
+            const size_t password_length = has_password ? std::strlen(m_config.password) : 0;
+
+            const size_t remaining = 10 + 2 + id_length + (has_user ? 2 + user_length : 0) +
+                                     (has_password ? 2 + password_length : 0);
+            if (1 + 4 + remaining > FrameBytes)
+            {
+                return false;
+            }
+
+            size_t n = 0;
+            m_tx[n++] = static_cast<uint8_t>(static_cast<uint8_t>(PacketType::CONNECT) << 4);
+            n += put_remaining_length(m_tx + n, remaining);
+            n += put_string(m_tx + n, "MQTT", 4);
+            m_tx[n++] = 4; // Protocol level 3.1.1
+            m_tx[n++] = static_cast<uint8_t>(0x02 | (has_user ? 0x80 : 0) | (has_password ? 0x40 : 0)); // Clean session
+            m_tx[n++] = static_cast<uint8_t>(m_config.keepalive_s >> 8);
+            m_tx[n++] = static_cast<uint8_t>(m_config.keepalive_s & 0xFF);
+            n += put_string(m_tx + n, id, id_length);
+            if (has_user)
+            {
+                n += put_string(m_tx + n, m_config.username, user_length);
+            }
+            if (has_password)
+            {
+                n += put_string(m_tx + n, m_config.password, password_length);
+            }
+            return write_frame(m_tx, n);
+        }
+
+        bool write_frame(const uint8_t *frame, size_t length)
+        {
+            if (m_client.write(frame, length) != length)
+            {
+                m_client.stop();
+                return false;
+            }
+            m_stats.frames_written++;
+            m_stats.bytes_written += length;
+            m_last_tx_ms = Clock::now_ms();
+            return true;
+        }
+
+        void reset_receiver()
+        {
+            m_rx_length = 0;
+            m_skip = 0;
+        }
+
+        // Drains the socket; false if the broker sent something that ends the session
+        bool receive()
+        {
+            uint8_t buffer[64];
+            int available;
+            while ((available = m_client.available()) > 0)
+            {
+                const size_t want = static_cast<size_t>(available) < sizeof(buffer) ? available : sizeof(buffer);
+                const int n = m_client.read(buffer, want);
+                if (n <= 0)
+                {
+                    break;
+                }
+                m_last_rx_ms = Clock::now_ms();
+                for (int i = 0; i < n; i++)
+                {
+                    if (!feed(buffer[i]))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Packets we act on are at most 5 bytes; anything longer (a stray PUBLISH) is skipped
+        bool feed(uint8_t byte)
+        {
+            if (m_skip > 0)
+            {
+                m_skip--;
+                return true;
+            }
+
+            m_rx[m_rx_length++] = byte;
+            if (m_rx_length < 2)
+            {
+                return true;
+            }
+
+            // Remaining length: up to four bytes with continuation bits
+            size_t remaining = 0, header = 1;
+            for (size_t shift = 0; header < m_rx_length; shift += 7)
+            {
+                const uint8_t digit = m_rx[header++];
+                remaining |= static_cast<size_t>(digit & 0x7F) << shift;
+                if (!(digit & 0x80))
+                {
+                    break;
+                }
+                if (header == m_rx_length)
+                {
+                    return header < 5; // Length still arriving; more than four bytes is malformed
+                }
+            }
+
+            if (header + remaining > sizeof(m_rx))
+            {
+                m_skip = header + remaining - m_rx_length;
+                m_rx_length = 0;
+                return true;
+            }
+            if (m_rx_length < header + remaining)
+            {
+                return true;
+            }
+
+            const bool keep = handle_packet(static_cast<PacketType>(m_rx[0] >> 4), m_rx + header, remaining);
+            m_rx_length = 0;
+            return keep;
+        }
+
+        bool handle_packet(PacketType type, const uint8_t *body, size_t length)
+        {
+            switch (type)
+            {
+            case PacketType::CONNACK:
+                m_connack_code = length >= 2 ? body[1] : 0xFF;
+                return m_connack_code == 0;
+            case PacketType::PUBACK:
+                if (length >= 2)
+                {
+                    on_puback(static_cast<uint16_t>((body[0] << 8) | body[1]));
+                }
+                return true;
+            case PacketType::PINGRESP:
+                m_ping_outstanding = false;
+                return true;
+            default:
+                return true;
+            }
+        }
+
+        void on_puback(uint16_t packet_id)
+        {
+            Slot *slot = find_in_flight(packet_id);
+            if (!slot)
+            {
+                return; // Late PUBACK for a message already acknowledged or dropped
+            }
+            m_in_flight_mask &= ~(1UL << (slot - m_slots));
+            const uint32_t rtt = Clock::now_ms() - slot->first_sent_ms;
+            m_stats.acked++;
+            m_stats.last_rtt_ms = rtt;
+            m_stats.max_rtt_ms = rtt > m_stats.max_rtt_ms ? rtt : m_stats.max_rtt_ms;
+            m_stats.total_rtt_ms += rtt;
+        }
+
+        Client &m_client;
+        SessionConfig m_config;
+        Slot m_slots[MaxWindow];
+        uint32_t m_in_flight_mask{0};
+        uint16_t m_packet_id{0};
+        uint8_t m_tx[FrameBytes]; // QoS 0 frames, CONNECT
+        uint8_t m_rx[8];
+        size_t m_rx_length{0};
+        size_t m_skip{0};
+        int m_connack_code{-1};
+        bool m_ping_outstanding{false};
+        uint32_t m_ping_sent_ms{0};
+        uint32_t m_last_tx_ms{0};
+        uint32_t m_last_rx_ms{0};
+        SessionStats m_stats;
+    };
+} // namespace pooaway::mqtt
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <IPAddress.h>
+#include <Preferences.h>
+
+namespace pooaway
+{
+    /**
+     * @brief Last good WiFi association and DNS answers, kept in NVS for fast reconnects
+     *
+     * With the BSSID and channel of the last access point, WiFiManager joins it directly
+     * instead of scanning every channel, and HTTP/MQTT connects skip the DNS round trip
+     * while a cached answer is fresh. Anything cached is only a hint: when a connect fails
+     * on it the caller takes the slow path, and a DNS answer that failed is forgotten. The
+     * blob is written only when the access point or an address changes, not on every refresh.
+     */
+    class NetworkCache
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x54454E50; // "PNET"
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t MAX_HOSTS = 4;
+        static constexpr size_t MAX_HOST_LENGTH = 31;
+
+        struct Association
+        {
+            uint8_t bssid[6];
+            uint8_t channel; // 0 = nothing cached
+            uint8_t reserved;
+            uint32_t ip;     // Last DHCP lease, 0 = none
+            uint32_t gateway;
+            uint32_t subnet;
+            uint32_t dns;
+        };
+
+        // Connect-to-first-byte of HTTP and MQTT connects, by how the address was found
+        struct FirstByteStats
+        {
+            uint32_t count{0};
+            uint64_t total_ms{0};
+            uint32_t max_ms{0};
+        };
+
+        struct Stats
+        {
+            uint32_t dns_hits{0};
+            uint32_t dns_misses{0};      // Resolved over the network
+            uint32_t dns_failures{0};
+            uint32_t stale_forgotten{0}; // Cached entries dropped after a failed connect
+            FirstByteStats first_byte_cached;
+            FirstByteStats first_byte_resolved;
+        };
+
+        static NetworkCache &instance();
+
+        NetworkCache(const NetworkCache &) = delete;
+        NetworkCache &operator=(const NetworkCache &) = delete;
+
+        bool get_association(Association &association) const;
+        void set_association(const Association &association);
+
+        /**
+         * @brief Address of host, from the cache while its TTL lasts, otherwise from DNS
+         * @param cached Set when the answer came from the cache
+         * @return false if the host could not be resolved
+         */
+        bool resolve(const char *host, IPAddress &address, bool &cached);
+
+        // Drop a cached answer that a connect just failed on
+        void forget_host(const char *host);
+
+        void record_first_byte(bool cached, unsigned long elapsed_ms);
+        const Stats &get_stats() const { return m_stats; }
+
+    private:
+        static constexpr char const *TAG = "NetworkCache";
+        static constexpr char const *KEY = "net";
+
+        struct HostEntry
+        {
+            char name[MAX_HOST_LENGTH + 1];
+            uint32_t address;
+            uint32_t expires_utc_s; // 0 if resolved before the clock was set
+        };
+
+        struct Blob
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t reserved;
+            Association association;
+            HostEntry hosts[MAX_HOSTS];
+            uint32_t crc; // CRC-32 of every byte above
+        };
+
+        NetworkCache();
+        void load();
+        void save();
+        HostEntry *find_host(const char *host);
+        bool is_fresh(size_t index) const;
+
+        Blob m_blob{};
+        unsigned long m_resolved_ms[MAX_HOSTS]{};
+        bool m_refreshed[MAX_HOSTS]{}; // Resolved since boot, not only restored from NVS
+        Preferences m_preferences;
+        Stats m_stats;
+    };
+} // namespace pooaway
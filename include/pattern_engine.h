@@ -0,0 +1,246 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Pure C++ (no Arduino dependencies) so tools/patterns checks the timing of the programs the firmware writes
+
+namespace pooaway::pattern
+{
+    // LEDC timers on the ESP32-C6: up to an 80 MHz source, a divider of at most 1023 and a
+    // counter of up to 20 bits
+    inline constexpr uint32_t LEDC_SOURCE_HZ = 80000000;
+    inline constexpr uint32_t LEDC_MAX_DIVIDER = 1023;
+    inline constexpr uint8_t LEDC_MAX_BITS = 20;
+    inline constexpr uint32_t LEDC_FADE_HZ = 5000; // Flicker-free PWM for steady levels and fades
+    inline constexpr uint8_t LEDC_FADE_BITS = 12;
+
+    // RMT transmit channels: one 48-symbol memory block, each symbol two (level, ticks) halves
+    inline constexpr uint32_t RMT_TICK_HZ = 1000000;
+    inline constexpr size_t RMT_MAX_SYMBOLS = 48;
+    inline constexpr uint16_t RMT_MAX_TICKS = 32767;
+
+    enum class LedMode : uint8_t
+    {
+        OFF,
+        BLINK
+    };
+
+    struct LedPattern
+    {
+        LedMode mode{LedMode::OFF};
+        uint16_t period_ms{0}; // BLINK: one on/off cycle; must divide 1000
+        uint8_t on_percent{0}; // BLINK: share of the cycle lit
+        uint16_t fade_ms{0};   // OFF: ramp down from full brightness
+
+        bool operator==(const LedPattern &other) const
+        {
+            return mode == other.mode && period_ms == other.period_ms && on_percent == other.on_percent &&
+                   fade_ms == other.fade_ms;
+        }
+        bool operator!=(const LedPattern &other) const { return !(*this == other); }
+    };
+
+    /**
+     * @brief LEDC settings that play a LedPattern without the CPU
+     *
+     * A blink is the PWM itself: the timer runs at the blink rate, so one PWM period is one
+     * blink and the duty cycle is the lit share. A fade runs the timer at LEDC_FADE_HZ and
+     * lets the hardware fader step the duty from fade_from to duty.
+     */
+    struct LedProgram
+    {
+        uint32_t frequency_hz{0};
+        uint8_t resolution_bits{0};
+        uint32_t duty{0};      // Where the output settles
+        uint32_t fade_from{0}; // Equal to duty when there is no ramp
+        uint16_t fade_ms{0};
+    };
+
+    struct ToneStep
+    {
+        uint16_t on_ms;
+        uint16_t off_ms;
+    };
+
+    inline constexpr size_t MAX_TONE_STEPS = 4;
+
+    // Beeps at one pitch, repeated until the next pattern; frequency 0 is silence
+    struct TonePattern
+    {
+        uint16_t frequency_hz{0};
+        uint8_t step_count{0};
+        ToneStep steps[MAX_TONE_STEPS]{};
+
+        bool operator==(const TonePattern &other) const
+        {
+            if (frequency_hz != other.frequency_hz || step_count != other.step_count)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < step_count; i++)
+            {
+                if (steps[i].on_ms != other.steps[i].on_ms || steps[i].off_ms != other.steps[i].off_ms)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        bool operator!=(const TonePattern &other) const { return !(*this == other); }
+    };
+
+    // Same bit layout as rmt_symbol_word_t: duration0:15, level0:1, duration1:15, level1:1
+    struct RmtSymbol
+    {
+        uint32_t value;
+
+        static constexpr RmtSymbol make(uint16_t duration0, bool level0, uint16_t duration1, bool level1)
+        {
+            return RmtSymbol{(duration0 & 0x7FFFU) | (static_cast<uint32_t>(level0) << 15) |
+                             (static_cast<uint32_t>(duration1 & 0x7FFFU) << 16) | (static_cast<uint32_t>(level1) << 31)};
+        }
+        constexpr uint16_t duration0() const { return value & 0x7FFFU; }
+        constexpr bool level0() const { return (value >> 15) & 1U; }
+        constexpr uint16_t duration1() const { return (value >> 16) & 0x7FFFU; }
+        constexpr bool level1() const { return value >> 31; }
+    };
+
+    /**
+     * @brief RMT settings that play a TonePattern without the CPU
+     *
+     * The carrier generator makes the pitch and the symbols gate it: a high half sounds, a low
+     * half is silent. The channel loops over the symbols in hardware until it is rewritten.
+     */
+    struct ToneProgram
+    {
+        uint32_t carrier_hz{0};
+        size_t symbol_count{0}; // 0: silence
+        RmtSymbol symbols[RMT_MAX_SYMBOLS]{};
+    };
+
+    // Smallest counter width that keeps the LEDC divider in range at this frequency
+    constexpr uint8_t ledc_resolution_bits(uint32_t frequency_hz)
+    {
+        uint8_t bits = 1;
+        while (bits < LEDC_MAX_BITS && LEDC_SOURCE_HZ / (frequency_hz << bits) > LEDC_MAX_DIVIDER)
+        {
+            bits++;
+        }
+        return bits;
+    }
+
+    /**
+     * @brief LEDC settings for pattern, taking over from previous
+     * @return false if the pattern cannot be played exactly (period not a divisor of 1 s)
+     */
+    inline bool compile(const LedPattern &pattern, const LedPattern &previous, LedProgram &program)
+    {
+        program = LedProgram{};
+        if (pattern.mode == LedMode::BLINK)
+        {
+            if (pattern.period_ms == 0 || pattern.period_ms > 1000 || 1000 % pattern.period_ms != 0 ||
+                pattern.on_percent > 100)
+            {
+                return false;
+            }
+            program.frequency_hz = 1000 / pattern.period_ms;
+            program.resolution_bits = ledc_resolution_bits(program.frequency_hz);
+            program.duty = static_cast<uint32_t>((uint64_t{1} << program.resolution_bits) * pattern.on_percent / 100);
+            program.fade_from = program.duty;
+            return true;
+        }
+
+        program.frequency_hz = LEDC_FADE_HZ;
+        program.resolution_bits = LEDC_FADE_BITS;
+        program.duty = 0;
+        // Whatever phase a blink was in, the ramp starts from full brightness
+        const bool was_lit = previous.mode == LedMode::BLINK;
+        program.fade_from = was_lit && pattern.fade_ms > 0 ? (1U << LEDC_FADE_BITS) - 1 : 0;
+        program.fade_ms = program.fade_from > 0 ? pattern.fade_ms : 0;
+        return true;
+    }
+
+    /**
+     * @brief RMT symbols for pattern
+     *
+     * Segments longer than RMT_MAX_TICKS are split. The halves are paired into symbols, and
+     * an odd count splits one more half, since a zero duration would end the transmission.
+     * @return false if the pattern needs more than RMT_MAX_SYMBOLS
+     */
+    inline bool compile(const TonePattern &pattern, ToneProgram &program)
+    {
+        program = ToneProgram{};
+        program.carrier_hz = pattern.frequency_hz;
+        if (pattern.step_count > MAX_TONE_STEPS)
+        {
+            return false;
+        }
+        if (pattern.frequency_hz == 0)
+        {
+            return true;
+        }
+
+        constexpr size_t MAX_HALVES = 2 * RMT_MAX_SYMBOLS;
+        constexpr uint32_t TICKS_PER_MS = RMT_TICK_HZ / 1000;
+        bool levels[MAX_HALVES]{};
+        uint16_t ticks[MAX_HALVES]{};
+        size_t halves = 0;
+        const auto append = [&](bool level, uint32_t segment_ticks)
+        {
+            const uint32_t pieces = (segment_ticks + RMT_MAX_TICKS - 1) / RMT_MAX_TICKS;
+            for (uint32_t i = 0; i < pieces; i++)
+            {
+                if (halves == MAX_HALVES)
+                {
+                    return false;
+                }
+                // Even split, the remainder spread over the first pieces
+                levels[halves] = level;
+                ticks[halves++] = static_cast<uint16_t>(segment_ticks / pieces + (i < segment_ticks % pieces ? 1 : 0));
+            }
+            return true;
+        };
+        for (size_t i = 0; i < pattern.step_count; i++)
+        {
+            if (!append(true, pattern.steps[i].on_ms * TICKS_PER_MS) ||
+                !append(false, pattern.steps[i].off_ms * TICKS_PER_MS))
+            {
+                return false;
+            }
+        }
+        if (halves == 0)
+        {
+            return true;
+        }
+
+        if (halves % 2 != 0)
+        {
+            if (halves == MAX_HALVES || ticks[halves - 1] < 2)
+            {
+                return false;
+            }
+            levels[halves] = levels[halves - 1];
+            ticks[halves] = ticks[halves - 1] / 2;
+            ticks[halves - 1] -= ticks[halves];
+            halves++;
+        }
+
+        for (size_t i = 0; i < halves; i += 2)
+        {
+            program.symbols[program.symbol_count++] = RmtSymbol::make(ticks[i], levels[i], ticks[i + 1], levels[i + 1]);
+        }
+        return true;
+    }
+
+    // What the alert LED and buzzer play; tools/patterns checks these exact patterns
+    inline constexpr LedPattern LED_CLEAR{LedMode::OFF, 0, 0, 400};
+    inline constexpr LedPattern LED_ALERT{LedMode::BLINK, 1000, 50, 0};       // One sensor
+    inline constexpr LedPattern LED_MULTI_ALERT{LedMode::BLINK, 250, 50, 0};  // More than one
+    inline constexpr TonePattern TONE_SILENT{};
+
+    // A double beep every second, pitched by the sensor that alerted first
+    constexpr TonePattern alert_tone(size_t sensor_index)
+    {
+        return TonePattern{static_cast<uint16_t>(2000 + 200 * sensor_index), 2, {{100, 100}, {100, 700}}};
+    }
+} // namespace pooaway::pattern
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "pattern_engine.h"
+
+namespace pooaway::pattern
+{
+    /**
+     * @brief Plays LedPatterns on an LEDC channel
+     *
+     * A pattern reaches the peripheral only when it differs from the one playing, so the
+     * periodic alert refresh costs a comparison. Between changes the LED runs on its own.
+     */
+    class LedPlayer
+    {
+    public:
+        bool begin(uint8_t pin);
+        bool play(const LedPattern &pattern); // false if it could not be programmed
+        uint32_t get_programs() const { return m_programs; }
+
+    private:
+        static constexpr char const *TAG = "LedPlayer";
+
+        uint8_t m_pin{0};
+        bool m_attached{false};
+        LedPattern m_current{};
+        uint32_t m_programs{0};
+    };
+
+    /**
+     * @brief Plays TonePatterns on an RMT transmit channel with its carrier as the pitch
+     *
+     * The symbols stay in this object while the channel loops over them.
+     */
+    class TonePlayer
+    {
+    public:
+        bool begin(uint8_t pin);
+        bool play(const TonePattern &pattern); // false if it could not be programmed
+        uint32_t get_programs() const { return m_programs; }
+
+    private:
+        static constexpr char const *TAG = "TonePlayer";
+
+        uint8_t m_pin{0};
+        bool m_ready{false};
+        TonePattern m_current{};
+        rmt_data_t m_symbols[RMT_MAX_SYMBOLS]{};
+        uint32_t m_programs{0};
+    };
+} // namespace pooaway::pattern
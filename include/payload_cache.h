@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ArduinoJson.h>
+
+// Only depends on ArduinoJson so tools/payloads can benchmark the same encoders on the host
+
+namespace pooaway::alert
+{
+    // Wire formats derived from the telemetry document, one payload per sensor each
+    enum class PayloadFormat : uint8_t
+    {
+        SENSOR_JSON,       // MQTT <prefix>/sensors/<name> message
+        THINGSPEAK_UPDATE, // One element of a ThingSpeak bulk_update "updates" array
+        COUNT
+    };
+
+    // Read-only view of an encoded payload; NUL-terminated, valid until the next reset()
+    struct PayloadView
+    {
+        const char *data{nullptr};
+        size_t length{0};
+
+        bool empty() const { return length == 0; }
+    };
+
+    /**
+     * @brief Encoded payloads of one telemetry document, shared by every publisher of a cycle
+     *
+     * AlertManager resets the cache whenever it rebuilds the telemetry document. A payload is
+     * serialized the first time a publisher asks for it and served from the buffer to every
+     * later caller of the same cycle, so each format is encoded at most once however many
+     * publishers use it, and formats nobody asks for are never encoded. Publishers only add
+     * their framing (topic, API key) around the shared bytes and must not hold a view past
+     * their call. A payload that does not fit the remaining buffer is reported as empty and
+     * counted. Not thread-safe; publishers run in the main loop.
+     */
+    class PayloadCache
+    {
+    public:
+        static constexpr size_t MAX_SENSORS = 32; // Matches SensorManager::MAX_CHANNELS
+        static constexpr size_t TIMESTAMP_SIZE = 20; // "YYYY-MM-DD HH:MM:SS"
+
+        struct Stats
+        {
+            size_t capacity{0};
+            size_t peak_used{0};
+            uint32_t cycles{0};
+            uint32_t encodes{0};      // Payloads serialized
+            uint32_t reuses{0};       // Requests served from an earlier encode in the same cycle
+            uint32_t overflows{0};    // Payloads that did not fit the buffer
+            uint64_t bytes_encoded{0};
+            uint64_t bytes_reused{0}; // Serialization work saved by sharing
+        };
+
+        /**
+         * @param storage Buffer the payloads are written to, reused every cycle
+         * @param scratch Allocator for the short-lived document each encode builds
+         */
+        PayloadCache(char *storage, size_t capacity,
+                     ArduinoJson::Allocator *scratch = ArduinoJson::detail::DefaultAllocator::instance())
+            : m_storage(storage), m_scratch(scratch)
+        {
+            m_stats.capacity = capacity;
+        }
+
+        PayloadCache(const PayloadCache &) = delete;
+        PayloadCache &operator=(const PayloadCache &) = delete;
+
+        /**
+         * @brief Start a cycle for a freshly built telemetry document
+         * @param created_at Local time of the sample for ThingSpeak, or "" while the clock is unset,
+         *        in which case ThingSpeak stamps each update when it arrives
+         */
+        void reset(const JsonDocument &telemetry, const char *created_at)
+        {
+            m_sensors = telemetry["sensors"].as<JsonArrayConst>();
+            std::strncpy(m_created_at, created_at ? created_at : "", sizeof(m_created_at) - 1);
+            m_created_at[sizeof(m_created_at) - 1] = '\0';
+            m_used = 0;
+            for (auto &format : m_entries)
+            {
+                std::fill(std::begin(format), std::end(format), Entry{});
+            }
+            m_stats.cycles++;
+        }
+
+        size_t sensor_count() const { return std::min(m_sensors.size(), MAX_SENSORS); }
+        JsonObjectConst sensor(size_t index) const { return m_sensors[index].as<JsonObjectConst>(); }
+
+        // Payload of one sensor in one format, encoded on the first request of the cycle
+        PayloadView get(PayloadFormat format, size_t index)
+        {
+            if (format >= PayloadFormat::COUNT || index >= sensor_count())
+            {
+                return {};
+            }
+
+            Entry &entry = m_entries[static_cast<size_t>(format)][index];
+            if (entry.state == State::EMPTY)
+            {
+                encode(format, index, entry);
+            }
+            else if (entry.state == State::READY)
+            {
+                m_stats.reuses++;
+                m_stats.bytes_reused += entry.length;
+            }
+
+            if (entry.state != State::READY)
+            {
+                return {};
+            }
+            return PayloadView{m_storage + entry.offset, entry.length};
+        }
+
+        const Stats &get_stats() const { return m_stats; }
+        size_t get_used() const { return m_used; }
+
+        // Per-sensor MQTT message: flattened readings and calibration, diagnostics when present
+        static void build_sensor_json(JsonObjectConst sensor, JsonObject doc)
+        {
+            doc["sensor"] = sensor["name"].as<const char *>();
+            doc["model"] = sensor["model"].as<const char *>();
+
+            const auto readings = sensor["readings"].as<JsonObjectConst>();
+            doc["ppm"] = readings["value"].as<float>();
+            doc["baseline_ppm"] = readings["baseline"].as<float>();
+            doc["voltage"] = readings["voltage"].as<float>();
+            doc["rs"] = readings["rs"].as<float>();
+            doc["r0"] = readings["r0"].as<float>();
+            doc["ratio"] = readings["ratio"].as<float>();
+            doc["alert"] = sensor["alert"].as<bool>();
+
+            const auto cal = sensor["calibration"].as<JsonObjectConst>();
+            doc["preheating_time"] = cal["preheating_time"].as<int>();
+            doc["cal_a"] = cal["a"].as<float>();
+            doc["cal_b"] = cal["b"].as<float>();
+
+            // Present once per AlertManager diagnostics interval
+            const auto diagnostics = sensor["diagnostics"];
+            if (diagnostics.is<JsonObjectConst>())
+            {
+                doc["diagnostics"] = diagnostics;
+            }
+        }
+
+        // ThingSpeak channel update: field1..field8 in the order the channels were set up with.
+        // Without created_at the server stamps the update on receipt, off by the upload delay
+        static void build_thingspeak_update(JsonObjectConst sensor, const char *created_at, JsonObject doc)
+        {
+            const auto readings = sensor["readings"].as<JsonObjectConst>();
+            if (created_at && created_at[0])
+            {
+                doc["created_at"] = created_at;
+            }
+            doc["field1"] = readings["value"].as<float>();
+            doc["field2"] = readings["baseline"].as<float>();
+            doc["field3"] = readings["voltage"].as<float>();
+            doc["field4"] = readings["rs"].as<float>();
+            doc["field5"] = readings["r0"].as<float>();
+            doc["field6"] = readings["ratio"].as<float>();
+            doc["field7"] = sensor["alert"].as<bool>();
+            doc["field8"] = sensor["calibration"]["preheating_time"].as<int>();
+        }
+
+    private:
+        enum class State : uint8_t
+        {
+            EMPTY,
+            READY,
+            FAILED // No room; not retried until the next cycle
+        };
+
+        struct Entry
+        {
+            uint32_t offset{0};
+            uint32_t length{0};
+            State state{State::EMPTY};
+        };
+
+        void encode(PayloadFormat format, size_t index, Entry &entry)
+        {
+            entry.state = State::FAILED;
+
+            JsonDocument doc(m_scratch);
+            const JsonObjectConst sensor = this->sensor(index);
+            if (format == PayloadFormat::SENSOR_JSON)
+            {
+                build_sensor_json(sensor, doc.to<JsonObject>());
+            }
+            else
+            {
+                build_thingspeak_update(sensor, m_created_at, doc.to<JsonObject>());
+            }
+
+            // Serialized straight into the free space; a result that fills it was truncated
+            const size_t room = m_stats.capacity - m_used;
+            const size_t length = serializeJson(doc, m_storage + m_used, room);
+            if (length == 0 || length >= room)
+            {
+                m_stats.overflows++;
+                return;
+            }
+
+            entry.offset = static_cast<uint32_t>(m_used);
+            entry.length = static_cast<uint32_t>(length);
+            entry.state = State::READY;
+            m_used += length + 1;
+            m_stats.peak_used = std::max(m_stats.peak_used, m_used);
+            m_stats.encodes++;
+            m_stats.bytes_encoded += length;
+        }
+
+        char *m_storage;
+        ArduinoJson::Allocator *m_scratch;
+        size_t m_used{0};
+        JsonArrayConst m_sensors;
+        char m_created_at[TIMESTAMP_SIZE]{};
+        Entry m_entries[static_cast<size_t>(PayloadFormat::COUNT)][MAX_SENSORS]{};
+        Stats m_stats;
+    };
+} // namespace pooaway::alert
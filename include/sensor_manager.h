@@ -5,31 +5,95 @@
 #include "sensors/base_sensor.h"
 #include "sensors/nh3_sensor.h"
 #include "sensors/ch4_sensor.h"
+#include "sensors/analog_mux.h"
 #include "sensors/sensor_types.h"
 
 namespace pooaway::sensors
 {
     class SensorManager
     {
+    public:
+        static constexpr size_t MAX_CHANNELS = 32;
+
+        // Throughput figures for the channel scan, refreshed after every full pass
+        struct ScanStats
+        {
+            uint32_t completed_scans{0};
+            uint32_t channel_reads{0};
+            uint32_t failed_reads{0}; // Reads that returned a failure, also counted per sensor
+            uint32_t last_scan_us{0};
+            uint32_t max_scan_us{0};
+            uint64_t total_scan_us{0};
+        };
+
     private:
         static constexpr char const *TAG = "SensorManager";
-        static constexpr size_t MAX_SENSORS = SENSOR_COUNT;
 
-        std::array<BaseSensor *, MAX_SENSORS> m_sensors{};
-        std::unique_ptr<NH3Sensor> m_nh3_sensor;
-        std::unique_ptr<CH4Sensor> m_ch4_sensor;
-        Preferences m_preferences;
+        // Hot per-channel scan state, packed so a full scan walks one contiguous array
+        struct ChannelSlot
+        {
+            BaseSensor *sensor{nullptr};
+            uint32_t settle_us{0};
+            uint8_t mux_channel{AnalogMux::NO_CHANNEL};
+            bool alert{false};
+        };
+
+        std::array<ChannelSlot, MAX_CHANNELS> m_channels{};
+        std::array<std::unique_ptr<BaseSensor>, MAX_CHANNELS> m_owned_sensors{};
+        size_t m_channel_count{0};
+
+        AnalogMux m_mux;
+        size_t m_scan_cursor{0};
+        unsigned long m_select_time_us{0};
+        uint32_t m_settle_remaining_us{0};
+        unsigned long m_scan_start_us{0};
+        unsigned long m_edge_us{0};
+        bool m_edge_in_scan{false};
+        ScanStats m_scan_stats;
+        unsigned long m_last_snapshot_ms{0};
+        Preferences m_preferences; // Legacy per-name R0 keys, read once for migration
+
+        bool m_initialized{false}; // Set by init(); the channel set is fixed from then on
 
         SensorManager();
 
+        bool uses_mux() const;
+        void select_channel_blocking(const ChannelSlot &slot);
+        void register_mux_channels();
+        bool restore_channel(size_t index);
+        void snapshot_baselines();
+
     public:
         static SensorManager &instance();
 
+        /**
+         * @brief Register a sensor as a scan channel; refused once init() has run, since init()
+         *        is what preheats, restores and calibrates the channels
+         * @param sensor Sensor instance; ownership moves to the manager
+         * @param mux_channel Mux input the sensor is wired to, or AnalogMux::NO_CHANNEL
+         * @param settle_us Time to wait after switching the mux before sampling
+         * @return Channel index, or -1 after init() or when all MAX_CHANNELS slots are taken
+         */
+        int register_channel(std::unique_ptr<BaseSensor> sensor,
+                             uint8_t mux_channel = AnalogMux::NO_CHANNEL,
+                             uint32_t settle_us = 0);
+
+        // Expects StateStore::load() to have run so channels can warm-start
         void init();
         void update();
+
+        // Non-zero when update() stopped at a mux input still settling: call again after this long
+        uint32_t get_settle_remaining_us() const { return m_settle_remaining_us; }
         void perform_clean_air_calibration();
         void run_diagnostics();
 
+        size_t get_channel_count() const { return m_channel_count; }
+        BaseSensor *get_channel(size_t index);
+        bool get_channel_alert(size_t index) const;
+        // micros() at the first read of the latest scan with an edge that started or cleared an alert
+        unsigned long get_edge_us() const { return m_edge_us; }
+        const ScanStats &get_scan_stats() const { return m_scan_stats; }
+
         float get_sensor_value(SensorType type) const;
         bool get_alert_status(SensorType type) const;
         BaseSensor *get_sensor(SensorType type);
@@ -39,4 +103,4 @@ namespace pooaway::sensors
         SensorManager(const SensorManager &) = delete;
         SensorManager &operator=(const SensorManager &) = delete;
     };
-} // namespace pooaway::sensors
\ No newline at end of file
+} // namespace pooaway::sensors
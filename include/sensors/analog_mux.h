@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pooaway::sensors
+{
+    /**
+     * @brief Driver for a CD74HC4067-style analog multiplexer
+     *
+     * Up to four select lines address 16 inputs that all share a single ADC pin (COM).
+     * The optional enable line is active-low; pass -1 when it is tied to ground.
+     */
+    class AnalogMux
+    {
+    public:
+        static constexpr size_t MAX_SELECT_PINS = 4;
+        static constexpr uint8_t NO_CHANNEL = 0xFF; // Sensor is wired directly to its ADC pin
+
+        AnalogMux(const std::array<int, MAX_SELECT_PINS> &select_pins, int enable_pin);
+
+        void init();
+
+        /**
+         * @brief Route a mux input to COM
+         * @return true if the select lines changed, i.e. the caller must wait for settling
+         */
+        bool select(uint8_t channel);
+        uint8_t get_selected() const { return m_selected; }
+        static constexpr uint8_t get_channel_count() { return 1U << MAX_SELECT_PINS; }
+
+    private:
+        static constexpr char const *TAG = "AnalogMux";
+
+        const std::array<int, MAX_SELECT_PINS> m_select_pins;
+        const int m_enable_pin;
+        uint8_t m_selected{NO_CHANNEL};
+    };
+} // namespace pooaway::sensors
@@ -1,5 +1,8 @@
 #pragma once
 #include "sensors/interfaces.h"
+#include "sensors/sensor_diagnostics.h"
+#include "sensors/p2_quantile.h"
+#include "sensors/change_detector.h"
 #include "esp_log.h"
 #include "config.h"
 
@@ -30,13 +33,22 @@ namespace pooaway::sensors
         const float m_coeff_b;
 
         float m_value{0.0F};
+        float m_last_raw{0.0F};
         float m_r0{0.0F};
         bool m_needs_calibration{true};
         bool m_alerts_enabled{false};
         bool m_first_reading{true};
         float m_baseline_ema{0.0F};
-        mutable unsigned long m_detect_start{0UL};
+        mutable ThresholdDetector m_threshold;
+        CusumDetector m_cusum;
+        AlertEngine m_alert_engine{AlertEngine::THRESHOLD};
         bool m_low_power_mode{false};
+        SensorDiagnostics m_diagnostics;
+
+        // Background R0 tracking: quantile of Rs on the clean-air side of the curve
+        P2Quantile m_clean_air_rs;
+        unsigned long m_epoch_start_ms{0};
+        unsigned long m_last_r0_sample_ms{0};
 
         virtual bool validate_reading(float raw_value) const = 0;
         virtual float calculate_ppm(float raw_value) const = 0;
@@ -52,10 +64,16 @@ namespace pooaway::sensors
 
         // ISensor interface
         void init() override;
-        void read() override;
+        Result read() override;
         float get_value() const override { return m_value; }
         bool check_alert() const override;
         const char *get_name() const override { return m_name; }
+        const char *get_model() const { return m_model; }
+        float get_baseline() const { return m_baseline_ema; }
+        float get_last_raw() const { return m_last_raw; } // ADC counts of the latest read(), valid or not
+        float get_preheating_time() const { return m_preheating_time; }
+        float get_coeff_a() const { return m_coeff_a; }
+        float get_coeff_b() const { return m_coeff_b; }
 
         // Sensor reading getters
         virtual float get_voltage() const { return 0.0f; } // Default implementation
@@ -63,10 +81,10 @@ namespace pooaway::sensors
         float get_r0() const { return m_r0; }              // Concrete implementation
 
         // ICalibration interface
-        void calibrate() override;
+        Result calibrate() override;
         void set_r0(float r0) override { m_r0 = r0; }
         bool validate_r0(float r0) const override = 0;
-        void run_self_test() override;
+        Result run_self_test() override;
 
         // ISensorReading interface
         float read_raw() const override;
@@ -76,5 +94,26 @@ namespace pooaway::sensors
         void exit_low_power() override;
 
         bool needs_calibration() const { return m_needs_calibration; }
+        void set_alert_engine(AlertEngine engine) { m_alert_engine = engine; }
+        AlertEngine get_alert_engine() const { return m_alert_engine; }
+        const SensorDiagnostics &get_diagnostics() const { return m_diagnostics; }
+        // Called by SensorManager on each rising alert edge
+        void record_alert() { m_diagnostics.record_alert(); }
+
+        /**
+         * @brief Feed the clean-air Rs estimator and apply a bounded R0 correction once per epoch
+         *
+         * Uses the Rs of the latest read(), so it costs no extra ADC sampling.
+         * @return true if R0 changed and should be persisted
+         */
+        bool track_r0(unsigned long now);
+
+        /**
+         * @brief Warm-start from persisted state instead of calibrating and re-learning the baseline
+         * @param r0 Saved R0, ignored if it fails validate_r0()
+         * @param baseline Saved EMA baseline, ignored if not positive
+         * @return true if R0 was accepted
+         */
+        bool restore_state(float r0, float baseline);
     };
 }
\ No newline at end of file
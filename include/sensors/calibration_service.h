@@ -1,46 +1,86 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include "sensors/interfaces.h"
-#include <vector>
+#include "sensors/convergence_window.h"
+#include "config.h"
 
 namespace pooaway::sensors
 {
+    struct CalibrationResult
+    {
+        float r0{0.0F};             // Mean Rs over the final window
+        float confidence{0.0F};     // 1 for a flat signal, 0.5 at the acceptance limits, 0 at twice them
+        float spread{0.0F};         // Relative standard deviation of Rs over the final window
+        float trend_per_s{0.0F};    // Relative Rs slope over the final window
+        uint16_t samples{0};        // ADC reads taken
+        uint16_t invalid{0};        // Reads rejected by the sensor
+        unsigned long elapsed_ms{0};
+        bool converged{false};      // Only a converged result may be used as R0
+    };
+
+    /**
+     * @brief Clean-air R0 from Rs, sampled until the signal has settled
+     *
+     * Samples every config::calibration::CONVERGE_SAMPLE_MS and stops as soon as the
+     * last CONVERGE_WINDOW readings of Rs are both quiet (relative spread) and flat
+     * (relative trend), so a settled sensor finishes in well under a second. A sensor still
+     * drifting after preheat does not converge before CONVERGE_MAX_MS and is refused, rather
+     * than averaged into an R0 that is wrong from the start.
+     */
     class CalibrationService
     {
     public:
-        static constexpr int CALIBRATION_SAMPLES = 10;
-
-        static float calibrate_sensor(BaseSensor &sensor, int samples)
+        static CalibrationResult calibrate_sensor(BaseSensor &sensor)
         {
-            std::vector<float> readings;
-            readings.reserve(samples);
+            namespace cfg = config::calibration;
+            ConvergenceWindow<cfg::CONVERGE_WINDOW> window;
+            CalibrationResult result;
+            float score = INFINITY;
 
-            // Take multiple readings
-            for (int i = 0; i < samples; i++)
+            const unsigned long start = millis();
+            while (true)
             {
                 const float raw_value = sensor.read_raw();
-                if (!sensor.validate_reading(raw_value))
+                result.samples++;
+                const float rs = sensor.validate_reading(raw_value)
+                                     ? sensor.calculate_rs(raw_value * (BaseSensor::VCC / static_cast<float>(BaseSensor::ADC_RESOLUTION)))
+                                     : 0.0F;
+                if (rs > 0.0F)
                 {
-                    continue;
+                    window.add(static_cast<float>(millis() - start) / 1000.0F, rs);
+                }
+                else
+                {
+                    result.invalid++;
                 }
 
-                const float rs = sensor.calculate_rs(raw_value);
-                readings.push_back(rs);
-                delay(100); // Small delay between readings
-            }
-
-            if (readings.empty())
-            {
-                return 0.0F;
-            }
-
-            // Calculate average R0
-            float sum = 0.0F;
-            for (float reading : readings)
-            {
-                sum += reading;
+                result.elapsed_ms = millis() - start;
+                if (window.full())
+                {
+                    result.r0 = window.mean();
+                    result.spread = window.relative_spread();
+                    result.trend_per_s = window.relative_trend();
+                    score = std::max(result.spread / cfg::CONVERGE_MAX_SPREAD,
+                                     std::fabs(result.trend_per_s) / cfg::CONVERGE_MAX_TREND_PER_S);
+                    if (score <= 1.0F)
+                    {
+                        result.converged = true;
+                        break;
+                    }
+                }
+                if (result.elapsed_ms >= cfg::CONVERGE_MAX_MS)
+                {
+                    break;
+                }
+                delay(cfg::CONVERGE_SAMPLE_MS);
             }
 
-            return sum / static_cast<float>(readings.size());
+            // Rejected reads lower the confidence in proportion, even when the valid ones agree
+            const float valid_ratio = static_cast<float>(result.samples - result.invalid) / static_cast<float>(result.samples);
+            result.confidence = std::min(std::max(1.0F - score / 2.0F, 0.0F), 1.0F) * valid_ratio;
+            return result;
         }
     };
-} // namespace pooaway::sensors
\ No newline at end of file
+} // namespace pooaway::sensors
@@ -23,8 +23,8 @@ namespace pooaway::sensors
         void set_r0(float r0) override;
 
     public:
-        CH4Sensor(int pin)
-            : BaseSensor("GM-402B", "POO", pin,
+        explicit CH4Sensor(int pin, const char *name = "POO")
+            : BaseSensor("GM-402B", name, pin,
                          0.05F,   // alpha (faster response)
                          0.4F,    // tolerance
                          30.0F,   // preheating time (30s)
@@ -32,6 +32,7 @@ namespace pooaway::sensors
                          26.572F, // coeff a
                          1.2894F) // coeff b
         {
+            set_alert_engine(config::detection::CH4_USE_CUSUM ? AlertEngine::CUSUM : AlertEngine::THRESHOLD);
         }
         float get_voltage() const override;
         float get_rs() const override;
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Pure C++ (no Arduino dependencies) so tools/replay can run the exact firmware detectors on recorded traces
+
+namespace pooaway::sensors
+{
+    enum class AlertEngine : uint8_t
+    {
+        THRESHOLD, // |value - baseline| > tolerance * baseline held for min_detect_ms
+        CUSUM      // One-sided CUSUM on the noise-normalized residual
+    };
+
+    /**
+     * @brief The original alert rule: relative deviation from baseline, held for a minimum time
+     */
+    class ThresholdDetector
+    {
+    public:
+        ThresholdDetector(float tolerance, unsigned long min_detect_ms)
+            : m_tolerance(tolerance), m_min_detect_ms(min_detect_ms) {}
+
+        bool update(unsigned long now_ms, float value, float baseline)
+        {
+            const float deviation = std::fabs(value - baseline);
+            if (deviation <= m_tolerance * baseline)
+            {
+                m_exceeded = false;
+                return false;
+            }
+
+            if (!m_exceeded)
+            {
+                m_exceeded = true;
+                m_detect_start = now_ms;
+            }
+            return (now_ms - m_detect_start) >= m_min_detect_ms;
+        }
+
+        // Deviation currently above tolerance, whether or not the hold time has passed
+        bool is_exceeded() const { return m_exceeded; }
+        void reset() { m_exceeded = false; }
+
+    private:
+        float m_tolerance;
+        unsigned long m_min_detect_ms;
+        unsigned long m_detect_start{0};
+        bool m_exceeded{false};
+    };
+
+    struct CusumParams
+    {
+        float drift_k{0.75F};         // Allowance per sample, in noise sigmas
+        float threshold_h{10.0F};     // Alarm when the statistic exceeds this many sigmas
+        float noise_alpha{0.01F};     // EW weight of the residual variance estimate
+        float min_sigma_ratio{0.02F}; // Noise floor as a fraction of the baseline
+        float max_step{4.0F};         // Per-sample cap on z, so one glitch cannot reach h
+    };
+
+    /**
+     * @brief Sequential change detector for an upward shift of value over baseline
+     *
+     * Accumulates S = max(0, S + r/sigma - k) over the residual r = value - baseline and
+     * alarms once S > h; sigma is an exponentially weighted estimate of the residual noise,
+     * learned over a warm-up of 1/noise_alpha samples and afterwards only while quiet. Each
+     * sample adds at most max_step sigmas, so single-sample ADC glitches cannot alarm. S is
+     * clamped at 2h so the alarm clears within 2h/k quiet samples after the gas is gone.
+     * State is a few words per sensor.
+     */
+    class CusumDetector
+    {
+    public:
+        explicit CusumDetector(const CusumParams &params = CusumParams{}) : m_params(params) {}
+
+        bool update(float value, float baseline)
+        {
+            const float residual = value - baseline;
+
+            // Learn the noise level first; until then sigma is unknown and alarms would be noise
+            if (m_warmup < warmup_samples())
+            {
+                m_variance += (residual * residual - m_variance) / static_cast<float>(++m_warmup);
+                return false;
+            }
+
+            const float floor = std::max(m_params.min_sigma_ratio * std::fabs(baseline), 1e-6F);
+            const float sigma = std::max(std::sqrt(m_variance), floor);
+            const float z = std::min(residual / sigma, m_params.max_step);
+
+            m_statistic = std::min(std::max(0.0F, m_statistic + z - m_params.drift_k), 2.0F * m_params.threshold_h);
+
+            if (!m_alarm && m_statistic > m_params.threshold_h)
+            {
+                m_alarm = true;
+            }
+            else if (m_alarm && m_statistic <= 0.0F)
+            {
+                m_alarm = false;
+            }
+
+            // Keep tracking the noise only from quiet samples, so gas does not inflate sigma
+            if (!m_alarm && std::fabs(residual) < 3.0F * sigma)
+            {
+                m_variance += m_params.noise_alpha * (residual * residual - m_variance);
+            }
+            return m_alarm;
+        }
+
+        bool in_alarm() const { return m_alarm; }
+        // Statistic has left zero, i.e. evidence of a shift is accumulating
+        bool is_accumulating() const { return m_statistic > 0.0F; }
+        float get_statistic() const { return m_statistic; }
+        float get_sigma() const { return std::sqrt(m_variance); }
+
+        void reset()
+        {
+            m_statistic = 0.0F;
+            m_alarm = false;
+        }
+
+    private:
+        uint32_t warmup_samples() const { return static_cast<uint32_t>(1.0F / m_params.noise_alpha); }
+
+        CusumParams m_params;
+        float m_statistic{0.0F};
+        float m_variance{0.0F};
+        uint32_t m_warmup{0};
+        bool m_alarm{false};
+    };
+} // namespace pooaway::sensors
@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace pooaway::sensors
+{
+    /**
+     * @brief The last N samples of a signal, scored for how settled it is
+     *
+     * Spread is the coefficient of variation and trend the least-squares slope relative to
+     * the mean, so both are dimensionless and one threshold fits every sensor and load
+     * resistor. Samples carry their own time, so a slow ADC read does not skew the slope.
+     * Everything is recomputed from the window on demand; N is small.
+     */
+    template <size_t N>
+    class ConvergenceWindow
+    {
+        static_assert(N >= 3, "A trend needs at least three samples");
+
+    public:
+        void add(float t_s, float value)
+        {
+            m_times[m_next] = t_s;
+            m_values[m_next] = value;
+            m_next = (m_next + 1) % N;
+            m_count = m_count < N ? m_count + 1 : N;
+        }
+
+        void reset()
+        {
+            m_next = 0;
+            m_count = 0;
+        }
+
+        bool full() const { return m_count == N; }
+        size_t size() const { return m_count; }
+
+        float mean() const
+        {
+            float sum = 0.0F;
+            for (size_t i = 0; i < m_count; i++)
+            {
+                sum += m_values[i];
+            }
+            return m_count > 0 ? sum / static_cast<float>(m_count) : 0.0F;
+        }
+
+        // Sample standard deviation over the mean
+        float relative_spread() const
+        {
+            const float average = mean();
+            if (m_count < 2 || average <= 0.0F)
+            {
+                return INFINITY;
+            }
+
+            float m2 = 0.0F;
+            for (size_t i = 0; i < m_count; i++)
+            {
+                const float delta = m_values[i] - average;
+                m2 += delta * delta;
+            }
+            return std::sqrt(m2 / static_cast<float>(m_count - 1)) / average;
+        }
+
+        // Least-squares slope over the mean: relative change per second
+        float relative_trend() const
+        {
+            const float average = mean();
+            if (m_count < 3 || average <= 0.0F)
+            {
+                return INFINITY;
+            }
+
+            float t_mean = 0.0F;
+            for (size_t i = 0; i < m_count; i++)
+            {
+                t_mean += m_times[i];
+            }
+            t_mean /= static_cast<float>(m_count);
+
+            float covariance = 0.0F;
+            float t_variance = 0.0F;
+            for (size_t i = 0; i < m_count; i++)
+            {
+                const float dt = m_times[i] - t_mean;
+                covariance += dt * (m_values[i] - average);
+                t_variance += dt * dt;
+            }
+            return t_variance > 0.0F ? covariance / t_variance / average : INFINITY;
+        }
+
+    private:
+        std::array<float, N> m_times{};
+        std::array<float, N> m_values{};
+        size_t m_next{0};
+        size_t m_count{0};
+    };
+} // namespace pooaway::sensors
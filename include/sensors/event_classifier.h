@@ -0,0 +1,260 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Pure C++ (no Arduino dependencies) so tools/replay can train and score the exact firmware classifier
+
+namespace pooaway::sensors
+{
+    enum class EventClass : uint8_t
+    {
+        URINE, // NH3-led: strong NH3 rise, little CH4
+        FECES, // CH4-led, NH3 following later and weaker
+        SPRAY, // Cleaning spray or other VOC: both sensors at once, fast rise and decay
+        COUNT
+    };
+
+    inline const char *to_string(EventClass event_class)
+    {
+        switch (event_class)
+        {
+        case EventClass::URINE:
+            return "urine";
+        case EventClass::FECES:
+            return "feces";
+        case EventClass::SPRAY:
+            return "spray";
+        default:
+            return "unknown";
+        }
+    }
+
+    // Features of one event in Q8.8; see EventFeatureExtractor::finish() for their definitions
+    enum EventFeature : uint8_t
+    {
+        NH3_PEAK,      // Peak relative excess over the pre-event reference
+        CH4_PEAK,
+        NH3_RISE,      // Peak excess per second from onset to peak
+        CH4_RISE,
+        ONSET_LAG,     // CH4 onset minus NH3 onset, in units of 8 s
+        CO_OCCURRENCE, // min(NH3_PEAK, CH4_PEAK): both sensors responding
+        DURATION,      // Event duration, in units of 8 min
+        FEATURE_COUNT
+    };
+
+    constexpr int FEATURE_FRACTION_BITS = 8;
+    constexpr int32_t FEATURE_ONE = 1 << FEATURE_FRACTION_BITS;
+    constexpr int32_t FEATURE_LIMIT = 16 * FEATURE_ONE; // Features are clamped to +-16
+    constexpr int32_t WEIGHT_LIMIT = 32 * FEATURE_ONE;  // Keeps the dot product inside int32
+
+    using EventFeatures = std::array<int16_t, FEATURE_COUNT>;
+
+    /**
+     * @brief Linear model over the event features, one row per class
+     *
+     * Weights are Q8.8 and biases Q16.16, so a score is bias + sum(weight * feature) in
+     * Q16.16 with plain 32-bit integer arithmetic; the C6 has no FPU. With |weight| <= 32 and
+     * |feature| <= 16 each product stays below 2^25.
+     */
+    struct EventModel
+    {
+        std::array<std::array<int16_t, FEATURE_COUNT>, static_cast<size_t>(EventClass::COUNT)> weights;
+        std::array<int32_t, static_cast<size_t>(EventClass::COUNT)> biases;
+    };
+
+    struct EventClassification
+    {
+        EventClass event_class{EventClass::COUNT};
+        int32_t margin{0}; // Top score minus runner-up, Q16.16; the log-odds between the two for a logistic model
+
+        float margin_f() const { return static_cast<float>(margin) / static_cast<float>(FEATURE_ONE * FEATURE_ONE); }
+    };
+
+    // Integer-only, so it also runs at compile time (see the static_asserts in event_model.h)
+    constexpr EventClassification classify(const EventModel &model, const EventFeatures &features)
+    {
+        int32_t best = INT32_MIN;
+        int32_t second = INT32_MIN;
+        size_t best_class = 0;
+        for (size_t c = 0; c < static_cast<size_t>(EventClass::COUNT); c++)
+        {
+            int32_t score = model.biases[c];
+            for (size_t f = 0; f < FEATURE_COUNT; f++)
+            {
+                score += static_cast<int32_t>(model.weights[c][f]) * features[f];
+            }
+
+            if (score > best)
+            {
+                second = best;
+                best = score;
+                best_class = c;
+            }
+            else if (score > second)
+            {
+                second = score;
+            }
+        }
+        return EventClassification{static_cast<EventClass>(best_class), best - second};
+    }
+
+    constexpr int16_t to_feature(float value)
+    {
+        const float scaled = value * static_cast<float>(FEATURE_ONE);
+        const float clamped = std::min(std::max(scaled, static_cast<float>(-FEATURE_LIMIT)),
+                                       static_cast<float>(FEATURE_LIMIT));
+        return static_cast<int16_t>(clamped < 0.0F ? clamped - 0.5F : clamped + 0.5F);
+    }
+
+    /**
+     * @brief Follows one NH3/CH4 pair every pass and summarizes an event as EventFeatures
+     *
+     * Index 0 is the pair's NH3 channel and index 1 its CH4 channel; each pair has its own
+     * extractor, so gas from another litter box never mixes into the features. Each channel keeps a reference level learned while it is quiet, so the
+     * excess is measured against the air before the event rather than against the EMA
+     * baseline, which follows the gas. A gas has its onset when its channel rises
+     * ONSET_RATIO above the reference; onsets are tracked between events too, because the
+     * sensor that did not trigger the event often started rising before it.
+     */
+    class EventFeatureExtractor
+    {
+    public:
+        static constexpr size_t CHANNELS = 2;
+        static constexpr float ONSET_RATIO = 0.15F;    // Relative excess that counts as a rise
+        static constexpr float REFERENCE_ALPHA = 0.02F; // Reference tracking while quiet
+        static constexpr float NO_ONSET_LAG_S = 128.0F; // Lag reported when one gas never rose
+
+        // Call for every channel on every pass, events or not
+        void update(unsigned long now_ms, size_t index, float value, float baseline)
+        {
+            if (index >= CHANNELS)
+            {
+                return;
+            }
+
+            auto &channel = m_channels[index];
+            auto &gas = m_gases[index];
+            if (channel.reference <= 0.0F)
+            {
+                channel.reference = baseline > 0.0F ? baseline : value;
+                if (channel.reference <= 0.0F)
+                {
+                    return;
+                }
+            }
+
+            const float excess = value / channel.reference - 1.0F;
+            const bool quiet = excess < ONSET_RATIO;
+            if (!m_active)
+            {
+                // A rise that never turns into an event is a level shift; absorb it slowly
+                channel.reference += (quiet ? REFERENCE_ALPHA : REFERENCE_ALPHA / 16.0F) * (value - channel.reference);
+            }
+            if (quiet)
+            {
+                channel.rising = false;
+                return;
+            }
+
+            if (!channel.rising)
+            {
+                channel.rising = true;
+                channel.rising_since_ms = now_ms;
+            }
+            if (!m_active)
+            {
+                return;
+            }
+
+            if (!gas.has_onset)
+            {
+                gas.has_onset = true;
+                gas.onset_ms = channel.rising_since_ms;
+            }
+            if (excess > gas.peak_excess)
+            {
+                gas.peak_excess = excess;
+                gas.peak_ms = now_ms;
+            }
+        }
+
+        // Opens an event; gases already rising keep the onset they had before it
+        void begin(unsigned long now_ms, size_t count)
+        {
+            m_active = true;
+            m_start_ms = now_ms;
+            m_gases = {};
+            count = std::min(count, CHANNELS);
+            for (size_t i = 0; i < count; i++)
+            {
+                auto &gas = m_gases[i];
+                const auto &channel = m_channels[i];
+                if (channel.rising && (!gas.has_onset || before(channel.rising_since_ms, gas.onset_ms)))
+                {
+                    gas.has_onset = true;
+                    gas.onset_ms = channel.rising_since_ms;
+                }
+            }
+        }
+
+        EventFeatures finish(unsigned long end_ms)
+        {
+            m_active = false;
+
+            const auto &nh3 = m_gases[0];
+            const auto &ch4 = m_gases[1];
+            float lag_s = 0.0F;
+            if (nh3.has_onset && ch4.has_onset)
+            {
+                lag_s = static_cast<float>(static_cast<long>(ch4.onset_ms - nh3.onset_ms)) / 1000.0F;
+            }
+            else if (nh3.has_onset || ch4.has_onset)
+            {
+                lag_s = nh3.has_onset ? NO_ONSET_LAG_S : -NO_ONSET_LAG_S;
+            }
+
+            EventFeatures features{};
+            features[NH3_PEAK] = to_feature(nh3.peak_excess);
+            features[CH4_PEAK] = to_feature(ch4.peak_excess);
+            features[NH3_RISE] = to_feature(nh3.rise_per_s());
+            features[CH4_RISE] = to_feature(ch4.rise_per_s());
+            features[ONSET_LAG] = to_feature(lag_s / 8.0F);
+            features[CO_OCCURRENCE] = std::min(features[NH3_PEAK], features[CH4_PEAK]);
+            features[DURATION] = to_feature(static_cast<float>(end_ms - m_start_ms) / 480000.0F);
+            return features;
+        }
+
+        bool is_active() const { return m_active; }
+
+    private:
+        struct Channel
+        {
+            float reference{0.0F};
+            unsigned long rising_since_ms{0};
+            bool rising{false};
+        };
+
+        struct Gas
+        {
+            unsigned long onset_ms{0};
+            unsigned long peak_ms{0};
+            float peak_excess{0.0F};
+            bool has_onset{false};
+
+            float rise_per_s() const
+            {
+                const float rise_s = std::max(static_cast<float>(peak_ms - onset_ms) / 1000.0F, 1.0F);
+                return peak_excess / rise_s;
+            }
+        };
+
+        static bool before(unsigned long a, unsigned long b) { return static_cast<long>(a - b) < 0; }
+
+        std::array<Channel, CHANNELS> m_channels{};
+        std::array<Gas, CHANNELS> m_gases{}; // NH3, CH4
+        unsigned long m_start_ms{0};
+        bool m_active{false};
+    };
+} // namespace pooaway::sensors
@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "sensors/event_classifier.h"
+
+namespace pooaway::sensors
+{
+    enum class EventPhase
+    {
+        NONE,    // No transition on this update
+        STARTED, // First channel alert of a new event
+        CLOSED   // All channels quiet for the hold-off period
+    };
+
+    // Compact summary of one detected elimination event
+    struct EventRecord
+    {
+        uint32_t id{0};
+        uint8_t pair{0};              // NH3/CH4 pair (litter box) the event happened at
+        unsigned long start_ms{0};
+        unsigned long end_ms{0};      // Last time any channel was alerting
+        uint32_t sensor_mask{0};      // Bit n set if SensorManager channel n alerted during the event
+        uint8_t peak_channel{0};      // SensorManager channel that reached peak_ppm
+        float peak_ppm{0.0F};         // Highest reading of any alerting channel
+        float exposure_ppm_s{0.0F};   // Integral of (value - baseline) over alerting channels
+        EventClass event_class{EventClass::COUNT}; // Set on close by the fused NH3/CH4 classifier
+        float class_margin{0.0F};     // Log-odds of event_class over the runner-up
+        uint32_t classify_cycles{0};  // CPU cycles the inference took
+
+        unsigned long duration_ms() const { return end_ms - start_ms; }
+    };
+
+    // Per-channel input to the detector, sampled once per main loop pass
+    struct ChannelSample
+    {
+        bool alert{false};
+        float value{0.0F};
+        float baseline{0.0F};
+    };
+
+    /**
+     * @brief Folds one NH3/CH4 pair's level-triggered alerts into start/close event transitions
+     *
+     * One detector runs per pair, so visits to different litter boxes are separate events
+     * with their own features. An event opens on the pair's first alerting channel and closes
+     * once both have been quiet for config::events::CLOSE_HOLDOFF_MS, so short dips below the
+     * threshold do not split one visit into several events. On close the event is classified
+     * from both gases' features (event_classifier.h, model in event_model.h).
+     */
+    class EventDetector
+    {
+    public:
+        static constexpr size_t PAIR_CHANNELS = 2; // NH3, then CH4
+        static constexpr size_t MAX_PAIRS = 16;    // SensorManager::MAX_CHANNELS / PAIR_CHANNELS
+
+        // Pair index; the pair's channels are 2 * pair and 2 * pair + 1 in SensorManager
+        void set_pair(uint8_t pair) { m_pair = pair; }
+
+        // samples holds the pair's PAIR_CHANNELS channels, NH3 first
+        EventPhase update(unsigned long now_ms, const ChannelSample *samples);
+
+        bool is_active() const { return m_active; }
+        const EventRecord &get_record() const { return m_record; }
+
+        // Event ids are shared by all pairs and continue across reboots through the StateStore
+        static uint32_t get_next_id() { return s_next_id; }
+        static void set_next_id(uint32_t id) { s_next_id = id > 0 ? id : 1; }
+
+    private:
+        static constexpr char const *TAG = "EventDetector";
+
+        static uint32_t s_next_id;
+
+        EventRecord m_record;
+        EventFeatureExtractor m_features;
+        uint8_t m_pair{0};
+        unsigned long m_last_update_ms{0};
+        bool m_active{false};
+    };
+} // namespace pooaway::sensors
@@ -0,0 +1,23 @@
+#pragma once
+#include "sensors/event_classifier.h"
+
+// Generated by tools/replay --classify --emit-model; retrain instead of editing by hand.
+// Trained on 515 synthetic events (40 runs x 24 h, seed 1); fixed-point test accuracy 96.2%
+
+namespace pooaway::sensors
+{
+    // Rows in EventClass order, columns in EventFeature order; weights Q8.8, biases Q16.16
+    constexpr EventModel EVENT_MODEL{
+        {{
+            {{68, -295, -100, 262, 12, -349, 14}}, // URINE
+            {{-250, 74, 88, -230, -22, -85, 174}}, // FECES
+            {{182, 221, 12, -32, 10, 434, -188}}, // SPRAY
+        }},
+        {{136100, 129297, -265397}},
+    };
+
+    // Mean training event of each class, classified at compile time
+    static_assert(classify(EVENT_MODEL, EventFeatures{{508, 40, 22, 9, 2832, 32, 14}}).event_class == EventClass::URINE);
+    static_assert(classify(EVENT_MODEL, EventFeatures{{100, 471, 13, 18, -2463, 80, 20}}).event_class == EventClass::FECES);
+    static_assert(classify(EVENT_MODEL, EventFeatures{{687, 648, 158, 128, -10, 500, 8}}).event_class == EventClass::SPRAY);
+} // namespace pooaway::sensors
@@ -1,15 +1,19 @@
 #pragma once
 #include <Arduino.h>
 #include "sensors/sensor_types.h"
+#include "error_handler.h"
 
 namespace pooaway::sensors
 {
+    using pooaway::error::Code;
+    using pooaway::error::Result;
+
     class ISensor
     {
     public:
         virtual ~ISensor() = default;
         virtual void init() = 0;
-        virtual void read() = 0;
+        virtual Result read() = 0;
         virtual float get_value() const = 0;
         virtual bool check_alert() const = 0;
         virtual const char* get_name() const = 0;
@@ -19,11 +23,11 @@ namespace pooaway::sensors
     {
     public:
         virtual ~ICalibration() = default;
-        virtual void calibrate() = 0;
+        virtual Result calibrate() = 0;
         virtual float get_r0() const = 0;
         virtual bool validate_r0(float r0) const = 0;
         virtual void set_r0(float r0) = 0;
-        virtual void run_self_test() = 0;
+        virtual Result run_self_test() = 0;
     };
 
     class ISensorReading
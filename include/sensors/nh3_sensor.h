@@ -23,8 +23,8 @@ namespace pooaway::sensors
         void set_r0(float r0) override;
 
     public:
-        NH3Sensor(int pin)
-            : BaseSensor("GM-802B", "PEE", pin,
+        explicit NH3Sensor(int pin, const char *name = "PEE")
+            : BaseSensor("GM-802B", name, pin,
                          0.1F,    // alpha (slower response)
                          0.3F,    // tolerance
                          30.0F,   // preheating time (30s)
@@ -32,6 +32,7 @@ namespace pooaway::sensors
                          102.2F,  // coeff a (calibrated for NH3 curve)
                          -2.473F) // coeff b (calibrated for NH3 curve)
         {
+            set_alert_engine(config::detection::NH3_USE_CUSUM ? AlertEngine::CUSUM : AlertEngine::THRESHOLD);
         }
 
         float get_voltage() const override;
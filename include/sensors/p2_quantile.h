@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+namespace pooaway::sensors
+{
+    /**
+     * @brief Streaming quantile estimate in constant memory (Jain & Chlamtac P² algorithm)
+     *
+     * Keeps five markers whose heights approximate the minimum, p/2, p, (1+p)/2 quantiles
+     * and the maximum, adjusting them with a piecewise-parabolic fit on every sample.
+     * Each add() is a handful of float operations regardless of how many samples were seen.
+     */
+    class P2Quantile
+    {
+    public:
+        explicit P2Quantile(float p) : m_p(p) {}
+
+        void reset() { m_count = 0; }
+        uint32_t count() const { return m_count; }
+        float get_p() const { return m_p; }
+
+        void add(float x)
+        {
+            if (m_count < MARKERS)
+            {
+                m_q[m_count++] = x;
+                if (m_count == MARKERS)
+                {
+                    std::sort(m_q, m_q + MARKERS);
+                    for (int i = 0; i < MARKERS; i++)
+                    {
+                        m_n[i] = i;
+                    }
+                    m_np[0] = 0.0F;
+                    m_np[1] = 2.0F * m_p;
+                    m_np[2] = 4.0F * m_p;
+                    m_np[3] = 2.0F + 2.0F * m_p;
+                    m_np[4] = 4.0F;
+                    m_dn[0] = 0.0F;
+                    m_dn[1] = m_p / 2.0F;
+                    m_dn[2] = m_p;
+                    m_dn[3] = (1.0F + m_p) / 2.0F;
+                    m_dn[4] = 1.0F;
+                }
+                return;
+            }
+
+            // Find the cell holding x, widening the extremes if needed
+            int k = 0;
+            if (x < m_q[0])
+            {
+                m_q[0] = x;
+            }
+            else if (x >= m_q[MARKERS - 1])
+            {
+                m_q[MARKERS - 1] = x;
+                k = MARKERS - 2;
+            }
+            else
+            {
+                while (x >= m_q[k + 1])
+                {
+                    k++;
+                }
+            }
+
+            for (int i = k + 1; i < MARKERS; i++)
+            {
+                m_n[i]++;
+            }
+            for (int i = 0; i < MARKERS; i++)
+            {
+                m_np[i] += m_dn[i];
+            }
+
+            // Move the middle markers towards their desired positions
+            for (int i = 1; i < MARKERS - 1; i++)
+            {
+                const float d = m_np[i] - static_cast<float>(m_n[i]);
+                if ((d >= 1.0F && m_n[i + 1] - m_n[i] > 1) || (d <= -1.0F && m_n[i - 1] - m_n[i] < -1))
+                {
+                    const int s = d >= 0.0F ? 1 : -1;
+                    float q = parabolic(i, s);
+                    if (!(m_q[i - 1] < q && q < m_q[i + 1]))
+                    {
+                        q = linear(i, s);
+                    }
+                    m_q[i] = q;
+                    m_n[i] += s;
+                }
+            }
+            m_count++;
+        }
+
+        // Current estimate; exact while fewer than five samples have been seen
+        float value() const
+        {
+            if (m_count == 0)
+            {
+                return 0.0F;
+            }
+
+            if (m_count < MARKERS)
+            {
+                float sorted[MARKERS];
+                std::copy(m_q, m_q + m_count, sorted);
+                std::sort(sorted, sorted + m_count);
+                const auto index = static_cast<uint32_t>(m_p * static_cast<float>(m_count - 1) + 0.5F);
+                return sorted[std::min(index, m_count - 1)];
+            }
+            return m_q[2];
+        }
+
+    private:
+        static constexpr int MARKERS = 5;
+
+        float parabolic(int i, int s) const
+        {
+            const float n_prev = static_cast<float>(m_n[i - 1]);
+            const float n_i = static_cast<float>(m_n[i]);
+            const float n_next = static_cast<float>(m_n[i + 1]);
+            const float sf = static_cast<float>(s);
+            return m_q[i] + sf / (n_next - n_prev) *
+                                ((n_i - n_prev + sf) * (m_q[i + 1] - m_q[i]) / (n_next - n_i) +
+                                 (n_next - n_i - sf) * (m_q[i] - m_q[i - 1]) / (n_i - n_prev));
+        }
+
+        float linear(int i, int s) const
+        {
+            return m_q[i] + static_cast<float>(s) * (m_q[i + s] - m_q[i]) /
+                                static_cast<float>(m_n[i + s] - m_n[i]);
+        }
+
+        float m_p;
+        uint32_t m_count{0};
+        float m_q[MARKERS]{};   // Marker heights
+        int32_t m_n[MARKERS]{}; // Actual marker positions
+        float m_np[MARKERS]{};  // Desired marker positions
+        float m_dn[MARKERS]{};  // Desired position increments
+    };
+} // namespace pooaway::sensors
@@ -1,23 +1,104 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <cmath>
+#include "sensors/sensor_types.h"
 
 namespace pooaway::sensors
 {
 
+    // Per-sensor health statistics, updated in constant time and memory on every read
     struct SensorDiagnostics
     {
+        static constexpr uint32_t WINDOW_READS = 100; // Read attempts per error-rate window
+
         uint32_t read_count{0};
         uint32_t error_count{0};
         float min_value{99999.0F};
         float max_value{0.0F};
-        float avg_value{0.0F};
+        float avg_value{0.0F}; // Running mean (Welford)
+        float m2{0.0F};        // Sum of squared deviations from the mean (Welford)
         uint32_t alert_count{0};
         uint32_t calibration_count{0};
+        float calibration_confidence{0.0F}; // Of the latest clean-air calibration, accepted or not
         float last_voltage{0.0F};
         float last_resistance{0.0F};
+        uint32_t voltage_jumps{0}; // Consecutive readings further apart than MAX_VOLTAGE_DELTA
         unsigned long last_read_time{0};
         unsigned long total_active_time{0};
+
+        // Tumbling window over the last WINDOW_READS attempts
+        uint32_t window_reads{0};
+        uint32_t window_errors{0};
+        uint32_t window_jumps{0};
+        float last_window_error_rate{0.0F};
+        uint32_t last_window_jumps{0};
+        uint32_t consecutive_errors{0};
+
         bool is_healthy{true};
+
+        float variance() const { return read_count > 1 ? m2 / static_cast<float>(read_count - 1) : 0.0F; }
+        float stddev() const { return std::sqrt(variance()); }
+
+        void record_read(unsigned long now, float value, float voltage, float resistance)
+        {
+            if (last_read_time != 0)
+            {
+                total_active_time += now - last_read_time;
+                if (std::fabs(voltage - last_voltage) > MAX_VOLTAGE_DELTA)
+                {
+                    voltage_jumps++;
+                    window_jumps++;
+                }
+            }
+            last_read_time = now;
+            last_voltage = voltage;
+            last_resistance = resistance;
+
+            read_count++;
+            const float delta = value - avg_value;
+            avg_value += delta / static_cast<float>(read_count);
+            m2 += delta * (value - avg_value);
+            min_value = std::min(min_value, value);
+            max_value = std::max(max_value, value);
+
+            consecutive_errors = 0;
+            advance_window(false);
+        }
+
+        void record_error(unsigned long now)
+        {
+            last_read_time = now;
+            error_count++;
+            consecutive_errors++;
+            advance_window(true);
+        }
+
+        void record_alert() { alert_count++; }
+        void record_calibration() { calibration_count++; }
+
+    private:
+        void advance_window(bool error)
+        {
+            window_reads++;
+            window_errors += error ? 1 : 0;
+            if (window_reads >= WINDOW_READS)
+            {
+                last_window_error_rate = static_cast<float>(window_errors) / static_cast<float>(window_reads);
+                last_window_jumps = window_jumps;
+                window_reads = 0;
+                window_errors = 0;
+                window_jumps = 0;
+            }
+
+            // Judge on the worse of the finished and the running window so a burst shows up at once
+            const uint32_t errors = std::max(window_errors,
+                                             static_cast<uint32_t>(last_window_error_rate * WINDOW_READS + 0.5F));
+            const uint32_t jumps = std::max(window_jumps, last_window_jumps);
+            is_healthy = consecutive_errors < static_cast<uint32_t>(ERROR_THRESHOLD) &&
+                         errors < static_cast<uint32_t>(ERROR_THRESHOLD) &&
+                         jumps < static_cast<uint32_t>(ERROR_THRESHOLD);
+        }
     };
 
-} // namespace pooaway::sensors
\ No newline at end of file
+} // namespace pooaway::sensors
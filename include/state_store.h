@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <Preferences.h>
+
+namespace pooaway
+{
+    /**
+     * @brief Single versioned, CRC-protected blob holding all state that must survive a reboot
+     *
+     * Producers update an in-RAM image through the setters; update() writes it to NVS only
+     * when it differs materially from the last committed copy, and no more often than the
+     * configured commit interval, to bound flash wear.
+     *
+     * Detection state (threshold hold timers, CUSUM sums, an open event) is not kept: it spans
+     * seconds, is rebuilt within the CUSUM warm-up after boot, and restored after an unknown
+     * downtime it would raise or hide alerts for air that has long changed.
+     */
+    class StateStore
+    {
+    public:
+        static constexpr size_t MAX_CHANNELS = 32; // Matches SensorManager::MAX_CHANNELS
+        static constexpr uint32_t MAGIC = 0x53574150; // "PAWS"
+        static constexpr uint16_t VERSION = 1;
+
+        static StateStore &instance();
+
+        StateStore(const StateStore &) = delete;
+        StateStore &operator=(const StateStore &) = delete;
+
+        /**
+         * @brief Read and validate the blob from NVS
+         * @return true if a blob with matching magic, version and CRC was restored
+         */
+        bool load();
+
+        // Commit the image if it is dirty and the rate limit allows
+        void update();
+
+        // Ask for a prompt commit, e.g. after calibration (still bounded by the urgent interval)
+        void request_commit();
+
+        /**
+         * @brief Look up persisted values for a channel
+         * @return false if the slot is empty or was saved for a differently named sensor
+         */
+        bool get_channel(size_t index, const char *name, float &r0, float &baseline) const;
+        void set_channel_r0(size_t index, const char *name, float r0);
+        void set_channel_baseline(size_t index, const char *name, float baseline);
+
+        // Where event ids resume after a reboot: the end of the last reserved block
+        uint32_t get_next_event_id() const { return m_image.next_event_id; }
+        // Reserves the next EVENT_ID_BLOCK ids with an immediate commit once id runs past the
+        // reserved block, so an id is durable before the event carrying it is published
+        void set_next_event_id(uint32_t id);
+
+        uint32_t get_commit_count() const { return m_commit_count; }
+
+    private:
+        static constexpr char const *TAG = "StateStore";
+        static constexpr char const *KEY = "state";
+
+        enum ChannelFlags : uint32_t
+        {
+            HAS_R0 = 1U << 0,
+            HAS_BASELINE = 1U << 1
+        };
+
+        struct ChannelState
+        {
+            uint32_t name_hash;
+            float r0;
+            float baseline;
+            uint32_t flags;
+        };
+
+        struct Blob
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t reserved;
+            uint32_t sequence; // Incremented on every commit
+            uint32_t next_event_id; // Ids below this may have been published
+            ChannelState channels[MAX_CHANNELS];
+            uint32_t crc; // CRC-32 of every byte above
+        };
+
+        Blob m_image{};
+        Blob m_committed{};
+        Preferences m_preferences;
+        bool m_dirty{false};
+        bool m_urgent{false};
+        unsigned long m_last_commit_ms{0};
+        uint32_t m_commit_count{0};
+
+        StateStore();
+        bool commit();
+        ChannelState *claim_slot(size_t index, const char *name);
+        static uint32_t hash_name(const char *name);
+        static uint32_t compute_crc(const Blob &blob);
+    };
+} // namespace pooaway
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct timeval;
+
+namespace pooaway
+{
+    /**
+     * @brief Wall-clock time as the monotonic esp_timer plus an offset kept by SNTP
+     *
+     * Samples are stamped with capture_us(), microseconds since boot, which is one timer read
+     * and never steps. Every SNTP sync (at boot, then every config::ntp::SYNC_INTERVAL) sets the
+     * offset from that clock to UTC, so turning a stamp into UTC is one addition, and a sample
+     * taken before a resync is still placed correctly once converted. The offset is written by
+     * the lwIP task and read by the main loop through a sequence counter, without a lock.
+     *
+     * Local-time formatting caches the broken-down current minute, so localtime_r() and
+     * strftime() run once a minute however many payloads are stamped in it.
+     */
+    class TimeService
+    {
+    public:
+        static constexpr size_t LOCAL_TIME_SIZE = 20; // "YYYY-MM-DD HH:MM:SS"
+
+        struct Stats
+        {
+            uint32_t syncs{0};
+            int64_t last_correction_us{0}; // Offset change applied by the latest resync
+            int64_t max_correction_us{0};  // Largest magnitude of such a change
+            int64_t last_sync_us{0};       // Capture clock at the latest sync
+            uint32_t formats{0};
+            uint32_t format_misses{0};     // Minute changed, so the prefix was rebuilt
+        };
+
+        static TimeService &instance();
+
+        TimeService(const TimeService &) = delete;
+        TimeService &operator=(const TimeService &) = delete;
+
+        // Starts SNTP with the resync interval and the sync callback; call once WiFi is up
+        void begin();
+
+        // Capture stamp: esp_timer microseconds since boot
+        static int64_t capture_us();
+
+        bool is_synced() const { return m_synced.load(std::memory_order_acquire); }
+        int64_t to_utc_us(int64_t captured_us) const { return captured_us + offset_us(); }
+        int64_t now_utc_us() const { return to_utc_us(capture_us()); }
+
+        /**
+         * @brief Format a UTC time as local "YYYY-MM-DD HH:MM:SS" (config::ntp::TIMEZONE)
+         * @return false if the buffer is smaller than LOCAL_TIME_SIZE; out is then ""
+         */
+        bool format_local(int64_t utc_us, char *out, size_t size);
+
+        const Stats &get_stats() const { return m_stats; }
+
+    private:
+        TimeService() = default;
+
+        static void on_sync(struct timeval *tv);
+        void apply_sync(int64_t utc_us, int64_t captured_us);
+        int64_t offset_us() const;
+
+        static constexpr char const *TAG = "TimeService";
+        static constexpr size_t PREFIX_LENGTH = 17; // "YYYY-MM-DD HH:MM:"
+
+        std::atomic<uint32_t> m_sequence{0}; // Odd while apply_sync() is writing m_offset_us
+        int64_t m_offset_us{0};
+        std::atomic<bool> m_synced{false};
+        int64_t m_cached_minute{-1};
+        char m_cached_prefix[LOCAL_TIME_SIZE]{};
+        Stats m_stats;
+    };
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Pure C++ (no Arduino dependencies) so the scheduling logic builds unchanged in tools/soak
+namespace pooaway
+{
+    /**
+     * @brief Hashed timing wheel for a handful of periodic and one-shot timers
+     *
+     * A timer due at tick t sits in slot t % Slots; each slot is an intrusive list, so
+     * starting or stopping a timer is O(1) and advancing walks only the slots that have come
+     * due since the last call, at most one revolution however long the caller was away.
+     * Timers further out than one revolution stay in their slot until their own pass comes
+     * round. Ticks are whatever unit the caller passes in (milliseconds on the device) and
+     * wrap like millis(); deadlines are compared by signed difference.
+     */
+    template <size_t MaxTimers, size_t Slots>
+    class TimerWheel
+    {
+        static_assert(MaxTimers > 0 && MaxTimers < 255, "Timer ids are stored in a byte");
+        static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0, "Slot count must be a power of two");
+
+    public:
+        using Callback = void (*)();
+        static constexpr uint32_t NO_DEADLINE = UINT32_MAX;
+
+        explicit TimerWheel(uint32_t now = 0) : m_now(now)
+        {
+            m_heads.fill(NONE);
+        }
+
+        /**
+         * @brief Register a timer, stopped
+         * @param period Re-armed this many ticks after each expiry; 0 for a one-shot timer
+         * @return Timer id, or -1 when MaxTimers is reached
+         */
+        int add(Callback fn, uint32_t period)
+        {
+            if (m_count >= MaxTimers || fn == nullptr)
+            {
+                return -1;
+            }
+            auto &timer = m_timers[m_count];
+            timer.fn = fn;
+            timer.period = period;
+            return static_cast<int>(m_count++);
+        }
+
+        // (Re)arm a timer to fire `delay` ticks after `now`, which must not be before the last advance()
+        void start(int id, uint32_t now, uint32_t delay)
+        {
+            if (!valid(id))
+            {
+                return;
+            }
+            unlink(static_cast<uint8_t>(id));
+            link(static_cast<uint8_t>(id), now + delay);
+        }
+
+        void stop(int id)
+        {
+            if (valid(id))
+            {
+                unlink(static_cast<uint8_t>(id));
+            }
+        }
+
+        bool is_armed(int id) const { return valid(id) && m_timers[id].armed; }
+
+        /**
+         * @brief Fire every timer due at or before `now`, in slot order
+         *
+         * Periodic timers are re-armed one period after their deadline before the callback
+         * runs, so a callback may stop or restart its own timer. A timer that fell more than a
+         * period behind (the loop was blocked) fires once and skips the missed expiries.
+         * @return Number of callbacks run
+         */
+        size_t advance(uint32_t now)
+        {
+            const uint32_t elapsed = now - m_now;
+            if (static_cast<int32_t>(elapsed) < 0)
+            {
+                return 0;
+            }
+
+            // Callbacks may start or stop any timer, so collect a slot's due timers before
+            // running them and check each one again just before it fires
+            const uint32_t base = m_now;
+            const uint32_t walk = elapsed < Slots ? elapsed : static_cast<uint32_t>(Slots - 1);
+            m_now = now;
+            size_t fired = 0;
+            for (uint32_t step = 0; step <= walk; step++)
+            {
+                std::array<uint8_t, MaxTimers> due;
+                size_t due_count = 0;
+                for (uint8_t id = m_heads[(base + step) & (Slots - 1)]; id != NONE; id = m_timers[id].next)
+                {
+                    if (static_cast<int32_t>(m_timers[id].deadline - now) <= 0)
+                    {
+                        due[due_count++] = id;
+                    }
+                }
+
+                for (size_t i = 0; i < due_count; i++)
+                {
+                    auto &timer = m_timers[due[i]];
+                    if (!timer.armed || static_cast<int32_t>(timer.deadline - now) > 0)
+                    {
+                        continue;
+                    }
+                    unlink(due[i]);
+                    if (timer.period > 0)
+                    {
+                        uint32_t deadline = timer.deadline + timer.period;
+                        if (static_cast<int32_t>(deadline - now) <= 0)
+                        {
+                            deadline = now + timer.period;
+                        }
+                        link(due[i], deadline);
+                    }
+                    timer.fn();
+                    fired++;
+                }
+            }
+            return fired;
+        }
+
+        /**
+         * @brief Ticks from `now` until the earliest armed timer is due
+         * @return 0 if one is already due, NO_DEADLINE if none is armed
+         */
+        uint32_t next_due_in(uint32_t now) const
+        {
+            // Within one revolution the first non-empty slot usually holds the answer
+            for (uint32_t step = 0; step < Slots; step++)
+            {
+                uint8_t id = m_heads[(m_now + step) & (Slots - 1)];
+                for (; id != NONE; id = m_timers[id].next)
+                {
+                    if (m_timers[id].deadline - m_now == step)
+                    {
+                        const int32_t remaining = static_cast<int32_t>(m_timers[id].deadline - now);
+                        return remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+                    }
+                }
+            }
+
+            // Only timers a revolution or more away are left
+            uint32_t earliest = NO_DEADLINE;
+            for (size_t i = 0; i < m_count; i++)
+            {
+                if (m_timers[i].armed)
+                {
+                    const int32_t remaining = static_cast<int32_t>(m_timers[i].deadline - now);
+                    const uint32_t wait = remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+                    earliest = wait < earliest ? wait : earliest;
+                }
+            }
+            return earliest;
+        }
+
+    private:
+        static constexpr uint8_t NONE = 0xFF;
+
+        struct Timer
+        {
+            Callback fn{nullptr};
+            uint32_t period{0};
+            uint32_t deadline{0};
+            uint8_t prev{NONE};
+            uint8_t next{NONE};
+            bool armed{false};
+        };
+
+        bool valid(int id) const { return id >= 0 && static_cast<size_t>(id) < m_count; }
+
+        void link(uint8_t id, uint32_t deadline)
+        {
+            auto &timer = m_timers[id];
+            const size_t slot = deadline & (Slots - 1);
+            timer.deadline = deadline;
+            timer.prev = NONE;
+            timer.next = m_heads[slot];
+            if (timer.next != NONE)
+            {
+                m_timers[timer.next].prev = id;
+            }
+            m_heads[slot] = id;
+            timer.armed = true;
+        }
+
+        void unlink(uint8_t id)
+        {
+            auto &timer = m_timers[id];
+            if (!timer.armed)
+            {
+                return;
+            }
+            if (timer.prev != NONE)
+            {
+                m_timers[timer.prev].next = timer.next;
+            }
+            else
+            {
+                m_heads[timer.deadline & (Slots - 1)] = timer.next;
+            }
+            if (timer.next != NONE)
+            {
+                m_timers[timer.next].prev = timer.prev;
+            }
+            timer.prev = timer.next = NONE;
+            timer.armed = false;
+        }
+
+        std::array<Timer, MaxTimers> m_timers{};
+        std::array<uint8_t, Slots> m_heads{};
+        size_t m_count{0};
+        uint32_t m_now;
+    };
+} // namespace pooaway
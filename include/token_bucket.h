@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+
+namespace pooaway
+{
+    enum class TrafficClass : uint8_t
+    {
+        ROUTINE,   // Periodic telemetry, thinned to the sustained rate
+        TRANSITION // Alert start/stop, may spend the reserved burst credit
+    };
+
+    struct RateLimiterStats
+    {
+        uint32_t admitted{0};
+        uint32_t dropped{0};   // Refused and lost
+        uint32_t coalesced{0}; // Refused, but the caller folds it into a later message
+    };
+
+    /**
+     * @brief Token bucket with a burst reserve that only alert transitions may spend
+     *
+     * One token is earned every period_ms up to routine_burst + transition_credit tokens.
+     * ROUTINE traffic needs a token above the reserve of transition_credit tokens, so on its
+     * own it is paced exactly like a fixed interval; TRANSITION traffic may use any token, so
+     * the first messages of a new alert get through even right after routine traffic. A
+     * period of 0 admits everything. Tokens are kept in integer milli-tokens since the C6
+     * has no FPU.
+     *
+     * @tparam Clock Type with a static now_ms() returning a wrapping millisecond counter
+     */
+    template <typename Clock>
+    class TokenBucket
+    {
+    public:
+        explicit TokenBucket(unsigned long period_ms = 0, uint8_t routine_burst = 1, uint8_t transition_credit = 0)
+            : m_period_ms(period_ms),
+              m_reserve(static_cast<int32_t>(transition_credit) * SCALE),
+              m_capacity((static_cast<int32_t>(routine_burst) + transition_credit) * SCALE),
+              m_tokens(m_capacity),
+              m_last_refill_ms(Clock::now_ms())
+        {
+        }
+
+        /**
+         * @brief Take a token for one message
+         * @param carry_forward The caller keeps the content for a later message if refused
+         * @return true if the message may be sent now
+         */
+        bool admit(TrafficClass traffic, bool carry_forward = false)
+        {
+            if (m_period_ms == 0)
+            {
+                m_stats.admitted++;
+                return true;
+            }
+
+            refill();
+            const int32_t floor = (traffic == TrafficClass::TRANSITION) ? 0 : m_reserve;
+            if (m_tokens - floor >= SCALE)
+            {
+                m_tokens -= SCALE;
+                m_stats.admitted++;
+                return true;
+            }
+
+            if (carry_forward)
+            {
+                m_stats.coalesced++;
+            }
+            else
+            {
+                m_stats.dropped++;
+            }
+            return false;
+        }
+
+        unsigned long get_period_ms() const { return m_period_ms; }
+        const RateLimiterStats &get_stats() const { return m_stats; }
+
+    private:
+        static constexpr int32_t SCALE = 1000;
+
+        void refill()
+        {
+            const uint32_t now = static_cast<uint32_t>(Clock::now_ms());
+            const uint32_t elapsed = now - m_last_refill_ms;
+            const uint64_t earned = static_cast<uint64_t>(elapsed) * SCALE / m_period_ms;
+            if (earned == 0)
+            {
+                return; // Keep the fractional time for the next call
+            }
+
+            const uint64_t tokens = static_cast<uint64_t>(m_tokens) + earned;
+            if (tokens >= static_cast<uint64_t>(m_capacity))
+            {
+                m_tokens = m_capacity;
+                m_last_refill_ms = now; // A full bucket does not bank idle time
+            }
+            else
+            {
+                // Advance only by the time actually converted, so frequent polls lose no credit
+                m_tokens = static_cast<int32_t>(tokens);
+                m_last_refill_ms += static_cast<uint32_t>(earned * m_period_ms / SCALE);
+            }
+        }
+
+        unsigned long m_period_ms;
+        int32_t m_reserve;
+        int32_t m_capacity;
+        int32_t m_tokens;
+        uint32_t m_last_refill_ms;
+        RateLimiterStats m_stats;
+    };
+} // namespace pooaway
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include "trace_ring.h"
+#include "config.h"
+
+// Compile-time ceiling for TRACE_LOGx; sites above it are removed entirely, arguments included
+#ifndef POOAWAY_TRACE_LEVEL
+#ifdef CORE_DEBUG_LEVEL
+#define POOAWAY_TRACE_LEVEL CORE_DEBUG_LEVEL
+#else
+#define POOAWAY_TRACE_LEVEL 3
+#endif
+#endif
+
+namespace pooaway::trace
+{
+    /**
+     * @brief Deferred logging for the sample path
+     *
+     * TRACE_LOGx stores the format address, a timestamp and the raw arguments in a lock-free
+     * ring, which costs a few stores instead of a vsnprintf. drain() formats the records later
+     * from the main loop, or writes them as binary frames for tools/tracelog to decode on the
+     * host. %s arguments are kept by address, so they must be string literals or other strings
+     * that live for the whole run (sensor names).
+     */
+    class TraceLog
+    {
+    public:
+        static TraceLog &instance();
+
+        TraceLog(const TraceLog &) = delete;
+        TraceLog &operator=(const TraceLog &) = delete;
+
+        template <typename... Args>
+        void write(Level level, const char *tag, const char *format, Args... args)
+        {
+            Record record{};
+            record.timestamp_us = now_us();
+            record.format = encode(format);
+            record.tag = encode(tag);
+            record.level = static_cast<uint8_t>(level);
+            pack(record, args...);
+            m_ring.push(record);
+        }
+
+        // Emit up to max_records queued records; call from the main loop after sampling.
+        // Returns true if the limit was reached and records may still be queued
+        bool drain(size_t max_records);
+        uint32_t get_dropped() const { return m_ring.get_dropped(); }
+
+    private:
+        static constexpr char const *TAG = "TraceLog";
+
+        TraceLog() = default;
+        static uint32_t now_us();
+        void emit_text(const Record &record);
+        void emit_binary(Record record);
+
+        TraceRing<config::trace::RING_RECORDS> m_ring;
+        uint32_t m_reported_dropped{0};
+    };
+
+    // Never called; lets the compiler check trace formats against their arguments
+    inline void check_format(const char *, ...) __attribute__((format(printf, 1, 2)));
+    inline void check_format(const char *, ...) {}
+} // namespace pooaway::trace
+
+#define POOAWAY_TRACE(level, tag, format, ...)                                                          \
+    do                                                                                                   \
+    {                                                                                                    \
+        if (false)                                                                                       \
+            pooaway::trace::check_format(format, ##__VA_ARGS__);                                         \
+        pooaway::trace::TraceLog::instance().write(pooaway::trace::Level::level, tag, format, ##__VA_ARGS__); \
+    } while (0)
+
+#define POOAWAY_TRACE_DISABLED(format, ...)                  \
+    do                                                       \
+    {                                                        \
+        if (false)                                           \
+            pooaway::trace::check_format(format, ##__VA_ARGS__); \
+    } while (0)
+
+#if POOAWAY_TRACE_LEVEL >= 1
+#define TRACE_LOGE(tag, format, ...) POOAWAY_TRACE(ERROR, tag, format, ##__VA_ARGS__)
+#else
+#define TRACE_LOGE(tag, format, ...) POOAWAY_TRACE_DISABLED(format, ##__VA_ARGS__)
+#endif
+#if POOAWAY_TRACE_LEVEL >= 2
+#define TRACE_LOGW(tag, format, ...) POOAWAY_TRACE(WARN, tag, format, ##__VA_ARGS__)
+#else
+#define TRACE_LOGW(tag, format, ...) POOAWAY_TRACE_DISABLED(format, ##__VA_ARGS__)
+#endif
+#if POOAWAY_TRACE_LEVEL >= 3
+#define TRACE_LOGI(tag, format, ...) POOAWAY_TRACE(INFO, tag, format, ##__VA_ARGS__)
+#else
+#define TRACE_LOGI(tag, format, ...) POOAWAY_TRACE_DISABLED(format, ##__VA_ARGS__)
+#endif
+#if POOAWAY_TRACE_LEVEL >= 4
+#define TRACE_LOGD(tag, format, ...) POOAWAY_TRACE(DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define TRACE_LOGD(tag, format, ...) POOAWAY_TRACE_DISABLED(format, ##__VA_ARGS__)
+#endif
+#if POOAWAY_TRACE_LEVEL >= 5
+#define TRACE_LOGV(tag, format, ...) POOAWAY_TRACE(VERBOSE, tag, format, ##__VA_ARGS__)
+#else
+#define TRACE_LOGV(tag, format, ...) POOAWAY_TRACE_DISABLED(format, ##__VA_ARGS__)
+#endif
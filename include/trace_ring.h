@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+// Pure C++ (no Arduino dependencies) so tools/tracelog decodes with the same layout and formatter
+
+namespace pooaway::trace
+{
+    // Same numbering as CORE_DEBUG_LEVEL / esp_log_level_t
+    enum class Level : uint8_t
+    {
+        NONE,
+        ERROR,
+        WARN,
+        INFO,
+        DEBUG,
+        VERBOSE
+    };
+
+    enum class ArgType : uint8_t
+    {
+        NONE,
+        INT,   // Signed integer, truncated to 32 bits
+        UINT,  // Unsigned integer or enum, truncated to 32 bits
+        FLOAT, // float or double, stored as float
+        STR,   // Address of a string that outlives the record (literal, sensor name)
+        PTR
+    };
+
+    inline constexpr size_t MAX_ARGS = 6;
+    inline constexpr uint8_t FRAME_MAGIC[2] = {0xA5, 0x5A}; // Precedes each record in binary output
+
+    /**
+     * @brief One deferred log call: format and tag by address, arguments as raw 32-bit words
+     *
+     * The address of a string literal identifies it for the lifetime of the firmware image,
+     * so the device formats by dereferencing it and the host decoder looks it up in the ELF.
+     */
+    struct Record
+    {
+        uint32_t timestamp_us;
+        uint32_t format;
+        uint32_t tag;
+        uint32_t arg_types; // 4 bits per argument, first argument in the low bits
+        uint32_t args[MAX_ARGS];
+        uint8_t level;
+        uint8_t arg_count;
+        uint8_t reserved;
+        uint8_t checksum; // Binary frames only: sum of all other bytes, negated
+
+        ArgType type_of(size_t index) const { return static_cast<ArgType>((arg_types >> (index * 4)) & 0xF); }
+    };
+    static_assert(sizeof(Record) == 44, "Record layout is shared with the host decoder");
+
+    inline uint8_t checksum(const Record &record)
+    {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&record);
+        uint8_t sum = 0;
+        for (size_t i = 0; i < offsetof(Record, checksum); i++)
+        {
+            sum += bytes[i];
+        }
+        return static_cast<uint8_t>(-sum);
+    }
+
+    template <typename T>
+    constexpr ArgType arg_type()
+    {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_floating_point_v<U>)
+            return ArgType::FLOAT;
+        else if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+            return ArgType::STR;
+        else if constexpr (std::is_pointer_v<U>)
+            return ArgType::PTR;
+        else if constexpr (std::is_enum_v<U> || std::is_unsigned_v<U>)
+            return ArgType::UINT;
+        else
+        {
+            static_assert(std::is_integral_v<U>, "Unsupported trace argument type");
+            return ArgType::INT;
+        }
+    }
+
+    template <typename T>
+    uint32_t encode(T value)
+    {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_floating_point_v<U>)
+        {
+            const float f = static_cast<float>(value);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+        else if constexpr (std::is_pointer_v<U>)
+            return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+        else
+            return static_cast<uint32_t>(value);
+    }
+
+    template <typename... Args>
+    void pack(Record &record, Args... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many trace arguments");
+        record.arg_count = static_cast<uint8_t>(sizeof...(Args));
+        record.arg_types = 0;
+        [[maybe_unused]] size_t index = 0;
+        ((record.arg_types |= static_cast<uint32_t>(arg_type<Args>()) << (index * 4),
+          record.args[index++] = encode(args)),
+         ...);
+    }
+
+    /**
+     * @brief Bounded lock-free multi-producer queue of records (Vyukov's sequenced cells)
+     *
+     * push() never blocks: when the ring is full the record is dropped and counted, so
+     * logging cannot stall the sample path. Safe to push from an ISR that preempts another
+     * producer, since a producer only spins while its slot is being claimed by someone else.
+     */
+    template <size_t N>
+    class TraceRing
+    {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
+    public:
+        TraceRing()
+        {
+            for (uint32_t i = 0; i < N; i++)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(const Record &record)
+        {
+            uint32_t pos = m_enqueue.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = m_cells[pos & (N - 1)];
+                const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<int32_t>(sequence - pos);
+                if (diff == 0)
+                {
+                    if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.record = record;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    pos = m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool pop(Record &out)
+        {
+            uint32_t pos = m_dequeue.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = m_cells[pos & (N - 1)];
+                const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<int32_t>(sequence - (pos + 1));
+                if (diff == 0)
+                {
+                    if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        out = cell.record;
+                        cell.sequence.store(pos + N, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // Empty, or the next record is still being written
+                }
+                else
+                {
+                    pos = m_dequeue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        uint32_t get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Cell
+        {
+            std::atomic<uint32_t> sequence;
+            Record record;
+        };
+
+        Cell m_cells[N];
+        std::atomic<uint32_t> m_enqueue{0};
+        std::atomic<uint32_t> m_dequeue{0};
+        std::atomic<uint32_t> m_dropped{0};
+    };
+
+    // Maps a string address from a record to its text, or nullptr if unknown
+    using StringResolver = const char *(*)(uint32_t address, void *context);
+
+    /**
+     * @brief Expand a record's format with its stored arguments
+     *
+     * Each conversion is formatted on its own with snprintf. If a conversion does not match
+     * the stored argument type, the argument is printed in its natural form instead.
+     * @return Length written, excluding the terminator
+     */
+    inline size_t format_record(const Record &record, StringResolver resolve, void *context, char *out, size_t size)
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        const char *format = resolve(record.format, context);
+        if (!format)
+        {
+            return static_cast<size_t>(std::snprintf(out, size, "<format 0x%08lx>", static_cast<unsigned long>(record.format)));
+        }
+
+        size_t length = 0;
+        size_t arg = 0;
+        const auto append = [&](int written)
+        {
+            if (written > 0)
+            {
+                length = std::min(size - 1, length + static_cast<size_t>(written));
+            }
+        };
+
+        for (const char *p = format; *p && length + 1 < size; p++)
+        {
+            if (*p != '%')
+            {
+                out[length++] = *p;
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                out[length++] = '%';
+                p++;
+                continue;
+            }
+
+            // Copy flags, width and precision; drop length modifiers since the type is known
+            char spec[16] = "%";
+            size_t spec_length = 1;
+            const char *q = p + 1;
+            while (*q && std::strchr("-+ #0123456789.", *q) && spec_length < sizeof(spec) - 4)
+            {
+                spec[spec_length++] = *q++;
+            }
+            while (*q && std::strchr("hlLqjzt", *q))
+            {
+                q++;
+            }
+            const char conversion = *q ? *q : 'd';
+            p = *q ? q : q - 1;
+
+            if (arg >= record.arg_count)
+            {
+                append(std::snprintf(out + length, size - length, "<?>"));
+                continue;
+            }
+
+            const uint32_t raw = record.args[arg];
+            const ArgType type = record.type_of(arg++);
+            switch (type)
+            {
+            case ArgType::FLOAT:
+            {
+                float f;
+                std::memcpy(&f, &raw, sizeof(f));
+                spec[spec_length++] = std::strchr("fFeEgGaA", conversion) ? conversion : 'g';
+                spec[spec_length] = '\0';
+                append(std::snprintf(out + length, size - length, spec, static_cast<double>(f)));
+                break;
+            }
+            case ArgType::STR:
+            {
+                const char *text = resolve(raw, context);
+                spec[spec_length++] = 's';
+                spec[spec_length] = '\0';
+                append(std::snprintf(out + length, size - length, spec, text ? text : "<?>"));
+                break;
+            }
+            case ArgType::INT:
+            case ArgType::UINT:
+            {
+                const bool is_int = std::strchr("diouxXc", conversion) != nullptr;
+                const char c = is_int ? conversion : (type == ArgType::INT ? 'd' : 'u');
+                if (c == 'c')
+                {
+                    spec[spec_length++] = 'c';
+                    spec[spec_length] = '\0';
+                    append(std::snprintf(out + length, size - length, spec, static_cast<int>(raw)));
+                    break;
+                }
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = c;
+                spec[spec_length] = '\0';
+                if (type == ArgType::INT && (c == 'd' || c == 'i'))
+                    append(std::snprintf(out + length, size - length, spec, static_cast<long>(static_cast<int32_t>(raw))));
+                else
+                    append(std::snprintf(out + length, size - length, spec, static_cast<unsigned long>(raw)));
+                break;
+            }
+            default:
+                append(std::snprintf(out + length, size - length, "0x%08lx", static_cast<unsigned long>(raw)));
+                break;
+            }
+        }
+
+        out[length] = '\0';
+        return length;
+    }
+
+    inline char level_letter(uint8_t level)
+    {
+        return level <= static_cast<uint8_t>(Level::VERBOSE) ? "NEWIDV"[level] : '?';
+    }
+} // namespace pooaway::trace
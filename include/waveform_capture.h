@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <Preferences.h>
+#include "waveform_recorder.h"
+#include "config.h"
+
+namespace pooaway
+{
+    /**
+     * @brief Raw ADC waveform of every channel around each alert edge
+     *
+     * SensorManager feeds every raw reading and each alert edge; the capture is encoded
+     * from loop(), served at /capture and written to NVS, rate-limited for flash wear. The
+     * last saved capture is restored at boot, so the waveform behind an alert survives a
+     * reset. RAM use is fixed by config::capture and checked against its budget at compile
+     * time.
+     */
+    class WaveformCapture
+    {
+    public:
+        static constexpr size_t CHANNELS = 2 + 2 * static_cast<size_t>(config::mux::PAIR_COUNT);
+        using Recorder = capture::WaveformRecorder<CHANNELS, config::capture::PRE_TRIGGER_SAMPLES,
+                                                   config::capture::POST_TRIGGER_SAMPLES>;
+        static constexpr size_t FOOTPRINT_BYTES = sizeof(Recorder) + Recorder::MAX_BLOB_BYTES;
+        static_assert(FOOTPRINT_BYTES <= config::capture::RAM_BUDGET_BYTES,
+                      "Waveform capture exceeds config::capture::RAM_BUDGET_BYTES; shorten the window or raise the budget");
+
+        static WaveformCapture &instance();
+
+        WaveformCapture(const WaveformCapture &) = delete;
+        WaveformCapture &operator=(const WaveformCapture &) = delete;
+
+        // Restore the last saved capture from NVS
+        void init();
+
+        // Called by SensorManager for every raw reading, at the end of each scan and on each alert edge
+        void add(size_t channel, float raw);
+        void on_scan();
+        void trigger(size_t channel);
+
+        // Encode, save and rearm once a capture is complete; call from loop()
+        void poll();
+
+        /**
+         * @brief The latest capture, live or restored from NVS
+         * @return Blob length, 0 if there is none
+         */
+        size_t get_blob(const uint8_t *&data) const;
+
+        const capture::RecorderStats &get_stats() const { return m_recorder.get_stats(); }
+        uint32_t get_save_count() const { return m_saves; }
+
+    private:
+        static constexpr char const *TAG = "WaveformCapture";
+        static constexpr char const *KEY = "last";
+
+        WaveformCapture();
+        void save();
+
+        Recorder m_recorder{config::capture::SAMPLE_INTERVAL_MS};
+        uint8_t m_blob[Recorder::MAX_BLOB_BYTES]{};
+        size_t m_blob_length{0};
+        bool m_complete{false};
+        unsigned long m_last_save_ms{0};
+        bool m_saved{false};
+        uint32_t m_saves{0};
+        Preferences m_preferences;
+    };
+} // namespace pooaway
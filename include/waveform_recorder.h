@@ -0,0 +1,392 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Pure C++ (no Arduino dependencies) so tools/capture decodes the exact blob layout and CRC
+
+namespace pooaway::capture
+{
+    inline constexpr uint32_t BLOB_MAGIC = 0x56415750; // "PWAV"
+    inline constexpr uint8_t BLOB_VERSION = 1;
+    inline constexpr uint8_t NO_TRIGGER_CHANNEL = 0xFF;
+
+    /**
+     * @brief Fixed-size header at the start of every blob, little-endian on the wire
+     *
+     * Followed by one block per channel: the first raw sample as a little-endian uint16,
+     * then pre_samples + post_samples - 1 zigzag varint deltas. A CRC-32 of every preceding
+     * byte closes the blob. Sample i of a channel is at (i - pre_samples) * interval_ms from
+     * the trigger.
+     */
+    struct BlobHeader
+    {
+        uint32_t magic{BLOB_MAGIC};
+        uint8_t version{BLOB_VERSION};
+        uint8_t channels{0};
+        uint8_t trigger_channel{NO_TRIGGER_CHANNEL};
+        uint8_t reserved{0};
+        uint16_t interval_ms{0};
+        uint16_t pre_samples{0};  // Samples before the trigger; fewer than configured right after boot
+        uint16_t post_samples{0}; // Samples from the trigger on
+        uint16_t reserved2{0};
+        uint32_t sequence{0};     // Captures since boot
+        uint32_t trigger_ms{0};   // Uptime at the trigger
+        uint32_t trigger_utc_s{0}; // UTC at the trigger, 0 if time was not synced
+    };
+
+    inline constexpr size_t HEADER_BYTES = 28;
+    inline constexpr size_t CRC_BYTES = 4;
+    inline constexpr size_t MAX_DELTA_BYTES = 2; // 12-bit ADC: |delta| < 4096 zigzags into 14 bits
+
+    // CRC-32 (IEEE, reflected), bitwise: it runs once per capture, so no table is worth its flash
+    inline uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0)
+    {
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+            }
+        }
+        return ~crc;
+    }
+
+    inline uint32_t zigzag(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+    inline int32_t unzigzag(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1U); }
+
+    /**
+     * @brief Bounds-checked little-endian writer over a caller-owned buffer
+     *
+     * After one write does not fit, all further writes fail and size() stops growing.
+     */
+    class BlobWriter
+    {
+    public:
+        BlobWriter(uint8_t *buffer, size_t capacity) : m_buffer(buffer), m_capacity(capacity) {}
+
+        void u8(uint8_t value)
+        {
+            if (m_length >= m_capacity)
+            {
+                m_failed = true;
+                return;
+            }
+            if (!m_failed)
+            {
+                m_buffer[m_length++] = value;
+            }
+        }
+
+        void u16(uint16_t value)
+        {
+            u8(static_cast<uint8_t>(value));
+            u8(static_cast<uint8_t>(value >> 8));
+        }
+
+        void u32(uint32_t value)
+        {
+            u16(static_cast<uint16_t>(value));
+            u16(static_cast<uint16_t>(value >> 16));
+        }
+
+        void varint(uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                u8(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            u8(static_cast<uint8_t>(value));
+        }
+
+        size_t size() const { return m_length; }
+        bool failed() const { return m_failed; }
+        const uint8_t *data() const { return m_buffer; }
+
+    private:
+        uint8_t *m_buffer;
+        size_t m_capacity;
+        size_t m_length{0};
+        bool m_failed{false};
+    };
+
+    // Reader counterpart of BlobWriter; reads past the end fail and return 0
+    class BlobReader
+    {
+    public:
+        BlobReader(const uint8_t *data, size_t length) : m_data(data), m_length(length) {}
+
+        uint8_t u8()
+        {
+            if (m_offset >= m_length)
+            {
+                m_failed = true;
+                return 0;
+            }
+            return m_data[m_offset++];
+        }
+
+        uint16_t u16()
+        {
+            const uint16_t low = u8();
+            return static_cast<uint16_t>(low | (u8() << 8));
+        }
+
+        uint32_t u32()
+        {
+            const uint32_t low = u16();
+            return low | (static_cast<uint32_t>(u16()) << 16);
+        }
+
+        uint32_t varint()
+        {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7)
+            {
+                const uint8_t byte = u8();
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            m_failed = true;
+            return 0;
+        }
+
+        size_t offset() const { return m_offset; }
+        bool failed() const { return m_failed; }
+
+    private:
+        const uint8_t *m_data;
+        size_t m_length;
+        size_t m_offset{0};
+        bool m_failed{false};
+    };
+
+    inline void write_header(BlobWriter &out, const BlobHeader &header)
+    {
+        out.u32(header.magic);
+        out.u8(header.version);
+        out.u8(header.channels);
+        out.u8(header.trigger_channel);
+        out.u8(header.reserved);
+        out.u16(header.interval_ms);
+        out.u16(header.pre_samples);
+        out.u16(header.post_samples);
+        out.u16(header.reserved2);
+        out.u32(header.sequence);
+        out.u32(header.trigger_ms);
+        out.u32(header.trigger_utc_s);
+    }
+
+    inline BlobHeader read_header(BlobReader &in)
+    {
+        BlobHeader header;
+        header.magic = in.u32();
+        header.version = in.u8();
+        header.channels = in.u8();
+        header.trigger_channel = in.u8();
+        header.reserved = in.u8();
+        header.interval_ms = in.u16();
+        header.pre_samples = in.u16();
+        header.post_samples = in.u16();
+        header.reserved2 = in.u16();
+        header.sequence = in.u32();
+        header.trigger_ms = in.u32();
+        header.trigger_utc_s = in.u32();
+        return header;
+    }
+
+    struct RecorderStats
+    {
+        uint32_t triggers{0}; // Alert edges that started a capture
+        uint32_t captures{0}; // Captures completed and encoded
+        uint32_t missed{0};   // Alert edges while a capture was still in progress or unsaved
+        uint32_t last_blob_bytes{0};
+    };
+
+    /**
+     * @brief Always-on raw ADC history per channel that freezes around a trigger, like a scope
+     *
+     * Every raw reading is accumulated with add(); tick() closes one sample interval and
+     * stores the mean per channel, which averages away ADC noise and keeps the rate fixed
+     * however fast the scan runs. The ring always holds the last PreSamples intervals. A
+     * trigger records PostSamples more, then the ring freezes until encode() has copied it
+     * out and rearm() is called; triggers in the meantime are only counted.
+     *
+     * All storage is inline, so sizeof() is the whole RAM cost and MAX_BLOB_BYTES bounds
+     * the encoded capture; both are known at compile time.
+     *
+     * @tparam Channels    Channels recorded, indexed as SensorManager scans them
+     * @tparam PreSamples  Intervals kept from before the trigger
+     * @tparam PostSamples Intervals recorded from the trigger on
+     */
+    template <size_t Channels, size_t PreSamples, size_t PostSamples>
+    class WaveformRecorder
+    {
+        static_assert(Channels > 0 && Channels < NO_TRIGGER_CHANNEL, "Channel count must fit the blob header");
+        static_assert(PostSamples > 0 && PreSamples + PostSamples <= UINT16_MAX, "Sample counts must fit the blob header");
+
+    public:
+        enum class State : uint8_t
+        {
+            ARMED,     // Recording, waiting for a trigger
+            TRIGGERED, // Recording the post-trigger samples
+            FROZEN     // Capture complete, waiting for encode() and rearm()
+        };
+
+        static constexpr size_t RING_SAMPLES = PreSamples + PostSamples;
+        static constexpr size_t MAX_BLOB_BYTES =
+            HEADER_BYTES + Channels * (sizeof(uint16_t) + (RING_SAMPLES - 1) * MAX_DELTA_BYTES) + CRC_BYTES;
+
+        explicit WaveformRecorder(uint16_t interval_ms) : m_interval_ms(interval_ms) {}
+
+        // Accumulate one raw ADC reading; ignored while frozen
+        void add(size_t channel, uint16_t raw)
+        {
+            if (channel >= Channels || m_state == State::FROZEN)
+            {
+                return;
+            }
+            m_sums[channel] += raw;
+            m_counts[channel]++;
+        }
+
+        /**
+         * @brief Close the sample interval if it has elapsed; call once per scan
+         * @return true when this tick completed a capture
+         */
+        bool tick(uint32_t now_ms)
+        {
+            if (m_state == State::FROZEN || now_ms - m_interval_start_ms < m_interval_ms)
+            {
+                return false;
+            }
+            // A stalled loop restarts the interval rather than storing a burst of catch-up samples
+            m_interval_start_ms = now_ms - m_interval_start_ms < 2U * m_interval_ms ? m_interval_start_ms + m_interval_ms
+                                                                                       : now_ms;
+
+            for (size_t c = 0; c < Channels; c++)
+            {
+                // A channel with no reading this interval (low power, mux still settling) holds its level
+                if (m_counts[c] > 0)
+                {
+                    m_ring[c][m_head] = static_cast<uint16_t>((m_sums[c] + m_counts[c] / 2) / m_counts[c]);
+                }
+                else
+                {
+                    m_ring[c][m_head] = m_ring[c][(m_head + RING_SAMPLES - 1) % RING_SAMPLES];
+                }
+                m_sums[c] = 0;
+                m_counts[c] = 0;
+            }
+            m_head = (m_head + 1) % RING_SAMPLES;
+            m_filled = std::min(m_filled + 1, RING_SAMPLES);
+
+            if (m_state != State::TRIGGERED || ++m_post_count < PostSamples)
+            {
+                return false;
+            }
+            m_state = State::FROZEN;
+            return true;
+        }
+
+        /**
+         * @brief Start a capture on an alert edge
+         * @return false if a capture is already in progress or waiting to be encoded
+         */
+        bool trigger(size_t channel, uint32_t now_ms, uint32_t utc_s)
+        {
+            if (m_state != State::ARMED)
+            {
+                m_stats.missed++;
+                return false;
+            }
+
+            m_state = State::TRIGGERED;
+            m_pre_count = static_cast<uint16_t>(std::min(m_filled, PreSamples));
+            m_post_count = 0;
+            m_header.trigger_channel = static_cast<uint8_t>(std::min<size_t>(channel, NO_TRIGGER_CHANNEL));
+            m_header.trigger_ms = now_ms;
+            m_header.trigger_utc_s = utc_s;
+            m_stats.triggers++;
+            return true;
+        }
+
+        /**
+         * @brief Encode the frozen capture as a blob, see BlobHeader for the layout
+         * @return Blob length, or 0 if nothing is frozen or the buffer is too small
+         */
+        size_t encode(uint8_t *buffer, size_t capacity)
+        {
+            if (m_state != State::FROZEN)
+            {
+                return 0;
+            }
+
+            BlobHeader header = m_header;
+            header.channels = static_cast<uint8_t>(Channels);
+            header.interval_ms = m_interval_ms;
+            header.pre_samples = m_pre_count;
+            header.post_samples = static_cast<uint16_t>(PostSamples);
+            header.sequence = m_stats.captures;
+
+            BlobWriter out(buffer, capacity);
+            write_header(out, header);
+            const size_t count = m_pre_count + PostSamples;
+            const size_t first = (m_head + RING_SAMPLES - count) % RING_SAMPLES;
+            for (size_t c = 0; c < Channels; c++)
+            {
+                uint16_t previous = m_ring[c][first];
+                out.u16(previous);
+                for (size_t i = 1; i < count; i++)
+                {
+                    const uint16_t sample = m_ring[c][(first + i) % RING_SAMPLES];
+                    out.varint(zigzag(static_cast<int32_t>(sample) - static_cast<int32_t>(previous)));
+                    previous = sample;
+                }
+            }
+            out.u32(crc32(buffer, out.size()));
+
+            if (out.failed())
+            {
+                return 0;
+            }
+            m_stats.captures++;
+            m_stats.last_blob_bytes = static_cast<uint32_t>(out.size());
+            return out.size();
+        }
+
+        // Resume recording; the pre-trigger history restarts, since the frozen ring has a gap
+        void rearm(uint32_t now_ms)
+        {
+            m_state = State::ARMED;
+            m_filled = 0;
+            m_interval_start_ms = now_ms;
+            m_sums = {};
+            m_counts = {};
+        }
+
+        State get_state() const { return m_state; }
+        const RecorderStats &get_stats() const { return m_stats; }
+
+    private:
+        uint16_t m_ring[Channels][RING_SAMPLES]{};
+        std::array<uint32_t, Channels> m_sums{};
+        std::array<uint16_t, Channels> m_counts{};
+        size_t m_head{0};   // Next slot to write
+        size_t m_filled{0}; // Valid samples in the ring, up to RING_SAMPLES
+        uint32_t m_interval_start_ms{0};
+        const uint16_t m_interval_ms;
+        uint16_t m_pre_count{0};
+        size_t m_post_count{0};
+        State m_state{State::ARMED};
+        BlobHeader m_header;
+        RecorderStats m_stats;
+    };
+} // namespace pooaway::capture
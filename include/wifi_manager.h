@@ -7,6 +7,17 @@ namespace pooaway
 {
     class WiFiManager
     {
+    public:
+        // Association time, from WiFi.begin() to WL_CONNECTED, by path
+        struct ConnectStats
+        {
+            uint32_t fast_connects{0};  // Joined the cached BSSID/channel directly
+            uint32_t scan_connects{0};  // Full scan
+            uint32_t fast_failures{0};  // Fast attempts that timed out while a scan then found the AP
+            uint32_t last_fast_ms{0};
+            uint32_t last_scan_ms{0};
+        };
+
     private:
         static constexpr char const *TAG = "WiFiManager";
         static constexpr int MAX_RETRIES = 20;
@@ -15,7 +26,17 @@ namespace pooaway
         bool m_is_connected = false;
         std::string m_last_error;
 
+        bool m_connecting = false;
+        bool m_fast_attempt = false;
+        bool m_fast_timed_out = false; // Counted as a fast failure only if the scan finds the AP
+        bool m_static_lease = false;
+        unsigned long m_connect_start_ms = 0;
+        ConnectStats m_stats;
+
         WiFiManager() = default;
+        void start_connect();
+        void fall_back_to_scan();
+        void remember_association();
 
     public:
         static WiFiManager &instance();
@@ -24,7 +45,14 @@ namespace pooaway
         bool ensure_connected();
         bool is_connected() const { return m_is_connected; }
         const std::string &get_last_error() const { return m_last_error; }
+        const ConnectStats &get_connect_stats() const { return m_stats; }
 
         bool sync_time();
+
+        // Non-blocking variants for the boot pipeline: start, then poll on later passes
+        void begin();
+        bool poll_connected();
+        void begin_time_sync();
+        bool is_time_synced() const;
     };
 }
\ No newline at end of file
@@ -1,261 +1,292 @@
+#include "config.h"
+
+#if POOAWAY_WITH_API
 #include "alert_handlers/api_handler.h"
 #include "esp_log.h"
-#include "config.h"
+#include "network_cache.h"
+#include "wifi_manager.h"
 #include "private.h"
 #include <Arduino.h>
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
 
 namespace pooaway::alert
 {
     ApiHandler::ApiHandler(unsigned long rate_limit_ms)
-        : m_rate_limit_ms(rate_limit_ms)
+        : AlertHandler(rate_limit_ms)
     {
         m_type = HandlerType::DATA_PUBLISHER;
     }
 
-    void ApiHandler::init()
+    Result ApiHandler::init()
     {
         ESP_LOGI(TAG, "Initializing API handler");
 
-        // Initialize HTTP client with SSL
-
-        // Initialize sensors one by one with proper error handling
+        // Initialize sensors one by one; the first failure is reported
         const char *sensors[] = {"NH3", "CH4"};
-        bool all_success = true;
+        Result outcome;
         for (const char *sensor : sensors)
         {
-            try
-            {
-                if (!ensure_channel_exists(sensor))
-                {
-                    ESP_LOGE(TAG, "Failed to initialize channel for %s: %s",
-                             sensor, m_last_error.c_str());
-                    all_success = false;
-                    continue;
-                }
-            }
-            catch (const std::exception &e)
+            const Result channel = ensure_channel_exists(sensor);
+            if (!channel)
             {
-                ESP_LOGE(TAG, "Exception initializing channel for %s: %s",
-                         sensor, e.what());
-                all_success = false;
-                continue;
+                ESP_LOGE(TAG, "Failed to initialize channel for %s: %s", sensor, channel.message());
+                outcome = outcome ? channel : outcome;
             }
         }
 
         // Only mark as available if all channels were initialized successfully
-        m_available = all_success;
+        m_available = outcome.is_ok();
         ESP_LOGI(TAG, "API handler initialization %s", m_available ? "successful" : "failed");
+        return outcome;
     }
 
-    bool ApiHandler::ensure_channel_exists(const char *name)
+    Result ApiHandler::ensure_channel_exists(const char *name)
     {
         if (!name)
         {
-            m_last_error = "Invalid sensor name (null)";
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return false;
+            ESP_LOGE(TAG, "Invalid sensor name (null)");
+            return Result::fail(Code::INVALID_ARGUMENT, "Invalid sensor name (null)");
         }
 
         ESP_LOGI(TAG, "Verifying/Creating ThingSpeak channel for %s", name);
 
-        // Convert to lowercase for consistent comparison
-        String sensor_name(name);
-        sensor_name.toLowerCase();
-
-        try
+        if (!find_channel(name))
         {
-            // Set the write API key based on sensor name
-            ChannelInfo info;
-            if (sensor_name == "nh3" || sensor_name == "pee")
-            {
-                info.write_api_key = config::thingspeak::NH3_API_KEY;
-                m_channel_info["pee"] = info; // Store both mappings
-                m_channel_info["nh3"] = info;
-            }
-            else if (sensor_name == "ch4" || sensor_name == "poo")
-            {
-                info.write_api_key = config::thingspeak::CH4_API_KEY;
-                m_channel_info["poo"] = info; // Store both mappings
-                m_channel_info["ch4"] = info;
-            }
-            else
-            {
-                m_last_error = std::string("Unknown sensor type: ") + name;
-                ESP_LOGE(TAG, "%s", m_last_error.c_str());
-                return false;
-            }
-
-            info.read_api_key = config::thingspeak::USER_API_KEY;
-
-            ESP_LOGI(TAG, "Successfully configured channel for %s", name);
-            return true;
-        }
-        catch (const std::exception &e)
-        {
-            m_last_error = std::string("Exception in ensure_channel_exists: ") + e.what();
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return false;
+            ESP_LOGE(TAG, "Unknown sensor type: %s", name);
+            return Result::fail(Code::INVALID_ARGUMENT, "Unknown sensor type");
         }
+
+        ESP_LOGI(TAG, "Successfully configured channel for %s", name);
+        return Result::ok();
     }
 
-    bool ApiHandler::store_channel_info(const char *name, JsonDocument &response)
+    ApiHandler::ChannelInfo *ApiHandler::find_channel(const char *name)
     {
-        String sensor_name(name);
-        sensor_name.toLowerCase();
-
-        // The channel info should already be stored by ensure_channel_exists
-        if (m_channel_info.find(sensor_name) == m_channel_info.end())
+        // Gas and sensor names both map to the channel, in any case
+        if (strcasecmp(name, "nh3") == 0 || strcasecmp(name, "pee") == 0)
         {
-            m_last_error = std::string("Channel info not found for ") + std::string(name);
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return false;
+            return &m_channels[0];
         }
-
-        ESP_LOGI(TAG, "Channel info already configured for %s", name);
-        return true;
+        if (strcasecmp(name, "ch4") == 0 || strcasecmp(name, "poo") == 0)
+        {
+            return &m_channels[1];
+        }
+        return nullptr;
     }
 
-    void ApiHandler::handle_alert(JsonDocument &alert_data)
+    Result ApiHandler::handle_telemetry(JsonDocument &telemetry, PayloadCache &payloads)
     {
-        ESP_LOGV(TAG, "handle_alert called for DATA_PUBLISHER");
+        ESP_LOGV(TAG, "handle_telemetry called for DATA_PUBLISHER");
 
         if (!m_available)
         {
             ESP_LOGW(TAG, "Handler not available, skipping");
-            return;
+            return Result::fail(Code::NOT_READY, "API handler not initialized");
         }
 
-        // Check rate limiting
-        if (m_rate_limit_ms > 0)
+        // Routine telemetry is thinned; documents carrying an alert transition use the reserve
+        const auto traffic = traffic_class(telemetry);
+        if (!m_rate_limiter.admit(traffic))
         {
-            unsigned long now = millis();
-            if (now - m_last_request < m_rate_limit_ms)
-            {
-                ESP_LOGD(TAG, "Rate limited, skipping request. Time since last: %lu ms",
-                         now - m_last_request);
-                return;
-            }
-            m_last_request = now;
+            ESP_LOGD(TAG, "Rate limited, skipping request");
+            return Result::ok();
         }
 
         if (!WiFiManager::instance().ensure_connected())
         {
-            m_last_error = "WiFi connection lost";
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return;
+            ESP_LOGE(TAG, "WiFi connection lost");
+            return Result::fail(Code::NOT_CONNECTED, "WiFi connection lost");
         }
 
-        JsonArrayConst sensors = alert_data["sensors"].as<JsonArrayConst>();
-        ESP_LOGV(TAG, "Processing %u sensors for data publishing", sensors.size());
+        ESP_LOGV(TAG, "Processing %u sensors for data publishing", payloads.sensor_count());
 
-        // Process all sensors regardless of alert status
-        for (JsonObjectConst sensor : sensors)
+        // Process all sensors regardless of alert status; the first failure is reported
+        Result outcome;
+        for (size_t i = 0; i < payloads.sensor_count(); i++)
         {
-            ESP_LOGV(TAG, "Publishing data for sensor %s", sensor["name"].as<const char *>());
-            send_sensor_data(sensor);
+            ESP_LOGV(TAG, "Publishing data for sensor %s", payloads.sensor(i)["name"].as<const char *>());
+            const Result sent = send_sensor_data(payloads, i, traffic);
+            outcome = outcome ? sent : outcome;
+        }
+        return outcome;
+    }
 
-            // ThingSpeak requires 15 seconds between updates
-            delay(15000);
+    pooaway::RateLimiterStats ApiHandler::get_rate_stats() const
+    {
+        // Handler-level pacing plus the per-channel ThingSpeak intervals
+        auto stats = m_rate_limiter.get_stats();
+        for (const auto &info : m_channels)
+        {
+            const auto &channel = info.limiter.get_stats();
+            stats.dropped += channel.dropped;
+            stats.coalesced += channel.coalesced;
         }
+        return stats;
     }
 
-    void ApiHandler::send_sensor_data(JsonObjectConst sensor)
+    Result ApiHandler::send_sensor_data(PayloadCache &payloads, size_t index, pooaway::TrafficClass traffic)
     {
-        String sensor_name(sensor["name"].as<const char *>());
-        sensor_name.toLowerCase();
+        const char *sensor_name = payloads.sensor(index)["name"].as<const char *>();
 
-        if (m_channel_info.find(sensor_name) == m_channel_info.end())
+        // Mux channels have no ThingSpeak channel of their own
+        ChannelInfo *channel = sensor_name ? find_channel(sensor_name) : nullptr;
+        if (!channel)
         {
-            ESP_LOGE(TAG, "No channel info found for %s", sensor_name.c_str());
-            return;
+            ESP_LOGD(TAG, "No channel info found for %s", sensor_name ? sensor_name : "(unnamed)");
+            return Result::ok();
         }
+        auto &channel_info = *channel;
 
-        const auto &channel_info = m_channel_info[sensor_name];
+        // ThingSpeak accepts one update per channel every 15 s. Instead of sleeping, skip the
+        // channel until its bucket refills; the next document carries the latest reading anyway
+        if (!channel_info.limiter.admit(traffic, true))
+        {
+            ESP_LOGD(TAG, "ThingSpeak interval for %s not elapsed, coalescing", sensor_name);
+            return Result::ok();
+        }
 
         ESP_LOGV(TAG, "Sending data for sensor %s with API key %s",
-                 sensor_name.c_str(),
-                 channel_info.write_api_key.c_str());
-
-        // Create bulk update payload following ThingSpeak format
-        JsonDocument payload_doc;
-        payload_doc["write_api_key"] = channel_info.write_api_key;
-        JsonArray updates = payload_doc["updates"].to<JsonArray>();
+                 sensor_name,
+                 channel_info.write_api_key);
 
-        JsonObject update = updates.add<JsonObject>();
-
-        // Get current timestamp
-        struct tm timeinfo;
-        if (!getLocalTime(&timeinfo))
+        // The update object is encoded once per interval; only the bulk update envelope is ours
+        const PayloadView update = payloads.get(PayloadFormat::THINGSPEAK_UPDATE, index);
+        if (update.empty())
         {
-            ESP_LOGE(TAG, "Failed to obtain time");
-            return;
+            ESP_LOGE(TAG, "No update payload for %s (payload cache full)", sensor_name);
+            return Result::fail(Code::NO_SPACE, "No update payload (payload cache full)");
         }
 
-        char timestamp[30];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo); // Remove timezone
-        update["created_at"] = timestamp;
-
-        // Add all fields
-        update["field1"] = sensor["readings"]["value"].as<float>();
-        update["field2"] = sensor["readings"]["baseline"].as<float>();
-        update["field3"] = sensor["readings"]["voltage"].as<float>();
-        update["field4"] = sensor["readings"]["rs"].as<float>();
-        update["field5"] = sensor["readings"]["r0"].as<float>();
-        update["field6"] = sensor["readings"]["ratio"].as<float>();
-        update["field7"] = sensor["alert"].as<bool>();
-        update["field8"] = sensor["calibration"]["preheating_time"].as<int>();
-
-        String payload;
-        serializeJson(payload_doc, payload);
-        ESP_LOGV(TAG, "Sending payload: %s", payload.c_str());
+        char payload[512];
+        const int framed = snprintf(payload, sizeof(payload), "{\"write_api_key\":\"%s\",\"updates\":[%.*s]}",
+                                    channel_info.write_api_key, static_cast<int>(update.length), update.data);
+        if (framed < 0 || static_cast<size_t>(framed) >= sizeof(payload))
+        {
+            ESP_LOGE(TAG, "Update payload for %s too large (%d bytes)", sensor_name, framed);
+            return Result::fail(Code::NO_SPACE, "Update payload too large");
+        }
+        const size_t payload_length = static_cast<size_t>(framed);
+        ESP_LOGV(TAG, "Sending payload: %s", payload);
 
         // Use ThingSpeak's bulk update endpoint with channel ID
-        String url = "https://api.thingspeak.com/channels/";
-        url += (sensor_name == "pee" || sensor_name == "nh3") ? config::thingspeak::NH3_CHANNEL_ID : config::thingspeak::CH4_CHANNEL_ID;
-        url += "/bulk_update.json";
+        char url[URL_BYTES];
+        const int url_length = snprintf(url, sizeof(url), "https://%s/channels/%s/bulk_update.json",
+                                        config::thingspeak::HOST, channel_info.channel_id);
+        if (url_length < 0 || static_cast<size_t>(url_length) >= sizeof(url))
+        {
+            ESP_LOGE(TAG, "Update URL for %s too long", sensor_name);
+            return Result::fail(Code::NO_SPACE, "Update URL too long");
+        }
 
         // Ensure we end any previous connection
         m_http_client.end();
         
         // Configure secure client
         m_secure_client.setInsecure(); // For ThingSpeak we can use insecure mode
-        
-        // Begin new connection with retry logic
+
+        // Connect to the cached address first; HTTPClient reuses a connected client instead of
+        // resolving the host again. A cached address that no longer answers is forgotten and
+        // HTTPClient resolves the host itself
+        auto &network_cache = NetworkCache::instance();
+        unsigned long connect_start = millis();
+        IPAddress address;
+        bool cached = false;
+        if (network_cache.resolve(config::thingspeak::HOST, address, cached) &&
+            !m_secure_client.connect(address, config::thingspeak::HTTPS_PORT, config::thingspeak::HOST, nullptr, nullptr, nullptr) &&
+            cached)
+        {
+            network_cache.forget_host(config::thingspeak::HOST);
+            cached = false;
+        }
+
+        // Begin new connection with retry logic; a request that went out still spent the update interval
+        Result outcome = Result::fail(Code::NOT_CONNECTED, "Failed to begin HTTP client");
         int retries = 3;
         while (retries > 0) {
             if (m_http_client.begin(m_secure_client, url)) {
                 m_http_client.addHeader("Content-Type", "application/json");
                 m_http_client.setTimeout(config::api::TIMEOUT_MS);
                 
-                int httpCode = m_http_client.POST(payload);
+                int httpCode = m_http_client.POST(reinterpret_cast<uint8_t *>(payload), payload_length);
                 
                 if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_ACCEPTED) {
-                    String response = m_http_client.getString();
-                    ESP_LOGI(TAG, "ThingSpeak Response: %s", response.c_str());
+                    network_cache.record_first_byte(cached, millis() - connect_start);
+                    char response[RESPONSE_LOG_BYTES];
+                    const size_t response_length = drain_response(response, sizeof(response));
+                    ESP_LOGI(TAG, "ThingSpeak Response (%u bytes): %s", static_cast<unsigned>(response_length), response);
                     m_http_client.end();
-                    return; // Success, exit function
+                    return Result::ok(); // Success, exit function
                 }
                 
                 if (httpCode == -11) { // Timeout
                     ESP_LOGW(TAG, "HTTP POST timeout, retrying... (%d attempts left)", retries - 1);
+                    outcome = Result::fail(Code::TIMEOUT, "ThingSpeak POST timed out");
                     retries--;
                     m_http_client.end();
                     delay(1000); // Wait before retry
+                    connect_start = millis(); // The retry connects and resolves on its own
+                    cached = false;
                     continue;
                 }
                 
                 // Other errors
                 ESP_LOGE(TAG, "HTTP POST failed, code: %d", httpCode);
+                outcome = Result::fail(httpCode > 0 ? Code::REJECTED : Code::NOT_CONNECTED, "ThingSpeak POST failed");
                 break;
             }
             
             ESP_LOGE(TAG, "Failed to begin HTTP client");
             retries--;
             delay(1000);
+            connect_start = millis();
         }
 
         // Always ensure connection is closed
         m_http_client.end();
         delay(100); // Give some time for socket cleanup
+        return outcome;
     }
-} // namespace pooaway::alert
\ No newline at end of file
+
+    size_t ApiHandler::drain_response(char *head, size_t head_size)
+    {
+        // Reads the body through a stack buffer instead of getString(), keeping its head for the
+        // log, so a successful update does not allocate; end() discards anything still in flight
+        head[0] = '\0';
+        WiFiClient *stream = m_http_client.getStreamPtr();
+        if (!stream)
+        {
+            return 0;
+        }
+
+        int remaining = m_http_client.getSize(); // -1 when the server did not send a length
+        size_t total = 0;
+        uint8_t chunk[64];
+        while (remaining != 0 && stream->available() > 0)
+        {
+            size_t wanted = sizeof(chunk);
+            if (remaining > 0 && static_cast<size_t>(remaining) < wanted)
+            {
+                wanted = static_cast<size_t>(remaining);
+            }
+            const int got = stream->read(chunk, wanted);
+            if (got <= 0)
+            {
+                break;
+            }
+
+            if (total < head_size - 1)
+            {
+                const size_t kept = std::min(static_cast<size_t>(got), head_size - 1 - total);
+                memcpy(head + total, chunk, kept);
+                head[total + kept] = '\0';
+            }
+            total += static_cast<size_t>(got);
+            remaining = remaining > 0 ? remaining - got : remaining;
+        }
+        return total;
+    }
+} // namespace pooaway::alert
+
+#endif // POOAWAY_WITH_API
@@ -7,56 +7,46 @@ namespace pooaway::alert
 {
 
     BuzzerHandler::BuzzerHandler(unsigned long rate_limit_ms)
-        : m_rate_limit_ms(rate_limit_ms)
+        : AlertHandler(rate_limit_ms)
     {
         m_type = HandlerType::ALERT_ONLY; // Buzzer only needs alerts
     }
 
-    void BuzzerHandler::init()
+    Result BuzzerHandler::init()
     {
         ESP_LOGI(TAG, "Initializing buzzer handler");
-        pinMode(config::hardware::BUZZER_PIN, OUTPUT);
-        m_available = true;
-        if (m_rate_limit_ms > 0)
+        if (!m_player.begin(config::hardware::BUZZER_PIN))
         {
-            ESP_LOGI(TAG, "Rate limiting enabled: %lu ms", m_rate_limit_ms);
+            return Result::fail(Code::NOT_READY, "No RMT channel for the buzzer");
         }
+        m_available = true;
+        return Result::ok();
     }
 
-    void BuzzerHandler::handle_alert(JsonDocument &alert_data)
+    Result BuzzerHandler::handle_alert(JsonDocument &alert_data)
     {
         if (!m_available)
-            return;
-
-        // Check rate limiting
-        if (m_rate_limit_ms > 0)
-        {
-            unsigned long now = millis();
-            if (now - m_last_request < m_rate_limit_ms)
-            {
-                return;
-            }
-            m_last_request = now;
-        }
+            return Result::fail(Code::NOT_READY, "Buzzer handler not initialized");
 
         auto sensors = alert_data["sensors"].as<JsonArray>();
 
+        // Different tones for different sensors; only one plays even if several alert
+        pooaway::pattern::TonePattern pattern = pooaway::pattern::TONE_SILENT;
         for (JsonObject sensor : sensors)
         {
             if (sensor["alert"].as<bool>())
             {
-                // Different tones for different sensors
-                int base_freq = 2000;
-                int freq_offset = sensor["index"].as<int>() * 200;
-                play_tone(base_freq + freq_offset, 100);
-                return; // Play only one tone even if multiple alerts
+                pattern = pooaway::pattern::alert_tone(sensor["index"].as<size_t>());
+                break;
             }
         }
-    }
 
-    void BuzzerHandler::play_tone(int frequency_hz, int duration_ms)
-    {
-        tone(config::hardware::BUZZER_PIN, frequency_hz, duration_ms);
+        // RMT repeats the beeps until the state changes; an unchanged refresh writes nothing
+        if (!m_player.play(pattern))
+        {
+            return Result::fail(Code::INVALID_DATA, "Buzzer pattern could not be programmed");
+        }
+        return Result::ok();
     }
 
 } // namespace pooaway::alert
\ No newline at end of file
@@ -7,56 +7,47 @@ namespace pooaway::alert
 {
 
     LedHandler::LedHandler(unsigned long rate_limit_ms)
-        : m_rate_limit_ms(rate_limit_ms) {}
+        : AlertHandler(rate_limit_ms)
+    {
+        m_type = HandlerType::ALERT_ONLY; // LED only reflects alert state
+    }
 
-    void LedHandler::init()
+    Result LedHandler::init()
     {
         ESP_LOGI(TAG, "Initializing LED handler");
-        pinMode(config::hardware::LED_PIN, OUTPUT);
-        m_available = true;
-        if (m_rate_limit_ms > 0)
+        if (!m_player.begin(config::hardware::LED_PIN))
         {
-            ESP_LOGI(TAG, "Rate limiting enabled: %lu ms", m_rate_limit_ms);
+            return Result::fail(Code::NOT_READY, "No LEDC channel for the LED");
         }
+        m_available = true;
+        return Result::ok();
     }
 
-    void LedHandler::handle_alert(JsonDocument &alert_data)
+    Result LedHandler::handle_alert(JsonDocument &alert_data)
     {
         if (!m_available)
-            return;
+            return Result::fail(Code::NOT_READY, "Led handler not initialized");
 
-        // Check rate limiting
-        if (m_rate_limit_ms > 0)
-        {
-            unsigned long now = millis();
-            if (now - m_last_request < m_rate_limit_ms)
-            {
-                return;
-            }
-            m_last_request = now;
-        }
-
-        bool any_alert = false;
+        size_t alerting = 0;
         JsonArray sensors = alert_data["sensors"].as<JsonArray>();
 
         for (const JsonObject &sensor : sensors)
         {
             if (sensor["alert"].as<bool>())
             {
-                any_alert = true;
-                break;
+                alerting++;
             }
         }
 
-        if (any_alert)
-        {
-            m_led_state = !m_led_state;
-            digitalWrite(config::hardware::LED_PIN, m_led_state);
-        }
-        else
+        // LEDC blinks or fades out on its own; the periodic refresh of an unchanged state writes nothing
+        const auto &pattern = alerting == 0   ? pooaway::pattern::LED_CLEAR
+                              : alerting == 1 ? pooaway::pattern::LED_ALERT
+                                              : pooaway::pattern::LED_MULTI_ALERT;
+        if (!m_player.play(pattern))
         {
-            digitalWrite(config::hardware::LED_PIN, LOW);
+            return Result::fail(Code::INVALID_DATA, "LED pattern could not be programmed");
         }
+        return Result::ok();
     }
 
 } // namespace pooaway::alert
\ No newline at end of file
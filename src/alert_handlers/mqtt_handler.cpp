@@ -1,144 +1,312 @@
+#include "config.h"
+
+#if POOAWAY_WITH_MQTT
 #include "alert_handlers/mqtt_handler.h"
+#include "network_cache.h"
 #include "wifi_manager.h"
 #include "esp_log.h"
-#include "config.h"
 #include <Arduino.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
 
 namespace pooaway::alert
 {
+    using pooaway::mqtt::PayloadPart;
+    using pooaway::mqtt::PublishResult;
+
+    namespace
+    {
+        constexpr pooaway::mqtt::SessionConfig SESSION_CONFIG{
+            config::mqtt::CLIENT_ID,
+            config::mqtt::USERNAME,
+            config::mqtt::PASSWORD,
+            config::mqtt::KEEPALIVE_S,
+            config::mqtt::CONNECT_TIMEOUT_MS,
+            config::mqtt::RETRANSMIT_MS,
+            config::mqtt::MAX_ATTEMPTS,
+            config::mqtt::INFLIGHT_WINDOW,
+        };
+
+        // Per-sensor frames go out together each interval; any past the window would be dropped
+        static_assert(config::mqtt::PACK_SENSORS || config::mqtt::INFLIGHT_WINDOW >= 2 + 2 * config::mux::PAIR_COUNT,
+                      "INFLIGHT_WINDOW must hold one frame per sensor, or set PACK_SENSORS");
+
+        // <prefix>/sensors/<lowercase name>, without going through String
+        void sensor_topic(char *topic, size_t size, const char *name)
+        {
+            const int n = snprintf(topic, size, "%s/sensors/", config::mqtt::FEED_PREFIX);
+            size_t pos = (n > 0) ? std::min(static_cast<size_t>(n), size - 1) : 0;
+            for (; name && *name && pos + 1 < size; name++)
+            {
+                topic[pos++] = static_cast<char>(tolower(static_cast<unsigned char>(*name)));
+            }
+            topic[pos] = '\0';
+        }
+    }
 
     MqttHandler::MqttHandler(unsigned long rate_limit_ms)
-        : m_rate_limit_ms(rate_limit_ms), m_mqtt_client(m_wifi_client)
+        : AlertHandler(rate_limit_ms), m_session(m_wifi_client, SESSION_CONFIG)
     {
         m_type = HandlerType::DATA_PUBLISHER; // MQTT publishes all data
-        m_mqtt_client.setBufferSize(512);
     }
 
-    void MqttHandler::init()
+    Result MqttHandler::init()
     {
         ESP_LOGI(TAG, "Initializing MQTT handler");
 
         if (!WiFiManager::instance().ensure_connected())
         {
-            m_last_error = "WiFi not connected";
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return;
+            ESP_LOGE(TAG, "WiFi not connected");
+            return Result::fail(Code::NOT_CONNECTED, "WiFi not connected");
         }
 
-        m_mqtt_client.setServer(config::mqtt::BROKER, config::mqtt::PORT);
-
-        if (connect())
+        const Result connected = connect();
+        if (connected)
         {
             m_available = true;
-            ESP_LOGI(TAG, "MQTT handler initialized");
-            if (m_rate_limit_ms > 0)
+            ESP_LOGI(TAG, "MQTT handler initialized (QoS %u, window %u, %s)", config::mqtt::QOS,
+                     static_cast<unsigned>(m_session.window()),
+                     config::mqtt::PACK_SENSORS ? "one frame per interval" : "one frame per sensor");
+            if (m_rate_limiter.get_period_ms() > 0)
             {
-                ESP_LOGI(TAG, "Rate limiting enabled: %lu ms", m_rate_limit_ms);
+                ESP_LOGI(TAG, "Rate limiting enabled: %lu ms", m_rate_limiter.get_period_ms());
             }
         }
+        return connected;
     }
 
-    void MqttHandler::handle_alert(JsonDocument &alert_data)
+    Result MqttHandler::handle_telemetry(JsonDocument &telemetry, PayloadCache &payloads)
     {
         if (!m_available)
-            return;
+            return Result::fail(Code::NOT_READY, "MQTT handler not initialized");
 
-        // Check rate limiting
-        if (m_rate_limit_ms > 0)
+        // Routine telemetry is thinned; documents carrying an alert transition use the reserve
+        if (!m_rate_limiter.admit(traffic_class(telemetry)))
         {
-            unsigned long now = millis();
-            if (now - m_last_request < m_rate_limit_ms)
+            ESP_LOGD(TAG, "Rate limited, skipping publish");
+            return Result::ok();
+        }
+
+        const Result session = ensure_session();
+        if (!session)
+        {
+            return session;
+        }
+
+        // PUBACKs of the previous interval free their window slots before new frames go out
+        m_session.poll();
+        const Result published = config::mqtt::PACK_SENSORS ? publish_packed(payloads) : publish_sensors(payloads);
+        m_session.poll();
+
+        const unsigned long now = millis();
+        if (now - m_last_stats_log >= config::alerts::STATS_LOG_INTERVAL_MS)
+        {
+            m_last_stats_log = now;
+            log_session_stats();
+        }
+        return published;
+    }
+
+    Result MqttHandler::publish_sensors(PayloadCache &payloads)
+    {
+        // Process all sensors regardless of alert status; the first failure is reported
+        Result outcome;
+        char topic[TOPIC_SIZE];
+        for (size_t i = 0; i < payloads.sensor_count(); i++)
+        {
+            sensor_topic(topic, sizeof(topic), payloads.sensor(i)["name"].as<const char *>());
+
+            // Encoded once per interval and shared with any other publisher using this format
+            const PayloadView payload = payloads.get(PayloadFormat::SENSOR_JSON, i);
+            if (payload.empty())
+            {
+                ESP_LOGE(TAG, "No payload for %s", topic);
+                outcome = outcome ? Result::fail(Code::NO_SPACE, "Payload did not fit the cache") : outcome;
+                continue;
+            }
+
+            const PayloadPart part{payload.data, payload.length};
+            const Result published = publish(topic, &part, 1);
+            if (published)
             {
-                ESP_LOGD(TAG, "Rate limited, skipping publish");
-                return;
+                ESP_LOGI(TAG, "Published to %s: %s", topic, payload.data);
             }
-            m_last_request = now;
+            outcome = outcome ? published : outcome;
         }
+        return outcome;
+    }
 
-        // First ensure WiFi is connected
-        if (!WiFiManager::instance().ensure_connected())
+    Result MqttHandler::publish_packed(PayloadCache &payloads)
+    {
+        // One <prefix>/sensors frame holding a JSON array of the per-sensor messages
+        std::array<PayloadPart, 2 * PayloadCache::MAX_SENSORS + 1> parts;
+        size_t count = 0;
+        parts[count++] = PayloadPart{"[", 1};
+        for (size_t i = 0; i < payloads.sensor_count(); i++)
         {
-            m_last_error = "WiFi connection lost";
-            ESP_LOGE(TAG, "%s", m_last_error.c_str());
-            return;
+            const PayloadView payload = payloads.get(PayloadFormat::SENSOR_JSON, i);
+            if (payload.empty())
+            {
+                ESP_LOGE(TAG, "No payload for sensor %u", static_cast<unsigned>(i));
+                continue;
+            }
+            if (count > 1)
+            {
+                parts[count++] = PayloadPart{",", 1};
+            }
+            parts[count++] = PayloadPart{payload.data, payload.length};
         }
+        if (count == 1)
+        {
+            return Result::fail(Code::NO_SPACE, "No sensor payload fit the cache");
+        }
+        parts[count++] = PayloadPart{"]", 1};
 
-        // Then check MQTT connection
-        if (!m_mqtt_client.connected() && !connect())
+        char topic[TOPIC_SIZE];
+        snprintf(topic, sizeof(topic), "%s/sensors", config::mqtt::FEED_PREFIX);
+        const Result published = publish(topic, parts.data(), count);
+        if (published)
         {
-            return;
+            ESP_LOGI(TAG, "Published %u sensors to %s", static_cast<unsigned>(payloads.sensor_count()), topic);
         }
+        return published;
+    }
 
-        // Process all sensors regardless of alert status
-        auto sensors = alert_data["sensors"].as<JsonArray>();
-        for (JsonObject sensor : sensors)
+    Result MqttHandler::publish(const char *topic, const PayloadPart *parts, size_t count)
+    {
+        const PublishResult result = m_session.publish(topic, parts, count, config::mqtt::QOS);
+        switch (result)
         {
-            String sensor_name = sensor["name"].as<const char *>();
-            sensor_name.toLowerCase(); // Convert to lowercase for consistent naming
+        case PublishResult::SENT:
+        case PublishResult::IN_FLIGHT:
+            return Result::ok();
+        case PublishResult::WINDOW_FULL:
+            // The broker is behind; the next interval carries newer readings anyway
+            ESP_LOGW(TAG, "In-flight window full (%u), skipping %s", static_cast<unsigned>(m_session.window()), topic);
+            return Result::fail(Code::NO_SPACE, "MQTT in-flight window full");
+        case PublishResult::TOO_LARGE:
+            ESP_LOGE(TAG, "Frame for %s exceeds %u bytes", topic, static_cast<unsigned>(config::mqtt::FRAME_BYTES));
+            return Result::fail(Code::NO_SPACE, "MQTT frame too large");
+        default:
+            ESP_LOGE(TAG, "Failed to publish to %s", topic);
+            return Result::fail(Code::NOT_CONNECTED, "MQTT connection lost");
+        }
+    }
 
-            String topic = String(MQTT_FEED_PREFIX) + "/sensors/" + sensor_name;
+    Result MqttHandler::handle_event(JsonDocument &event_data)
+    {
+        if (!m_available)
+            return Result::fail(Code::NOT_READY, "MQTT handler not initialized");
 
-            // Create a new payload document for each sensor
-            JsonDocument payload_doc;
+        // Events are rare and carry the summary consumers act on, so they bypass rate limiting
+        const Result session = ensure_session();
+        if (!session)
+        {
+            return session;
+        }
 
-            // Basic info
-            payload_doc["sensor"] = sensor["name"].as<const char *>();
-            payload_doc["model"] = sensor["model"].as<const char *>();
+        // A record naming many mux sensors can outgrow the buffer; refuse it rather than send cut JSON
+        const size_t n = measureJson(event_data);
+        if (n >= EVENT_BYTES)
+        {
+            ESP_LOGE(TAG, "Event record of %u bytes exceeds %u", static_cast<unsigned>(n),
+                     static_cast<unsigned>(EVENT_BYTES));
+            return Result::fail(Code::INVALID_DATA, "Event record too large");
+        }
 
-            // Readings
-            const auto readings = sensor["readings"].as<JsonObject>();
-            payload_doc["ppm"] = readings["value"].as<float>();
-            payload_doc["baseline_ppm"] = readings["baseline"].as<float>();
-            payload_doc["voltage"] = readings["voltage"].as<float>();
-            payload_doc["rs"] = readings["rs"].as<float>();
-            payload_doc["r0"] = readings["r0"].as<float>();
-            payload_doc["ratio"] = readings["ratio"].as<float>();
-            payload_doc["alert"] = sensor["alert"].as<bool>();
+        char topic[TOPIC_SIZE];
+        snprintf(topic, sizeof(topic), "%s/events", config::mqtt::FEED_PREFIX);
+        char buffer[EVENT_BYTES];
+        serializeJson(event_data, buffer, sizeof(buffer));
 
-            // Calibration data
-            const auto cal = sensor["calibration"].as<JsonObject>();
-            payload_doc["preheating_time"] = cal["preheating_time"].as<int>();
-            payload_doc["cal_a"] = cal["a"].as<float>();
-            payload_doc["cal_b"] = cal["b"].as<float>();
+        m_session.poll();
+        const PayloadPart part{buffer, n};
+        const Result published = publish(topic, &part, 1);
+        if (published)
+        {
+            ESP_LOGI(TAG, "Published event to %s: %s", topic, buffer);
+        }
+        m_session.poll();
+        return published;
+    }
 
-            // Use buffer for more efficient publishing
-            char buffer[1024];
-            size_t n = serializeJson(payload_doc, buffer);
+    void MqttHandler::poll()
+    {
+        // Telemetry is thinned during events and by the rate limiter, so PINGREQ, PUBACK matching
+        // and retransmits cannot wait for the next publish; reconnecting is left to the publish path
+        m_session.poll();
+    }
 
-            if (m_mqtt_client.publish(topic.c_str(), buffer, n))
-            {
-                ESP_LOGI(TAG, "Published to %s: %s", topic.c_str(), buffer);
-            }
-            else
-            {
-                ESP_LOGE(TAG, "Failed to publish to %s", topic.c_str());
-            }
+    Result MqttHandler::ensure_session()
+    {
+        // First ensure WiFi is connected
+        if (!WiFiManager::instance().ensure_connected())
+        {
+            ESP_LOGE(TAG, "WiFi connection lost");
+            return Result::fail(Code::NOT_CONNECTED, "WiFi connection lost");
         }
 
-        m_mqtt_client.loop();
+        // Then check MQTT connection
+        return m_session.connected() ? Result::ok() : connect();
     }
 
-    bool MqttHandler::connect()
+    Result MqttHandler::connect()
     {
         int retries = 0;
-        while (!m_mqtt_client.connected() && retries < MAX_RETRIES)
+        while (retries < MAX_RETRIES)
         {
             ESP_LOGI(TAG, "Attempting MQTT connection...");
 
-            if (m_mqtt_client.connect(MQTT_CLIENT_ID, MQTT_USERNAME, MQTT_PASSWORD))
+            // The broker's cached address saves the DNS round trip; the client parses a dotted
+            // quad without a lookup
+            auto &network_cache = NetworkCache::instance();
+            const unsigned long connect_start = millis();
+            IPAddress address;
+            bool cached = false;
+            char host[16];
+            const char *target = config::mqtt::BROKER;
+            if (network_cache.resolve(config::mqtt::BROKER, address, cached))
             {
-                ESP_LOGI(TAG, "Connected to MQTT broker");
-                return true;
+                snprintf(host, sizeof(host), "%u.%u.%u.%u", address[0], address[1], address[2], address[3]);
+                target = host;
             }
 
-            ESP_LOGW(TAG, "Failed to connect to MQTT, rc=%d", m_mqtt_client.state());
+            // Messages still waiting for a PUBACK are resent once the session is back
+            if (m_session.connect(target, config::mqtt::PORT))
+            {
+                network_cache.record_first_byte(cached, millis() - connect_start);
+                ESP_LOGI(TAG, "Connected to MQTT broker, %u messages in flight",
+                         static_cast<unsigned>(m_session.in_flight()));
+                return Result::ok();
+            }
+
+            ESP_LOGW(TAG, "Failed to connect to MQTT, rc=%d", m_session.connack_code());
+            if (cached && m_session.connack_code() < 0) // No answer at all, not a refusal
+            {
+                network_cache.forget_host(config::mqtt::BROKER);
+            }
             delay(RETRY_DELAY_MS);
             retries++;
         }
 
-        m_last_error = "Failed to connect to MQTT broker";
-        ESP_LOGE(TAG, "%s", m_last_error.c_str());
-        return false;
+        ESP_LOGE(TAG, "Failed to connect to MQTT broker");
+        return Result::fail(Code::NOT_CONNECTED, "Failed to connect to MQTT broker");
     }
 
-} // namespace pooaway::alert
\ No newline at end of file
+    void MqttHandler::log_session_stats() const
+    {
+        const auto &stats = m_session.get_stats();
+        const unsigned long mean_rtt_ms = stats.acked ? stats.total_rtt_ms / stats.acked : 0;
+        ESP_LOGI(TAG, "Session: %lu connects, %lu published, %lu acked, %lu retransmits, %lu expired, "
+                      "%lu window full, max %u in flight, RTT mean %lu ms max %lu ms, %lu frames %llu bytes",
+                 static_cast<unsigned long>(stats.connects), static_cast<unsigned long>(stats.published),
+                 static_cast<unsigned long>(stats.acked), static_cast<unsigned long>(stats.retransmits),
+                 static_cast<unsigned long>(stats.expired), static_cast<unsigned long>(stats.window_full),
+                 static_cast<unsigned>(stats.max_in_flight), mean_rtt_ms, static_cast<unsigned long>(stats.max_rtt_ms),
+                 static_cast<unsigned long>(stats.frames_written), static_cast<unsigned long long>(stats.bytes_written));
+    }
+
+} // namespace pooaway::alert
+
+#endif // POOAWAY_WITH_MQTT
@@ -1,15 +1,29 @@
 #include "alert_manager.h"
 #include "esp_log.h"
 #include "config.h"
-#include "sensors.h"
 #include "sensor_manager.h"
+#include "state_store.h"
+#include "boot_pipeline.h"
+#include "trace_log.h"
+#include "json_arena.h"
+#include "time_service.h"
 #include <algorithm>
+#include <array>
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <WiFi.h>
+#include <cstdio>
+#include <esp_mac.h>
 
 namespace pooaway::alert
 {
+    namespace
+    {
+        char payload_storage[config::json::PAYLOAD_BUFFER_BYTES];
+
+        static_assert(pooaway::sensors::EventDetector::MAX_PAIRS * pooaway::sensors::EventDetector::PAIR_CHANNELS >=
+                          pooaway::sensors::SensorManager::MAX_CHANNELS,
+                      "Every sensor pair needs an event detector");
+    }
 
     AlertManager &AlertManager::instance()
     {
@@ -17,120 +31,549 @@ namespace pooaway::alert
         return instance;
     }
 
-    AlertManager::AlertManager() = default;
+    AlertManager::AlertManager()
+        : m_deferred_doc(&pooaway::JsonArena::telemetry()),
+          m_payloads(payload_storage, sizeof(payload_storage), &pooaway::JsonArena::scratch())
+    {
+        for (size_t pair = 0; pair < m_event_detectors.size(); pair++)
+        {
+            m_event_detectors[pair].set_pair(static_cast<uint8_t>(pair));
+        }
+    }
 
     void AlertManager::init()
     {
         ESP_LOGI(TAG, "Initializing alert manager");
-        for (auto handler : m_handlers)
+
+        // Read from eFuse once, so the sensor-only build needs no WiFi and no payload formats a String
+        uint8_t mac[6]{};
+        esp_read_mac(mac, ESP_MAC_WIFI_STA);
+        std::snprintf(m_device_id, sizeof(m_device_id), "%02X:%02X:%02X:%02X:%02X:%02X",
+                      mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        pooaway::sensors::EventDetector::set_next_id(pooaway::StateStore::instance().get_next_event_id());
+        init_handlers(false);
+    }
+
+    void AlertManager::init_network_handlers()
+    {
+        ESP_LOGI(TAG, "Initializing network handlers");
+        init_handlers(true);
+    }
+
+    void AlertManager::init_handlers(bool network_ready)
+    {
+        for (auto &slot : m_handlers)
         {
-            try
+            auto *handler = slot.handler;
+            if (handler->is_initialized() || (handler->requires_network() && !network_ready))
             {
-                handler->init();
-                if (!handler->is_available())
-                {
-                    ESP_LOGW(TAG, "Handler initialization failed: %s",
-                             handler->get_last_error().c_str());
-                }
+                continue;
             }
-            catch (const std::exception &e)
+
+            const Result result = handler->ensure_initialized();
+            record_result(slot, result);
+            if (!result || !handler->is_available())
             {
-                ESP_LOGE(TAG, "Handler initialization error: %s", e.what());
+                ESP_LOGW(TAG, "Handler %s initialization failed: %s", handler->get_name(), result.message());
             }
         }
     }
 
-    void AlertManager::update(const bool alerts[pooaway::sensors::SENSOR_COUNT])
+    void AlertManager::update(const bool *alerts, size_t count)
     {
         const unsigned long now = millis();
 
-        if (now - m_last_alert < config::alerts::ALERT_INTERVAL)
+        // Event tracking runs every pass so start/close are not delayed by ALERT_INTERVAL
+        update_events(now, alerts, count);
+
+        uint32_t alert_mask = 0;
+        for (size_t i = 0; i < count && i < 32; i++)
         {
-            return;
+            alert_mask |= alerts[i] ? (1UL << i) : 0;
+        }
+        const bool edge = (alert_mask != m_alert_mask);
+        m_alert_mask = alert_mask;
+
+        const bool interval_due = (now - m_last_alert >= config::alerts::ALERT_INTERVAL);
+
+        // Local actuators react to edges straight away; the interval only keeps them refreshed
+        if (edge || interval_due)
+        {
+            // An edge has been due since the scan read it, not since the scan finished
+            const unsigned long due_us =
+                edge ? pooaway::sensors::SensorManager::instance().get_edge_us() : micros();
+            dispatch_local(due_us, edge, alerts, count);
+        }
+
+        if (interval_due)
+        {
+            m_last_alert = now;
+            // A build without publishers has no reader for the telemetry document
+            if constexpr (config::features::DATA_PUBLISHERS)
+            {
+                // While an event is open its start/close records carry it, so only alert
+                // transitions and a slow refresh still go out
+                const bool thinned = is_event_open() && alert_mask == m_published_mask &&
+                                     now - m_last_telemetry_ms < config::events::TELEMETRY_INTERVAL_MS;
+                if (thinned)
+                {
+                    m_thinned_telemetry++;
+                }
+                else
+                {
+                    queue_telemetry(now, alert_mask, alerts, count);
+                }
+            }
+        }
+
+        if constexpr (config::features::DATA_PUBLISHERS)
+        {
+            dispatch_deferred();
+        }
+
+        if (now - m_last_stats_log >= config::alerts::STATS_LOG_INTERVAL_MS)
+        {
+            m_last_stats_log = now;
+            log_dispatch_stats();
+        }
+    }
+
+    void AlertManager::poll_handlers()
+    {
+        for (auto &slot : m_handlers)
+        {
+            if (slot.handler->is_initialized() && slot.handler->is_available())
+            {
+                slot.handler->poll();
+            }
+        }
+    }
+
+    void AlertManager::queue_telemetry(unsigned long now, uint32_t alert_mask, const bool *alerts, size_t count)
+    {
+        const bool with_diagnostics = (now - m_last_diagnostics_export >= config::alerts::DIAGNOSTICS_INTERVAL_MS);
+        if (with_diagnostics)
+        {
+            m_last_diagnostics_export = now;
         }
 
-        m_last_alert = now;
-        ESP_LOGV(TAG, "Creating alert data document");
+        m_last_telemetry_ms = now;
+        m_deferred_captured_us = pooaway::TimeService::capture_us();
+        build_telemetry(m_deferred_doc, now, alerts, count, with_diagnostics);
+        m_deferred_doc["transition"] = (alert_mask != m_published_mask);
+        m_published_mask = alert_mask;
+        reset_payloads();
+        m_deferred_due_us = micros();
+        for (auto &slot : m_handlers)
+        {
+            if (slot.handler->get_type() == HandlerType::DATA_PUBLISHER)
+            {
+                slot.pending = true; // A handler still owed the previous document gets this one
+            }
+        }
+    }
 
-        JsonDocument doc;
-        doc["device_id"] = WiFi.macAddress();
+    void AlertManager::build_telemetry(JsonDocument &doc, unsigned long now, const bool *alerts, size_t count,
+                                       bool with_diagnostics)
+    {
+        TRACE_LOGV(TAG, "Creating alert data document");
+        doc.clear();
+        doc["device_id"] = m_device_id;
         doc["timestamp"] = now;
 
         auto sensors_array = doc["sensors"].to<JsonArray>();
-        ESP_LOGV(TAG, "Processing sensors data");
+        TRACE_LOGV(TAG, "Processing sensors data");
 
-        // Add all sensors regardless of alert status
-        for (size_t i = 0; i < pooaway::sensors::SENSOR_COUNT; i++)
+        // Add all sensor channels regardless of alert status
+        auto &sensor_manager = pooaway::sensors::SensorManager::instance();
+        for (size_t i = 0; i < count; i++)
         {
+            // Get sensor instance from SensorManager
+            auto *sensor_ptr = sensor_manager.get_channel(i);
+            if (!sensor_ptr)
+                continue;
+
             auto sensor = sensors_array.add<JsonObject>();
             sensor["index"] = i;
-            sensor["name"] = ::sensors[i].name;
-            sensor["model"] = ::sensors[i].model;
+            sensor["name"] = sensor_ptr->get_name();
+            sensor["model"] = sensor_ptr->get_model();
             sensor["alert"] = alerts[i];
 
-            // Get sensor instance from SensorManager
-            auto *sensor_ptr = pooaway::sensors::SensorManager::instance().get_sensor(static_cast<pooaway::sensors::SensorType>(i));
+            const float rs = sensor_ptr->get_rs();
+            auto readings = sensor["readings"].to<JsonObject>();
+            readings["value"] = sensor_ptr->get_value();
+            readings["baseline"] = sensor_ptr->get_baseline();
+            readings["voltage"] = sensor_ptr->get_voltage();
+            readings["rs"] = rs;
+            readings["r0"] = sensor_ptr->get_r0();
+            readings["ratio"] = rs / sensor_ptr->get_r0();
+
+            auto calibration = sensor["calibration"].to<JsonObject>();
+            calibration["preheating_time"] = sensor_ptr->get_preheating_time();
+            calibration["a"] = sensor_ptr->get_coeff_a();
+            calibration["b"] = sensor_ptr->get_coeff_b();
+
+            // Health statistics ride along at a slower cadence to keep routine payloads small
+            if (with_diagnostics)
+            {
+                const auto &diag = sensor_ptr->get_diagnostics();
+                auto diagnostics = sensor["diagnostics"].to<JsonObject>();
+                diagnostics["healthy"] = diag.is_healthy;
+                diagnostics["reads"] = diag.read_count;
+                diagnostics["errors"] = diag.error_count;
+                diagnostics["error_rate"] = diag.last_window_error_rate;
+                diagnostics["mean"] = diag.avg_value;
+                diagnostics["stddev"] = diag.stddev();
+                diagnostics["min"] = diag.min_value;
+                diagnostics["max"] = diag.max_value;
+                diagnostics["alerts"] = diag.alert_count;
+                diagnostics["calibrations"] = diag.calibration_count;
+                diagnostics["calibration_confidence"] = diag.calibration_confidence;
+                diagnostics["voltage_jumps"] = diag.voltage_jumps;
+                diagnostics["active_s"] = diag.total_active_time / 1000;
+            }
+        }
+    }
+
+    void AlertManager::reset_payloads()
+    {
+        // ThingSpeak wants local wall-clock time of the sample, not of the upload; until SNTP
+        // has synced its updates go without one and the server stamps them on receipt
+        char created_at[PayloadCache::TIMESTAMP_SIZE] = "";
+        auto &time_service = pooaway::TimeService::instance();
+        if (time_service.is_synced())
+        {
+            time_service.format_local(time_service.to_utc_us(m_deferred_captured_us), created_at, sizeof(created_at));
+        }
+        m_payloads.reset(m_deferred_doc, created_at);
+    }
+
+    void AlertManager::dispatch_local(unsigned long due_us, bool edge, const bool *alerts, size_t count)
+    {
+        // Actuators only look at alert flags, so they get a reduced document that is cheap to build
+        JsonDocument doc(&pooaway::JsonArena::scratch());
+        doc["timestamp"] = millis();
+        doc["transition"] = edge;
+        auto sensors_array = doc["sensors"].to<JsonArray>();
+        auto &sensor_manager = pooaway::sensors::SensorManager::instance();
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto *sensor_ptr = sensor_manager.get_channel(i);
             if (!sensor_ptr)
                 continue;
 
-            auto readings = sensor["readings"].to<JsonObject>();
-            readings["value"] = ::sensors[i].value;                          // PPM value from global array
-            readings["baseline"] = ::sensors[i].baselineEMA;                 // Baseline from global array
-            readings["voltage"] = sensor_ptr->get_voltage();                 // Get voltage from sensor instance
-            readings["rs"] = sensor_ptr->get_rs();                           // Get Rs from sensor instance
-            readings["r0"] = sensor_ptr->get_r0();                           // Get R0 from sensor instance
-            readings["ratio"] = sensor_ptr->get_rs() / sensor_ptr->get_r0(); // Calculate ratio
+            auto sensor = sensors_array.add<JsonObject>();
+            sensor["index"] = i;
+            sensor["name"] = sensor_ptr->get_name();
+            sensor["alert"] = alerts[i];
+        }
 
-            auto calibration = sensor["calibration"].to<JsonObject>();
-            calibration["preheating_time"] = ::sensors[i].cal.preheatingTime;
-            calibration["a"] = ::sensors[i].cal.a;
-            calibration["b"] = ::sensors[i].cal.b;
+        for (auto &slot : m_handlers)
+        {
+            auto *handler = slot.handler;
+            if (handler->get_type() != HandlerType::ALERT_ONLY || !handler->is_initialized() ||
+                !handler->is_available())
+            {
+                continue;
+            }
+
+            record_result(slot, handler->handle_alert(doc));
+            record_latency(HandlerType::ALERT_ONLY, due_us);
         }
+    }
 
-        ESP_LOGV(TAG, "Sending to %d handlers", m_handlers.size());
-        for (auto handler : m_handlers)
+    void AlertManager::dispatch_deferred()
+    {
+        // One publisher call per pass, so a slow network call delays sampling by one handler at
+        // most. A publisher's queued event records go before its telemetry
+        for (auto &slot : m_handlers)
         {
-            try
+            auto *handler = slot.handler;
+            const bool owes_event = handler->get_type() == HandlerType::DATA_PUBLISHER &&
+                                    slot.events_sent != m_events_queued;
+            if (!slot.pending && !owes_event)
             {
-                if (handler->is_available())
-                {
-                    ESP_LOGV(TAG, "Calling handler type: %d", static_cast<int>(handler->get_type()));
-                    handler->handle_alert(doc);
-                }
-                else
+                continue;
+            }
+            const bool telemetry = slot.pending;
+            slot.pending = false;
+
+            if (!handler->is_initialized())
+            {
+                continue; // Still waiting on its boot step; event records stay queued for it
+            }
+
+            if (!handler->is_available())
+            {
+                ESP_LOGW(TAG, "Handler not available, type: %d", static_cast<int>(handler->get_type()));
+                slot.events_sent = m_events_queued;
+                continue;
+            }
+
+            const unsigned long start_ms = millis();
+            if (static_cast<long>(start_ms - slot.resume_ms) < 0)
+            {
+                continue; // Sitting out after a budget overrun
+            }
+
+            TRACE_LOGV(TAG, "Calling handler %s", handler->get_name());
+            Result result;
+            unsigned long due_us = m_deferred_due_us;
+            if (owes_event)
+            {
+                const auto &event = m_event_queue[slot.events_sent % m_event_queue.size()];
+                slot.events_sent++;
+                slot.pending = telemetry; // Telemetry goes out on a later pass
+                due_us = event.queued_us;
+
+                JsonDocument doc(&pooaway::JsonArena::scratch());
+                build_event(doc, event.record, event.closed);
+                result = handler->handle_event(doc);
+            }
+            else
+            {
+                result = handler->handle_telemetry(m_deferred_doc, m_payloads);
+                if (result)
                 {
-                    ESP_LOGW(TAG, "Handler not available, type: %d", static_cast<int>(handler->get_type()));
+                    pooaway::BootPipeline::instance().mark(pooaway::BootMilestone::FIRST_PUBLISH);
                 }
             }
-            catch (const std::exception &e)
+            record_result(slot, result);
+            record_latency(HandlerType::DATA_PUBLISHER, due_us);
+
+            const unsigned long elapsed_ms = millis() - start_ms;
+            if (elapsed_ms > handler->get_time_budget_ms())
+            {
+                // Back off exponentially so a dead link does not stall every loop pass
+                slot.overruns++;
+                slot.backoff = std::min<uint8_t>(slot.backoff ? slot.backoff * 2 : 1,
+                                                 config::alerts::MAX_BACKOFF_INTERVALS);
+                slot.resume_ms = millis() + slot.backoff * config::alerts::ALERT_INTERVAL;
+                ESP_LOGW(TAG, "Handler type %d took %lu ms (budget %lu ms), skipping %u intervals",
+                         static_cast<int>(handler->get_type()), elapsed_ms,
+                         handler->get_time_budget_ms(), slot.backoff);
+            }
+            else
             {
-                ESP_LOGE(TAG, "Handler update error: %s", e.what());
+                slot.backoff = 0;
             }
+            return;
         }
     }
 
-    std::vector<std::string> AlertManager::get_handler_errors() const
+    void AlertManager::record_latency(HandlerType tier, unsigned long due_us)
     {
-        std::vector<std::string> errors;
-        for (const auto handler : m_handlers)
+        auto &stats = m_tier_stats[static_cast<size_t>(tier)];
+        const auto latency_us = static_cast<uint32_t>(micros() - due_us);
+        stats.dispatches++;
+        stats.last_us = latency_us;
+        stats.max_us = std::max(stats.max_us, latency_us);
+        stats.total_us += latency_us;
+    }
+
+    const AlertManager::TierStats &AlertManager::get_tier_stats(HandlerType tier) const
+    {
+        return m_tier_stats[static_cast<size_t>(tier)];
+    }
+
+    void AlertManager::log_dispatch_stats() const
+    {
+        const char *names[] = {"local", "deferred"};
+        for (size_t i = 0; i < m_tier_stats.size(); i++)
         {
-            if (!handler->is_available())
+            const auto &stats = m_tier_stats[i];
+            const unsigned long mean_us = stats.dispatches ? stats.total_us / stats.dispatches : 0;
+            ESP_LOGI(TAG, "Dispatch %s: %lu calls, last %lu us, mean %lu us, max %lu us", names[i],
+                     static_cast<unsigned long>(stats.dispatches), static_cast<unsigned long>(stats.last_us),
+                     mean_us, static_cast<unsigned long>(stats.max_us));
+        }
+
+        for (size_t i = 0; i < m_handlers.size(); i++)
+        {
+            const auto stats = get_handler_stats(i);
+            ESP_LOGI(TAG, "Handler %s: %lu admitted, %lu dropped, %lu coalesced, %lu budget overruns, %lu errors%s%s",
+                     stats.name, static_cast<unsigned long>(stats.rate.admitted),
+                     static_cast<unsigned long>(stats.rate.dropped), static_cast<unsigned long>(stats.rate.coalesced),
+                     static_cast<unsigned long>(stats.overruns), static_cast<unsigned long>(stats.errors),
+                     stats.last_error ? ", last: " : "", stats.last_error ? stats.last_error : "");
+        }
+
+        ESP_LOGI(TAG, "Telemetry: %lu documents thinned out during events", static_cast<unsigned long>(m_thinned_telemetry));
+        ESP_LOGI(TAG, "Events: %lu records queued, %lu dropped by publishers that fell behind",
+                 static_cast<unsigned long>(m_events_queued), static_cast<unsigned long>(m_events_dropped));
+
+        const auto &payloads = m_payloads.get_stats();
+        ESP_LOGI(TAG, "Payloads: %lu cycles, %lu encoded (%llu bytes), %lu shared (%llu bytes), %lu overflows, peak %u of %u bytes",
+                 static_cast<unsigned long>(payloads.cycles), static_cast<unsigned long>(payloads.encodes),
+                 static_cast<unsigned long long>(payloads.bytes_encoded), static_cast<unsigned long>(payloads.reuses),
+                 static_cast<unsigned long long>(payloads.bytes_reused), static_cast<unsigned long>(payloads.overflows),
+                 static_cast<unsigned>(payloads.peak_used), static_cast<unsigned>(payloads.capacity));
+
+        const auto &time = pooaway::TimeService::instance().get_stats();
+        ESP_LOGI(TAG, "Time: %lu syncs, last correction %lld us, max %lld us, %lu timestamps formatted, %lu cache misses",
+                 static_cast<unsigned long>(time.syncs), static_cast<long long>(time.last_correction_us),
+                 static_cast<long long>(time.max_correction_us), static_cast<unsigned long>(time.formats),
+                 static_cast<unsigned long>(time.format_misses));
+
+        for (const auto *arena : {&pooaway::JsonArena::telemetry(), &pooaway::JsonArena::scratch()})
+        {
+            const auto &stats = arena->get_stats();
+            ESP_LOGI(TAG, "JSON arena %s: peak %u of %u bytes, %lu resets, %lu heap fallbacks", arena->get_name(),
+                     static_cast<unsigned>(stats.peak_used), static_cast<unsigned>(stats.capacity),
+                     static_cast<unsigned long>(stats.resets), static_cast<unsigned long>(stats.heap_fallbacks));
+        }
+    }
+
+    AlertManager::HandlerStats AlertManager::get_handler_stats(size_t index) const
+    {
+        const auto &slot = m_handlers[index];
+        return HandlerStats{slot.handler->get_name(), slot.handler->get_type(), slot.handler->get_rate_stats(),
+                            slot.overruns, slot.errors, slot.errors ? slot.last_error.message() : nullptr};
+    }
+
+    void AlertManager::update_events(unsigned long now, const bool *alerts, size_t count)
+    {
+        using pooaway::sensors::ChannelSample;
+        using pooaway::sensors::EventDetector;
+        using pooaway::sensors::EventPhase;
+
+        auto &sensor_manager = pooaway::sensors::SensorManager::instance();
+        const size_t pairs = std::min(count / EventDetector::PAIR_CHANNELS, m_event_detectors.size());
+        for (size_t pair = 0; pair < pairs; pair++)
+        {
+            std::array<ChannelSample, EventDetector::PAIR_CHANNELS> samples{};
+            for (size_t i = 0; i < samples.size(); i++)
+            {
+                const size_t channel = pair * EventDetector::PAIR_CHANNELS + i;
+                const auto *sensor = sensor_manager.get_channel(channel);
+                if (!sensor)
+                    continue;
+
+                samples[i].alert = alerts[channel];
+                samples[i].value = sensor->get_value();
+                samples[i].baseline = sensor->get_baseline();
+            }
+
+            auto &detector = m_event_detectors[pair];
+            const EventPhase phase = detector.update(now, samples.data());
+            if (phase == EventPhase::STARTED)
+            {
+                pooaway::StateStore::instance().set_next_event_id(EventDetector::get_next_id()); // Before publish_event()
+            }
+
+            if (phase != EventPhase::NONE)
+            {
+                publish_event(detector.get_record(), phase == EventPhase::CLOSED);
+            }
+        }
+    }
+
+    bool AlertManager::is_event_open() const
+    {
+        return std::any_of(m_event_detectors.begin(), m_event_detectors.end(),
+                           [](const auto &detector) { return detector.is_active(); });
+    }
+
+    void AlertManager::publish_event(const pooaway::sensors::EventRecord &record, bool closed)
+    {
+        // Local handlers get the record inline; publishers get it from the deferred tier, under
+        // the same one-call-per-pass rule, time budget and back-off as telemetry
+        JsonDocument doc(&pooaway::JsonArena::scratch());
+        build_event(doc, record, closed);
+        for (auto &slot : m_handlers)
+        {
+            auto *handler = slot.handler;
+            if (handler->get_type() == HandlerType::ALERT_ONLY && handler->is_initialized() &&
+                handler->is_available())
             {
-                errors.push_back(handler->get_last_error());
+                record_result(slot, handler->handle_event(doc));
             }
         }
-        return errors;
+
+        if constexpr (config::features::DATA_PUBLISHERS)
+        {
+            queue_event(record, closed);
+        }
+    }
+
+    void AlertManager::queue_event(const pooaway::sensors::EventRecord &record, bool closed)
+    {
+        m_event_queue[m_events_queued % m_event_queue.size()] = QueuedEvent{record, closed, micros()};
+        m_events_queued++;
+
+        // A publisher that is QUEUE_DEPTH records behind loses its oldest one
+        for (auto &slot : m_handlers)
+        {
+            if (slot.handler->get_type() == HandlerType::DATA_PUBLISHER &&
+                m_events_queued - slot.events_sent > m_event_queue.size())
+            {
+                slot.events_sent = m_events_queued - m_event_queue.size();
+                m_events_dropped++;
+                ESP_LOGW(TAG, "Handler %s fell behind, dropped event record", slot.handler->get_name());
+            }
+        }
+    }
+
+    void AlertManager::build_event(JsonDocument &doc, const pooaway::sensors::EventRecord &record, bool closed) const
+    {
+        doc["device_id"] = m_device_id;
+        doc["type"] = closed ? "event" : "event_start";
+        doc["id"] = record.id;
+        doc["pair"] = record.pair;
+        doc["start"] = record.start_ms;
+
+        auto &sensor_manager = pooaway::sensors::SensorManager::instance();
+        auto fired = doc["sensors"].to<JsonArray>();
+        for (size_t i = 0; i < sensor_manager.get_channel_count(); i++)
+        {
+            const auto *sensor = sensor_manager.get_channel(i);
+            if (sensor && (record.sensor_mask & (1UL << i)))
+            {
+                fired.add(sensor->get_name());
+            }
+        }
+
+        if (closed)
+        {
+            const auto *peak_sensor = sensor_manager.get_channel(record.peak_channel);
+            doc["end"] = record.end_ms;
+            doc["duration_ms"] = record.duration_ms();
+            doc["peak_ppm"] = record.peak_ppm;
+            doc["peak_sensor"] = peak_sensor ? peak_sensor->get_name() : "";
+            doc["exposure_ppm_s"] = record.exposure_ppm_s;
+
+            // A close call between two classes is reported as such rather than guessed
+            const bool confident = record.class_margin >= config::events::MIN_CLASS_MARGIN;
+            doc["class"] = confident ? pooaway::sensors::to_string(record.event_class) : "unknown";
+            doc["class_margin"] = record.class_margin;
+        }
+    }
+
+    void AlertManager::record_result(HandlerSlot &slot, Result result)
+    {
+        // Handlers log their own failures with the details; this keeps the count for stats
+        if (!result)
+        {
+            slot.errors++;
+            slot.last_error = result;
+            TRACE_LOGD(TAG, "Handler %s failed: %s", slot.handler->get_name(), result.message());
+        }
     }
 
     void AlertManager::add_handler(AlertHandler *handler)
     {
-        m_handlers.push_back(handler);
-        handler->init();
+        // Initialization happens once, from init() or init_network_handlers()
+        HandlerSlot slot;
+        slot.handler = handler;
+        slot.events_sent = m_events_queued;
+        m_handlers.push_back(slot);
     }
 
     void AlertManager::remove_handler(AlertHandler *handler)
     {
-        auto it = std::find(m_handlers.begin(), m_handlers.end(), handler);
+        auto it = std::find_if(m_handlers.begin(), m_handlers.end(),
+                               [handler](const HandlerSlot &slot)
+                               { return slot.handler == handler; });
         if (it != m_handlers.end())
         {
             m_handlers.erase(it);
@@ -0,0 +1,219 @@
+#include "boot_pipeline.h"
+#include <Arduino.h>
+#include "esp_log.h"
+
+namespace pooaway
+{
+    namespace
+    {
+        const char *status_name(StepStatus status)
+        {
+            switch (status)
+            {
+            case StepStatus::WAITING:
+                return "waiting";
+            case StepStatus::PENDING:
+                return "pending";
+            case StepStatus::DONE:
+                return "done";
+            case StepStatus::FAILED:
+                return "failed";
+            case StepStatus::SKIPPED:
+                return "skipped";
+            }
+            return "?";
+        }
+
+        bool finished(StepStatus status)
+        {
+            return status == StepStatus::DONE || status == StepStatus::FAILED ||
+                   status == StepStatus::SKIPPED;
+        }
+
+        const char *MILESTONE_NAMES[] = {"first sample", "first publish"};
+        static_assert(sizeof(MILESTONE_NAMES) / sizeof(MILESTONE_NAMES[0]) ==
+                          static_cast<size_t>(BootMilestone::COUNT),
+                      "Every milestone needs a name");
+    }
+
+    BootPipeline &BootPipeline::instance()
+    {
+        static BootPipeline instance;
+        return instance;
+    }
+
+    int BootPipeline::add_step(const char *name, StepFn fn, uint32_t depends_on, unsigned long timeout_ms)
+    {
+        if (m_step_count >= MAX_STEPS || !fn)
+        {
+            ESP_LOGE(TAG, "Cannot add boot step %s", name);
+            return -1;
+        }
+
+        const int id = static_cast<int>(m_step_count++);
+        auto &step = m_steps[id];
+        step.name = name;
+        step.fn = fn;
+        step.depends_on = depends_on;
+        step.timeout_ms = timeout_ms;
+        step.status = StepStatus::WAITING;
+        m_complete = false;
+        return id;
+    }
+
+    bool BootPipeline::is_finished(int step) const
+    {
+        return step >= 0 && static_cast<size_t>(step) < m_step_count && finished(m_steps[step].status);
+    }
+
+    void BootPipeline::run_step(StepRecord &step, unsigned long now)
+    {
+        if (step.status == StepStatus::WAITING)
+        {
+            step.start_ms = now;
+            ESP_LOGD(TAG, "Starting %s", step.name);
+        }
+
+        step.status = step.fn();
+        if (step.status == StepStatus::PENDING && step.timeout_ms > 0 &&
+            millis() - step.start_ms >= step.timeout_ms)
+        {
+            ESP_LOGW(TAG, "%s timed out after %lu ms", step.name, step.timeout_ms);
+            step.status = StepStatus::FAILED;
+        }
+
+        if (finished(step.status))
+        {
+            step.end_ms = millis();
+            ESP_LOGI(TAG, "%s %s at %lu ms (%lu ms)", step.name, status_name(step.status),
+                     step.end_ms, step.end_ms - step.start_ms);
+        }
+    }
+
+    bool BootPipeline::poll()
+    {
+        if (m_complete)
+        {
+            return true;
+        }
+
+        // Registration order is a valid topological order, so one forward pass starts
+        // everything whose dependencies finished earlier in the same pass
+        bool all_finished = true;
+        for (size_t i = 0; i < m_step_count; i++)
+        {
+            auto &step = m_steps[i];
+            if (finished(step.status))
+            {
+                continue;
+            }
+
+            bool ready = true;
+            for (size_t dep = 0; dep < m_step_count; dep++)
+            {
+                if (!(step.depends_on & (1UL << dep)))
+                {
+                    continue;
+                }
+
+                const StepStatus dep_status = m_steps[dep].status;
+                if (dep_status == StepStatus::FAILED || dep_status == StepStatus::SKIPPED)
+                {
+                    ESP_LOGW(TAG, "Skipping %s: %s did not complete", step.name, m_steps[dep].name);
+                    step.status = StepStatus::SKIPPED;
+                    step.start_ms = step.end_ms = millis();
+                    break;
+                }
+                ready = ready && dep_status == StepStatus::DONE;
+            }
+
+            if (step.status != StepStatus::SKIPPED && ready)
+            {
+                run_step(step, millis());
+            }
+            all_finished = all_finished && finished(step.status);
+        }
+
+        if (all_finished)
+        {
+            m_complete = true;
+            ESP_LOGI(TAG, "Boot timeline%s (ms since reset):", m_logged ? ", remaining steps" : "");
+            log_timeline(finished_steps() & ~m_logged, true);
+            m_logged = finished_steps();
+        }
+        return m_complete;
+    }
+
+    uint32_t BootPipeline::finished_steps() const
+    {
+        uint32_t steps = 0;
+        for (size_t i = 0; i < m_step_count; i++)
+        {
+            if (finished(m_steps[i].status))
+            {
+                steps |= 1UL << i;
+            }
+        }
+        return steps;
+    }
+
+    void BootPipeline::run_until_finished(uint32_t steps)
+    {
+        while (!poll())
+        {
+            if ((steps & finished_steps()) == steps)
+            {
+                // The rest may wait on the network indefinitely, so log what is known now
+                ESP_LOGI(TAG, "Boot timeline so far (ms since reset):");
+                log_timeline(finished_steps() & ~m_logged, false);
+                m_logged = finished_steps();
+                return;
+            }
+            delay(10);
+        }
+    }
+
+    void BootPipeline::mark(BootMilestone milestone)
+    {
+        auto &at = m_milestones[static_cast<size_t>(milestone)];
+        if (at != 0)
+        {
+            return;
+        }
+
+        at = millis();
+        ESP_LOGI(TAG, "Time to %s: %lu ms", MILESTONE_NAMES[static_cast<size_t>(milestone)], at);
+    }
+
+    unsigned long BootPipeline::get_milestone(BootMilestone milestone) const
+    {
+        return m_milestones[static_cast<size_t>(milestone)];
+    }
+
+    void BootPipeline::log_timeline(uint32_t steps, bool milestones) const
+    {
+        for (size_t i = 0; i < m_step_count; i++)
+        {
+            if (!(steps & (1UL << i)))
+            {
+                continue;
+            }
+
+            const auto &step = m_steps[i];
+            ESP_LOGI(TAG, "  %-16s %7lu -> %7lu  %s", step.name, step.start_ms, step.end_ms,
+                     status_name(step.status));
+        }
+
+        for (size_t i = 0; milestones && i < m_milestones.size(); i++)
+        {
+            if (m_milestones[i] != 0)
+            {
+                ESP_LOGI(TAG, "  %-16s %7lu", MILESTONE_NAMES[i], m_milestones[i]);
+            }
+            else
+            {
+                ESP_LOGI(TAG, "  %-16s   (not yet)", MILESTONE_NAMES[i]);
+            }
+        }
+    }
+} // namespace pooaway
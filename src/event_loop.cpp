@@ -0,0 +1,137 @@
+#include "event_loop.h"
+#include <Arduino.h>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "config.h"
+
+namespace pooaway
+{
+    namespace
+    {
+        // Shared with the button ISR, which runs from IRAM and must only touch DRAM
+        TaskHandle_t s_loop_task = nullptr;
+        volatile uint32_t s_button_edges = 0;
+
+        void IRAM_ATTR on_button_edge()
+        {
+            s_button_edges = s_button_edges + 1;
+            if (s_loop_task == nullptr)
+            {
+                return;
+            }
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(s_loop_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+    }
+
+    EventLoop &EventLoop::instance()
+    {
+        static EventLoop instance;
+        return instance;
+    }
+
+    void EventLoop::begin()
+    {
+        s_loop_task = xTaskGetCurrentTaskHandle();
+        m_wheel.advance(static_cast<uint32_t>(millis()));
+        m_window_start_ms = millis();
+    }
+
+    int EventLoop::add_timer(TimerFn fn, unsigned long period_ms)
+    {
+        const int timer = m_wheel.add(fn, static_cast<uint32_t>(period_ms));
+        if (timer < 0)
+        {
+            ESP_LOGE(TAG, "Timer table full (%u timers)", static_cast<unsigned>(MAX_TIMERS));
+        }
+        return timer;
+    }
+
+    void EventLoop::start_timer(int timer, unsigned long delay_ms)
+    {
+        m_wheel.start(timer, static_cast<uint32_t>(millis()), static_cast<uint32_t>(delay_ms));
+    }
+
+    void EventLoop::stop_timer(int timer)
+    {
+        m_wheel.stop(timer);
+    }
+
+    void EventLoop::watch_button(uint8_t pin, ButtonFn on_press)
+    {
+        m_button_pin = pin;
+        m_on_press = on_press;
+        m_button_pressed = digitalRead(pin) == LOW;
+        m_debounce_timer = add_timer(on_debounce, 0);
+        attachInterrupt(digitalPinToInterrupt(pin), on_button_edge, CHANGE);
+    }
+
+    void EventLoop::on_debounce()
+    {
+        // The pin has been quiet for DEBOUNCE_DELAY; act on the level it settled at
+        auto &self = instance();
+        const bool pressed = digitalRead(self.m_button_pin) == LOW;
+        if (pressed != self.m_button_pressed)
+        {
+            self.m_button_pressed = pressed;
+            if (pressed && self.m_on_press)
+            {
+                self.m_on_press();
+            }
+        }
+    }
+
+    void EventLoop::run_once()
+    {
+        const uint32_t wait_ms = m_pass_requested ? 0 : m_wheel.next_due_in(static_cast<uint32_t>(millis()));
+        m_pass_requested = false;
+        if (wait_ms > 0)
+        {
+            // One tick more than the wait, since a tick-based timeout can end up to a tick early
+            // and would cost a second wakeup just to find the timer not yet due
+            const TickType_t ticks = wait_ms == decltype(m_wheel)::NO_DEADLINE ? portMAX_DELAY
+                                                                                : pdMS_TO_TICKS(wait_ms) + 1;
+            const unsigned long wait_start_us = micros();
+            ulTaskNotifyTake(pdTRUE, ticks);
+            const unsigned long idle_us = micros() - wait_start_us;
+            m_stats.idle_us += idle_us;
+            m_stats.wakeups++;
+            m_window_idle_us += idle_us;
+            m_window_wakeups++;
+        }
+
+        // Each edge restarts the quiet-time timer, so bounces never reach the press handler
+        const uint32_t edges = s_button_edges;
+        if (edges != m_seen_edges)
+        {
+            m_stats.button_edges += edges - m_seen_edges;
+            m_seen_edges = edges;
+            start_timer(m_debounce_timer, config::input::DEBOUNCE_DELAY);
+        }
+
+        m_stats.timers_fired += static_cast<uint32_t>(m_wheel.advance(static_cast<uint32_t>(millis())));
+
+        const unsigned long now = millis();
+        if (now - m_window_start_ms >= config::scheduler::STATS_LOG_INTERVAL_MS)
+        {
+            log_stats(now);
+        }
+    }
+
+    void EventLoop::log_stats(unsigned long now)
+    {
+        const float window_s = static_cast<float>(now - m_window_start_ms) / 1000.0F;
+        m_wakeups_per_s = static_cast<float>(m_window_wakeups) / window_s;
+        m_idle_ratio = std::min(static_cast<float>(m_window_idle_us) / 1e6F / window_s, 1.0F);
+        ESP_LOGI(TAG, "%.1f wakeups/s, %.1f%% idle, %lu button edges, %lu timers fired",
+                 m_wakeups_per_s, m_idle_ratio * 100.0F, static_cast<unsigned long>(m_stats.button_edges),
+                 static_cast<unsigned long>(m_stats.timers_fired));
+
+        m_window_start_ms = now;
+        m_window_wakeups = 0;
+        m_window_idle_us = 0;
+    }
+} // namespace pooaway
@@ -0,0 +1,122 @@
+#include "json_arena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "esp_log.h"
+#include "config.h"
+
+namespace pooaway
+{
+    static constexpr char const *TAG = "JsonArena";
+
+    namespace
+    {
+        alignas(8) uint8_t telemetry_storage[config::json::TELEMETRY_ARENA_BYTES];
+        alignas(8) uint8_t scratch_storage[config::json::SCRATCH_ARENA_BYTES];
+    }
+
+    JsonArena &JsonArena::telemetry()
+    {
+        static JsonArena arena("telemetry", telemetry_storage, sizeof(telemetry_storage));
+        return arena;
+    }
+
+    JsonArena &JsonArena::scratch()
+    {
+        static JsonArena arena("scratch", scratch_storage, sizeof(scratch_storage));
+        return arena;
+    }
+
+    JsonArena::JsonArena(const char *name, uint8_t *storage, size_t capacity)
+        : m_name(name), m_storage(storage)
+    {
+        m_stats.capacity = capacity;
+    }
+
+    bool JsonArena::owns(const void *pointer) const
+    {
+        const auto *p = static_cast<const uint8_t *>(pointer);
+        return p >= m_storage && p < m_storage + m_stats.capacity;
+    }
+
+    uint32_t &JsonArena::block_size(void *pointer) const
+    {
+        return *reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(pointer) - HEADER);
+    }
+
+    void *JsonArena::allocate(size_t size)
+    {
+        const size_t needed = HEADER + round_up(size);
+        if (needed > m_stats.capacity - m_used)
+        {
+            // Still succeed, but make the undersized arena visible
+            m_stats.heap_fallbacks++;
+            ESP_LOGW(TAG, "%s arena full (%u of %u bytes used), %u bytes from heap", m_name,
+                     static_cast<unsigned>(m_used), static_cast<unsigned>(m_stats.capacity),
+                     static_cast<unsigned>(size));
+            return std::malloc(size);
+        }
+
+        uint8_t *block = m_storage + m_used;
+        *reinterpret_cast<uint32_t *>(block) = static_cast<uint32_t>(size);
+        m_last_block = m_used;
+        m_used += needed;
+        m_live++;
+        m_stats.peak_used = std::max(m_stats.peak_used, m_used);
+        return block + HEADER;
+    }
+
+    void JsonArena::deallocate(void *pointer)
+    {
+        if (!pointer)
+        {
+            return;
+        }
+        if (!owns(pointer))
+        {
+            std::free(pointer);
+            return;
+        }
+
+        m_live--;
+        if (m_live == 0)
+        {
+            m_used = 0;
+            m_stats.resets++;
+        }
+        else if (static_cast<uint8_t *>(pointer) - HEADER == m_storage + m_last_block)
+        {
+            m_used = m_last_block; // Newest block: give the space back straight away
+        }
+    }
+
+    void *JsonArena::reallocate(void *pointer, size_t new_size)
+    {
+        if (!pointer)
+        {
+            return allocate(new_size);
+        }
+        if (!owns(pointer))
+        {
+            return std::realloc(pointer, new_size);
+        }
+
+        // The newest block can grow or shrink in place
+        uint8_t *header = static_cast<uint8_t *>(pointer) - HEADER;
+        if (header == m_storage + m_last_block && m_last_block + HEADER + round_up(new_size) <= m_stats.capacity)
+        {
+            block_size(pointer) = static_cast<uint32_t>(new_size);
+            m_used = m_last_block + HEADER + round_up(new_size);
+            m_stats.peak_used = std::max(m_stats.peak_used, m_used);
+            return pointer;
+        }
+
+        void *moved = allocate(new_size);
+        if (moved)
+        {
+            std::memcpy(moved, pointer, std::min<size_t>(block_size(pointer), new_size));
+            deallocate(pointer);
+        }
+        return moved;
+    }
+} // namespace pooaway
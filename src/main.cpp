@@ -8,11 +8,25 @@
 #include "alert_manager.h"
 #include "debug_manager.h"
 #include "config.h"
-#include "alert_handlers/api_handler.h"
 #include "alert_handlers/buzzer_handler.h"
 #include "alert_handlers/led_handler.h"
+#if POOAWAY_WITH_API
+#include "alert_handlers/api_handler.h"
+#endif
+#if POOAWAY_WITH_MQTT
 #include "alert_handlers/mqtt_handler.h"
+#endif
+#if POOAWAY_WITH_NETWORK
 #include "wifi_manager.h"
+#endif
+#if POOAWAY_WITH_METRICS
+#include "metrics_server.h"
+#endif
+#include "state_store.h"
+#include "boot_pipeline.h"
+#include "waveform_capture.h"
+#include "trace_log.h"
+#include "event_loop.h"
 
 using namespace pooaway::alert;
 using namespace pooaway::sensors;
@@ -20,105 +34,250 @@ using namespace pooaway;
 
 static constexpr char const *TAG = "Main";
 
-// Initialize alert handlers with rate limits
-static ApiHandler api_handler(config::alerts::API_RATE_LIMIT_MS);
+// Alert handlers; these are the only instances. The LED and buzzer only change pattern on
+// alert edges, so they need no rate limit. Transports are chosen with POOAWAY_WITH_x
+static LedHandler led_handler;
+static BuzzerHandler buzzer_handler;
+#if POOAWAY_WITH_MQTT
 static MqttHandler mqtt_handler(config::alerts::MQTT_RATE_LIMIT_MS);
-static LedHandler led_handler(config::alerts::LED_RATE_LIMIT_MS);
-static BuzzerHandler buzzer_handler(config::alerts::BUZZER_RATE_LIMIT_MS);
+#endif
+#if POOAWAY_WITH_API
+static ApiHandler api_handler(config::alerts::API_RATE_LIMIT_MS);
+#endif
 
-void setup()
-{
-    // Initialize serial communication
-    Serial.begin(115200);
-    ESP_LOGI(TAG, "Starting PooAway sensor system...");
+// Registered in this order, which is also the order they are dispatched in
+static AlertHandler *const handlers[] = {
+    &buzzer_handler,
+    &led_handler,
+#if POOAWAY_WITH_MQTT
+    &mqtt_handler,
+#endif
+#if POOAWAY_WITH_API
+    &api_handler,
+#endif
+};
 
-    // Initialize GPIO pins
-    pinMode(config::hardware::LED_PIN, OUTPUT);
-    pinMode(config::hardware::BUZZER_PIN, OUTPUT);
-    pinMode(config::hardware::CALIBRATION_BTN_PIN, INPUT_PULLUP);
-    pinMode(config::hardware::CALIBRATION_LED_PIN, OUTPUT);
+namespace
+{
+    // Boot steps, see setup() for their dependencies
+    StepStatus boot_state()
+    {
+        StateStore::instance().load();
+        return StepStatus::DONE;
+    }
 
-    // Initialize managers
-    SensorManager::instance().init();
-    WiFiManager::instance().init();
-    AlertManager::instance().init();
-    DebugManager::instance().init();
+    StepStatus boot_sensors()
+    {
+        WaveformCapture::instance().init();
 
-    // Initialize alert handlers
-    auto &alert_manager = AlertManager::instance();
+        auto &sensor_manager = SensorManager::instance();
+        sensor_manager.init();
 
-    static BuzzerHandler buzzer_handler;
-    static LedHandler led_handler;
-    static MqttHandler mqtt_handler;
+        // Initial calibration if needed
+        if (sensor_manager.needs_calibration())
+        {
+            ESP_LOGI(TAG, "No calibration values found, performing initial calibration...");
+            sensor_manager.perform_clean_air_calibration();
+        }
 
-    alert_manager.add_handler(&buzzer_handler);
-    alert_manager.add_handler(&led_handler);
-    // alert_manager.add_handler(&mqtt_handler);
-    alert_manager.add_handler(&api_handler);
+        // Run initial diagnostics
+        sensor_manager.run_diagnostics();
+        return StepStatus::DONE;
+    }
 
-    // Initial calibration if needed
-    if (SensorManager::instance().needs_calibration())
+    StepStatus boot_local_alerts()
     {
-        ESP_LOGI(TAG, "No calibration values found, performing initial calibration...");
-        SensorManager::instance().perform_clean_air_calibration();
+        AlertManager::instance().init();
+        DebugManager::instance().init();
+        return StepStatus::DONE;
     }
 
-    // Run initial diagnostics
-    SensorManager::instance().run_diagnostics();
+#if POOAWAY_WITH_NETWORK
+    StepStatus boot_wifi_begin()
+    {
+        WiFiManager::instance().begin();
+        return StepStatus::DONE;
+    }
 
-    ESP_LOGI(TAG, "Setup complete!");
-}
+    StepStatus boot_wifi_connected()
+    {
+        return WiFiManager::instance().poll_connected() ? StepStatus::DONE : StepStatus::PENDING;
+    }
 
-void loop()
-{
-    using pooaway::sensors::SensorType;
+    StepStatus boot_time_sync()
+    {
+        static bool started = false;
+        if (!started)
+        {
+            WiFiManager::instance().begin_time_sync();
+            started = true;
+        }
+        return WiFiManager::instance().is_time_synced() ? StepStatus::DONE : StepStatus::PENDING;
+    }
 
-    static bool alerts[2] = {false};
-    static bool last_btn_state = true;
-    static unsigned long last_debounce = 0;
+    StepStatus boot_network_alerts()
+    {
+        AlertManager::instance().init_network_handlers();
+        return StepStatus::DONE;
+    }
 
-    // Handle calibration button
-    const bool current_btn_state = digitalRead(config::hardware::CALIBRATION_BTN_PIN);
-    if (current_btn_state != last_btn_state)
+#if POOAWAY_WITH_METRICS
+    StepStatus boot_metrics()
     {
-        last_debounce = millis();
+        MetricsServer::instance().begin();
+        return StepStatus::DONE;
     }
+#endif
 
-    if ((millis() - last_debounce) > config::input::DEBOUNCE_DELAY)
+    void poll_network()
     {
-        if (current_btn_state == LOW)
-        { // Button pressed (active LOW)
-            ESP_LOGI(TAG, "Calibration button pressed");
-            SensorManager::instance().perform_clean_air_calibration();
-        }
+        // Finish any boot steps still waiting on the network
+        BootPipeline::instance().poll();
+
+        // Keep publisher sessions alive between sends
+        AlertManager::instance().poll_handlers();
+
+#if POOAWAY_WITH_METRICS
+        // Serve /metrics, /capture and feed /stream clients
+        MetricsServer::instance().poll();
+#endif
     }
-    last_btn_state = current_btn_state;
+#endif // POOAWAY_WITH_NETWORK
 
-    // Update sensors
-    auto &sensor_manager = SensorManager::instance();
-    sensor_manager.update();
+    // One-shot timer that resumes a scan waiting on the mux, see setup()
+    int settle_timer = -1;
 
-    // Check for alerts
-    for (size_t i = 0; i < SENSOR_COUNT; i++)
+    // Sensor scan, then the alert tick and everything else that follows new samples
+    void scan_step()
     {
-        const auto sensor_type = static_cast<SensorType>(i);
-        alerts[i] = sensor_manager.get_alert_status(sensor_type);
+        static std::array<bool, SensorManager::MAX_CHANNELS> alerts{};
 
-        if (alerts[i])
+        auto &sensor_manager = SensorManager::instance();
+        sensor_manager.update();
+        uint32_t settle_us = sensor_manager.get_settle_remaining_us();
+
+        // The wheel ticks in whole milliseconds and its wait can run a tick past a timer, so a
+        // settle timed on it alone costs up to two ticks extra per mux input. The timer wakes the
+        // scan a tick early instead and the rest is spun out in microseconds
+        while (settle_us > 0 && settle_us < config::scheduler::SETTLE_SPIN_US)
         {
-            const auto *sensor = sensor_manager.get_sensor(sensor_type);
-            if (sensor)
+            delayMicroseconds(settle_us);
+            sensor_manager.update();
+            settle_us = sensor_manager.get_settle_remaining_us();
+        }
+        if (settle_us > 0)
+        {
+            // Finish the scan as soon as the mux input has settled, not a whole interval later
+            EventLoop::instance().start_timer(settle_timer, settle_us / 1000 - 1);
+            return;
+        }
+        if (sensor_manager.get_scan_stats().completed_scans > 0)
+        {
+            BootPipeline::instance().mark(BootMilestone::FIRST_SAMPLE);
+        }
+
+        // Check for alerts
+        const size_t channel_count = sensor_manager.get_channel_count();
+        for (size_t i = 0; i < channel_count; i++)
+        {
+            const bool alert = sensor_manager.get_channel_alert(i);
+
+            // Only on the rising edge: formatting a float on every pass of a long alert costs
+            // more than the scan it reports on
+            if (alert && !alerts[i])
             {
-                ESP_LOGW(TAG, "Alert from %s! Value: %.2f",
-                         sensor->get_name(),
-                         sensor_manager.get_sensor_value(sensor_type));
+                const auto *sensor = sensor_manager.get_channel(i);
+                if (sensor)
+                {
+                    ESP_LOGW(TAG, "Alert from %s! Value: %.2f",
+                             sensor->get_name(), sensor->get_value());
+                }
             }
+            alerts[i] = alert;
         }
+
+        // Update alert system
+        AlertManager::instance().update(alerts.data(), channel_count);
+
+        // Persist calibration and baselines when they have changed enough
+        StateStore::instance().update();
+
+        // Encode and save a completed alert waveform
+        WaveformCapture::instance().poll();
     }
 
-    // Update alert system
-    AlertManager::instance().update(alerts);
+    void on_calibration_button()
+    {
+        ESP_LOGI(TAG, "Calibration button pressed");
+        SensorManager::instance().perform_clean_air_calibration();
+    }
+}
+
+void setup()
+{
+    // Initialize serial communication
+    Serial.begin(115200);
+    ESP_LOGI(TAG, "Starting PooAway sensor system...");
 
-    // Small delay to prevent tight looping
-    delay(10);
+    // Initialize GPIO pins
+    pinMode(config::hardware::LED_PIN, OUTPUT);
+    pinMode(config::hardware::BUZZER_PIN, OUTPUT);
+    pinMode(config::hardware::CALIBRATION_BTN_PIN, INPUT_PULLUP);
+    pinMode(config::hardware::CALIBRATION_LED_PIN, OUTPUT);
+
+    // Register alert handlers; each is initialized once by its boot step
+    auto &alert_manager = AlertManager::instance();
+    for (auto *handler : handlers)
+    {
+        alert_manager.add_handler(handler);
+    }
+
+    // WiFi associates in the background while the sensors preheat and calibrate
+    auto &boot = BootPipeline::instance();
+#if POOAWAY_WITH_NETWORK
+    const int wifi_begin = boot.add_step("wifi_begin", boot_wifi_begin);
+#endif
+    const int state = boot.add_step("state", boot_state);
+    const int sensors = boot.add_step("sensors", boot_sensors, BootPipeline::dependency(state));
+    const int alerts = boot.add_step("alerts_local", boot_local_alerts, BootPipeline::dependency(state));
+#if POOAWAY_WITH_NETWORK
+    const int wifi = boot.add_step("wifi", boot_wifi_connected, BootPipeline::dependency(wifi_begin));
+    boot.add_step("ntp", boot_time_sync, BootPipeline::dependency(wifi), config::ntp::SYNC_TIMEOUT_MS);
+    boot.add_step("alerts_network", boot_network_alerts,
+                  BootPipeline::dependency(wifi) | BootPipeline::dependency(alerts));
+#if POOAWAY_WITH_METRICS
+    boot.add_step("metrics", boot_metrics, BootPipeline::dependency(wifi));
+#endif
+#endif
+
+    // Sampling starts once the local steps are done; network steps keep being polled from loop()
+    boot.run_until_finished(BootPipeline::dependency(sensors) | BootPipeline::dependency(alerts));
+
+    // From here on loop() sleeps until one of these timers is due or the button interrupts
+    auto &event_loop = EventLoop::instance();
+    event_loop.begin();
+    event_loop.watch_button(config::hardware::CALIBRATION_BTN_PIN, on_calibration_button);
+    const int scan_timer = event_loop.add_timer(scan_step, config::scheduler::SAMPLE_INTERVAL_MS);
+    settle_timer = event_loop.add_timer(scan_step, 0);
+    event_loop.start_timer(scan_timer);
+#if POOAWAY_WITH_NETWORK
+    const int network_timer = event_loop.add_timer(poll_network, config::scheduler::NETWORK_POLL_MS);
+    event_loop.start_timer(network_timer);
+#endif
+
+    ESP_LOGI(TAG, "Setup complete!");
+}
+
+void loop()
+{
+    // Sleep until the next timer is due or the button interrupts, then run what is due
+    auto &event_loop = EventLoop::instance();
+    event_loop.run_once();
+
+    // Format deferred TRACE_LOGx records now that the time-critical work is done; a backlog
+    // skips the next wait
+    if (pooaway::trace::TraceLog::instance().drain(config::trace::DRAIN_PER_LOOP))
+    {
+        event_loop.request_pass();
+    }
 }
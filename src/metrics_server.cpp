@@ -0,0 +1,294 @@
+#include "config.h"
+
+#if POOAWAY_WITH_METRICS
+#include "metrics_server.h"
+#include <Arduino.h>
+#include "esp_log.h"
+#include "sensor_manager.h"
+#include "alert_manager.h"
+#include "trace_log.h"
+#include "json_arena.h"
+#include "waveform_capture.h"
+#include "event_loop.h"
+#include "network_cache.h"
+#include "wifi_manager.h"
+
+namespace pooaway
+{
+    namespace
+    {
+        using pooaway::sensors::BaseSensor;
+
+        struct ChannelFamily
+        {
+            const char *name;
+            const char *type;
+            const char *help;
+            double (*get)(const BaseSensor &sensor);
+        };
+
+        // Per-channel families; each is written for all channels before the next, as the format requires
+        const ChannelFamily CHANNEL_FAMILIES[] = {
+            {"sensor_value_ppm", "gauge", "Latest reading",
+             [](const BaseSensor &s) -> double { return s.get_value(); }},
+            {"sensor_baseline_ppm", "gauge", "EMA baseline",
+             [](const BaseSensor &s) -> double { return s.get_baseline(); }},
+            {"sensor_voltage_volts", "gauge", "Sensor output voltage",
+             [](const BaseSensor &s) -> double { return s.get_voltage(); }},
+            {"sensor_rs_ohms", "gauge", "Sensor resistance",
+             [](const BaseSensor &s) -> double { return s.get_rs(); }},
+            {"sensor_r0_ohms", "gauge", "Clean-air reference resistance",
+             [](const BaseSensor &s) -> double { return s.get_r0(); }},
+            {"sensor_healthy", "gauge", "1 if the diagnostics consider the sensor healthy",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().is_healthy ? 1.0 : 0.0; }},
+            {"sensor_reads_total", "counter", "Valid readings",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().read_count; }},
+            {"sensor_errors_total", "counter", "Rejected readings",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().error_count; }},
+            {"sensor_alerts_total", "counter", "Rising alert edges",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().alert_count; }},
+            {"sensor_calibrations_total", "counter", "R0 calibrations, manual and background",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().calibration_count; }},
+            {"sensor_calibration_confidence", "gauge", "Confidence of the latest clean-air calibration, 0 to 1",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().calibration_confidence; }},
+            {"sensor_window_error_ratio", "gauge", "Error rate over the last diagnostics window",
+             [](const BaseSensor &s) -> double { return s.get_diagnostics().last_window_error_rate; }},
+        };
+    }
+
+    MetricsServer &MetricsServer::instance()
+    {
+        static MetricsServer instance;
+        return instance;
+    }
+
+    MetricsServer::MetricsServer()
+        : m_server(config::metrics::PORT),
+          m_endpoint(m_ring, write_metrics, channel_name,
+                     Endpoint::Limits{config::metrics::REQUEST_TIMEOUT_MS, config::metrics::KEEPALIVE_MS,
+                                      config::metrics::MAX_EVENTS_PER_POLL})
+    {
+        if (config::capture::ENABLED)
+        {
+            m_endpoint.set_capture([](const uint8_t *&data) { return WaveformCapture::instance().get_blob(data); });
+        }
+    }
+
+    void MetricsServer::begin()
+    {
+        if (m_started)
+        {
+            return;
+        }
+
+        m_server.begin();
+        m_server.setNoDelay(true);
+        m_started = true;
+        ESP_LOGI(TAG, "Serving /metrics, /stream and /capture on port %u", static_cast<unsigned>(config::metrics::PORT));
+    }
+
+    void MetricsServer::poll()
+    {
+        if (!m_started)
+        {
+            return;
+        }
+
+        const auto now = static_cast<uint32_t>(millis());
+        WiFiClient client = m_server.accept();
+        if (client)
+        {
+            m_endpoint.accept(client, now);
+        }
+        m_endpoint.poll(now);
+    }
+
+    void MetricsServer::record_sample(uint8_t channel, float value, float baseline, bool alert)
+    {
+        m_ring.push(static_cast<uint32_t>(millis()), channel, value, baseline, alert);
+    }
+
+    const char *MetricsServer::channel_name(uint8_t channel)
+    {
+        const auto *sensor = sensors::SensorManager::instance().get_channel(channel);
+        return sensor ? sensor->get_name() : "";
+    }
+
+    void MetricsServer::write_metrics(metrics::ChunkWriter &out)
+    {
+        using metrics::write_family;
+        using metrics::write_value;
+
+        auto &sensor_manager = sensors::SensorManager::instance();
+        const size_t channel_count = sensor_manager.get_channel_count();
+        char labels[64];
+
+        for (const auto &family : CHANNEL_FAMILIES)
+        {
+            write_family(out, family.name, family.type, family.help);
+            for (size_t i = 0; i < channel_count; i++)
+            {
+                const auto *sensor = sensor_manager.get_channel(i);
+                if (!sensor)
+                    continue;
+
+                snprintf(labels, sizeof(labels), "channel=\"%u\",sensor=\"%s\"", static_cast<unsigned>(i),
+                         sensor->get_name());
+                write_value(out, family.name, labels, family.get(*sensor));
+            }
+        }
+
+        write_family(out, "sensor_alert", "gauge", "1 while the channel is alerting");
+        for (size_t i = 0; i < channel_count; i++)
+        {
+            const auto *sensor = sensor_manager.get_channel(i);
+            if (!sensor)
+                continue;
+
+            snprintf(labels, sizeof(labels), "channel=\"%u\",sensor=\"%s\"", static_cast<unsigned>(i),
+                     sensor->get_name());
+            write_value(out, "sensor_alert", labels, sensor_manager.get_channel_alert(i) ? 1.0 : 0.0);
+        }
+
+        const auto &scan = sensor_manager.get_scan_stats();
+        write_family(out, "scans_total", "counter", "Completed passes over all channels");
+        write_value(out, "scans_total", "", scan.completed_scans);
+        write_family(out, "scan_last_seconds", "gauge", "Duration of the last channel scan");
+        write_value(out, "scan_last_seconds", "", scan.last_scan_us / 1e6);
+        write_family(out, "scan_max_seconds", "gauge", "Longest channel scan since boot");
+        write_value(out, "scan_max_seconds", "", scan.max_scan_us / 1e6);
+
+        // Alert handler counters
+        auto &alert_manager = alert::AlertManager::instance();
+        const size_t handler_count = alert_manager.get_handler_count();
+        const struct
+        {
+            const char *name;
+            const char *help;
+            uint32_t (*get)(const alert::AlertManager::HandlerStats &stats);
+        } handler_families[] = {
+            {"handler_admitted_total", "Messages admitted by the rate limiter",
+             [](const alert::AlertManager::HandlerStats &h) { return h.rate.admitted; }},
+            {"handler_dropped_total", "Messages refused by the rate limiter and lost",
+             [](const alert::AlertManager::HandlerStats &h) { return h.rate.dropped; }},
+            {"handler_coalesced_total", "Messages refused and folded into a later one",
+             [](const alert::AlertManager::HandlerStats &h) { return h.rate.coalesced; }},
+            {"handler_overruns_total", "Calls that exceeded the handler time budget",
+             [](const alert::AlertManager::HandlerStats &h) { return h.overruns; }},
+            {"handler_errors_total", "Calls that returned a failure",
+             [](const alert::AlertManager::HandlerStats &h) { return h.errors; }},
+        };
+        for (const auto &family : handler_families)
+        {
+            write_family(out, family.name, "counter", family.help);
+            for (size_t i = 0; i < handler_count; i++)
+            {
+                const auto stats = alert_manager.get_handler_stats(i);
+                snprintf(labels, sizeof(labels), "handler=\"%s\"", stats.name);
+                write_value(out, family.name, labels, family.get(stats));
+            }
+        }
+
+        write_family(out, "dispatch_max_seconds", "gauge", "Longest dispatch latency per tier");
+        const struct
+        {
+            alert::HandlerType type;
+            const char *labels;
+        } tiers[] = {{alert::HandlerType::ALERT_ONLY, "tier=\"local\""},
+                     {alert::HandlerType::DATA_PUBLISHER, "tier=\"deferred\""}};
+        for (const auto &tier : tiers)
+        {
+            write_value(out, "dispatch_max_seconds", tier.labels, alert_manager.get_tier_stats(tier.type).max_us / 1e6);
+        }
+        write_family(out, "telemetry_thinned_total", "counter", "Telemetry intervals skipped while an event was open");
+        write_value(out, "telemetry_thinned_total", "", alert_manager.get_thinned_telemetry());
+
+        const auto &event_loop = EventLoop::instance();
+        write_family(out, "loop_wakeups_total", "counter", "Main loop wakeups, by timer or button interrupt");
+        write_value(out, "loop_wakeups_total", "", event_loop.get_stats().wakeups);
+        write_family(out, "loop_idle_seconds_total", "counter", "Time the main loop spent waiting for work");
+        write_value(out, "loop_idle_seconds_total", "", event_loop.get_stats().idle_us / 1e6);
+        write_family(out, "loop_wakeups_per_second", "gauge", "Wakeup rate over the last stats window");
+        write_value(out, "loop_wakeups_per_second", "", event_loop.get_wakeups_per_s());
+        write_family(out, "loop_idle_ratio", "gauge", "Share of the last stats window spent waiting");
+        write_value(out, "loop_idle_ratio", "", event_loop.get_idle_ratio());
+
+        const auto &connect = WiFiManager::instance().get_connect_stats();
+        write_family(out, "wifi_connects_total", "counter", "WiFi associations, by cached access point or full scan");
+        write_value(out, "wifi_connects_total", "path=\"cached\"", connect.fast_connects);
+        write_value(out, "wifi_connects_total", "path=\"scan\"", connect.scan_connects);
+        write_family(out, "wifi_fast_failures_total", "counter", "Cached access point attempts that timed out while a scan found the access point");
+        write_value(out, "wifi_fast_failures_total", "", connect.fast_failures);
+        write_family(out, "wifi_connect_seconds", "gauge", "Duration of the last association, by path");
+        write_value(out, "wifi_connect_seconds", "path=\"cached\"", connect.last_fast_ms / 1e3);
+        write_value(out, "wifi_connect_seconds", "path=\"scan\"", connect.last_scan_ms / 1e3);
+
+        const auto &network = NetworkCache::instance().get_stats();
+        write_family(out, "dns_cache_hits_total", "counter", "Host lookups answered from the network cache");
+        write_value(out, "dns_cache_hits_total", "", network.dns_hits);
+        write_family(out, "dns_lookups_total", "counter", "Host lookups that went to the DNS server");
+        write_value(out, "dns_lookups_total", "", network.dns_misses);
+        write_family(out, "dns_failures_total", "counter", "DNS lookups that failed");
+        write_value(out, "dns_failures_total", "", network.dns_failures);
+        write_family(out, "dns_cache_forgotten_total", "counter", "Cached addresses dropped after a failed connect");
+        write_value(out, "dns_cache_forgotten_total", "", network.stale_forgotten);
+        const struct
+        {
+            const char *labels;
+            const NetworkCache::FirstByteStats &stats;
+        } first_byte[] = {{"dns=\"cached\"", network.first_byte_cached},
+                          {"dns=\"resolved\"", network.first_byte_resolved}};
+        write_family(out, "connect_first_byte_seconds", "summary", "HTTP/MQTT connect to first response byte");
+        for (const auto &path : first_byte)
+        {
+            write_value(out, "connect_first_byte_seconds_sum", path.labels, path.stats.total_ms / 1e3);
+            write_value(out, "connect_first_byte_seconds_count", path.labels, path.stats.count);
+        }
+        write_family(out, "connect_first_byte_max_seconds", "gauge", "Slowest connect to first response byte since boot");
+        for (const auto &path : first_byte)
+        {
+            write_value(out, "connect_first_byte_max_seconds", path.labels, path.stats.max_ms / 1e3);
+        }
+
+        write_family(out, "uptime_seconds", "counter", "Time since boot");
+        write_value(out, "uptime_seconds", "", millis() / 1000.0);
+        write_family(out, "heap_free_bytes", "gauge", "Free heap");
+        write_value(out, "heap_free_bytes", "", ESP.getFreeHeap());
+        const JsonArena *arenas[] = {&JsonArena::telemetry(), &JsonArena::scratch()};
+        write_family(out, "json_arena_capacity_bytes", "gauge", "Static arena size behind JSON documents");
+        for (const auto *arena : arenas)
+        {
+            snprintf(labels, sizeof(labels), "arena=\"%s\"", arena->get_name());
+            write_value(out, "json_arena_capacity_bytes", labels, arena->get_stats().capacity);
+        }
+        write_family(out, "json_arena_peak_bytes", "gauge", "Most of the arena ever in use at once");
+        for (const auto *arena : arenas)
+        {
+            snprintf(labels, sizeof(labels), "arena=\"%s\"", arena->get_name());
+            write_value(out, "json_arena_peak_bytes", labels, arena->get_stats().peak_used);
+        }
+        write_family(out, "json_arena_heap_fallbacks_total", "counter", "JSON allocations that overflowed to the heap");
+        for (const auto *arena : arenas)
+        {
+            snprintf(labels, sizeof(labels), "arena=\"%s\"", arena->get_name());
+            write_value(out, "json_arena_heap_fallbacks_total", labels, arena->get_stats().heap_fallbacks);
+        }
+
+        const auto &capture = WaveformCapture::instance();
+        write_family(out, "capture_triggers_total", "counter", "Alert edges that started a waveform capture");
+        write_value(out, "capture_triggers_total", "", capture.get_stats().triggers);
+        write_family(out, "capture_missed_total", "counter", "Alert edges during a capture in progress");
+        write_value(out, "capture_missed_total", "", capture.get_stats().missed);
+        write_family(out, "capture_saves_total", "counter", "Captures written to NVS");
+        write_value(out, "capture_saves_total", "", capture.get_save_count());
+        write_family(out, "capture_blob_bytes", "gauge", "Size of the latest encoded capture");
+        write_value(out, "capture_blob_bytes", "", capture.get_stats().last_blob_bytes);
+        write_family(out, "capture_ram_bytes", "gauge", "RAM reserved for waveform capture");
+        write_value(out, "capture_ram_bytes", "", WaveformCapture::FOOTPRINT_BYTES);
+
+        write_family(out, "trace_dropped_total", "counter", "Deferred log records lost to a full ring");
+        write_value(out, "trace_dropped_total", "", trace::TraceLog::instance().get_dropped());
+    }
+} // namespace pooaway
+
+#endif // POOAWAY_WITH_METRICS
@@ -0,0 +1,196 @@
+#include "config.h"
+
+#if POOAWAY_WITH_NETWORK
+#include "network_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <Arduino.h>
+#include <WiFi.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "time_service.h"
+
+namespace pooaway
+{
+    namespace
+    {
+        uint32_t compute_crc(const void *blob, size_t length)
+        {
+            return esp_rom_crc32_le(0, static_cast<const uint8_t *>(blob), length);
+        }
+    }
+
+    NetworkCache &NetworkCache::instance()
+    {
+        static NetworkCache instance;
+        return instance;
+    }
+
+    NetworkCache::NetworkCache()
+    {
+        m_preferences.begin("pooaway_net", false);
+        m_blob.magic = MAGIC;
+        m_blob.version = VERSION;
+        load();
+    }
+
+    void NetworkCache::load()
+    {
+        Blob blob{};
+        if (m_preferences.getBytesLength(KEY) != sizeof(Blob))
+        {
+            return;
+        }
+
+        m_preferences.getBytes(KEY, &blob, sizeof(blob));
+        if (blob.magic != MAGIC || blob.version != VERSION || compute_crc(&blob, offsetof(Blob, crc)) != blob.crc)
+        {
+            ESP_LOGW(TAG, "Discarding invalid network cache");
+            return;
+        }
+
+        m_blob = blob;
+        ESP_LOGI(TAG, "Restored network cache (channel %u)", m_blob.association.channel);
+    }
+
+    void NetworkCache::save()
+    {
+        m_blob.crc = compute_crc(&m_blob, offsetof(Blob, crc));
+        if (m_preferences.putBytes(KEY, &m_blob, sizeof(Blob)) != sizeof(Blob))
+        {
+            ESP_LOGE(TAG, "Failed to write network cache");
+        }
+    }
+
+    bool NetworkCache::get_association(Association &association) const
+    {
+        if (m_blob.association.channel == 0)
+        {
+            return false;
+        }
+        association = m_blob.association;
+        return true;
+    }
+
+    void NetworkCache::set_association(const Association &association)
+    {
+        if (std::memcmp(&association, &m_blob.association, sizeof(Association)) != 0)
+        {
+            m_blob.association = association;
+            save();
+        }
+    }
+
+    NetworkCache::HostEntry *NetworkCache::find_host(const char *host)
+    {
+        for (auto &entry : m_blob.hosts)
+        {
+            if (std::strncmp(entry.name, host, sizeof(entry.name)) == 0)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool NetworkCache::is_fresh(size_t index) const
+    {
+        const auto &entry = m_blob.hosts[index];
+        const bool aged_out = m_refreshed[index] && millis() - m_resolved_ms[index] >= config::network::DNS_TTL_S * 1000UL;
+        const auto &time_service = TimeService::instance();
+        if (time_service.is_synced() && entry.expires_utc_s != 0)
+        {
+            return static_cast<uint32_t>(time_service.now_utc_us() / 1000000) < entry.expires_utc_s;
+        }
+
+        // Without a clock, an answer restored from NVS is trusted until a connect fails on it
+        return !aged_out;
+    }
+
+    bool NetworkCache::resolve(const char *host, IPAddress &address, bool &cached)
+    {
+        cached = false;
+        HostEntry *entry = find_host(host);
+        if (entry && is_fresh(static_cast<size_t>(entry - m_blob.hosts)))
+        {
+            address = IPAddress(entry->address);
+            cached = true;
+            m_stats.dns_hits++;
+            return true;
+        }
+
+        if (!WiFi.hostByName(host, address))
+        {
+            m_stats.dns_failures++;
+            if (entry)
+            {
+                // A stale answer beats none while the resolver is unreachable
+                ESP_LOGW(TAG, "DNS lookup of %s failed, using the expired answer", host);
+                address = IPAddress(entry->address);
+                cached = true;
+                return true;
+            }
+            ESP_LOGW(TAG, "DNS lookup of %s failed", host);
+            return false;
+        }
+        m_stats.dns_misses++;
+
+        if (std::strlen(host) > MAX_HOST_LENGTH)
+        {
+            return true;
+        }
+        if (!entry)
+        {
+            // An empty slot, else the entry closest to expiry
+            entry = std::min_element(std::begin(m_blob.hosts), std::end(m_blob.hosts),
+                                     [](const HostEntry &a, const HostEntry &b)
+                                     { return (a.name[0] ? a.expires_utc_s + 1 : 0) < (b.name[0] ? b.expires_utc_s + 1 : 0); });
+        }
+
+        const auto index = static_cast<size_t>(entry - m_blob.hosts);
+        const bool changed = std::strncmp(entry->name, host, sizeof(entry->name)) != 0 ||
+                             entry->address != static_cast<uint32_t>(address);
+        std::strncpy(entry->name, host, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+        entry->address = static_cast<uint32_t>(address);
+
+        const auto &time_service = TimeService::instance();
+        entry->expires_utc_s = time_service.is_synced()
+                                   ? static_cast<uint32_t>(time_service.now_utc_us() / 1000000) + config::network::DNS_TTL_S
+                                   : 0;
+        m_resolved_ms[index] = millis();
+        m_refreshed[index] = true;
+
+        // Only a new address is worth a flash write; the expiry alone is refreshed in RAM
+        if (changed)
+        {
+            ESP_LOGI(TAG, "%s is at %s", host, address.toString().c_str());
+            save();
+        }
+        return true;
+    }
+
+    void NetworkCache::forget_host(const char *host)
+    {
+        HostEntry *entry = find_host(host);
+        if (!entry)
+        {
+            return;
+        }
+        ESP_LOGW(TAG, "Forgetting cached address of %s", host);
+        *entry = HostEntry{};
+        m_refreshed[entry - m_blob.hosts] = false;
+        m_stats.stale_forgotten++;
+        save();
+    }
+
+    void NetworkCache::record_first_byte(bool cached, unsigned long elapsed_ms)
+    {
+        auto &stats = cached ? m_stats.first_byte_cached : m_stats.first_byte_resolved;
+        stats.count++;
+        stats.total_ms += elapsed_ms;
+        stats.max_ms = std::max(stats.max_ms, static_cast<uint32_t>(elapsed_ms));
+    }
+} // namespace pooaway
+
+#endif // POOAWAY_WITH_NETWORK
@@ -0,0 +1,116 @@
+#include "pattern_player.h"
+#include "esp_log.h"
+
+namespace pooaway::pattern
+{
+    static_assert(sizeof(rmt_data_t) == sizeof(RmtSymbol), "RmtSymbol must match the RMT symbol word");
+
+    bool LedPlayer::begin(uint8_t pin)
+    {
+        m_pin = pin;
+        m_attached = ledcAttach(pin, LEDC_FADE_HZ, LEDC_FADE_BITS) && ledcWrite(pin, 0);
+        m_current = LedPattern{};
+        if (!m_attached)
+        {
+            ESP_LOGE(TAG, "No LEDC channel for pin %u", pin);
+        }
+        return m_attached;
+    }
+
+    bool LedPlayer::play(const LedPattern &pattern)
+    {
+        if (!m_attached)
+        {
+            return false;
+        }
+        if (pattern == m_current)
+        {
+            return true;
+        }
+
+        LedProgram program;
+        if (!compile(pattern, m_current, program))
+        {
+            ESP_LOGE(TAG, "Pattern cannot be played (period %u ms)", pattern.period_ms);
+            return false;
+        }
+
+        // A blink is the PWM period itself, so the timer is retuned for every pattern
+        if (ledcChangeFrequency(m_pin, program.frequency_hz, program.resolution_bits) == 0)
+        {
+            ESP_LOGE(TAG, "LEDC cannot run at %lu Hz with %u bits", static_cast<unsigned long>(program.frequency_hz),
+                     program.resolution_bits);
+            return false;
+        }
+        const bool written = program.fade_from != program.duty
+                                 ? ledcFade(m_pin, program.fade_from, program.duty, program.fade_ms)
+                                 : ledcWrite(m_pin, program.duty);
+        if (!written)
+        {
+            ESP_LOGE(TAG, "LEDC write failed");
+            return false;
+        }
+
+        m_current = pattern;
+        m_programs++;
+        return true;
+    }
+
+    bool TonePlayer::begin(uint8_t pin)
+    {
+        m_pin = pin;
+        m_ready = rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, RMT_TICK_HZ);
+        m_current = TonePattern{};
+        if (!m_ready)
+        {
+            ESP_LOGE(TAG, "No RMT channel for pin %u", pin);
+        }
+        return m_ready;
+    }
+
+    bool TonePlayer::play(const TonePattern &pattern)
+    {
+        if (!m_ready)
+        {
+            return false;
+        }
+        if (pattern == m_current)
+        {
+            return true;
+        }
+
+        ToneProgram program;
+        if (!compile(pattern, program))
+        {
+            ESP_LOGE(TAG, "Pattern does not fit %u RMT symbols", static_cast<unsigned>(RMT_MAX_SYMBOLS));
+            return false;
+        }
+
+        bool written;
+        if (program.symbol_count == 0)
+        {
+            // Any write ends a looping transmission; the line idles low, which is silent
+            m_symbols[0].val = RmtSymbol::make(1, false, 1, false).value;
+            written = rmtWriteAsync(m_pin, m_symbols, 1);
+        }
+        else
+        {
+            for (size_t i = 0; i < program.symbol_count; i++)
+            {
+                m_symbols[i].val = program.symbols[i].value;
+            }
+            // Carrier on the high halves, square wave
+            written = rmtSetCarrier(m_pin, true, true, program.carrier_hz, 0.5F) &&
+                      rmtWriteLooping(m_pin, m_symbols, program.symbol_count);
+        }
+        if (!written)
+        {
+            ESP_LOGE(TAG, "RMT write failed");
+            return false;
+        }
+
+        m_current = pattern;
+        m_programs++;
+        return true;
+    }
+} // namespace pooaway::pattern
@@ -1,9 +1,44 @@
 #include "sensor_manager.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "config.h"
+#include "state_store.h"
+#include "alert_manager.h"
+#if POOAWAY_WITH_METRICS
+#include "metrics_server.h"
+#endif
+#include "waveform_capture.h"
 
 namespace pooaway::sensors
 {
+    namespace
+    {
+        // Names for the NH3/CH4 pairs on the mux; must outlive the sensors, hence static storage
+        constexpr const char *MUX_SENSOR_NAMES[][2] = {
+            {"PEE1", "POO1"}, {"PEE2", "POO2"}, {"PEE3", "POO3"}, {"PEE4", "POO4"},
+            {"PEE5", "POO5"}, {"PEE6", "POO6"}, {"PEE7", "POO7"}, {"PEE8", "POO8"}};
+
+        constexpr size_t MUX_PAIR_CAPACITY = sizeof(MUX_SENSOR_NAMES) / sizeof(MUX_SENSOR_NAMES[0]);
+        static_assert(config::mux::PAIR_COUNT >= 0 &&
+                          static_cast<size_t>(config::mux::PAIR_COUNT) <= MUX_PAIR_CAPACITY,
+                      "config::mux::PAIR_COUNT exceeds the 16 inputs of the multiplexer");
+        static_assert(SensorManager::MAX_CHANNELS <= pooaway::StateStore::MAX_CHANNELS,
+                      "StateStore cannot hold every sensor channel");
+
+        // Heaters are fed from the supply rail, so they stay hot across any reset but a power cycle
+        bool heaters_still_warm()
+        {
+            switch (esp_reset_reason())
+            {
+            case ESP_RST_POWERON:
+            case ESP_RST_BROWNOUT:
+            case ESP_RST_UNKNOWN:
+                return false;
+            default:
+                return true;
+            }
+        }
+    }
 
     SensorManager &SensorManager::instance()
     {
@@ -12,48 +47,290 @@ namespace pooaway::sensors
     }
 
     SensorManager::SensorManager()
-        : m_nh3_sensor(std::make_unique<NH3Sensor>(config::hardware::PEE_SENSOR_PIN)), m_ch4_sensor(std::make_unique<CH4Sensor>(config::hardware::POO_SENSOR_PIN))
+        : m_mux({config::mux::SELECT_PINS[0], config::mux::SELECT_PINS[1],
+                 config::mux::SELECT_PINS[2], config::mux::SELECT_PINS[3]},
+                config::mux::ENABLE_PIN)
     {
         m_preferences.begin("pooaway", false);
 
-        // Initialize sensor array
-        m_sensors[static_cast<size_t>(SensorType::PEE)] = m_nh3_sensor.get();
-        m_sensors[static_cast<size_t>(SensorType::POO)] = m_ch4_sensor.get();
+        // Built-in sensors keep the SensorType indices (PEE = 0, POO = 1)
+        register_channel(std::make_unique<NH3Sensor>(config::hardware::PEE_SENSOR_PIN));
+        register_channel(std::make_unique<CH4Sensor>(config::hardware::POO_SENSOR_PIN));
+        register_mux_channels();
+    }
+
+    void SensorManager::register_mux_channels()
+    {
+        for (int pair = 0; pair < config::mux::PAIR_COUNT; pair++)
+        {
+            const auto nh3_input = static_cast<uint8_t>(pair * 2);
+            const auto ch4_input = static_cast<uint8_t>(pair * 2 + 1);
+
+            register_channel(std::make_unique<NH3Sensor>(config::mux::COM_PIN,
+                                                         MUX_SENSOR_NAMES[pair][0]),
+                             nh3_input, config::mux::SETTLE_US);
+            register_channel(std::make_unique<CH4Sensor>(config::mux::COM_PIN,
+                                                         MUX_SENSOR_NAMES[pair][1]),
+                             ch4_input, config::mux::SETTLE_US);
+        }
+    }
+
+    int SensorManager::register_channel(std::unique_ptr<BaseSensor> sensor,
+                                        uint8_t mux_channel, uint32_t settle_us)
+    {
+        if (!sensor)
+        {
+            ESP_LOGE(TAG, "Cannot register a null sensor");
+            return -1;
+        }
+        if (m_initialized)
+        {
+            ESP_LOGE(TAG, "Cannot register %s after init", sensor->get_name());
+            return -1;
+        }
+
+        if (m_channel_count >= MAX_CHANNELS)
+        {
+            ESP_LOGE(TAG, "Channel table full, cannot register %s", sensor->get_name());
+            return -1;
+        }
+
+        const size_t index = m_channel_count++;
+        auto &slot = m_channels[index];
+        slot.sensor = sensor.get();
+        slot.mux_channel = mux_channel;
+        slot.settle_us = settle_us;
+        slot.alert = false;
+        m_owned_sensors[index] = std::move(sensor);
+
+        ESP_LOGD(TAG, "Registered channel %u: %s (mux input %u, settle %lu us)",
+                 static_cast<unsigned>(index), slot.sensor->get_name(), mux_channel,
+                 static_cast<unsigned long>(settle_us));
+        return static_cast<int>(index);
+    }
+
+    bool SensorManager::uses_mux() const
+    {
+        for (size_t i = 0; i < m_channel_count; i++)
+        {
+            if (m_channels[i].mux_channel != AnalogMux::NO_CHANNEL)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void SensorManager::select_channel_blocking(const ChannelSlot &slot)
+    {
+        if (slot.mux_channel == AnalogMux::NO_CHANNEL)
+        {
+            return;
+        }
+
+        if (m_mux.select(slot.mux_channel))
+        {
+            delayMicroseconds(slot.settle_us);
+        }
     }
 
     void SensorManager::init()
     {
-        ESP_LOGI(TAG, "Initializing sensors...");
+        ESP_LOGI(TAG, "Initializing %u sensor channels...", static_cast<unsigned>(m_channel_count));
+        m_initialized = true;
 
-        for (auto *sensor : m_sensors)
+        if (uses_mux())
         {
-            if (sensor == nullptr)
-                continue;
+            m_mux.init();
+        }
 
+        // StateStore::load() has already run as its own boot step
+        auto &store = pooaway::StateStore::instance();
+
+        // All heaters power up together, so a single wait covers the longest preheat
+        float preheat_s = 0.0F;
+        bool all_restored = true;
+        for (size_t i = 0; i < m_channel_count; i++)
+        {
+            auto *sensor = m_channels[i].sensor;
             sensor->init();
+            preheat_s = std::max(preheat_s, sensor->get_preheating_time());
+            all_restored = restore_channel(i) && all_restored;
+        }
+
+        if (all_restored && heaters_still_warm())
+        {
+            ESP_LOGI(TAG, "Warm restart with restored state, skipping preheat");
+        }
+        else
+        {
+            ESP_LOGI(TAG, "Preheating sensors for %.0f s", preheat_s);
+            delay(static_cast<unsigned long>(preheat_s * 1000.0F));
+        }
 
-            // Load calibration from preferences if available
-            const float saved_r0 = m_preferences.getFloat(sensor->get_name(), 0.0F);
-            if (saved_r0 > 0.0F)
+        for (size_t i = 0; i < m_channel_count; i++)
+        {
+            auto &slot = m_channels[i];
+            auto *sensor = slot.sensor;
+            if (!sensor->needs_calibration())
             {
-                ESP_LOGI(TAG, "Loaded calibration for %s: R0=%.1f",
-                         sensor->get_name(), saved_r0);
-                sensor->set_r0(saved_r0);
+                continue;
             }
-            else
+
+            select_channel_blocking(slot);
+            if (sensor->calibrate())
             {
-                sensor->calibrate();
+                store.set_channel_r0(i, sensor->get_name(), sensor->get_r0());
+                store.request_commit();
             }
         }
     }
 
+    bool SensorManager::restore_channel(size_t index)
+    {
+        auto &store = pooaway::StateStore::instance();
+        auto *sensor = m_channels[index].sensor;
+
+        float r0 = 0.0F;
+        float baseline = 0.0F;
+        if (store.get_channel(index, sensor->get_name(), r0, baseline))
+        {
+            return sensor->restore_state(r0, baseline);
+        }
+
+        // Older firmware kept only R0, one Preferences key per sensor name
+        const float legacy_r0 = m_preferences.getFloat(sensor->get_name(), 0.0F);
+        if (legacy_r0 > 0.0F && sensor->restore_state(legacy_r0, 0.0F))
+        {
+            store.set_channel_r0(index, sensor->get_name(), legacy_r0);
+            store.request_commit();
+            return true;
+        }
+        return false;
+    }
+
     void SensorManager::update()
     {
-        for (auto *sensor : m_sensors)
+        // Sample every channel that is ready, stopping at the first mux input that is still
+        // settling so the main loop never blocks on the multiplexer
+        m_settle_remaining_us = 0;
+        for (size_t visited = 0; visited < m_channel_count; visited++)
         {
-            if (sensor != nullptr)
+            auto &slot = m_channels[m_scan_cursor];
+
+            if (slot.mux_channel != AnalogMux::NO_CHANNEL)
+            {
+                if (m_mux.select(slot.mux_channel))
+                {
+                    m_select_time_us = micros();
+                }
+
+                const unsigned long settled_us = micros() - m_select_time_us;
+                if (settled_us < slot.settle_us)
+                {
+                    m_settle_remaining_us = slot.settle_us - settled_us;
+                    return;
+                }
+            }
+
+            if (m_scan_cursor == 0)
+            {
+                m_scan_start_us = micros();
+                m_edge_in_scan = false;
+            }
+
+            if (!slot.sensor->read())
+            {
+                m_scan_stats.failed_reads++;
+            }
+            auto &capture = pooaway::WaveformCapture::instance();
+            capture.add(m_scan_cursor, slot.sensor->get_last_raw());
+            const bool alert = slot.sensor->check_alert();
+            if (alert != slot.alert && !m_edge_in_scan)
             {
-                sensor->read();
+                m_edge_us = micros();
+                m_edge_in_scan = true;
+            }
+            if (alert && !slot.alert)
+            {
+                slot.sensor->record_alert();
+                capture.trigger(m_scan_cursor);
+            }
+            slot.alert = alert;
+#if POOAWAY_WITH_METRICS
+            pooaway::MetricsServer::instance().record_sample(static_cast<uint8_t>(m_scan_cursor),
+                                                             slot.sensor->get_value(),
+                                                             slot.sensor->get_baseline(), alert);
+#endif
+
+            // Drift-corrected R0 goes through the normal throttled commit path
+            if (slot.sensor->track_r0(millis()))
+            {
+                pooaway::StateStore::instance().set_channel_r0(m_scan_cursor, slot.sensor->get_name(),
+                                                               slot.sensor->get_r0());
+            }
+            m_scan_stats.channel_reads++;
+
+            m_scan_cursor = (m_scan_cursor + 1) % m_channel_count;
+            const bool scan_done = (m_scan_cursor == 0);
+            if (scan_done)
+            {
+                const auto scan_us = static_cast<uint32_t>(micros() - m_scan_start_us);
+                m_scan_stats.completed_scans++;
+                m_scan_stats.last_scan_us = scan_us;
+                m_scan_stats.max_scan_us = std::max(m_scan_stats.max_scan_us, scan_us);
+                m_scan_stats.total_scan_us += scan_us;
+                snapshot_baselines();
+                capture.on_scan();
+            }
+
+            // Switch the mux early so the next input settles while the loop does other work
+            const auto &next = m_channels[m_scan_cursor];
+            if (next.mux_channel != AnalogMux::NO_CHANNEL && m_mux.select(next.mux_channel))
+            {
+                m_select_time_us = micros();
+            }
+
+            // A scan resumed after a settle ends at the last channel; the next one waits for
+            // the sample timer rather than running straight on
+            if (scan_done)
+            {
+                return;
+            }
+        }
+    }
+
+    void SensorManager::snapshot_baselines()
+    {
+        const unsigned long now = millis();
+        if (now - m_last_snapshot_ms < config::storage::SNAPSHOT_INTERVAL_MS)
+        {
+            return;
+        }
+
+        // A baseline taken in gas would be restored after a reboot and hide the next event,
+        // so wait for clean air; the snapshot runs on the first scan after
+        if (pooaway::alert::AlertManager::instance().is_event_open())
+        {
+            return;
+        }
+        for (size_t i = 0; i < m_channel_count; i++)
+        {
+            if (m_channels[i].alert)
+            {
+                return;
+            }
+        }
+        m_last_snapshot_ms = now;
+
+        // Only updates the RAM image; StateStore decides whether the drift is worth a write
+        auto &store = pooaway::StateStore::instance();
+        for (size_t i = 0; i < m_channel_count; i++)
+        {
+            const auto *sensor = m_channels[i].sensor;
+            if (sensor->get_baseline() > 0.0F)
+            {
+                store.set_channel_baseline(i, sensor->get_name(), sensor->get_baseline());
             }
         }
     }
@@ -62,60 +339,88 @@ namespace pooaway::sensors
     {
         ESP_LOGI(TAG, "Starting clean air calibration...");
 
-        for (auto *sensor : m_sensors)
+        auto &store = pooaway::StateStore::instance();
+        for (size_t i = 0; i < m_channel_count; i++)
         {
-            if (sensor == nullptr)
-                continue;
+            auto &slot = m_channels[i];
+            auto *sensor = slot.sensor;
 
-            sensor->calibrate();
-
-            // Save calibration to preferences
-            m_preferences.putFloat(sensor->get_name(), sensor->get_r0());
+            select_channel_blocking(slot);
+            if (sensor->calibrate())
+            {
+                store.set_channel_r0(i, sensor->get_name(), sensor->get_r0());
+            }
         }
 
+        // A fresh R0 is worth persisting promptly
+        store.request_commit();
+
         ESP_LOGI(TAG, "Calibration complete");
         run_diagnostics();
     }
 
+    BaseSensor *SensorManager::get_channel(size_t index)
+    {
+        return index < m_channel_count ? m_channels[index].sensor : nullptr;
+    }
+
+    bool SensorManager::get_channel_alert(size_t index) const
+    {
+        return index < m_channel_count ? m_channels[index].alert : false;
+    }
+
     float SensorManager::get_sensor_value(SensorType type) const
     {
-        const auto *sensor = m_sensors[static_cast<size_t>(type)];
-        return sensor ? sensor->get_value() : 0.0F;
+        const auto index = static_cast<size_t>(type);
+        return index < m_channel_count ? m_channels[index].sensor->get_value() : 0.0F;
     }
 
     bool SensorManager::get_alert_status(SensorType type) const
     {
-        const auto *sensor = m_sensors[static_cast<size_t>(type)];
-        return sensor ? sensor->check_alert() : false;
+        return get_channel_alert(static_cast<size_t>(type));
     }
 
     BaseSensor *SensorManager::get_sensor(SensorType type)
     {
-        return m_sensors[static_cast<size_t>(type)];
+        return get_channel(static_cast<size_t>(type));
     }
 
     void SensorManager::run_diagnostics()
     {
         ESP_LOGI(TAG, "Running diagnostics for all sensors");
 
-        for (auto *sensor : m_sensors)
+        for (size_t i = 0; i < m_channel_count; i++)
         {
-            if (sensor == nullptr)
-                continue;
-
+            const auto *sensor = m_channels[i].sensor;
             const float value = sensor->get_value();
             const float r0 = sensor->get_r0();
+            const auto &diag = sensor->get_diagnostics();
 
-            ESP_LOGI(TAG, "[%s] Value: %.2f, R0: %.1f",
-                     sensor->get_name(), value, r0);
+            ESP_LOGI(TAG, "[%s] Value: %.2f, R0: %.1f, %s",
+                     sensor->get_name(), value, r0, diag.is_healthy ? "healthy" : "UNHEALTHY");
+            ESP_LOGI(TAG, "[%s] %lu reads, %lu errors (%.1f%% last window), mean %.2f sd %.2f [%.2f..%.2f], "
+                          "%lu alerts, %lu calibrations, %lu voltage jumps",
+                     sensor->get_name(), static_cast<unsigned long>(diag.read_count),
+                     static_cast<unsigned long>(diag.error_count), diag.last_window_error_rate * 100.0F,
+                     diag.avg_value, diag.stddev(), diag.min_value, diag.max_value,
+                     static_cast<unsigned long>(diag.alert_count),
+                     static_cast<unsigned long>(diag.calibration_count),
+                     static_cast<unsigned long>(diag.voltage_jumps));
         }
+
+        ESP_LOGI(TAG, "Scan: %u channels, %lu scans, %lu failed reads, last %lu us, max %lu us",
+                 static_cast<unsigned>(m_channel_count),
+                 static_cast<unsigned long>(m_scan_stats.completed_scans),
+                 static_cast<unsigned long>(m_scan_stats.failed_reads),
+                 static_cast<unsigned long>(m_scan_stats.last_scan_us),
+                 static_cast<unsigned long>(m_scan_stats.max_scan_us));
     }
 
     bool SensorManager::needs_calibration() const
     {
-        for (const auto *sensor : m_sensors)
+        for (size_t i = 0; i < m_channel_count; i++)
         {
-            if (sensor && sensor->needs_calibration())
+            if (m_channels[i].sensor->needs_calibration())
             {
                 return true;
             }
@@ -123,4 +428,4 @@ namespace pooaway::sensors
         return false;
     }
 
-} // namespace pooaway::sensors
\ No newline at end of file
+} // namespace pooaway::sensors
@@ -0,0 +1,57 @@
+#include "sensors/analog_mux.h"
+#include <Arduino.h>
+#include "esp_log.h"
+
+namespace pooaway::sensors
+{
+    AnalogMux::AnalogMux(const std::array<int, MAX_SELECT_PINS> &select_pins, int enable_pin)
+        : m_select_pins(select_pins), m_enable_pin(enable_pin)
+    {
+    }
+
+    void AnalogMux::init()
+    {
+        ESP_LOGI(TAG, "Initializing analog multiplexer");
+
+        for (const int pin : m_select_pins)
+        {
+            pinMode(pin, OUTPUT);
+            digitalWrite(pin, LOW);
+        }
+
+        if (m_enable_pin >= 0)
+        {
+            pinMode(m_enable_pin, OUTPUT);
+            digitalWrite(m_enable_pin, LOW); // Active-low enable
+        }
+
+        m_selected = NO_CHANNEL;
+    }
+
+    bool AnalogMux::select(uint8_t channel)
+    {
+        if (channel == m_selected)
+        {
+            return false;
+        }
+
+        if (channel >= get_channel_count())
+        {
+            ESP_LOGE(TAG, "Invalid mux channel: %u", channel);
+            return false;
+        }
+
+        // Only toggle the lines that differ to keep switching glitches minimal
+        const uint8_t changed = (m_selected == NO_CHANNEL) ? 0x0F : (channel ^ m_selected);
+        for (size_t bit = 0; bit < MAX_SELECT_PINS; bit++)
+        {
+            if (changed & (1U << bit))
+            {
+                digitalWrite(m_select_pins[bit], (channel >> bit) & 0x01U);
+            }
+        }
+
+        m_selected = channel;
+        return true;
+    }
+} // namespace pooaway::sensors
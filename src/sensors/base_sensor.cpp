@@ -1,15 +1,23 @@
 #include "sensors/base_sensor.h"
 #include "sensors/calibration_service.h"
+#include "trace_log.h"
+#include <algorithm>
 
 namespace pooaway::sensors
 {
     static constexpr char const *TAG = "BaseSensor";
-    static constexpr int CALIBRATION_SAMPLES = 10;
 
     BaseSensor::BaseSensor(const char *model, const char *name, int pin,
                            float alpha, float tolerance, float preheating_time,
                            int min_detect_ms, float coeff_a, float coeff_b)
-        : m_model(model), m_name(name), m_pin(pin), m_alpha(alpha), m_tolerance(tolerance), m_preheating_time(preheating_time), m_min_detect_ms(min_detect_ms), m_coeff_a(coeff_a), m_coeff_b(coeff_b)
+        : m_model(model), m_name(name), m_pin(pin), m_alpha(alpha), m_tolerance(tolerance), m_preheating_time(preheating_time), m_min_detect_ms(min_detect_ms), m_coeff_a(coeff_a), m_coeff_b(coeff_b),
+          m_threshold(tolerance, static_cast<unsigned long>(min_detect_ms)),
+          m_cusum(CusumParams{config::detection::CUSUM_DRIFT_K, config::detection::CUSUM_THRESHOLD_H,
+                              config::detection::CUSUM_NOISE_ALPHA, config::detection::CUSUM_MIN_SIGMA_RATIO,
+                              config::detection::CUSUM_MAX_STEP}),
+          // With b < 0 gas lowers Rs, so clean air sits at the top of the Rs distribution
+          m_clean_air_rs(coeff_b < 0.0F ? 1.0F - config::calibration::CLEAN_AIR_QUANTILE
+                                        : config::calibration::CLEAN_AIR_QUANTILE)
     {
     }
 
@@ -18,33 +26,39 @@ namespace pooaway::sensors
         ESP_LOGI(TAG, "Initializing %s sensor...", m_name);
         pinMode(m_pin, INPUT);
 
-        // Wait for sensor to warm up
-        delay(static_cast<unsigned long>(m_preheating_time * 1000.0F));
+        // Preheating is awaited once by SensorManager, since all heaters share the supply
         m_needs_calibration = true;
         m_alerts_enabled = true;
     }
 
-    void BaseSensor::read()
+    Result BaseSensor::read()
     {
         if (m_low_power_mode)
         {
-            return;
+            return Result::fail(Code::NOT_READY, "Sensor in low power mode");
         }
 
         const float raw_value = read_raw();
+        m_last_raw = raw_value;
         if (!validate_reading(raw_value))
         {
             ESP_LOGW(TAG, "Invalid reading from %s sensor: %.2f", m_name, raw_value);
-            return;
+            m_diagnostics.record_error(millis());
+            return Result::fail(Code::INVALID_DATA, "ADC reading out of range");
         }
 
         const float ppm = calculate_ppm(raw_value);
         if (!is_valid_ppm(ppm))
         {
             ESP_LOGW(TAG, "Invalid PPM from %s sensor: %.2f", m_name, ppm);
-            return;
+            m_diagnostics.record_error(millis());
+            return Result::fail(Code::INVALID_DATA, "PPM out of range");
         }
 
+        // CUSUM scores the sample against the baseline predicted before it, so it always runs
+        // and stays warm if the engine is switched at runtime
+        m_cusum.update(ppm, m_first_reading ? ppm : m_baseline_ema);
+
         // Update baseline using EMA
         if (m_first_reading)
         {
@@ -56,53 +70,133 @@ namespace pooaway::sensors
             m_baseline_ema = (m_alpha * ppm) + ((1.0F - m_alpha) * m_baseline_ema);
         }
         m_value = ppm;
+        m_diagnostics.record_read(millis(), ppm, get_voltage(), get_rs());
+        return Result::ok();
     }
 
     float BaseSensor::read_raw() const
     {
         const float raw_value = static_cast<float>(analogRead(m_pin));
-        ESP_LOGD(TAG, "Raw value from %s sensor: %.2f", m_name, raw_value);
+        TRACE_LOGD(TAG, "Raw value from %s sensor: %.2f", m_name, raw_value);
         return raw_value;
     }
 
-    void BaseSensor::calibrate()
+    Result BaseSensor::calibrate()
     {
         ESP_LOGI(TAG, "Starting calibration for %s sensor...", m_name);
 
-        float r0 = CalibrationService::calibrate_sensor(*this, CALIBRATION_SAMPLES);
-        if (validate_r0(r0))
+        const auto result = CalibrationService::calibrate_sensor(*this);
+        m_diagnostics.calibration_confidence = result.confidence;
+        if (!result.converged)
+        {
+            ESP_LOGE(TAG, "Calibration failed for %s: Rs not settled after %lu ms (spread %.2f%%, trend %.2f%%/s, "
+                          "%u of %u reads invalid), confidence %.2f",
+                     m_name, result.elapsed_ms, result.spread * 100.0F, result.trend_per_s * 100.0F,
+                     result.invalid, result.samples, result.confidence);
+            return Result::fail(Code::NOT_CONVERGED, "Rs did not settle");
+        }
+        if (!validate_r0(result.r0))
+        {
+            ESP_LOGE(TAG, "Calibration failed for %s. Invalid R0=%.1f", m_name, result.r0);
+            return Result::fail(Code::INVALID_DATA, "R0 out of range");
+        }
+
+        set_r0(result.r0);
+        m_needs_calibration = false;
+        m_diagnostics.record_calibration();
+        ESP_LOGI(TAG, "Calibration complete for %s in %lu ms. R0=%.1f, confidence %.2f", m_name,
+                 result.elapsed_ms, m_r0, result.confidence);
+        return Result::ok();
+    }
+
+    bool BaseSensor::restore_state(float r0, float baseline)
+    {
+        const bool r0_valid = validate_r0(r0);
+        if (r0_valid)
         {
             set_r0(r0);
             m_needs_calibration = false;
-            ESP_LOGI(TAG, "Calibration complete for %s. R0=%.1f", m_name, m_r0);
         }
-        else
+
+        if (baseline > 0.0F)
         {
-            ESP_LOGE(TAG, "Calibration failed for %s. Invalid R0=%.1f", m_name, r0);
+            // Seed value too, so the first check_alert() before a read sees no deviation
+            m_baseline_ema = baseline;
+            m_value = baseline;
+            m_first_reading = false;
         }
+
+        ESP_LOGI(TAG, "Restored %s: R0=%.1f%s, baseline=%.2f", m_name, r0,
+                 r0_valid ? "" : " (rejected)", baseline);
+        return r0_valid;
     }
 
-    bool BaseSensor::check_alert() const
+    bool BaseSensor::track_r0(unsigned long now)
     {
-        if (!m_alerts_enabled || m_first_reading)
+        if (!config::calibration::AUTO_R0_ENABLED || m_needs_calibration || m_low_power_mode ||
+            m_first_reading || m_diagnostics.consecutive_errors > 0 || m_threshold.is_exceeded() ||
+            m_cusum.is_accumulating())
+        {
+            return false; // Only learn from valid, non-alerting readings of a calibrated sensor
+        }
+
+        if (now - m_last_r0_sample_ms < config::calibration::SAMPLE_INTERVAL_MS)
         {
             return false;
         }
+        m_last_r0_sample_ms = now;
 
-        const float deviation = std::abs(m_value - m_baseline_ema);
-        const bool threshold_exceeded = (deviation > m_tolerance * m_baseline_ema);
+        if (m_clean_air_rs.count() == 0)
+        {
+            m_epoch_start_ms = now;
+        }
+        m_clean_air_rs.add(get_rs());
 
-        if (threshold_exceeded)
+        if (now - m_epoch_start_ms < config::calibration::EPOCH_MS)
         {
-            if (m_detect_start == 0)
-            {
-                m_detect_start = millis();
-            }
-            return (millis() - m_detect_start) >= static_cast<unsigned long>(m_min_detect_ms);
+            return false;
         }
 
-        m_detect_start = 0;
-        return false;
+        const uint32_t samples = m_clean_air_rs.count();
+        const float target = m_clean_air_rs.value();
+        m_clean_air_rs.reset();
+
+        if (samples < config::calibration::MIN_EPOCH_SAMPLES || !m_diagnostics.is_healthy)
+        {
+            ESP_LOGW(TAG, "Skipping R0 update for %s: %lu samples, %s", m_name,
+                     static_cast<unsigned long>(samples), m_diagnostics.is_healthy ? "healthy" : "unhealthy");
+            return false;
+        }
+
+        // Bounded step, so one bad day cannot move R0 far
+        const float max_step = config::calibration::MAX_STEP_RATIO * m_r0;
+        const float step = std::max(-max_step, std::min(max_step, target - m_r0));
+        const float next_r0 = m_r0 + step;
+        if (!validate_r0(next_r0))
+        {
+            ESP_LOGW(TAG, "Rejected background R0 for %s: %.1f (target %.1f)", m_name, next_r0, target);
+            return false;
+        }
+
+        ESP_LOGI(TAG, "Background R0 for %s: %.1f -> %.1f (clean-air Rs %.1f over %lu samples)",
+                 m_name, m_r0, next_r0, target, static_cast<unsigned long>(samples));
+        set_r0(next_r0);
+        m_diagnostics.record_calibration();
+        return step != 0.0F;
+    }
+
+    bool BaseSensor::check_alert() const
+    {
+        if (!m_alerts_enabled || m_first_reading)
+        {
+            return false;
+        }
+
+        if (m_alert_engine == AlertEngine::CUSUM)
+        {
+            return m_cusum.in_alarm();
+        }
+        return m_threshold.update(millis(), m_value, m_baseline_ema);
     }
 
     void BaseSensor::enter_low_power()
@@ -123,10 +217,12 @@ namespace pooaway::sensors
             // Reset readings
             m_first_reading = true;
             m_baseline_ema = 0.0F;
+            m_threshold.reset();
+            m_cusum.reset();
         }
     }
 
-    void BaseSensor::run_self_test()
+    Result BaseSensor::run_self_test()
     {
         ESP_LOGI(TAG, "Running self-test for %s sensor...", m_name);
 
@@ -134,18 +230,19 @@ namespace pooaway::sensors
         if (!validate_reading(raw_value))
         {
             ESP_LOGE(TAG, "Self-test failed for %s: Invalid reading %.2f", m_name, raw_value);
-            return;
+            return Result::fail(Code::INVALID_DATA, "ADC reading out of range");
         }
 
         const float ppm = calculate_ppm(raw_value);
         if (!is_valid_ppm(ppm))
         {
             ESP_LOGE(TAG, "Self-test failed for %s: Invalid PPM %.2f", m_name, ppm);
-            return;
+            return Result::fail(Code::INVALID_DATA, "PPM out of range");
         }
 
         ESP_LOGI(TAG, "Self-test passed for %s. Raw: %.2f, PPM: %.2f",
                  m_name, raw_value, ppm);
+        return Result::ok();
     }
 
 } // namespace pooaway::sensors
\ No newline at end of file
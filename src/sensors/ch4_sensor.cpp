@@ -1,4 +1,5 @@
 #include "sensors/ch4_sensor.h"
+#include "trace_log.h"
 #include <cmath>
 
 namespace pooaway::sensors
@@ -33,7 +34,7 @@ namespace pooaway::sensors
 
         const float ppm = m_coeff_a * std::pow(rs_r0_ratio, m_coeff_b);
 
-        ESP_LOGD(TAG, "[%s] V=%.2f Rs=%.0f R0=%.0f ratio=%.2f PPM=%.1f",
+        TRACE_LOGD(TAG, "[%s] V=%.2f Rs=%.0f R0=%.0f ratio=%.2f PPM=%.1f",
                  m_name, voltage, rs, m_r0, rs_r0_ratio, ppm);
 
         return ppm;
@@ -99,8 +100,9 @@ namespace pooaway::sensors
 
     float CH4Sensor::get_voltage() const
     {
-        // Convert ADC reading to voltage using the last raw reading
-        return (read_raw() * VCC) / ADC_RESOLUTION;
+        // Convert ADC reading to voltage using the last raw reading; sampling again here
+        // would read whichever mux input happens to be selected
+        return (m_last_raw * VCC) / ADC_RESOLUTION;
     }
 
     float CH4Sensor::get_rs() const
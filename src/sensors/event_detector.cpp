@@ -0,0 +1,95 @@
+#include "sensors/event_detector.h"
+#include <algorithm>
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "config.h"
+#include "sensors/event_model.h"
+
+namespace pooaway::sensors
+{
+    uint32_t EventDetector::s_next_id = 1;
+
+    EventPhase EventDetector::update(unsigned long now_ms, const ChannelSample *samples)
+    {
+        const float dt_s = m_active ? static_cast<float>(now_ms - m_last_update_ms) / 1000.0F : 0.0F;
+        m_last_update_ms = now_ms;
+
+        bool any_alert = false;
+        for (size_t i = 0; i < PAIR_CHANNELS; i++)
+        {
+            any_alert = any_alert || samples[i].alert;
+            m_features.update(now_ms, i, samples[i].value, samples[i].baseline);
+        }
+
+        bool started = false;
+        if (!m_active)
+        {
+            if (!any_alert)
+            {
+                return EventPhase::NONE;
+            }
+
+            started = true;
+            m_active = true;
+            m_record = EventRecord{};
+            m_record.id = s_next_id++;
+            m_record.pair = m_pair;
+            m_record.start_ms = now_ms;
+            m_features.begin(now_ms, PAIR_CHANNELS);
+        }
+
+        for (size_t i = 0; i < PAIR_CHANNELS; i++)
+        {
+            const auto &sample = samples[i];
+            if (!sample.alert)
+            {
+                continue;
+            }
+
+            const size_t channel = PAIR_CHANNELS * m_pair + i;
+            m_record.sensor_mask |= (1UL << channel);
+            m_record.exposure_ppm_s += std::max(0.0F, sample.value - sample.baseline) * dt_s;
+            if (sample.value > m_record.peak_ppm)
+            {
+                m_record.peak_ppm = sample.value;
+                m_record.peak_channel = static_cast<uint8_t>(channel);
+            }
+        }
+
+        if (any_alert)
+        {
+            m_record.end_ms = now_ms;
+            if (started)
+            {
+                ESP_LOGI(TAG, "Event %lu started at pair %u", static_cast<unsigned long>(m_record.id), m_pair);
+                return EventPhase::STARTED;
+            }
+
+            // Force-close events that never settle, e.g. a baseline that cannot catch up
+            if (now_ms - m_record.start_ms < config::events::MAX_DURATION_MS)
+            {
+                return EventPhase::NONE;
+            }
+        }
+        else if (now_ms - m_record.end_ms < config::events::CLOSE_HOLDOFF_MS)
+        {
+            return EventPhase::NONE;
+        }
+
+        m_active = false;
+
+        const EventFeatures features = m_features.finish(m_record.end_ms);
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+        const EventClassification result = classify(EVENT_MODEL, features);
+        m_record.classify_cycles = esp_cpu_get_cycle_count() - start_cycles;
+        m_record.event_class = result.event_class;
+        m_record.class_margin = result.margin_f();
+
+        ESP_LOGI(TAG, "Event %lu closed at pair %u: %lu ms, mask 0x%lx, peak %.1f ppm, exposure %.1f ppm*s, %s (margin %.2f, %lu cycles)",
+                 static_cast<unsigned long>(m_record.id), m_pair, m_record.duration_ms(),
+                 static_cast<unsigned long>(m_record.sensor_mask), m_record.peak_ppm,
+                 m_record.exposure_ppm_s, to_string(m_record.event_class), m_record.class_margin,
+                 static_cast<unsigned long>(m_record.classify_cycles));
+        return EventPhase::CLOSED;
+    }
+} // namespace pooaway::sensors
@@ -1,4 +1,5 @@
 #include "sensors/nh3_sensor.h"
+#include "trace_log.h"
 #include <cmath>
 
 namespace pooaway::sensors
@@ -33,7 +34,7 @@ namespace pooaway::sensors
 
         const float ppm = m_coeff_a * std::pow(rs_r0_ratio, m_coeff_b);
 
-        ESP_LOGD(TAG, "[%s] V=%.2f Rs=%.0f R0=%.0f ratio=%.2f PPM=%.1f",
+        TRACE_LOGD(TAG, "[%s] V=%.2f Rs=%.0f R0=%.0f ratio=%.2f PPM=%.1f",
                  m_name, voltage, rs, m_r0, rs_r0_ratio, ppm);
 
         return ppm;
@@ -53,7 +54,7 @@ namespace pooaway::sensors
     {
         if (voltage < 0.001F)
         {
-            ESP_LOGV(TAG, "[%s] Voltage too low for Rs calculation: %.3f", m_name, voltage);
+            TRACE_LOGV(TAG, "[%s] Voltage too low for Rs calculation: %.3f", m_name, voltage);
             return RL;
         }
         return RL * (VCC - voltage) / voltage;
@@ -99,8 +100,9 @@ namespace pooaway::sensors
 
     float NH3Sensor::get_voltage() const
     {
-        // Convert ADC reading to voltage using the last raw reading
-        return (read_raw() * VCC) / ADC_RESOLUTION;
+        // Convert ADC reading to voltage using the last raw reading; sampling again here
+        // would read whichever mux input happens to be selected
+        return (m_last_raw * VCC) / ADC_RESOLUTION;
     }
 
     float NH3Sensor::get_rs() const
@@ -0,0 +1,212 @@
+#include "state_store.h"
+#include <cmath>
+#include <cstring>
+#include <Arduino.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "config.h"
+
+namespace pooaway
+{
+    StateStore &StateStore::instance()
+    {
+        static StateStore instance;
+        return instance;
+    }
+
+    StateStore::StateStore()
+    {
+        m_preferences.begin("pooaway_state", false);
+        m_image.magic = MAGIC;
+        m_image.version = VERSION;
+        m_image.next_event_id = 1;
+        m_committed = m_image;
+    }
+
+    bool StateStore::load()
+    {
+        Blob blob{};
+        const size_t length = m_preferences.getBytesLength(KEY);
+        if (length != sizeof(Blob))
+        {
+            ESP_LOGI(TAG, "No persisted state (stored %u bytes, expected %u)",
+                     static_cast<unsigned>(length), static_cast<unsigned>(sizeof(Blob)));
+            return false;
+        }
+
+        m_preferences.getBytes(KEY, &blob, sizeof(blob));
+        if (blob.magic != MAGIC || blob.version != VERSION)
+        {
+            ESP_LOGW(TAG, "Discarding state with magic 0x%08lx version %u",
+                     static_cast<unsigned long>(blob.magic), blob.version);
+            return false;
+        }
+
+        if (compute_crc(blob) != blob.crc)
+        {
+            ESP_LOGE(TAG, "Persisted state failed CRC check, ignoring it");
+            return false;
+        }
+
+        m_image = blob;
+        m_committed = blob;
+        m_dirty = false;
+        ESP_LOGI(TAG, "Restored state #%lu", static_cast<unsigned long>(blob.sequence));
+        return true;
+    }
+
+    void StateStore::update()
+    {
+        if (!m_dirty)
+        {
+            return;
+        }
+
+        const unsigned long interval = m_urgent ? config::storage::URGENT_COMMIT_INTERVAL_MS
+                                                : config::storage::MIN_COMMIT_INTERVAL_MS;
+        if (millis() - m_last_commit_ms < interval)
+        {
+            return;
+        }
+
+        commit();
+    }
+
+    void StateStore::request_commit()
+    {
+        m_dirty = true;
+        m_urgent = true;
+    }
+
+    bool StateStore::commit()
+    {
+        m_image.sequence = m_committed.sequence + 1;
+
+        // Skip the flash write entirely if nothing but the sequence number would change
+        Blob candidate = m_image;
+        candidate.sequence = m_committed.sequence;
+        candidate.crc = m_committed.crc;
+        if (std::memcmp(&candidate, &m_committed, sizeof(Blob)) == 0)
+        {
+            m_dirty = false;
+            m_urgent = false;
+            return true;
+        }
+
+        m_image.crc = compute_crc(m_image);
+        if (m_preferences.putBytes(KEY, &m_image, sizeof(Blob)) != sizeof(Blob))
+        {
+            ESP_LOGE(TAG, "Failed to write persisted state");
+            m_last_commit_ms = millis(); // Back off instead of retrying every pass
+            return false;
+        }
+
+        m_committed = m_image;
+        m_dirty = false;
+        m_urgent = false;
+        m_last_commit_ms = millis();
+        m_commit_count++;
+        ESP_LOGI(TAG, "Committed state #%lu", static_cast<unsigned long>(m_image.sequence));
+        return true;
+    }
+
+    bool StateStore::get_channel(size_t index, const char *name, float &r0, float &baseline) const
+    {
+        if (index >= MAX_CHANNELS)
+        {
+            return false;
+        }
+
+        const auto &slot = m_image.channels[index];
+        if (slot.flags == 0 || slot.name_hash != hash_name(name))
+        {
+            return false;
+        }
+
+        r0 = (slot.flags & HAS_R0) ? slot.r0 : 0.0F;
+        baseline = (slot.flags & HAS_BASELINE) ? slot.baseline : 0.0F;
+        return true;
+    }
+
+    StateStore::ChannelState *StateStore::claim_slot(size_t index, const char *name)
+    {
+        if (index >= MAX_CHANNELS)
+        {
+            return nullptr;
+        }
+
+        auto &slot = m_image.channels[index];
+        const uint32_t hash = hash_name(name);
+        if (slot.name_hash != hash)
+        {
+            // Channel layout changed; the old contents belong to another sensor
+            slot = ChannelState{hash, 0.0F, 0.0F, 0};
+            m_dirty = true;
+        }
+        return &slot;
+    }
+
+    void StateStore::set_channel_r0(size_t index, const char *name, float r0)
+    {
+        auto *slot = claim_slot(index, name);
+        if (!slot || ((slot->flags & HAS_R0) && slot->r0 == r0))
+        {
+            return;
+        }
+
+        slot->r0 = r0;
+        slot->flags |= HAS_R0;
+        m_dirty = true;
+    }
+
+    void StateStore::set_channel_baseline(size_t index, const char *name, float baseline)
+    {
+        auto *slot = claim_slot(index, name);
+        if (!slot)
+        {
+            return;
+        }
+
+        slot->baseline = baseline;
+        slot->flags |= HAS_BASELINE;
+
+        // Only material drift against the committed copy is worth a flash write
+        const auto &committed = m_committed.channels[index];
+        const bool was_saved = (committed.flags & HAS_BASELINE) && committed.name_hash == slot->name_hash;
+        const float reference = std::fabs(committed.baseline);
+        if (!was_saved ||
+            std::fabs(baseline - committed.baseline) > config::storage::BASELINE_DIRTY_RATIO * reference)
+        {
+            m_dirty = true;
+        }
+    }
+
+    void StateStore::set_next_event_id(uint32_t id)
+    {
+        if (id <= m_committed.next_event_id)
+        {
+            return; // Still inside the reserved block
+        }
+
+        // Not bounded by the commit interval: a reboot before the write would reissue the id
+        m_image.next_event_id = id + config::storage::EVENT_ID_BLOCK;
+        ESP_LOGI(TAG, "Reserving event ids up to %lu", static_cast<unsigned long>(m_image.next_event_id - 1));
+        commit();
+    }
+
+    uint32_t StateStore::hash_name(const char *name)
+    {
+        // FNV-1a; only has to tell sensor names apart, never 0 so empty slots stay distinct
+        uint32_t hash = 2166136261UL;
+        for (const char *p = name; p && *p; p++)
+        {
+            hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619UL;
+        }
+        return hash ? hash : 1;
+    }
+
+    uint32_t StateStore::compute_crc(const Blob &blob)
+    {
+        return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t *>(&blob), offsetof(Blob, crc));
+    }
+} // namespace pooaway
@@ -0,0 +1,116 @@
+#include "time_service.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <cstring>
+#include <sys/time.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "config.h"
+
+namespace pooaway
+{
+    TimeService &TimeService::instance()
+    {
+        static TimeService instance;
+        return instance;
+    }
+
+    int64_t TimeService::capture_us()
+    {
+        return esp_timer_get_time();
+    }
+
+    void TimeService::begin()
+    {
+        // The RTC keeps the system time across a software reset; use it until SNTP refines it
+        const time_t inherited = time(nullptr);
+        if (!is_synced() && inherited >= 1000000000)
+        {
+            apply_sync(static_cast<int64_t>(inherited) * 1000000, capture_us());
+        }
+
+        // Resyncs run in the lwIP task on this interval and land in on_sync()
+        sntp_set_sync_interval(config::ntp::SYNC_INTERVAL);
+        sntp_set_time_sync_notification_cb(&TimeService::on_sync);
+        configTzTime(config::ntp::TIMEZONE, config::ntp::SERVER);
+    }
+
+    void TimeService::on_sync(struct timeval *tv)
+    {
+        const int64_t captured_us = capture_us();
+        instance().apply_sync(static_cast<int64_t>(tv->tv_sec) * 1000000 + tv->tv_usec, captured_us);
+    }
+
+    void TimeService::apply_sync(int64_t utc_us, int64_t captured_us)
+    {
+        const int64_t offset = utc_us - captured_us;
+        const bool resync = is_synced();
+
+        m_sequence.fetch_add(1, std::memory_order_acq_rel);
+        const int64_t previous = m_offset_us;
+        m_offset_us = offset;
+        m_sequence.fetch_add(1, std::memory_order_release);
+        m_synced.store(true, std::memory_order_release);
+
+        m_stats.syncs++;
+        m_stats.last_sync_us = captured_us;
+        if (resync)
+        {
+            const int64_t correction = offset - previous;
+            m_stats.last_correction_us = correction;
+            m_stats.max_correction_us = std::max(m_stats.max_correction_us, correction < 0 ? -correction : correction);
+        }
+        ESP_LOGI(TAG, "Time synchronized (sync %lu, correction %lld us)", static_cast<unsigned long>(m_stats.syncs),
+                 static_cast<long long>(resync ? m_stats.last_correction_us : 0));
+    }
+
+    int64_t TimeService::offset_us() const
+    {
+        // Retry if a sync landed mid-read; a sync is rare, so this almost never loops
+        for (;;)
+        {
+            const uint32_t before = m_sequence.load(std::memory_order_acquire);
+            const int64_t offset = m_offset_us;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((before & 1) == 0 && m_sequence.load(std::memory_order_relaxed) == before)
+            {
+                return offset;
+            }
+        }
+    }
+
+    bool TimeService::format_local(int64_t utc_us, char *out, size_t size)
+    {
+        if (!out || size < LOCAL_TIME_SIZE)
+        {
+            if (out && size)
+            {
+                out[0] = '\0';
+            }
+            return false;
+        }
+
+        m_stats.formats++;
+        const int64_t seconds = utc_us / 1000000;
+        const int64_t minute = seconds / 60;
+        if (minute != m_cached_minute)
+        {
+            // Time zone and DST changes fall on minute boundaries, so the prefix holds for 60 s
+            const time_t start = static_cast<time_t>(minute * 60);
+            struct tm local;
+            localtime_r(&start, &local);
+            strftime(m_cached_prefix, sizeof(m_cached_prefix), "%Y-%m-%d %H:%M:", &local);
+            m_cached_minute = minute;
+            m_stats.format_misses++;
+        }
+
+        const auto second = static_cast<unsigned>(seconds % 60);
+        std::memcpy(out, m_cached_prefix, PREFIX_LENGTH);
+        out[PREFIX_LENGTH] = static_cast<char>('0' + second / 10);
+        out[PREFIX_LENGTH + 1] = static_cast<char>('0' + second % 10);
+        out[PREFIX_LENGTH + 2] = '\0';
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+#include "trace_log.h"
+#include <Arduino.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace pooaway::trace
+{
+    namespace
+    {
+        // Addresses are 32-bit on the C6, so a record's string words point straight at the literals
+        const char *resolve_local(uint32_t address, void *)
+        {
+            return reinterpret_cast<const char *>(static_cast<uintptr_t>(address));
+        }
+    }
+
+    TraceLog &TraceLog::instance()
+    {
+        static TraceLog instance;
+        return instance;
+    }
+
+    uint32_t TraceLog::now_us()
+    {
+        return static_cast<uint32_t>(esp_timer_get_time());
+    }
+
+    bool TraceLog::drain(size_t max_records)
+    {
+        Record record{};
+        size_t emitted = 0;
+        for (; emitted < max_records && m_ring.pop(record); emitted++)
+        {
+            if (config::trace::BINARY_OUTPUT)
+            {
+                emit_binary(record);
+            }
+            else
+            {
+                emit_text(record);
+            }
+        }
+
+        const uint32_t dropped = m_ring.get_dropped();
+        if (dropped != m_reported_dropped)
+        {
+            ESP_LOGW(TAG, "Dropped %lu trace records (ring full)",
+                     static_cast<unsigned long>(dropped - m_reported_dropped));
+            m_reported_dropped = dropped;
+        }
+        return emitted == max_records;
+    }
+
+    void TraceLog::emit_text(const Record &record)
+    {
+        char text[160];
+        format_record(record, resolve_local, nullptr, text, sizeof(text));
+
+        // Same line layout as ESP_LOGx, stamped with the time of the call rather than of the drain
+        const char *tag = resolve_local(record.tag, nullptr);
+        esp_log_write(static_cast<esp_log_level_t>(record.level), tag, "%c (%lu) %s: %s\n",
+                      level_letter(record.level), static_cast<unsigned long>(record.timestamp_us / 1000), tag, text);
+    }
+
+    void TraceLog::emit_binary(Record record)
+    {
+        record.checksum = checksum(record);
+        Serial.write(FRAME_MAGIC, sizeof(FRAME_MAGIC));
+        Serial.write(reinterpret_cast<const uint8_t *>(&record), sizeof(record));
+    }
+} // namespace pooaway::trace
@@ -0,0 +1,137 @@
+#include "waveform_capture.h"
+#include <Arduino.h>
+#include <algorithm>
+#include "esp_log.h"
+#include "time_service.h"
+
+namespace pooaway
+{
+    WaveformCapture &WaveformCapture::instance()
+    {
+        static WaveformCapture instance;
+        return instance;
+    }
+
+    WaveformCapture::WaveformCapture()
+    {
+        m_preferences.begin("pooaway_cap", false);
+    }
+
+    void WaveformCapture::init()
+    {
+        if (!config::capture::ENABLED)
+        {
+            return;
+        }
+
+        ESP_LOGI(TAG, "%u channels, %u + %u samples every %u ms, %u bytes of RAM",
+                 static_cast<unsigned>(CHANNELS), static_cast<unsigned>(config::capture::PRE_TRIGGER_SAMPLES),
+                 static_cast<unsigned>(config::capture::POST_TRIGGER_SAMPLES),
+                 static_cast<unsigned>(config::capture::SAMPLE_INTERVAL_MS), static_cast<unsigned>(FOOTPRINT_BYTES));
+
+        const size_t length = m_preferences.getBytesLength(KEY);
+        if (length < capture::HEADER_BYTES + capture::CRC_BYTES || length > sizeof(m_blob))
+        {
+            return;
+        }
+
+        m_preferences.getBytes(KEY, m_blob, length);
+        capture::BlobReader in(m_blob, length);
+        const auto header = capture::read_header(in);
+        capture::BlobReader trailer(m_blob + length - capture::CRC_BYTES, capture::CRC_BYTES);
+        if (header.magic != capture::BLOB_MAGIC || header.version != capture::BLOB_VERSION ||
+            capture::crc32(m_blob, length - capture::CRC_BYTES) != trailer.u32())
+        {
+            ESP_LOGW(TAG, "Discarding invalid saved capture (%u bytes)", static_cast<unsigned>(length));
+            return;
+        }
+
+        m_blob_length = length;
+        ESP_LOGI(TAG, "Restored capture #%lu of channel %u (%u bytes)", static_cast<unsigned long>(header.sequence),
+                 header.trigger_channel, static_cast<unsigned>(length));
+    }
+
+    void WaveformCapture::add(size_t channel, float raw)
+    {
+        if (config::capture::ENABLED)
+        {
+            m_recorder.add(channel, static_cast<uint16_t>(std::min(std::max(raw, 0.0F), 65535.0F)));
+        }
+    }
+
+    void WaveformCapture::on_scan()
+    {
+        if (config::capture::ENABLED && m_recorder.tick(static_cast<uint32_t>(millis())))
+        {
+            m_complete = true;
+        }
+    }
+
+    void WaveformCapture::trigger(size_t channel)
+    {
+        if (!config::capture::ENABLED)
+        {
+            return;
+        }
+
+        auto &time_service = TimeService::instance();
+        const auto utc_s = time_service.is_synced() ? static_cast<uint32_t>(time_service.now_utc_us() / 1000000) : 0U;
+        m_recorder.trigger(channel, static_cast<uint32_t>(millis()), utc_s);
+    }
+
+    void WaveformCapture::poll()
+    {
+        if (!m_complete)
+        {
+            return;
+        }
+        m_complete = false;
+
+        // The live capture replaces the restored one even if it is not saved
+        const size_t length = m_recorder.encode(m_blob, sizeof(m_blob));
+        m_recorder.rearm(static_cast<uint32_t>(millis()));
+        if (length == 0)
+        {
+            ESP_LOGE(TAG, "Capture did not fit %u bytes", static_cast<unsigned>(sizeof(m_blob)));
+            m_blob_length = 0;
+            return;
+        }
+        m_blob_length = length;
+
+        const auto &stats = m_recorder.get_stats();
+        ESP_LOGI(TAG, "Captured %u channels in %u bytes (%lu missed triggers)", static_cast<unsigned>(CHANNELS),
+                 static_cast<unsigned>(length), static_cast<unsigned long>(stats.missed));
+        save();
+    }
+
+    void WaveformCapture::save()
+    {
+        const unsigned long now = millis();
+        if (m_blob_length > config::capture::MAX_SAVED_BYTES)
+        {
+            ESP_LOGW(TAG, "Capture of %u bytes is over the %u byte NVS limit, not saved",
+                     static_cast<unsigned>(m_blob_length), static_cast<unsigned>(config::capture::MAX_SAVED_BYTES));
+            return;
+        }
+        if (m_saved && now - m_last_save_ms < config::capture::MIN_SAVE_INTERVAL_MS)
+        {
+            ESP_LOGD(TAG, "Capture not saved, last save %lu ms ago", now - m_last_save_ms);
+            return;
+        }
+
+        if (m_preferences.putBytes(KEY, m_blob, m_blob_length) != m_blob_length)
+        {
+            ESP_LOGE(TAG, "Failed to save capture");
+            return;
+        }
+        m_saved = true;
+        m_last_save_ms = now;
+        m_saves++;
+    }
+
+    size_t WaveformCapture::get_blob(const uint8_t *&data) const
+    {
+        data = m_blob;
+        return m_blob_length;
+    }
+} // namespace pooaway
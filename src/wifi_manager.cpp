@@ -1,7 +1,10 @@
-#include "wifi_manager.h"
 #include "config.h"
-#include <time.h>
-#include "esp_sntp.h"
+
+#if POOAWAY_WITH_NETWORK
+#include "wifi_manager.h"
+#include <cstring>
+#include "network_cache.h"
+#include "time_service.h"
 
 namespace pooaway
 {
@@ -18,19 +21,143 @@ namespace pooaway
         return ensure_connected() && sync_time();
     }
 
+    void WiFiManager::begin()
+    {
+        WiFi.mode(WIFI_STA);
+        start_connect();
+    }
+
+    void WiFiManager::start_connect()
+    {
+        m_connecting = true;
+        m_fast_timed_out = false;
+        m_connect_start_ms = millis();
+
+        NetworkCache::Association cached{};
+        m_fast_attempt = config::network::FAST_RECONNECT && NetworkCache::instance().get_association(cached);
+        if (!m_fast_attempt)
+        {
+            ESP_LOGI(TAG, "Connecting to WiFi network: %s", config::wifi::SSID);
+            WiFi.begin(config::wifi::SSID, config::wifi::PASSWORD);
+            return;
+        }
+
+        // Joining a known BSSID on a known channel skips the scan of every channel
+        m_static_lease = config::network::REUSE_IP_LEASE && cached.ip != 0;
+        if (m_static_lease)
+        {
+            WiFi.config(IPAddress(cached.ip), IPAddress(cached.gateway), IPAddress(cached.subnet), IPAddress(cached.dns));
+        }
+        ESP_LOGI(TAG, "Connecting to WiFi network: %s (cached %02x:%02x:%02x:%02x:%02x:%02x on channel %u%s)",
+                 config::wifi::SSID, cached.bssid[0], cached.bssid[1], cached.bssid[2], cached.bssid[3],
+                 cached.bssid[4], cached.bssid[5], cached.channel, m_static_lease ? ", cached lease" : "");
+        WiFi.begin(config::wifi::SSID, config::wifi::PASSWORD, cached.channel, cached.bssid);
+    }
+
+    void WiFiManager::fall_back_to_scan()
+    {
+        // The cache is left alone: the next successful association overwrites it if it moved
+        ESP_LOGW(TAG, "Cached access point did not answer within %lu ms, scanning",
+                 config::network::FAST_CONNECT_TIMEOUT_MS);
+        m_fast_timed_out = true;
+        WiFi.disconnect();
+        if (m_static_lease)
+        {
+            WiFi.config(IPAddress(), IPAddress(), IPAddress()); // Back to DHCP
+            m_static_lease = false;
+        }
+        m_fast_attempt = false;
+        m_connect_start_ms = millis();
+        WiFi.begin(config::wifi::SSID, config::wifi::PASSWORD);
+    }
+
+    void WiFiManager::remember_association()
+    {
+        const uint8_t *bssid = WiFi.BSSID();
+        if (bssid == nullptr)
+        {
+            return;
+        }
+
+        NetworkCache::Association association{};
+        std::memcpy(association.bssid, bssid, sizeof(association.bssid));
+        association.channel = static_cast<uint8_t>(WiFi.channel());
+        association.ip = static_cast<uint32_t>(WiFi.localIP());
+        association.gateway = static_cast<uint32_t>(WiFi.gatewayIP());
+        association.subnet = static_cast<uint32_t>(WiFi.subnetMask());
+        association.dns = static_cast<uint32_t>(WiFi.dnsIP());
+        NetworkCache::instance().set_association(association);
+    }
+
+    bool WiFiManager::poll_connected()
+    {
+        const bool connected = (WiFi.status() == WL_CONNECTED);
+        if (connected && !m_is_connected)
+        {
+            ESP_LOGI(TAG, "Connected to WiFi. IP: %s", WiFi.localIP().toString().c_str());
+            if (m_connecting)
+            {
+                const auto elapsed_ms = static_cast<uint32_t>(millis() - m_connect_start_ms);
+                if (m_fast_attempt)
+                {
+                    m_stats.fast_connects++;
+                    m_stats.last_fast_ms = elapsed_ms;
+                }
+                else
+                {
+                    m_stats.scan_connects++;
+                    m_stats.last_scan_ms = elapsed_ms;
+                    // The scan found the AP straight away, so the cache was what failed
+                    if (m_fast_timed_out)
+                    {
+                        m_stats.fast_failures++;
+                        m_fast_timed_out = false;
+                    }
+                }
+                ESP_LOGI(TAG, "Associated in %lu ms (%s)", static_cast<unsigned long>(elapsed_ms),
+                         m_fast_attempt ? "cached access point" : "full scan");
+                m_connecting = false;
+            }
+            remember_association();
+        }
+        else if (!connected && m_connecting && m_fast_attempt &&
+                 millis() - m_connect_start_ms >= config::network::FAST_CONNECT_TIMEOUT_MS)
+        {
+            fall_back_to_scan();
+        }
+        else if (!connected && m_fast_timed_out &&
+                 millis() - m_connect_start_ms >= config::network::SCAN_CONNECT_TIMEOUT_MS)
+        {
+            // The scan does not see the AP either: it is down, not moved, so the cache is not to blame
+            ESP_LOGD(TAG, "Access point not found by the scan either, waiting for it");
+            m_fast_timed_out = false;
+        }
+        m_is_connected = connected;
+        return connected;
+    }
+
+    void WiFiManager::begin_time_sync()
+    {
+        ESP_LOGI(TAG, "Synchronizing time with NTP server...");
+        TimeService::instance().begin();
+    }
+
+    bool WiFiManager::is_time_synced() const
+    {
+        return TimeService::instance().is_synced();
+    }
+
     bool WiFiManager::ensure_connected()
     {
-        if (WiFi.status() == WL_CONNECTED)
+        if (poll_connected())
         {
-            m_is_connected = true;
             return true;
         }
 
-        ESP_LOGI(TAG, "Connecting to WiFi network: %s", WIFI_SSID);
-        WiFi.begin(WIFI_SSID, WIFI_PASS);
+        start_connect();
 
         int retries = 0;
-        while (WiFi.status() != WL_CONNECTED && retries < MAX_RETRIES)
+        while (!poll_connected() && retries < MAX_RETRIES)
         {
             delay(RETRY_DELAY_MS);
             ESP_LOGD(TAG, "Waiting for WiFi connection... (%d/%d)", retries + 1, MAX_RETRIES);
@@ -38,14 +165,12 @@ namespace pooaway
             retries++;
         }
 
-        if (WiFi.status() == WL_CONNECTED)
+        if (m_is_connected)
         {
-            m_is_connected = true;
-            ESP_LOGI(TAG, "Connected to WiFi. IP: %s", WiFi.localIP().toString().c_str());
             return true;
         }
 
-        m_is_connected = false;
+        m_connecting = false;
         m_last_error = "Failed to connect to WiFi";
         ESP_LOGE(TAG, "%s", m_last_error.c_str());
         return false;
@@ -56,19 +181,20 @@ namespace pooaway
         ESP_LOGI(TAG, "Synchronizing time with NTP server...");
 
         // Configure NTP
-        configTzTime(config::ntp::TIMEZONE, config::ntp::SERVER);
+        auto &time_service = TimeService::instance();
+        time_service.begin();
 
         // Wait for time to be set
         int retry = 0;
         const int max_retry = 10;
-        while (time(nullptr) < 1000000000 && retry < max_retry)
+        while (!time_service.is_synced() && retry < max_retry)
         {
             ESP_LOGD(TAG, "Waiting for NTP time sync... (%d/%d)", retry + 1, max_retry);
             delay(500);
             retry++;
         }
 
-        if (time(nullptr) < 1000000000)
+        if (!time_service.is_synced())
         {
             m_last_error = "Failed to sync time with NTP server";
             ESP_LOGE(TAG, "%s", m_last_error.c_str());
@@ -76,14 +202,12 @@ namespace pooaway
         }
 
         // Log current time
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo))
-        {
-            char time_str[64];
-            strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S %Z", &timeinfo);
-            ESP_LOGI(TAG, "Time synchronized: %s", time_str);
-        }
+        char time_str[TimeService::LOCAL_TIME_SIZE];
+        time_service.format_local(time_service.now_utc_us(), time_str, sizeof(time_str));
+        ESP_LOGI(TAG, "Time synchronized: %s", time_str);
 
         return true;
     }
-}
\ No newline at end of file
+}
+
+#endif // POOAWAY_WITH_NETWORK
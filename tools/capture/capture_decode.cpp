@@ -0,0 +1,157 @@
+/**
+ * @file capture_decode.cpp
+ * @brief Decodes alert waveform captures fetched from the device's /capture endpoint
+ *
+ * The blob is written by pooaway::capture::WaveformRecorder (include/waveform_recorder.h):
+ * a fixed header, then per channel the first raw ADC sample and zigzag varint deltas, closed
+ * by a CRC-32. Output is CSV with one row per sample interval and one column per channel, the
+ * time relative to the alert edge in the first column. --synth runs the recorder on a
+ * synthetic gas event instead, to check the layout and see how well it compresses.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "waveform_recorder.h"
+
+using namespace pooaway::capture;
+
+namespace
+{
+    bool decode(const std::vector<uint8_t> &blob, FILE *csv)
+    {
+        if (blob.size() < HEADER_BYTES + CRC_BYTES)
+        {
+            std::fprintf(stderr, "Blob too short: %zu bytes\n", blob.size());
+            return false;
+        }
+
+        BlobReader in(blob.data(), blob.size() - CRC_BYTES);
+        const BlobHeader header = read_header(in);
+        if (header.magic != BLOB_MAGIC || header.version != BLOB_VERSION)
+        {
+            std::fprintf(stderr, "Not a capture: magic 0x%08x version %u\n", header.magic, header.version);
+            return false;
+        }
+
+        BlobReader trailer(blob.data() + blob.size() - CRC_BYTES, CRC_BYTES);
+        const uint32_t stored_crc = trailer.u32();
+        const uint32_t crc = crc32(blob.data(), blob.size() - CRC_BYTES);
+        if (crc != stored_crc)
+        {
+            std::fprintf(stderr, "CRC mismatch: stored 0x%08x, computed 0x%08x\n", stored_crc, crc);
+            return false;
+        }
+
+        const size_t count = static_cast<size_t>(header.pre_samples) + header.post_samples;
+        std::vector<std::vector<int32_t>> channels(header.channels, std::vector<int32_t>(count));
+        for (auto &samples : channels)
+        {
+            int32_t value = in.u16();
+            samples[0] = value;
+            for (size_t i = 1; i < count; i++)
+            {
+                value += unzigzag(in.varint());
+                samples[i] = value;
+            }
+        }
+        if (in.failed() || in.offset() != blob.size() - CRC_BYTES)
+        {
+            std::fprintf(stderr, "Malformed sample data\n");
+            return false;
+        }
+
+        std::fprintf(stderr, "Capture #%u: %u channels, trigger on channel %u at %u ms uptime", header.sequence,
+                     header.channels, header.trigger_channel, header.trigger_ms);
+        if (header.trigger_utc_s != 0)
+        {
+            std::fprintf(stderr, " (UTC %u)", header.trigger_utc_s);
+        }
+        std::fprintf(stderr, ", %u + %u samples every %u ms, %zu bytes (%.2f per sample)\n", header.pre_samples,
+                     header.post_samples, header.interval_ms, blob.size(),
+                     static_cast<double>(blob.size()) / static_cast<double>(count * header.channels));
+
+        std::fprintf(csv, "t_ms");
+        for (size_t c = 0; c < channels.size(); c++)
+        {
+            std::fprintf(csv, ",ch%zu", c);
+        }
+        std::fprintf(csv, "\n");
+        for (size_t i = 0; i < count; i++)
+        {
+            const long t_ms = (static_cast<long>(i) - header.pre_samples) * header.interval_ms;
+            std::fprintf(csv, "%ld", t_ms);
+            for (const auto &samples : channels)
+            {
+                std::fprintf(csv, ",%d", samples[i]);
+            }
+            std::fprintf(csv, "\n");
+        }
+        return true;
+    }
+
+    // A 2-channel recorder on a noisy NH3 ramp with CH4 following, scanned every 10 ms like loop()
+    std::vector<uint8_t> synthesize(unsigned seed)
+    {
+        constexpr uint16_t INTERVAL_MS = 200;
+        static WaveformRecorder<2, 150, 150> recorder(INTERVAL_MS);
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0F, 12.0F);
+
+        const uint32_t onset_ms = 60000;
+        bool triggered = false;
+        for (uint32_t now_ms = 0; now_ms < 180000; now_ms += 10)
+        {
+            const float t_s = now_ms < onset_ms ? 0.0F : static_cast<float>(now_ms - onset_ms) / 1000.0F;
+            const float nh3 = 1200.0F + 900.0F * (1.0F - std::exp(-t_s / 8.0F));
+            const float ch4 = 900.0F + 300.0F * (1.0F - std::exp(-std::max(t_s - 10.0F, 0.0F) / 15.0F));
+            recorder.add(0, static_cast<uint16_t>(std::lround(nh3 + noise(rng))));
+            recorder.add(1, static_cast<uint16_t>(std::lround(ch4 + noise(rng))));
+            if (!triggered && now_ms >= onset_ms + 3000)
+            {
+                triggered = recorder.trigger(0, now_ms, 0);
+            }
+            if (recorder.tick(now_ms))
+            {
+                break;
+            }
+        }
+
+        std::vector<uint8_t> blob(decltype(recorder)::MAX_BLOB_BYTES);
+        blob.resize(recorder.encode(blob.data(), blob.size()));
+        std::fprintf(stderr, "Synthetic capture: %zu bytes, %zu at most, %zu as raw uint16\n", blob.size(),
+                     decltype(recorder)::MAX_BLOB_BYTES, sizeof(uint16_t) * 2 * decltype(recorder)::RING_SAMPLES);
+        return blob;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "--synth") == 0)
+    {
+        const auto blob = synthesize(1);
+        std::ofstream out(argv[2], std::ios::binary);
+        out.write(reinterpret_cast<const char *>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        return out && !blob.empty() ? 0 : 1;
+    }
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s capture.bin > capture.csv\n       %s --synth capture.bin\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    const std::vector<uint8_t> blob((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!in && blob.empty())
+    {
+        std::fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    return decode(blob, stdout) ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+# Builds each PlatformIO environment and reports its flash and static RAM use, plus the
+# unwind tables and exception tables the project's own objects contribute.
+#
+#   tools/footprint/footprint.sh [env...]
+#
+# Without arguments, every env in platformio.ini is built. Run from anywhere in the repository.
+
+set -euo pipefail
+
+cd "$(git -C "$(dirname "$0")" rev-parse --show-toplevel)"
+
+TOOLCHAIN=${TOOLCHAIN:-$HOME/.platformio/packages/toolchain-riscv32-esp/bin}
+SIZE=${SIZE:-$TOOLCHAIN/riscv32-esp-elf-size}
+
+if [ $# -eq 0 ]; then
+    set -- $(sed -n 's/^\[env:\(.*\)\]\r\{0,1\}$/\1/p' platformio.ini)
+fi
+
+# Sum the named sections (awk regex on the section name) of `size -A` output
+sum_sections() {
+    awk -v pattern="$1" '$1 ~ pattern { total += $2 } END { print total + 0 }'
+}
+
+printf '%-36s %10s %10s %10s %10s %10s\n' env flash iram dram eh_frame except_tbl
+for env in "$@"; do
+    pio run -s -e "$env" >/dev/null
+    build=.pio/build/$env
+    sections=$("$SIZE" -A "$build/firmware.elf")
+
+    flash=$(sum_sections '^\.(flash\.(text|rodata|appdesc|rodata_noload)|iram0\.(text|vectors)|dram0\.data)$' <<<"$sections")
+    iram=$(sum_sections '^\.iram0\.(text|vectors)$' <<<"$sections")
+    dram=$(sum_sections '^\.dram0\.(data|bss)$' <<<"$sections")
+
+    # The linker folds these into .flash.rodata, so count them in the firmware's objects instead
+    objects=$(find "$build/src" -name '*.o')
+    eh=$("$SIZE" -A $objects | sum_sections '^\.eh_frame')
+    except=$("$SIZE" -A $objects | sum_sections '^\.gcc_except_table')
+
+    printf '%-36s %10d %10d %10d %10d %10d\n' "$env" "$flash" "$iram" "$dram" "$eh" "$except"
+done
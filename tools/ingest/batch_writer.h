@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "telemetry_decoder.h"
+
+namespace pooaway::ingest
+{
+    /**
+     * @brief Append-only CSV sink with double-buffered batch writes
+     *
+     * The event loop formats rows into the active buffer; once it reaches the batch size or
+     * ages past the flush interval it is swapped with the idle buffer and handed to a writer
+     * thread, which issues a single write() (and optionally fdatasync()) per batch. The
+     * event loop only blocks if the writer is still busy with the previous batch.
+     */
+    class BatchWriter
+    {
+    public:
+        struct Stats
+        {
+            uint64_t rows{0};
+            uint64_t batches{0};
+            uint64_t bytes{0};
+            uint64_t stalls{0}; // Times the event loop waited for the writer thread
+            uint64_t max_flush_us{0};
+        };
+
+        BatchWriter(std::string path, size_t batch_bytes, uint64_t max_age_us, bool sync)
+            : m_path(std::move(path)), m_batch_bytes(batch_bytes), m_max_age_us(max_age_us), m_sync(sync)
+        {
+            m_active.reserve(batch_bytes + 4096);
+            m_pending.reserve(batch_bytes + 4096);
+        }
+
+        ~BatchWriter() { close(); }
+
+        BatchWriter(const BatchWriter &) = delete;
+        BatchWriter &operator=(const BatchWriter &) = delete;
+
+        bool open()
+        {
+            m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (m_fd < 0)
+            {
+                std::perror("open");
+                return false;
+            }
+
+            if (::lseek(m_fd, 0, SEEK_END) == 0)
+            {
+                m_active.append("recv_us,device_id,device_ts,index,name,model,alert,"
+                                "value,baseline,voltage,rs,r0,ratio\n");
+            }
+
+            m_running = true;
+            m_thread = std::thread([this]
+                                   { writer_loop(); });
+            return true;
+        }
+
+        void close()
+        {
+            if (!m_running)
+            {
+                return;
+            }
+
+            hand_off();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_cv.notify_all();
+            m_thread.join();
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        void append(const TelemetryFrame &frame, uint64_t recv_us)
+        {
+            if (m_active.empty())
+            {
+                m_active_since_us = recv_us;
+            }
+
+            for (size_t i = 0; i < frame.sensor_count; i++)
+            {
+                const auto &s = frame.sensors[i];
+                append_number(recv_us);
+                m_active.push_back(',');
+                m_active.append(frame.device_id);
+                m_active.push_back(',');
+                append_number(frame.timestamp);
+                m_active.push_back(',');
+                append_number(s.index);
+                m_active.push_back(',');
+                m_active.append(s.name);
+                m_active.push_back(',');
+                m_active.append(s.model);
+                m_active.append(s.alert ? ",1," : ",0,");
+                append_number(s.value);
+                m_active.push_back(',');
+                append_number(s.baseline);
+                m_active.push_back(',');
+                append_number(s.voltage);
+                m_active.push_back(',');
+                append_number(s.rs);
+                m_active.push_back(',');
+                append_number(s.r0);
+                m_active.push_back(',');
+                append_number(s.ratio);
+                m_active.push_back('\n');
+            }
+            m_rows_buffered += frame.sensor_count;
+
+            if (m_active.size() >= m_batch_bytes)
+            {
+                hand_off();
+            }
+        }
+
+        // Called from the event loop tick so quiet periods still reach disk promptly
+        void poll(uint64_t now_us)
+        {
+            if (!m_active.empty() && now_us - m_active_since_us >= m_max_age_us)
+            {
+                hand_off();
+            }
+        }
+
+        Stats stats() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stats;
+        }
+
+    private:
+        std::string m_path;
+        const size_t m_batch_bytes;
+        const uint64_t m_max_age_us;
+        const bool m_sync;
+        int m_fd{-1};
+
+        std::string m_active;
+        std::string m_pending;
+        uint64_t m_active_since_us{0};
+        uint64_t m_rows_buffered{0};
+        uint64_t m_rows_pending{0};
+        bool m_has_pending{false};
+        bool m_running{false};
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::thread m_thread;
+        Stats m_stats;
+
+        template <typename T>
+        void append_number(T value)
+        {
+            char buf[32];
+            const auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            m_active.append(buf, static_cast<size_t>(result.ptr - buf));
+        }
+
+        void hand_off()
+        {
+            if (m_active.empty())
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_has_pending)
+            {
+                m_stats.stalls++;
+                m_cv.wait(lock, [this]
+                          { return !m_has_pending; });
+            }
+
+            m_active.swap(m_pending);
+            m_rows_pending = m_rows_buffered;
+            m_rows_buffered = 0;
+            m_has_pending = true;
+            lock.unlock();
+            m_cv.notify_all();
+        }
+
+        void writer_loop()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;)
+            {
+                m_cv.wait(lock, [this]
+                          { return m_has_pending || !m_running; });
+                if (!m_has_pending)
+                {
+                    return; // Stopped with nothing left to write
+                }
+
+                lock.unlock();
+                const auto start = std::chrono::steady_clock::now();
+                const char *data = m_pending.data();
+                size_t left = m_pending.size();
+                while (left > 0)
+                {
+                    const ssize_t n = ::write(m_fd, data, left);
+                    if (n < 0)
+                    {
+                        std::perror("write");
+                        break;
+                    }
+                    data += n;
+                    left -= static_cast<size_t>(n);
+                }
+                if (m_sync)
+                {
+                    ::fdatasync(m_fd);
+                }
+                const auto elapsed_us = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+                lock.lock();
+
+                m_stats.rows += m_rows_pending;
+                m_stats.batches++;
+                m_stats.bytes += m_pending.size();
+                m_stats.max_flush_us = std::max(m_stats.max_flush_us, elapsed_us);
+                m_pending.clear();
+                m_has_pending = false;
+                m_cv.notify_all();
+            }
+        }
+    };
+} // namespace pooaway::ingest
@@ -0,0 +1,559 @@
+/**
+ * @file collector.cpp
+ * @brief Host-side telemetry collector for fleets of PooAway devices
+ *
+ * Accepts AlertManager payloads over a minimal MQTT 3.1.1 broker stand-in (CONNECT, PUBLISH
+ * QoS 0/1, PINGREQ, DISCONNECT) and over HTTP POST, decodes them in place with JsonCursor
+ * and appends one CSV row per sensor through a BatchWriter.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -o collector collector.cpp
+ */
+
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "batch_writer.h"
+#include "mqtt_codec.h"
+#include "telemetry_decoder.h"
+
+using namespace pooaway::ingest;
+
+namespace
+{
+    constexpr size_t MAX_CONNECTION_BUFFER = 1U << 20; // Drop peers that never complete a packet
+    constexpr size_t READ_CHUNK = 16384;
+    constexpr int MAX_EVENTS = 256;
+
+    volatile std::sig_atomic_t g_stop = 0;
+
+    struct Options
+    {
+        uint16_t mqtt_port{1883};
+        uint16_t http_port{8080};
+        std::string output{"telemetry.csv"};
+        size_t batch_bytes{256 * 1024};
+        uint64_t flush_ms{200};
+        bool sync{false};
+    };
+
+    enum class Protocol
+    {
+        MQTT,
+        HTTP
+    };
+
+    struct Connection
+    {
+        int fd{-1};
+        Protocol protocol{Protocol::MQTT};
+        std::string in;
+        std::string out;
+        bool want_write{false};
+        bool close_after_write{false};
+    };
+
+    struct Counters
+    {
+        uint64_t frames{0};
+        uint64_t rejected{0};
+        uint64_t bytes_in{0};
+        uint64_t accepted{0};
+        uint64_t closed{0};
+    };
+
+    uint64_t now_us()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    void print_usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--mqtt-port N] [--http-port N] [--out FILE]\n"
+                     "          [--batch-kb N] [--flush-ms N] [--sync]\n",
+                     argv0);
+    }
+
+    bool parse_options(int argc, char **argv, Options &opts)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg(argv[i]);
+            const bool has_value = i + 1 < argc;
+            if (arg == "--mqtt-port" && has_value)
+                opts.mqtt_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            else if (arg == "--http-port" && has_value)
+                opts.http_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            else if (arg == "--out" && has_value)
+                opts.output = argv[++i];
+            else if (arg == "--batch-kb" && has_value)
+                opts.batch_bytes = static_cast<size_t>(std::atol(argv[++i])) * 1024;
+            else if (arg == "--flush-ms" && has_value)
+                opts.flush_ms = static_cast<uint64_t>(std::atol(argv[++i]));
+            else if (arg == "--sync")
+                opts.sync = true;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    void raise_fd_limit()
+    {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    int open_listener(uint16_t port)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        const int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 4096) < 0)
+        {
+            std::perror("bind/listen");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    class Collector
+    {
+    public:
+        Collector(const Options &opts)
+            : m_opts(opts), m_writer(opts.output, opts.batch_bytes, opts.flush_ms * 1000, opts.sync)
+        {
+        }
+
+        int run()
+        {
+            if (!m_writer.open())
+            {
+                return 1;
+            }
+
+            m_epoll = epoll_create1(0);
+            m_mqtt_listener = open_listener(m_opts.mqtt_port);
+            m_http_listener = open_listener(m_opts.http_port);
+            if (m_epoll < 0 || m_mqtt_listener < 0 || m_http_listener < 0)
+            {
+                return 1;
+            }
+
+            watch(m_mqtt_listener, EPOLLIN);
+            watch(m_http_listener, EPOLLIN);
+            std::printf("Collector listening: MQTT :%u, HTTP :%u -> %s\n",
+                        m_opts.mqtt_port, m_opts.http_port, m_opts.output.c_str());
+
+            epoll_event events[MAX_EVENTS];
+            uint64_t last_report = now_us();
+            Counters last_counters;
+
+            while (!g_stop)
+            {
+                const int n = epoll_wait(m_epoll, events, MAX_EVENTS, 50);
+                for (int i = 0; i < n; i++)
+                {
+                    const int fd = events[i].data.fd;
+                    if (fd == m_mqtt_listener || fd == m_http_listener)
+                    {
+                        accept_all(fd, fd == m_mqtt_listener ? Protocol::MQTT : Protocol::HTTP);
+                        continue;
+                    }
+
+                    auto it = m_connections.find(fd);
+                    if (it == m_connections.end())
+                    {
+                        continue;
+                    }
+
+                    auto &conn = *it->second;
+                    bool keep = true;
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    {
+                        keep = on_readable(conn);
+                    }
+                    if (keep && (events[i].events & EPOLLOUT))
+                    {
+                        keep = flush(conn);
+                    }
+                    if (!keep)
+                    {
+                        drop(fd);
+                    }
+                }
+
+                const uint64_t now = now_us();
+                m_writer.poll(now);
+                if (now - last_report >= 1000000)
+                {
+                    report(now - last_report, last_counters);
+                    last_counters = m_counters;
+                    last_report = now;
+                }
+            }
+
+            m_writer.close();
+            const auto stats = m_writer.stats();
+            std::printf("Final: frames=%llu rejected=%llu rows=%llu batches=%llu stalls=%llu "
+                        "max_flush=%lluus\n",
+                        static_cast<unsigned long long>(m_counters.frames),
+                        static_cast<unsigned long long>(m_counters.rejected),
+                        static_cast<unsigned long long>(stats.rows),
+                        static_cast<unsigned long long>(stats.batches),
+                        static_cast<unsigned long long>(stats.stalls),
+                        static_cast<unsigned long long>(stats.max_flush_us));
+            return 0;
+        }
+
+    private:
+        const Options &m_opts;
+        BatchWriter m_writer;
+        int m_epoll{-1};
+        int m_mqtt_listener{-1};
+        int m_http_listener{-1};
+        std::unordered_map<int, std::unique_ptr<Connection>> m_connections;
+        TelemetryFrame m_frame; // Reused for every decode; views point into connection buffers
+        Counters m_counters;
+
+        void watch(int fd, uint32_t events)
+        {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+        }
+
+        void set_write_interest(Connection &conn, bool enabled)
+        {
+            if (conn.want_write == enabled)
+            {
+                return;
+            }
+
+            conn.want_write = enabled;
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP | (enabled ? EPOLLOUT : 0U);
+            ev.data.fd = conn.fd;
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, conn.fd, &ev);
+        }
+
+        void accept_all(int listener, Protocol protocol)
+        {
+            for (;;)
+            {
+                const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+                if (fd < 0)
+                {
+                    return; // EAGAIN, or out of descriptors until peers disconnect
+                }
+
+                const int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+                auto conn = std::make_unique<Connection>();
+                conn->fd = fd;
+                conn->protocol = protocol;
+                conn->in.reserve(READ_CHUNK);
+                m_connections.emplace(fd, std::move(conn));
+                watch(fd, EPOLLIN | EPOLLRDHUP);
+                m_counters.accepted++;
+            }
+        }
+
+        void drop(int fd)
+        {
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            m_connections.erase(fd);
+            m_counters.closed++;
+        }
+
+        bool on_readable(Connection &conn)
+        {
+            for (;;)
+            {
+                const size_t old_size = conn.in.size();
+                conn.in.resize(old_size + READ_CHUNK);
+                const ssize_t n = read(conn.fd, conn.in.data() + old_size, READ_CHUNK);
+                conn.in.resize(old_size + (n > 0 ? static_cast<size_t>(n) : 0));
+
+                if (n == 0)
+                {
+                    return false; // Peer closed
+                }
+                if (n < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    {
+                        break;
+                    }
+                    return false;
+                }
+                m_counters.bytes_in += static_cast<uint64_t>(n);
+            }
+
+            const size_t consumed = (conn.protocol == Protocol::MQTT) ? process_mqtt(conn)
+                                                                     : process_http(conn);
+            if (consumed == SIZE_MAX)
+            {
+                return false;
+            }
+
+            // Views into the buffer are dead by now (rows were copied into the batch), so the
+            // processed prefix can be discarded
+            conn.in.erase(0, consumed);
+            if (conn.in.size() > MAX_CONNECTION_BUFFER)
+            {
+                return false;
+            }
+
+            return flush(conn);
+        }
+
+        bool ingest(std::string_view payload)
+        {
+            if (!decode_telemetry(payload, m_frame))
+            {
+                m_counters.rejected++;
+                return false;
+            }
+
+            m_writer.append(m_frame, now_us());
+            m_counters.frames++;
+            return true;
+        }
+
+        // Returns the number of bytes consumed, or SIZE_MAX to drop the connection
+        size_t process_mqtt(Connection &conn)
+        {
+            const std::string_view buf(conn.in);
+            size_t pos = 0;
+
+            for (;;)
+            {
+                mqtt::FixedHeader header;
+                const auto status = mqtt::parse_fixed_header(buf.substr(pos), header);
+                if (status == mqtt::ParseStatus::INCOMPLETE)
+                {
+                    return pos;
+                }
+                if (status == mqtt::ParseStatus::MALFORMED)
+                {
+                    return SIZE_MAX;
+                }
+
+                const auto body = buf.substr(pos + header.header_len, header.remaining_len);
+                pos += header.header_len + header.remaining_len;
+
+                switch (header.type)
+                {
+                case mqtt::PacketType::CONNECT:
+                    mqtt::append_connack(conn.out);
+                    break;
+                case mqtt::PacketType::PUBLISH:
+                {
+                    mqtt::Publish publish;
+                    if (!mqtt::parse_publish(header, body, publish) || publish.qos > 1)
+                    {
+                        return SIZE_MAX;
+                    }
+                    ingest(publish.payload);
+                    if (publish.qos == 1)
+                    {
+                        // Acked once the rows are queued for the next batch, not after fsync
+                        mqtt::append_ack(conn.out, mqtt::PacketType::PUBACK, publish.packet_id);
+                    }
+                    break;
+                }
+                case mqtt::PacketType::PINGREQ:
+                    conn.out.push_back(static_cast<char>(static_cast<uint8_t>(mqtt::PacketType::PINGRESP) << 4));
+                    conn.out.push_back(0);
+                    break;
+                case mqtt::PacketType::DISCONNECT:
+                    conn.close_after_write = true;
+                    return pos;
+                default:
+                    break; // Devices only publish; anything else is ignored
+                }
+            }
+        }
+
+        size_t process_http(Connection &conn)
+        {
+            const std::string_view buf(conn.in);
+            size_t pos = 0;
+
+            for (;;)
+            {
+                const auto rest = buf.substr(pos);
+                const size_t header_end = rest.find("\r\n\r\n");
+                if (header_end == std::string_view::npos)
+                {
+                    return pos;
+                }
+
+                const auto head = rest.substr(0, header_end);
+                size_t content_length = 0;
+                bool close_requested = false;
+                size_t line_start = head.find("\r\n");
+                while (line_start != std::string_view::npos)
+                {
+                    line_start += 2;
+                    const size_t line_end = head.find("\r\n", line_start);
+                    const auto line = head.substr(line_start, line_end == std::string_view::npos
+                                                                  ? std::string_view::npos
+                                                                  : line_end - line_start);
+                    if (header_is(line, "content-length:"))
+                    {
+                        auto value = line.substr(15);
+                        while (!value.empty() && value.front() == ' ')
+                        {
+                            value.remove_prefix(1);
+                        }
+                        std::from_chars(value.data(), value.data() + value.size(), content_length);
+                    }
+                    else if (header_is(line, "connection:") && line.find("close") != std::string_view::npos)
+                    {
+                        close_requested = true;
+                    }
+                    line_start = line_end;
+                }
+
+                const size_t body_start = header_end + 4;
+                if (rest.size() < body_start + content_length)
+                {
+                    return pos; // Body not fully received yet
+                }
+
+                const auto request_line = head.substr(0, head.find("\r\n"));
+                const auto body = rest.substr(body_start, content_length);
+                pos += body_start + content_length;
+
+                if (request_line.rfind("POST /ingest ", 0) != 0)
+                {
+                    conn.out.append("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+                }
+                else if (ingest(body))
+                {
+                    conn.out.append("HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+                }
+                else
+                {
+                    conn.out.append("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+                }
+
+                if (close_requested)
+                {
+                    conn.close_after_write = true;
+                    return pos;
+                }
+            }
+        }
+
+        static bool header_is(std::string_view line, std::string_view name)
+        {
+            if (line.size() < name.size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < name.size(); i++)
+            {
+                const char c = line[i];
+                const char lower = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+                if (lower != name[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool flush(Connection &conn)
+        {
+            while (!conn.out.empty())
+            {
+                const ssize_t n = write(conn.fd, conn.out.data(), conn.out.size());
+                if (n < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    {
+                        set_write_interest(conn, true);
+                        return true;
+                    }
+                    return false;
+                }
+                conn.out.erase(0, static_cast<size_t>(n));
+            }
+
+            set_write_interest(conn, false);
+            return !conn.close_after_write;
+        }
+
+        void report(uint64_t elapsed_us, const Counters &last)
+        {
+            const double seconds = static_cast<double>(elapsed_us) / 1e6;
+            const auto stats = m_writer.stats();
+            std::printf("conns=%zu frames/s=%.0f rejected/s=%.0f MB/s=%.2f rows=%llu batches=%llu\n",
+                        m_connections.size(),
+                        static_cast<double>(m_counters.frames - last.frames) / seconds,
+                        static_cast<double>(m_counters.rejected - last.rejected) / seconds,
+                        static_cast<double>(m_counters.bytes_in - last.bytes_in) / seconds / 1e6,
+                        static_cast<unsigned long long>(stats.rows),
+                        static_cast<unsigned long long>(stats.batches));
+            std::fflush(stdout);
+        }
+    };
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::signal(SIGINT, [](int)
+                { g_stop = 1; });
+    std::signal(SIGTERM, [](int)
+                { g_stop = 1; });
+    std::signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+
+    Collector collector(opts);
+    return collector.run();
+}
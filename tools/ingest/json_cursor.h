@@ -0,0 +1,243 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace pooaway::ingest
+{
+    /**
+     * @brief Pull-style JSON reader that never copies or allocates
+     *
+     * Strings are returned as views into the source buffer with their escapes left in place,
+     * which is sufficient for the ASCII names and MAC addresses the firmware emits. The
+     * source buffer must outlive every view handed out by the cursor.
+     */
+    class JsonCursor
+    {
+    public:
+        explicit JsonCursor(std::string_view source) : m_src(source) {}
+
+        bool ok() const { return m_ok; }
+        bool at_end()
+        {
+            skip_ws();
+            return m_pos >= m_src.size();
+        }
+
+        bool begin_object() { return expect('{'); }
+        bool begin_array() { return expect('['); }
+
+        /**
+         * @brief Advance to the next member of the current object
+         * @return false once the closing brace has been consumed (or on a syntax error)
+         */
+        bool next_key(std::string_view &key)
+        {
+            if (!next_item('}'))
+            {
+                return false;
+            }
+            return read_string(key) && expect(':');
+        }
+
+        /**
+         * @brief Advance to the next element of the current array
+         * @return false once the closing bracket has been consumed (or on a syntax error)
+         */
+        bool next_element() { return next_item(']'); }
+
+        bool read_string(std::string_view &out)
+        {
+            if (!expect('"'))
+            {
+                return false;
+            }
+
+            const size_t start = m_pos;
+            while (m_pos < m_src.size() && m_src[m_pos] != '"')
+            {
+                m_pos += (m_src[m_pos] == '\\') ? 2 : 1;
+            }
+
+            if (m_pos >= m_src.size())
+            {
+                return fail();
+            }
+
+            out = m_src.substr(start, m_pos - start);
+            m_pos++; // Closing quote
+            return true;
+        }
+
+        // ArduinoJson writes NaN/Inf as null, which reads back as NaN (or 0 for integers)
+        template <typename T>
+        bool read_number(T &out)
+        {
+            skip_ws();
+            if (m_src.compare(m_pos, 4, "null") == 0)
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                    out = std::numeric_limits<T>::quiet_NaN();
+                else
+                    out = T{};
+                m_pos += 4;
+                return true;
+            }
+
+            const char *first = m_src.data() + m_pos;
+            const char *last = m_src.data() + m_src.size();
+            const auto result = std::from_chars(first, last, out);
+            if (result.ec != std::errc())
+            {
+                return fail();
+            }
+            m_pos += static_cast<size_t>(result.ptr - first);
+            return true;
+        }
+
+        bool read_bool(bool &out)
+        {
+            skip_ws();
+            if (m_src.compare(m_pos, 4, "true") == 0)
+            {
+                out = true;
+                m_pos += 4;
+                return true;
+            }
+            if (m_src.compare(m_pos, 5, "false") == 0)
+            {
+                out = false;
+                m_pos += 5;
+                return true;
+            }
+            return fail();
+        }
+
+        // Skip over any value, including nested containers, without materialising it
+        bool skip_value()
+        {
+            skip_ws();
+            if (m_pos >= m_src.size())
+            {
+                return fail();
+            }
+
+            switch (m_src[m_pos])
+            {
+            case '"':
+            {
+                std::string_view ignored;
+                return read_string(ignored);
+            }
+            case '{':
+            case '[':
+                return skip_container();
+            default:
+                // Numbers and literals end at the next delimiter
+                while (m_pos < m_src.size() && !is_delimiter(m_src[m_pos]))
+                {
+                    m_pos++;
+                }
+                return true;
+            }
+        }
+
+    private:
+        std::string_view m_src;
+        size_t m_pos{0};
+        bool m_ok{true};
+        bool m_first_item{true};
+
+        static bool is_delimiter(char c)
+        {
+            return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        bool fail()
+        {
+            m_ok = false;
+            m_pos = m_src.size();
+            return false;
+        }
+
+        void skip_ws()
+        {
+            while (m_pos < m_src.size() &&
+                   (m_src[m_pos] == ' ' || m_src[m_pos] == '\n' || m_src[m_pos] == '\r' || m_src[m_pos] == '\t'))
+            {
+                m_pos++;
+            }
+        }
+
+        bool expect(char c)
+        {
+            skip_ws();
+            if (m_pos >= m_src.size() || m_src[m_pos] != c)
+            {
+                return fail();
+            }
+            m_pos++;
+            if (c == '{' || c == '[')
+            {
+                m_first_item = true;
+            }
+            return true;
+        }
+
+        bool next_item(char closing)
+        {
+            if (!m_ok)
+            {
+                return false;
+            }
+
+            skip_ws();
+            if (m_pos < m_src.size() && m_src[m_pos] == closing)
+            {
+                m_pos++;
+                m_first_item = false;
+                return false;
+            }
+
+            if (!m_first_item && !expect(','))
+            {
+                return false;
+            }
+            m_first_item = false;
+            return true;
+        }
+
+        bool skip_container()
+        {
+            int depth = 0;
+            while (m_pos < m_src.size())
+            {
+                const char c = m_src[m_pos];
+                if (c == '"')
+                {
+                    std::string_view ignored;
+                    if (!read_string(ignored))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                m_pos++;
+                if (c == '{' || c == '[')
+                {
+                    depth++;
+                }
+                else if ((c == '}' || c == ']') && --depth == 0)
+                {
+                    m_first_item = false;
+                    return true;
+                }
+            }
+            return fail();
+        }
+    };
+} // namespace pooaway::ingest
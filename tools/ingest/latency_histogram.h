@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace pooaway::ingest
+{
+    /**
+     * @brief Fixed-size log-linear latency histogram (microseconds)
+     *
+     * Each power-of-two range is split into 16 linear sub-buckets, so any recorded value is
+     * reported within ~6% while the whole histogram stays a few KiB regardless of run length.
+     */
+    class LatencyHistogram
+    {
+    public:
+        void record(uint64_t value_us)
+        {
+            m_buckets[bucket_index(value_us)]++;
+            m_count++;
+            if (value_us > m_max)
+            {
+                m_max = value_us;
+            }
+        }
+
+        void merge(const LatencyHistogram &other)
+        {
+            for (size_t i = 0; i < BUCKETS; i++)
+            {
+                m_buckets[i] += other.m_buckets[i];
+            }
+            m_count += other.m_count;
+            if (other.m_max > m_max)
+            {
+                m_max = other.m_max;
+            }
+        }
+
+        uint64_t count() const { return m_count; }
+        uint64_t max() const { return m_max; }
+
+        // Upper bound of the bucket containing the requested percentile (0..100)
+        uint64_t percentile(double pct) const
+        {
+            if (m_count == 0)
+            {
+                return 0;
+            }
+
+            const auto target = static_cast<uint64_t>(static_cast<double>(m_count) * pct / 100.0);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; i++)
+            {
+                seen += m_buckets[i];
+                if (seen > target)
+                {
+                    const uint64_t upper = bucket_upper(i);
+                    return upper < m_max ? upper : m_max;
+                }
+            }
+            return m_max;
+        }
+
+    private:
+        static constexpr size_t SUB_BITS = 4;
+        static constexpr size_t SUB_BUCKETS = 1U << SUB_BITS;
+        static constexpr size_t GROUPS = 40; // Covers up to ~2^40 us
+        static constexpr size_t BUCKETS = GROUPS * SUB_BUCKETS;
+
+        std::array<uint64_t, BUCKETS> m_buckets{};
+        uint64_t m_count{0};
+        uint64_t m_max{0};
+
+        static size_t bucket_index(uint64_t v)
+        {
+            if (v < SUB_BUCKETS)
+            {
+                return static_cast<size_t>(v);
+            }
+            const size_t msb = 63U - static_cast<size_t>(__builtin_clzll(v));
+            const size_t group = msb - SUB_BITS + 1;
+            const size_t sub = static_cast<size_t>(v >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+            const size_t index = group * SUB_BUCKETS + sub;
+            return index < BUCKETS ? index : BUCKETS - 1;
+        }
+
+        static uint64_t bucket_upper(size_t index)
+        {
+            const size_t group = index / SUB_BUCKETS;
+            const size_t sub = index % SUB_BUCKETS;
+            if (group == 0)
+            {
+                return sub;
+            }
+            const size_t shift = group - 1;
+            return ((static_cast<uint64_t>(SUB_BUCKETS + sub + 1)) << shift) - 1;
+        }
+    };
+} // namespace pooaway::ingest
@@ -0,0 +1,512 @@
+/**
+ * @file loadgen.cpp
+ * @brief Load generator that simulates a fleet of PooAway devices against the collector
+ *
+ * Every simulated device holds its own TCP connection and publishes AlertManager payloads,
+ * either as MQTT QoS 1 PUBLISH (latency = PUBLISH to PUBACK) or as HTTP POST /ingest
+ * (latency = request to response). Devices are spread across worker threads, each driving
+ * its share with one epoll loop.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -o loadgen loadgen.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "latency_histogram.h"
+#include "mqtt_codec.h"
+
+using namespace pooaway::ingest;
+
+namespace
+{
+    std::atomic<bool> g_stop{false};
+
+    struct Options
+    {
+        std::string host{"127.0.0.1"};
+        uint16_t port{1883};
+        bool http{false};
+        size_t devices{1000};
+        double rate{1.0}; // Messages per second per device; 0 keeps the window full
+        size_t window{1}; // Outstanding (unacknowledged) messages per device
+        size_t threads{4};
+        unsigned duration_s{30};
+        size_t sensors{2};
+    };
+
+    struct Device
+    {
+        int fd{-1};
+        size_t id{0};
+        bool connected{false};
+        bool want_write{true};
+        uint16_t next_packet_id{1};
+        uint64_t next_send_us{0};
+        uint64_t sequence{0};
+        std::string in;
+        std::string out;
+        std::deque<std::pair<uint16_t, uint64_t>> in_flight; // Packet id, send time
+    };
+
+    struct WorkerResult
+    {
+        LatencyHistogram latency;
+        uint64_t sent{0};
+        uint64_t acked{0};
+        uint64_t errors{0};
+    };
+
+    uint64_t now_us()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    bool parse_options(int argc, char **argv, Options &opts)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg(argv[i]);
+            const bool has_value = i + 1 < argc;
+            if (arg == "--host" && has_value)
+                opts.host = argv[++i];
+            else if (arg == "--port" && has_value)
+                opts.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            else if (arg == "--http")
+                opts.http = true;
+            else if (arg == "--devices" && has_value)
+                opts.devices = static_cast<size_t>(std::atol(argv[++i]));
+            else if (arg == "--rate" && has_value)
+                opts.rate = std::atof(argv[++i]);
+            else if (arg == "--window" && has_value)
+                opts.window = static_cast<size_t>(std::atol(argv[++i]));
+            else if (arg == "--threads" && has_value)
+                opts.threads = static_cast<size_t>(std::atol(argv[++i]));
+            else if (arg == "--duration" && has_value)
+                opts.duration_s = static_cast<unsigned>(std::atoi(argv[++i]));
+            else if (arg == "--sensors" && has_value)
+                opts.sensors = static_cast<size_t>(std::atol(argv[++i]));
+            else
+                return false;
+        }
+        return opts.devices > 0 && opts.threads > 0 && opts.window > 0 && opts.sensors > 0;
+    }
+
+    // Same document shape AlertManager::update() produces
+    void build_payload(std::string &out, const Options &opts, const Device &device)
+    {
+        static constexpr const char *NAMES[] = {"PEE", "POO"};
+        static constexpr const char *MODELS[] = {"GM-802B", "GM-402B"};
+
+        char buf[256];
+        out.clear();
+        std::snprintf(buf, sizeof(buf), "{\"device_id\":\"02:00:00:%02X:%02X:%02X\",\"timestamp\":%llu,\"sensors\":[",
+                      static_cast<unsigned>((device.id >> 16) & 0xFF), static_cast<unsigned>((device.id >> 8) & 0xFF),
+                      static_cast<unsigned>(device.id & 0xFF), static_cast<unsigned long long>(device.sequence * 1000));
+        out.append(buf);
+
+        for (size_t i = 0; i < opts.sensors; i++)
+        {
+            const float value = 1.5F + static_cast<float>((device.sequence + i) % 17) * 0.1F;
+            std::snprintf(buf, sizeof(buf),
+                          "%s{\"index\":%zu,\"name\":\"%s\",\"model\":\"%s\",\"alert\":false,"
+                          "\"readings\":{\"value\":%.2f,\"baseline\":1.6,\"voltage\":1.21,\"rs\":12345.6,"
+                          "\"r0\":11000,\"ratio\":1.12},"
+                          "\"calibration\":{\"preheating_time\":30,\"a\":102.2,\"b\":-2.473}}",
+                          i == 0 ? "" : ",", i, NAMES[i % 2], MODELS[i % 2], static_cast<double>(value));
+            out.append(buf);
+        }
+        out.append("]}");
+    }
+
+    class Worker
+    {
+    public:
+        Worker(const Options &opts, size_t first_device, size_t device_count, const sockaddr_in &target)
+            : m_opts(opts), m_target(target)
+        {
+            m_devices.resize(device_count);
+            for (size_t i = 0; i < device_count; i++)
+            {
+                m_devices[i].id = first_device + i;
+            }
+            m_topic = "pooaway/telemetry";
+        }
+
+        void run()
+        {
+            m_epoll = epoll_create1(0);
+            const uint64_t start = now_us();
+            const uint64_t interval_us = m_opts.rate > 0.0 ? static_cast<uint64_t>(1e6 / m_opts.rate) : 0;
+
+            for (auto &device : m_devices)
+            {
+                // Spread the first publishes so devices do not fire in lockstep
+                device.next_send_us = start + (interval_us > 0 ? (device.id * 7919) % interval_us : 0);
+                open(device);
+            }
+
+            epoll_event events[256];
+            while (!g_stop)
+            {
+                const int n = epoll_wait(m_epoll, events, 256, 1);
+                for (int i = 0; i < n; i++)
+                {
+                    auto &device = m_devices[events[i].data.u64];
+                    if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    {
+                        fail(device);
+                        continue;
+                    }
+                    if (events[i].events & EPOLLIN)
+                    {
+                        on_readable(device);
+                    }
+                    if (events[i].events & EPOLLOUT)
+                    {
+                        flush(device);
+                    }
+                }
+
+                const uint64_t now = now_us();
+                for (auto &device : m_devices)
+                {
+                    if (!device.connected || device.in_flight.size() >= m_opts.window)
+                    {
+                        continue;
+                    }
+                    if (interval_us > 0 && now < device.next_send_us)
+                    {
+                        continue;
+                    }
+
+                    send(device, now);
+                    device.next_send_us += interval_us;
+                    if (interval_us > 0 && device.next_send_us < now)
+                    {
+                        device.next_send_us = now + interval_us; // Do not burst to catch up
+                    }
+                }
+            }
+
+            for (auto &device : m_devices)
+            {
+                if (device.fd >= 0)
+                {
+                    close(device.fd);
+                }
+            }
+            close(m_epoll);
+        }
+
+        const WorkerResult &result() const { return m_result; }
+
+    private:
+        const Options &m_opts;
+        const sockaddr_in m_target;
+        std::vector<Device> m_devices;
+        std::string m_topic;
+        std::string m_payload;
+        int m_epoll{-1};
+        WorkerResult m_result;
+
+        void open(Device &device)
+        {
+            device.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (device.fd < 0)
+            {
+                m_result.errors++;
+                return;
+            }
+
+            const int one = 1;
+            setsockopt(device.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connect(device.fd, reinterpret_cast<const sockaddr *>(&m_target), sizeof(m_target));
+
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT;
+            ev.data.u64 = static_cast<uint64_t>(&device - m_devices.data());
+            epoll_ctl(m_epoll, EPOLL_CTL_ADD, device.fd, &ev);
+
+            if (m_opts.http)
+            {
+                device.connected = true;
+            }
+            else
+            {
+                char client_id[24];
+                std::snprintf(client_id, sizeof(client_id), "sim-%zu", device.id);
+                mqtt::append_connect(device.out, client_id, 60);
+            }
+        }
+
+        void fail(Device &device)
+        {
+            m_result.errors++;
+            epoll_ctl(m_epoll, EPOLL_CTL_DEL, device.fd, nullptr);
+            close(device.fd);
+            device.fd = -1;
+            device.connected = false;
+            device.want_write = true;
+            device.in_flight.clear();
+        }
+
+        void send(Device &device, uint64_t now)
+        {
+            device.sequence++;
+            build_payload(m_payload, m_opts, device);
+
+            uint16_t packet_id = 0;
+            if (m_opts.http)
+            {
+                char header[160];
+                std::snprintf(header, sizeof(header),
+                              "POST /ingest HTTP/1.1\r\nHost: collector\r\nContent-Type: application/json\r\n"
+                              "Content-Length: %zu\r\n\r\n",
+                              m_payload.size());
+                device.out.append(header);
+                device.out.append(m_payload);
+            }
+            else
+            {
+                packet_id = device.next_packet_id++;
+                if (device.next_packet_id == 0)
+                {
+                    device.next_packet_id = 1; // Packet id 0 is reserved
+                }
+                mqtt::append_publish(device.out, m_topic, m_payload, 1, packet_id);
+            }
+
+            device.in_flight.emplace_back(packet_id, now);
+            m_result.sent++;
+            flush(device);
+        }
+
+        void set_write_interest(Device &device, bool enabled)
+        {
+            if (device.want_write == enabled || device.fd < 0)
+            {
+                return;
+            }
+
+            device.want_write = enabled;
+            epoll_event ev{};
+            ev.events = EPOLLIN | (enabled ? EPOLLOUT : 0U);
+            ev.data.u64 = static_cast<uint64_t>(&device - m_devices.data());
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, device.fd, &ev);
+        }
+
+        void flush(Device &device)
+        {
+            while (!device.out.empty() && device.fd >= 0)
+            {
+                const ssize_t n = write(device.fd, device.out.data(), device.out.size());
+                if (n < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOTCONN)
+                    {
+                        fail(device);
+                        return;
+                    }
+                    set_write_interest(device, true);
+                    return;
+                }
+                device.out.erase(0, static_cast<size_t>(n));
+            }
+            set_write_interest(device, false);
+        }
+
+        void complete(Device &device, uint16_t packet_id)
+        {
+            const uint64_t now = now_us();
+            for (auto it = device.in_flight.begin(); it != device.in_flight.end(); ++it)
+            {
+                if (m_opts.http || it->first == packet_id)
+                {
+                    m_result.latency.record(now - it->second);
+                    m_result.acked++;
+                    device.in_flight.erase(it);
+                    return;
+                }
+            }
+        }
+
+        void on_readable(Device &device)
+        {
+            char buf[4096];
+            for (;;)
+            {
+                const ssize_t n = read(device.fd, buf, sizeof(buf));
+                if (n == 0)
+                {
+                    fail(device);
+                    return;
+                }
+                if (n < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    {
+                        fail(device);
+                        return;
+                    }
+                    break;
+                }
+                device.in.append(buf, static_cast<size_t>(n));
+            }
+
+            m_opts.http ? consume_http(device) : consume_mqtt(device);
+        }
+
+        void consume_mqtt(Device &device)
+        {
+            size_t pos = 0;
+            for (;;)
+            {
+                mqtt::FixedHeader header;
+                const auto view = std::string_view(device.in).substr(pos);
+                if (mqtt::parse_fixed_header(view, header) != mqtt::ParseStatus::COMPLETE)
+                {
+                    break;
+                }
+
+                const auto body = view.substr(header.header_len, header.remaining_len);
+                if (header.type == mqtt::PacketType::CONNACK)
+                {
+                    device.connected = true;
+                }
+                else if (header.type == mqtt::PacketType::PUBACK && body.size() >= 2)
+                {
+                    const auto id = static_cast<uint16_t>((static_cast<uint8_t>(body[0]) << 8) |
+                                                          static_cast<uint8_t>(body[1]));
+                    complete(device, id);
+                }
+                pos += header.header_len + header.remaining_len;
+            }
+            device.in.erase(0, pos);
+        }
+
+        void consume_http(Device &device)
+        {
+            // The collector always answers with an empty body, so each header block is one response
+            size_t pos = 0;
+            for (;;)
+            {
+                const size_t end = device.in.find("\r\n\r\n", pos);
+                if (end == std::string::npos)
+                {
+                    break;
+                }
+                if (device.in.compare(pos, 12, "HTTP/1.1 204") != 0)
+                {
+                    m_result.errors++;
+                }
+                complete(device, 0);
+                pos = end + 4;
+            }
+            device.in.erase(0, pos);
+        }
+    };
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--host IP] [--port N] [--http] [--devices N] [--rate MSG_PER_S]\n"
+                     "          [--window N] [--threads N] [--duration S] [--sensors N]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, [](int)
+                { g_stop = true; });
+
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(opts.port);
+    if (inet_pton(AF_INET, opts.host.c_str(), &target.sin_addr) != 1)
+    {
+        std::fprintf(stderr, "Invalid host address: %s\n", opts.host.c_str());
+        return 2;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    const size_t per_thread = (opts.devices + opts.threads - 1) / opts.threads;
+    for (size_t first = 0; first < opts.devices; first += per_thread)
+    {
+        const size_t count = std::min(per_thread, opts.devices - first);
+        workers.push_back(std::make_unique<Worker>(opts, first, count, target));
+    }
+
+    const uint64_t start = now_us();
+    for (auto &worker : workers)
+    {
+        threads.emplace_back([&worker]
+                             { worker->run(); });
+    }
+
+    const uint64_t deadline = start + static_cast<uint64_t>(opts.duration_s) * 1000000ULL;
+    while (!g_stop && now_us() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    g_stop = true;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const double elapsed_s = static_cast<double>(now_us() - start) / 1e6;
+
+    WorkerResult total;
+    for (const auto &worker : workers)
+    {
+        const auto &r = worker->result();
+        total.latency.merge(r.latency);
+        total.sent += r.sent;
+        total.acked += r.acked;
+        total.errors += r.errors;
+    }
+
+    std::printf("%s, %zu devices, %zu threads, window %zu, %.1f s\n",
+                opts.http ? "HTTP" : "MQTT QoS1", opts.devices, opts.threads, opts.window, elapsed_s);
+    std::printf("sent=%llu acked=%llu errors=%llu throughput=%.0f msg/s\n",
+                static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(total.acked),
+                static_cast<unsigned long long>(total.errors), static_cast<double>(total.acked) / elapsed_s);
+    std::printf("latency us: p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n",
+                static_cast<unsigned long long>(total.latency.percentile(50.0)),
+                static_cast<unsigned long long>(total.latency.percentile(90.0)),
+                static_cast<unsigned long long>(total.latency.percentile(99.0)),
+                static_cast<unsigned long long>(total.latency.percentile(99.9)),
+                static_cast<unsigned long long>(total.latency.max()));
+    return 0;
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace pooaway::ingest::mqtt
+{
+    // MQTT 3.1.1 control packet types (upper nibble of the fixed header)
+    enum class PacketType : uint8_t
+    {
+        CONNECT = 1,
+        CONNACK = 2,
+        PUBLISH = 3,
+        PUBACK = 4,
+        SUBSCRIBE = 8,
+        SUBACK = 9,
+        PINGREQ = 12,
+        PINGRESP = 13,
+        DISCONNECT = 14
+    };
+
+    struct FixedHeader
+    {
+        PacketType type{PacketType::CONNECT};
+        uint8_t flags{0};
+        size_t header_len{0};    // Fixed header bytes, including the remaining-length varint
+        size_t remaining_len{0}; // Variable header + payload bytes
+    };
+
+    enum class ParseStatus
+    {
+        COMPLETE,
+        INCOMPLETE,
+        MALFORMED
+    };
+
+    /**
+     * @brief Parse the fixed header at the start of a receive buffer
+     * @return COMPLETE only when the whole packet (header + remaining length) is buffered
+     */
+    inline ParseStatus parse_fixed_header(std::string_view buf, FixedHeader &out)
+    {
+        if (buf.size() < 2)
+        {
+            return ParseStatus::INCOMPLETE;
+        }
+
+        out.type = static_cast<PacketType>(static_cast<uint8_t>(buf[0]) >> 4);
+        out.flags = static_cast<uint8_t>(buf[0]) & 0x0F;
+
+        size_t value = 0;
+        size_t multiplier = 1;
+        size_t pos = 1;
+        for (;;)
+        {
+            if (pos >= buf.size())
+            {
+                return ParseStatus::INCOMPLETE;
+            }
+            if (pos > 4)
+            {
+                return ParseStatus::MALFORMED; // Remaining length is at most four bytes
+            }
+
+            const auto byte = static_cast<uint8_t>(buf[pos++]);
+            value += (byte & 0x7FU) * multiplier;
+            multiplier *= 128;
+            if ((byte & 0x80U) == 0)
+            {
+                break;
+            }
+        }
+
+        out.header_len = pos;
+        out.remaining_len = value;
+        return (buf.size() >= pos + value) ? ParseStatus::COMPLETE : ParseStatus::INCOMPLETE;
+    }
+
+    struct Publish
+    {
+        std::string_view topic;
+        std::string_view payload;
+        uint16_t packet_id{0};
+        uint8_t qos{0};
+    };
+
+    // Decode a PUBLISH body (the bytes after the fixed header) without copying
+    inline bool parse_publish(const FixedHeader &header, std::string_view body, Publish &out)
+    {
+        if (body.size() < 2)
+        {
+            return false;
+        }
+
+        const size_t topic_len = (static_cast<uint8_t>(body[0]) << 8) | static_cast<uint8_t>(body[1]);
+        size_t pos = 2 + topic_len;
+        out.qos = (header.flags >> 1) & 0x03;
+        if (body.size() < pos + (out.qos > 0 ? 2 : 0))
+        {
+            return false;
+        }
+
+        out.topic = body.substr(2, topic_len);
+        out.packet_id = 0;
+        if (out.qos > 0)
+        {
+            out.packet_id = static_cast<uint16_t>((static_cast<uint8_t>(body[pos]) << 8) |
+                                                  static_cast<uint8_t>(body[pos + 1]));
+            pos += 2;
+        }
+        out.payload = body.substr(pos);
+        return true;
+    }
+
+    inline void append_remaining_length(std::string &out, size_t length)
+    {
+        do
+        {
+            auto byte = static_cast<uint8_t>(length % 128);
+            length /= 128;
+            if (length > 0)
+            {
+                byte |= 0x80U;
+            }
+            out.push_back(static_cast<char>(byte));
+        } while (length > 0);
+    }
+
+    inline void append_u16(std::string &out, uint16_t value)
+    {
+        out.push_back(static_cast<char>(value >> 8));
+        out.push_back(static_cast<char>(value & 0xFF));
+    }
+
+    inline void append_string(std::string &out, std::string_view value)
+    {
+        append_u16(out, static_cast<uint16_t>(value.size()));
+        out.append(value);
+    }
+
+    inline void append_connect(std::string &out, std::string_view client_id, uint16_t keepalive_s)
+    {
+        const size_t remaining = 10 + 2 + client_id.size();
+        out.push_back(static_cast<char>(static_cast<uint8_t>(PacketType::CONNECT) << 4));
+        append_remaining_length(out, remaining);
+        append_string(out, "MQTT");
+        out.push_back(4);    // Protocol level 3.1.1
+        out.push_back(0x02); // Clean session
+        append_u16(out, keepalive_s);
+        append_string(out, client_id);
+    }
+
+    inline void append_publish(std::string &out, std::string_view topic, std::string_view payload,
+                               uint8_t qos, uint16_t packet_id, bool dup = false)
+    {
+        const size_t remaining = 2 + topic.size() + (qos > 0 ? 2 : 0) + payload.size();
+        uint8_t first = static_cast<uint8_t>(PacketType::PUBLISH) << 4;
+        first |= static_cast<uint8_t>((qos & 0x03) << 1);
+        if (dup)
+        {
+            first |= 0x08;
+        }
+        out.push_back(static_cast<char>(first));
+        append_remaining_length(out, remaining);
+        append_string(out, topic);
+        if (qos > 0)
+        {
+            append_u16(out, packet_id);
+        }
+        out.append(payload);
+    }
+
+    inline void append_ack(std::string &out, PacketType type, uint16_t packet_id)
+    {
+        out.push_back(static_cast<char>(static_cast<uint8_t>(type) << 4));
+        out.push_back(2);
+        append_u16(out, packet_id);
+    }
+
+    inline void append_connack(std::string &out)
+    {
+        out.push_back(static_cast<char>(static_cast<uint8_t>(PacketType::CONNACK) << 4));
+        out.push_back(2);
+        out.push_back(0); // No session present
+        out.push_back(0); // Connection accepted
+    }
+} // namespace pooaway::ingest::mqtt
@@ -0,0 +1,167 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "json_cursor.h"
+
+namespace pooaway::ingest
+{
+    // One sensor entry of the AlertManager payload; views point into the receive buffer
+    struct SensorSample
+    {
+        uint32_t index{0};
+        std::string_view name;
+        std::string_view model;
+        bool alert{false};
+        float value{0.0F};
+        float baseline{0.0F};
+        float voltage{0.0F};
+        float rs{0.0F};
+        float r0{0.0F};
+        float ratio{0.0F};
+    };
+
+    /**
+     * @brief Decoded AlertManager document
+     *
+     * Mirrors the schema built in AlertManager::update():
+     * {"device_id", "timestamp", "sensors": [{"index", "name", "model", "alert",
+     *  "readings": {"value", "baseline", "voltage", "rs", "r0", "ratio"}, "calibration": {...}}]}
+     */
+    struct TelemetryFrame
+    {
+        static constexpr size_t MAX_SENSORS = 32; // SensorManager::MAX_CHANNELS
+
+        std::string_view device_id;
+        uint64_t timestamp{0};
+        size_t sensor_count{0};
+        std::array<SensorSample, MAX_SENSORS> sensors{};
+    };
+
+    namespace detail
+    {
+        inline bool decode_readings(JsonCursor &cursor, SensorSample &sample)
+        {
+            if (!cursor.begin_object())
+            {
+                return false;
+            }
+
+            std::string_view key;
+            while (cursor.next_key(key))
+            {
+                bool ok = true;
+                if (key == "value")
+                    ok = cursor.read_number(sample.value);
+                else if (key == "baseline")
+                    ok = cursor.read_number(sample.baseline);
+                else if (key == "voltage")
+                    ok = cursor.read_number(sample.voltage);
+                else if (key == "rs")
+                    ok = cursor.read_number(sample.rs);
+                else if (key == "r0")
+                    ok = cursor.read_number(sample.r0);
+                else if (key == "ratio")
+                    ok = cursor.read_number(sample.ratio);
+                else
+                    ok = cursor.skip_value();
+
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return cursor.ok();
+        }
+
+        inline bool decode_sensor(JsonCursor &cursor, SensorSample &sample)
+        {
+            if (!cursor.begin_object())
+            {
+                return false;
+            }
+
+            std::string_view key;
+            while (cursor.next_key(key))
+            {
+                bool ok = true;
+                if (key == "index")
+                    ok = cursor.read_number(sample.index);
+                else if (key == "name")
+                    ok = cursor.read_string(sample.name);
+                else if (key == "model")
+                    ok = cursor.read_string(sample.model);
+                else if (key == "alert")
+                    ok = cursor.read_bool(sample.alert);
+                else if (key == "readings")
+                    ok = decode_readings(cursor, sample);
+                else
+                    ok = cursor.skip_value();
+
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return cursor.ok();
+        }
+    } // namespace detail
+
+    /**
+     * @brief Decode one AlertManager payload in a single forward pass
+     * @return false on malformed JSON or when the frame exceeds MAX_SENSORS
+     */
+    inline bool decode_telemetry(std::string_view payload, TelemetryFrame &frame)
+    {
+        JsonCursor cursor(payload);
+        frame.sensor_count = 0;
+        frame.device_id = {};
+        frame.timestamp = 0;
+
+        if (!cursor.begin_object())
+        {
+            return false;
+        }
+
+        std::string_view key;
+        while (cursor.next_key(key))
+        {
+            bool ok = true;
+            if (key == "device_id")
+            {
+                ok = cursor.read_string(frame.device_id);
+            }
+            else if (key == "timestamp")
+            {
+                ok = cursor.read_number(frame.timestamp);
+            }
+            else if (key == "sensors")
+            {
+                ok = cursor.begin_array();
+                while (ok && cursor.next_element())
+                {
+                    if (frame.sensor_count >= TelemetryFrame::MAX_SENSORS)
+                    {
+                        return false;
+                    }
+                    auto &sample = frame.sensors[frame.sensor_count];
+                    sample = SensorSample{};
+                    ok = detail::decode_sensor(cursor, sample);
+                    frame.sensor_count++;
+                }
+                ok = ok && cursor.ok();
+            }
+            else
+            {
+                ok = cursor.skip_value();
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        return cursor.ok() && !frame.device_id.empty();
+    }
+} // namespace pooaway::ingest
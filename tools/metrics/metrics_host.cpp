@@ -0,0 +1,355 @@
+/**
+ * @file metrics_host.cpp
+ * @brief Serves the firmware metrics endpoint on a Linux loopback socket
+ *
+ * Runs metrics::Endpoint from include/metrics_endpoint.h, the code MetricsServer uses on the
+ * device, over POSIX sockets and fed with synthetic samples. Interactive mode serves until
+ * Ctrl+C so /metrics and /stream can be inspected with curl; --selftest drives the endpoint
+ * from a client thread and exits non-zero if any check fails.
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "metrics_endpoint.h"
+
+using namespace pooaway::metrics;
+
+namespace
+{
+    constexpr size_t RING_SIZE = 256;
+    constexpr size_t MAX_STREAMS = 2;
+    constexpr uint8_t CHANNELS = 2;
+    const char *const CHANNEL_NAMES[CHANNELS] = {"PEE", "POO"};
+
+    std::atomic<bool> g_running{true};
+
+    uint32_t now_ms()
+    {
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    // The subset of WiFiClient that Endpoint uses, over a non-blocking socket
+    class PosixClient
+    {
+    public:
+        PosixClient() = default;
+        explicit PosixClient(int fd) : m_fd(fd) {}
+
+        int available()
+        {
+            int pending = 0;
+            return (m_fd >= 0 && ioctl(m_fd, FIONREAD, &pending) == 0) ? pending : 0;
+        }
+
+        int read()
+        {
+            unsigned char c = 0;
+            return (m_fd >= 0 && recv(m_fd, &c, 1, 0) == 1) ? c : -1;
+        }
+
+        size_t write(const uint8_t *data, size_t length)
+        {
+            // Blocks like WiFiClient::write, bounded by a poll() timeout
+            size_t sent = 0;
+            while (m_fd >= 0 && sent < length)
+            {
+                const ssize_t n = send(m_fd, data + sent, length - sent, MSG_NOSIGNAL);
+                if (n > 0)
+                {
+                    sent += static_cast<size_t>(n);
+                    continue;
+                }
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    break;
+                }
+                pollfd pfd{m_fd, POLLOUT, 0};
+                if (::poll(&pfd, 1, 1000) <= 0)
+                {
+                    break;
+                }
+            }
+            return sent;
+        }
+
+        bool connected()
+        {
+            if (m_fd < 0)
+            {
+                return false;
+            }
+            char c;
+            const ssize_t n = recv(m_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+            return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        }
+
+        void stop()
+        {
+            if (m_fd >= 0)
+            {
+                shutdown(m_fd, SHUT_WR);
+                close(m_fd);
+                m_fd = -1;
+            }
+        }
+
+    private:
+        int m_fd{-1};
+    };
+
+    using HostEndpoint = Endpoint<PosixClient, RING_SIZE, MAX_STREAMS>;
+
+    SampleRing<RING_SIZE> g_ring;
+    float g_values[CHANNELS] = {5.0F, 30.0F};
+    float g_baselines[CHANNELS] = {5.0F, 30.0F};
+
+    const char *channel_name(uint8_t channel)
+    {
+        return channel < CHANNELS ? CHANNEL_NAMES[channel] : "";
+    }
+
+    void write_metrics(ChunkWriter &out)
+    {
+        char labels[64];
+        write_family(out, "sensor_value_ppm", "gauge", "Latest reading");
+        for (uint8_t i = 0; i < CHANNELS; i++)
+        {
+            std::snprintf(labels, sizeof(labels), "channel=\"%u\",sensor=\"%s\"", i, CHANNEL_NAMES[i]);
+            write_value(out, "sensor_value_ppm", labels, g_values[i]);
+        }
+        write_family(out, "sensor_baseline_ppm", "gauge", "EMA baseline");
+        for (uint8_t i = 0; i < CHANNELS; i++)
+        {
+            std::snprintf(labels, sizeof(labels), "channel=\"%u\",sensor=\"%s\"", i, CHANNEL_NAMES[i]);
+            write_value(out, "sensor_baseline_ppm", labels, g_baselines[i]);
+        }
+    }
+
+    void produce_samples(uint32_t now)
+    {
+        for (uint8_t i = 0; i < CHANNELS; i++)
+        {
+            const float clean = i == 0 ? 5.0F : 30.0F;
+            g_values[i] = clean * (1.0F + 0.05F * std::sin(static_cast<float>(now) / 2000.0F + i));
+            g_baselines[i] = 0.1F * g_values[i] + 0.9F * g_baselines[i];
+            g_ring.push(now, i, g_values[i], g_baselines[i], false);
+        }
+    }
+
+    int listen_loopback(uint16_t port)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        const int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 8) < 0)
+        {
+            std::perror("bind/listen");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Main-loop stand-in: accept, poll and produce samples at period_ms until told to stop
+    void serve(int listen_fd, HostEndpoint &endpoint, uint32_t period_ms, const std::atomic<bool> &running)
+    {
+        uint32_t last_sample = now_ms();
+        while (running)
+        {
+            const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd >= 0)
+            {
+                const int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                endpoint.accept(PosixClient(fd), now_ms());
+            }
+
+            const uint32_t now = now_ms();
+            if (now - last_sample >= period_ms)
+            {
+                last_sample = now;
+                produce_samples(now);
+            }
+            endpoint.poll(now);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Like delay(10) in loop()
+        }
+    }
+
+    // Client side of the self-test: connect and send a request without reading the reply
+    int send_request(uint16_t port, const char *request)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        timeval timeout{5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        send(fd, request, std::strlen(request), MSG_NOSIGNAL);
+        return fd;
+    }
+
+    // One request, read until the server closes or limit bytes have arrived
+    std::string http_get(uint16_t port, const char *request, size_t limit = 1 << 20)
+    {
+        const int fd = send_request(port, request);
+        if (fd < 0)
+        {
+            return "";
+        }
+
+        std::string response;
+        char buffer[1024];
+        ssize_t n;
+        while (response.size() < limit && (n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            response.append(buffer, static_cast<size_t>(n));
+        }
+        close(fd);
+        return response;
+    }
+
+    int failures = 0;
+
+    void expect(bool condition, const char *what)
+    {
+        std::printf("%s %s\n", condition ? "PASS" : "FAIL", what);
+        failures += condition ? 0 : 1;
+    }
+
+    size_t count(const std::string &text, const char *needle)
+    {
+        size_t n = 0;
+        for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        {
+            n++;
+        }
+        return n;
+    }
+
+    int self_test(uint16_t port)
+    {
+        const int listen_fd = listen_loopback(port);
+        if (listen_fd < 0)
+        {
+            return 1;
+        }
+
+        HostEndpoint endpoint(g_ring, write_metrics, channel_name, HostEndpoint::Limits{500, 15000, 16});
+        std::atomic<bool> running{true};
+        std::thread server([&]
+                           { serve(listen_fd, endpoint, 20, running); });
+
+        const auto metrics = http_get(port, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        expect(metrics.rfind("HTTP/1.0 200 OK\r\n", 0) == 0, "/metrics answers 200");
+        expect(metrics.find("text/plain; version=0.0.4") != std::string::npos, "/metrics has the exposition content type");
+        expect(count(metrics, "# TYPE pooaway_sensor_value_ppm gauge") == 1, "family header written once");
+        expect(metrics.find("pooaway_sensor_value_ppm{channel=\"1\",sensor=\"POO\"}") != std::string::npos,
+               "per-channel labelled sample");
+        expect(metrics.find("pooaway_http_requests_total") != std::string::npos, "endpoint counters appended");
+
+        const auto stream = http_get(port, "GET /stream HTTP/1.1\r\n\r\n", 4096);
+        expect(stream.find("text/event-stream") != std::string::npos, "/stream is an event stream");
+        unsigned long first = 0, second = 0;
+        const auto id = stream.find("id: ");
+        const auto next = stream.find("id: ", id + 1);
+        expect(id != std::string::npos && next != std::string::npos &&
+                   std::sscanf(stream.c_str() + id, "id: %lu", &first) == 1 &&
+                   std::sscanf(stream.c_str() + next, "id: %lu", &second) == 1 && second == first + 1,
+               "stream event ids are consecutive");
+        expect(stream.find("\"sensor\":\"PEE\"") != std::string::npos, "stream events carry the sensor name");
+
+        // Two open streams fill the slots, so a third is refused
+        const int held[] = {send_request(port, "GET /stream HTTP/1.1\r\n\r\n"),
+                            send_request(port, "GET /stream?x HTTP/1.1\r\n\r\n")};
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        expect(http_get(port, "GET /stream HTTP/1.1\r\n\r\n").rfind("HTTP/1.0 503", 0) == 0,
+               "stream beyond the client limit is 503");
+        for (const int fd : held)
+        {
+            close(fd);
+        }
+
+        expect(http_get(port, "GET /nope HTTP/1.1\r\n\r\n").rfind("HTTP/1.0 404", 0) == 0, "unknown path is 404");
+        expect(http_get(port, "POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.0 400", 0) == 0, "non-GET is 400");
+        expect(http_get(port, "GET /metrics HTTP/1.1\r\n").empty(), "incomplete request times out");
+
+        running = false;
+        server.join();
+        close(listen_fd);
+
+        const auto &stats = endpoint.get_stats();
+        std::printf("requests %u, rejected %u, streams %u, streamed %u, skipped %u\n", stats.requests, stats.rejected,
+                    stats.streams_opened, stats.samples_streamed, stats.samples_skipped);
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = 9100;
+    bool selftest = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--port") && i + 1 < argc)
+        {
+            port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        }
+        else if (!std::strcmp(argv[i], "--selftest"))
+        {
+            selftest = true;
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--port 9100] [--selftest]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (selftest)
+    {
+        return self_test(port);
+    }
+
+    const int listen_fd = listen_loopback(port);
+    if (listen_fd < 0)
+    {
+        return 1;
+    }
+    std::signal(SIGINT, [](int)
+                { g_running = false; });
+    std::printf("Serving http://127.0.0.1:%u/metrics and /stream, Ctrl+C to stop\n", port);
+
+    HostEndpoint endpoint(g_ring, write_metrics, channel_name, HostEndpoint::Limits{2000, 15000, 16});
+    serve(listen_fd, endpoint, 200, g_running);
+    close(listen_fd);
+    return 0;
+}
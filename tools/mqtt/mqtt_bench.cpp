@@ -0,0 +1,555 @@
+/**
+ * @file mqtt_bench.cpp
+ * @brief Benchmarks the firmware MQTT session against a loopback broker with a simulated RTT
+ *
+ * Runs mqtt::Session from include/mqtt_session.h, the code MqttHandler uses on the device,
+ * over a POSIX socket. The broker thread acknowledges QoS 1 publishes after --rtt-ms and can
+ * drop a share of PUBACKs to exercise retransmits. Two measurements:
+ *
+ * - throughput: acknowledged messages per second when publishing as fast as the in-flight
+ *   window allows, for several window sizes (window 1 is stop-and-wait);
+ * - cycles: one telemetry interval with two sensor payloads, sent as QoS 0, QoS 1 one frame
+ *   per sensor, or QoS 1 packed into one frame; reports frames, bytes and an estimate of how
+ *   long the radio stays on per interval.
+ *
+ * Radio-on time is a model, not a measurement: every frame written or packet received keeps
+ * the radio awake for --tail-ms after it, plus its airtime at --phy-mbps. A cycle ends when
+ * everything it sent has been acknowledged.
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mqtt_session.h"
+#include "../ingest/mqtt_codec.h"
+
+namespace codec = pooaway::ingest::mqtt;
+using pooaway::mqtt::PayloadPart;
+using pooaway::mqtt::PublishResult;
+
+namespace
+{
+    struct Options
+    {
+        uint32_t rtt_ms{30};
+        double ack_loss{0.0};
+        uint32_t messages{2000};
+        uint32_t cycles{100};
+        uint32_t tail_ms{30};
+        double phy_mbps{20.0};
+        uint32_t retransmit_ms{500};
+    };
+
+    Options g_opts;
+
+    uint64_t now_us()
+    {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    struct HostClock
+    {
+        static uint32_t now_ms() { return static_cast<uint32_t>(now_us() / 1000); }
+        static void idle() { std::this_thread::sleep_for(std::chrono::microseconds(200)); }
+    };
+
+    // Union of radio-awake intervals, fed with every frame sent or received
+    class RadioModel
+    {
+    public:
+        void activity(uint64_t at_us, size_t bytes)
+        {
+            const auto airtime_us = static_cast<uint64_t>(bytes * 8 / g_opts.phy_mbps);
+            const uint64_t until = at_us + airtime_us + g_opts.tail_ms * 1000ULL;
+            if (m_awake && at_us <= m_until_us)
+            {
+                m_until_us = std::max(m_until_us, until);
+                return;
+            }
+            close_interval();
+            m_awake = true;
+            m_from_us = at_us;
+            m_until_us = until;
+            m_wakeups++;
+        }
+
+        uint64_t on_us()
+        {
+            close_interval();
+            return m_on_us;
+        }
+        uint32_t wakeups() const { return m_wakeups; }
+
+    private:
+        void close_interval()
+        {
+            if (m_awake)
+            {
+                m_on_us += m_until_us - m_from_us;
+                m_awake = false;
+            }
+        }
+
+        bool m_awake{false};
+        uint64_t m_from_us{0};
+        uint64_t m_until_us{0};
+        uint64_t m_on_us{0};
+        uint32_t m_wakeups{0};
+    };
+
+    RadioModel *g_radio = nullptr;
+
+    // The subset of WiFiClient that mqtt::Session uses, over a loopback socket
+    class PosixClient
+    {
+    public:
+        int connect(const char *host, uint16_t port)
+        {
+            stop();
+            m_fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            inet_pton(AF_INET, host, &addr.sin_addr);
+            if (::connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+            {
+                stop();
+                return 0;
+            }
+            const int one = 1;
+            setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return 1;
+        }
+
+        size_t write(const uint8_t *data, size_t length)
+        {
+            size_t sent = 0;
+            while (m_fd >= 0 && sent < length)
+            {
+                const ssize_t n = send(m_fd, data + sent, length - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    break;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            if (g_radio && sent)
+            {
+                g_radio->activity(now_us(), sent);
+            }
+            return sent;
+        }
+
+        int available()
+        {
+            int pending = 0;
+            return (m_fd >= 0 && ioctl(m_fd, FIONREAD, &pending) == 0) ? pending : 0;
+        }
+
+        int read(uint8_t *buffer, size_t size)
+        {
+            const ssize_t n = m_fd >= 0 ? recv(m_fd, buffer, size, MSG_DONTWAIT) : -1;
+            if (g_radio && n > 0)
+            {
+                g_radio->activity(now_us(), static_cast<size_t>(n));
+            }
+            return static_cast<int>(n);
+        }
+
+        bool connected()
+        {
+            if (m_fd < 0)
+            {
+                return false;
+            }
+            char c;
+            const ssize_t n = recv(m_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+            return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        }
+
+        void stop()
+        {
+            if (m_fd >= 0)
+            {
+                close(m_fd);
+                m_fd = -1;
+            }
+        }
+
+    private:
+        int m_fd{-1};
+    };
+
+    constexpr size_t WINDOW_MAX = 16;
+    constexpr size_t FRAME_BYTES = 1536;
+    using BenchSession = pooaway::mqtt::Session<PosixClient, HostClock, WINDOW_MAX, FRAME_BYTES>;
+
+    // Broker stand-in: CONNACK, PINGRESP, and a PUBACK per QoS 1 publish held back by the RTT
+    class Broker
+    {
+    public:
+        bool start()
+        {
+            m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            const int one = 1;
+            setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(addr);
+            if (bind(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+                listen(m_listen_fd, 4) < 0 ||
+                getsockname(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), &length) < 0)
+            {
+                std::perror("broker");
+                return false;
+            }
+            m_port = ntohs(addr.sin_port);
+            m_thread = std::thread([this]
+                                   { run(); });
+            return true;
+        }
+
+        void stop()
+        {
+            m_running = false;
+            if (m_thread.joinable())
+            {
+                m_thread.join();
+            }
+            close(m_listen_fd);
+        }
+
+        uint16_t port() const { return m_port; }
+        uint64_t publishes() const { return m_publishes; }
+        uint64_t duplicates() const { return m_duplicates; }
+
+    private:
+        struct Pending
+        {
+            uint64_t due_us;
+            std::string bytes;
+        };
+
+        void run()
+        {
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            int fd = -1;
+            std::string in;
+            std::deque<Pending> out;
+
+            while (m_running)
+            {
+                if (fd < 0)
+                {
+                    pollfd pfd{m_listen_fd, POLLIN, 0};
+                    if (::poll(&pfd, 1, 10) > 0)
+                    {
+                        fd = accept(m_listen_fd, nullptr, nullptr);
+                        const int one = 1;
+                        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        in.clear();
+                        out.clear();
+                    }
+                    continue;
+                }
+
+                pollfd pfd{fd, POLLIN, 0};
+                const int timeout = out.empty() ? 5 : 0;
+                if (::poll(&pfd, 1, timeout) > 0)
+                {
+                    char buffer[4096];
+                    const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                    if (n <= 0)
+                    {
+                        close(fd);
+                        fd = -1;
+                        continue;
+                    }
+                    in.append(buffer, static_cast<size_t>(n));
+                }
+
+                size_t pos = 0;
+                for (;;)
+                {
+                    codec::FixedHeader header;
+                    if (codec::parse_fixed_header(std::string_view(in).substr(pos), header) !=
+                        codec::ParseStatus::COMPLETE)
+                    {
+                        break;
+                    }
+                    const auto body = std::string_view(in).substr(pos + header.header_len, header.remaining_len);
+                    std::string reply;
+                    if (header.type == codec::PacketType::CONNECT)
+                    {
+                        codec::append_connack(reply);
+                    }
+                    else if (header.type == codec::PacketType::PINGREQ)
+                    {
+                        reply.push_back(static_cast<char>(static_cast<uint8_t>(codec::PacketType::PINGRESP) << 4));
+                        reply.push_back(0);
+                    }
+                    else if (header.type == codec::PacketType::PUBLISH)
+                    {
+                        codec::Publish publish;
+                        if (codec::parse_publish(header, body, publish))
+                        {
+                            m_publishes++;
+                            m_duplicates += (header.flags & 0x08) ? 1 : 0;
+                            if (publish.qos == 1 && unit(rng) >= g_opts.ack_loss)
+                            {
+                                codec::append_ack(reply, codec::PacketType::PUBACK, publish.packet_id);
+                            }
+                        }
+                    }
+                    if (!reply.empty())
+                    {
+                        const uint64_t delay = header.type == codec::PacketType::PUBLISH ? g_opts.rtt_ms * 1000ULL : 0;
+                        out.push_back(Pending{now_us() + delay, reply});
+                    }
+                    pos += header.header_len + header.remaining_len;
+                }
+                in.erase(0, pos);
+
+                const uint64_t now = now_us();
+                while (!out.empty() && out.front().due_us <= now)
+                {
+                    send(fd, out.front().bytes.data(), out.front().bytes.size(), MSG_NOSIGNAL);
+                    out.pop_front();
+                }
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+
+        int m_listen_fd{-1};
+        uint16_t m_port{0};
+        std::atomic<bool> m_running{true};
+        std::atomic<uint64_t> m_publishes{0};
+        std::atomic<uint64_t> m_duplicates{0};
+        std::thread m_thread;
+    };
+
+    pooaway::mqtt::SessionConfig session_config(uint8_t window)
+    {
+        return pooaway::mqtt::SessionConfig{"bench", "", "", 60, 2000, g_opts.retransmit_ms, 5, window};
+    }
+
+    // Per-sensor message of the size MqttHandler sends without the diagnostics block
+    std::string sensor_payload(const char *name)
+    {
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer),
+                      "{\"sensor\":\"%s\",\"model\":\"GM-802B\",\"ppm\":12.75,\"baseline_ppm\":11.5,"
+                      "\"voltage\":0.8123,\"rs\":30123.4,\"r0\":41250,\"ratio\":0.730264,\"alert\":false,"
+                      "\"preheating_time\":180,\"cal_a\":102.2,\"cal_b\":-2.473}",
+                      name);
+        return buffer;
+    }
+
+    void wait_until_acked(BenchSession &session)
+    {
+        while (session.in_flight() > 0 && session.connected())
+        {
+            session.poll();
+            HostClock::idle();
+        }
+    }
+
+    void run_throughput(Broker &broker, PosixClient &client, uint8_t qos, uint8_t window)
+    {
+        BenchSession session(client, session_config(window));
+        if (!session.connect("127.0.0.1", broker.port()))
+        {
+            std::fprintf(stderr, "connect failed\n");
+            return;
+        }
+        const std::string payload = sensor_payload("PEE");
+
+        const uint64_t start = now_us();
+        for (uint32_t i = 0; i < g_opts.messages;)
+        {
+            const auto result = session.publish("bench/sensors/pee", payload.data(), payload.size(), qos);
+            if (result == PublishResult::SENT || result == PublishResult::IN_FLIGHT)
+            {
+                i++;
+            }
+            else if (result != PublishResult::WINDOW_FULL)
+            {
+                std::fprintf(stderr, "publish failed (%d)\n", static_cast<int>(result));
+                return;
+            }
+            session.poll();
+            if (result == PublishResult::WINDOW_FULL)
+            {
+                HostClock::idle();
+            }
+        }
+        wait_until_acked(session);
+        const double seconds = (now_us() - start) / 1e6;
+
+        const auto &stats = session.get_stats();
+        const uint32_t delivered = qos ? stats.acked : stats.published;
+        std::printf("%-5s %6u %8u %10.0f %10u %8u %8u %10.1f\n", qos ? "qos1" : "qos0", qos ? window : 0, delivered,
+                    delivered / seconds, stats.retransmits, stats.expired, stats.max_in_flight,
+                    stats.acked ? static_cast<double>(stats.total_rtt_ms) / stats.acked : 0.0);
+        session.disconnect();
+    }
+
+    enum class CycleMode
+    {
+        QOS0_PER_SENSOR,
+        QOS1_PER_SENSOR,
+        QOS1_STOP_AND_WAIT, // Per sensor, waiting for each PUBACK before the next publish
+        QOS1_PACKED
+    };
+
+    void run_cycles(Broker &broker, PosixClient &client, CycleMode mode)
+    {
+        const uint8_t window = (mode == CycleMode::QOS1_STOP_AND_WAIT) ? 1 : 4;
+        BenchSession session(client, session_config(window));
+        if (!session.connect("127.0.0.1", broker.port()))
+        {
+            std::fprintf(stderr, "connect failed\n");
+            return;
+        }
+
+        const std::string payloads[] = {sensor_payload("PEE"), sensor_payload("POO")};
+        const uint8_t qos = (mode == CycleMode::QOS0_PER_SENSOR) ? 0 : 1;
+        const auto before = session.get_stats();
+
+        RadioModel radio;
+        g_radio = &radio;
+        uint64_t busy_us = 0;
+        for (uint32_t cycle = 0; cycle < g_opts.cycles; cycle++)
+        {
+            const uint64_t start = now_us();
+            if (mode == CycleMode::QOS1_PACKED)
+            {
+                const PayloadPart parts[] = {{"[", 1},
+                                             {payloads[0].data(), payloads[0].size()},
+                                             {",", 1},
+                                             {payloads[1].data(), payloads[1].size()},
+                                             {"]", 1}};
+                session.publish("bench/sensors", parts, 5, qos);
+            }
+            else
+            {
+                for (const auto &payload : payloads)
+                {
+                    session.publish("bench/sensors/x", payload.data(), payload.size(), qos);
+                    if (mode == CycleMode::QOS1_STOP_AND_WAIT)
+                    {
+                        wait_until_acked(session);
+                    }
+                }
+            }
+            wait_until_acked(session);
+            busy_us += now_us() - start;
+
+            // Idle gap between intervals, longer than the radio tail so cycles do not merge
+            std::this_thread::sleep_for(std::chrono::milliseconds(g_opts.tail_ms + 20));
+        }
+        g_radio = nullptr;
+
+        const auto &after = session.get_stats();
+        const double n = g_opts.cycles;
+        const char *names[] = {"qos0 per-sensor", "qos1 per-sensor", "qos1 stop-and-wait", "qos1 packed"};
+        std::printf("%-19s %8.2f %8.0f %10.2f %12.2f %10.2f\n", names[static_cast<int>(mode)],
+                    (after.frames_written - before.frames_written) / n, (after.bytes_written - before.bytes_written) / n,
+                    radio.wakeups() / n, radio.on_us() / n / 1000.0, busy_us / n / 1000.0);
+        session.disconnect();
+    }
+
+    bool parse(int argc, char **argv)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char *arg = argv[i];
+            const char *value = argv[i + 1];
+            if (std::strcmp(arg, "--rtt-ms") == 0)
+                g_opts.rtt_ms = static_cast<uint32_t>(std::atoi(value));
+            else if (std::strcmp(arg, "--ack-loss") == 0)
+                g_opts.ack_loss = std::atof(value);
+            else if (std::strcmp(arg, "--messages") == 0)
+                g_opts.messages = static_cast<uint32_t>(std::atoi(value));
+            else if (std::strcmp(arg, "--cycles") == 0)
+                g_opts.cycles = static_cast<uint32_t>(std::atoi(value));
+            else if (std::strcmp(arg, "--tail-ms") == 0)
+                g_opts.tail_ms = static_cast<uint32_t>(std::atoi(value));
+            else if (std::strcmp(arg, "--phy-mbps") == 0)
+                g_opts.phy_mbps = std::atof(value);
+            else if (std::strcmp(arg, "--retransmit-ms") == 0)
+                g_opts.retransmit_ms = static_cast<uint32_t>(std::atoi(value));
+            else
+                return false;
+        }
+        return (argc % 2) == 1 && g_opts.phy_mbps > 0 && g_opts.cycles > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse(argc, argv))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--rtt-ms 30] [--ack-loss 0] [--messages 2000] [--cycles 100]\n"
+                     "          [--tail-ms 30] [--phy-mbps 20] [--retransmit-ms 500]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    Broker broker;
+    if (!broker.start())
+    {
+        return 1;
+    }
+    PosixClient client;
+
+    std::printf("Broker RTT %u ms, PUBACK loss %.1f%%, radio tail %u ms at %.0f Mbit/s\n\n", g_opts.rtt_ms,
+                g_opts.ack_loss * 100, g_opts.tail_ms, g_opts.phy_mbps);
+
+    std::printf("Throughput, %u messages of %zu bytes\n", g_opts.messages, sensor_payload("PEE").size());
+    std::printf("%-5s %6s %8s %10s %10s %8s %8s %10s\n", "qos", "window", "acked", "msgs/s", "retransmit", "expired",
+                "max_fly", "rtt_ms");
+    run_throughput(broker, client, 0, 1);
+    for (const uint8_t window : {1, 2, 4, 8, 16})
+    {
+        run_throughput(broker, client, 1, window);
+    }
+
+    std::printf("\nTelemetry intervals, 2 sensors, %u cycles; per-cycle means\n", g_opts.cycles);
+    std::printf("%-19s %8s %8s %10s %12s %10s\n", "mode", "frames", "bytes", "wakeups", "radio_on_ms", "busy_ms");
+    for (const auto mode : {CycleMode::QOS0_PER_SENSOR, CycleMode::QOS1_PER_SENSOR, CycleMode::QOS1_STOP_AND_WAIT,
+                            CycleMode::QOS1_PACKED})
+    {
+        run_cycles(broker, client, mode);
+    }
+
+    std::printf("\nbroker saw %llu publishes, %llu marked DUP\n", static_cast<unsigned long long>(broker.publishes()),
+                static_cast<unsigned long long>(broker.duplicates()));
+    broker.stop();
+    return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file pattern_check.cpp
+ * @brief Checks that the LEDC and RMT programs behind the alert LED and buzzer play on time
+ *
+ * The firmware compiles each LedPattern and TonePattern (include/pattern_engine.h) into
+ * peripheral settings once per alert state change, and the peripherals play them from there.
+ * This host mock stands in for the peripherals: it checks the settings against the ESP32-C6
+ * limits, renders the output the hardware would produce, and measures blink periods, lit
+ * time, fade length and beep timing from the rendered waveform. Exits with 1 on any mismatch.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "pattern_engine.h"
+
+using namespace pooaway::pattern;
+
+namespace
+{
+    constexpr uint32_t XTAL_HZ = 40000000;   // The other LEDC clock source the driver may pick
+    constexpr uint32_t STEP_US = 10;         // Render resolution
+    constexpr uint32_t RMT_SOURCE_HZ = 80000000;
+
+    int g_failures = 0;
+
+    void report(const char *name, const char *what, double expected, double measured, double tolerance)
+    {
+        const bool ok = measured >= expected - tolerance && measured <= expected + tolerance;
+        std::printf("%-22s %-16s %10.1f %10.1f  %s\n", name, what, expected, measured, ok ? "ok" : "FAIL");
+        g_failures += ok ? 0 : 1;
+    }
+
+    void fail(const char *name, const char *why)
+    {
+        std::printf("%-22s %s  FAIL\n", name, why);
+        g_failures++;
+    }
+
+    // LEDC timer: counter of 2^bits ticks per period, fed from the source through the divider
+    bool timer_in_range(const LedProgram &program, uint32_t source_hz)
+    {
+        const double divider = static_cast<double>(source_hz) /
+                               (static_cast<double>(program.frequency_hz) * (1ULL << program.resolution_bits));
+        return divider >= 1.0 && divider <= LEDC_MAX_DIVIDER + 255.0 / 256.0;
+    }
+
+    // Output of an LEDC channel, as the share of full brightness at time t
+    double ledc_level(const LedProgram &program, uint64_t t_us)
+    {
+        const double full = static_cast<double>(1ULL << program.resolution_bits);
+        if (program.fade_from != program.duty && t_us < program.fade_ms * 1000ULL)
+        {
+            const double progress = static_cast<double>(t_us) / (program.fade_ms * 1000.0);
+            return (program.fade_from + (static_cast<double>(program.duty) - program.fade_from) * progress) / full;
+        }
+        if (program.frequency_hz >= LEDC_FADE_HZ)
+        {
+            return program.duty / full; // Averaged by the eye
+        }
+        const uint64_t period_us = 1000000ULL / program.frequency_hz;
+        const uint64_t lit_us = static_cast<uint64_t>(period_us * (program.duty / full));
+        return (t_us % period_us) < lit_us ? 1.0 : 0.0;
+    }
+
+    void check_blink(const char *name, const LedPattern &pattern)
+    {
+        LedProgram program;
+        if (!compile(pattern, LedPattern{}, program))
+        {
+            fail(name, "does not compile");
+            return;
+        }
+        if (!timer_in_range(program, LEDC_SOURCE_HZ) || !timer_in_range(program, XTAL_HZ))
+        {
+            fail(name, "LEDC divider out of range");
+            return;
+        }
+
+        // Rising edges over five periods give the period, the lit samples the on time
+        std::vector<uint64_t> rises;
+        uint64_t lit_us = 0;
+        double last = 0.0;
+        const uint64_t horizon_us = 5ULL * pattern.period_ms * 1000;
+        for (uint64_t t = 0; t < horizon_us; t += STEP_US)
+        {
+            const double level = ledc_level(program, t);
+            if (level > 0.5 && last <= 0.5)
+            {
+                rises.push_back(t);
+            }
+            lit_us += level > 0.5 ? STEP_US : 0;
+            last = level;
+        }
+        if (rises.size() < 2)
+        {
+            fail(name, "does not blink");
+            return;
+        }
+        const double period_ms = static_cast<double>(rises.back() - rises.front()) / (rises.size() - 1) / 1000.0;
+        report(name, "period ms", pattern.period_ms, period_ms, 0.01);
+        report(name, "lit ms/period", pattern.period_ms * pattern.on_percent / 100.0,
+               lit_us / 1000.0 / (horizon_us / 1000.0 / pattern.period_ms), 0.05);
+    }
+
+    void check_fade(const char *name, const LedPattern &pattern, const LedPattern &previous)
+    {
+        LedProgram program;
+        if (!compile(pattern, previous, program))
+        {
+            fail(name, "does not compile");
+            return;
+        }
+        if (!timer_in_range(program, LEDC_SOURCE_HZ) || !timer_in_range(program, XTAL_HZ))
+        {
+            fail(name, "LEDC divider out of range");
+            return;
+        }
+
+        uint64_t dark_at_us = 0;
+        for (uint64_t t = 0; t < 2ULL * pattern.fade_ms * 1000 + STEP_US; t += STEP_US)
+        {
+            if (ledc_level(program, t) <= 0.001)
+            {
+                dark_at_us = t;
+                break;
+            }
+        }
+        report(name, "start level %", previous.mode == LedMode::BLINK ? 100.0 : 0.0, ledc_level(program, 0) * 100.0, 0.1);
+        report(name, "dark after ms", previous.mode == LedMode::BLINK ? pattern.fade_ms : 0.0, dark_at_us / 1000.0, 1.0);
+    }
+
+    using Runs = std::vector<std::pair<bool, uint64_t>>;
+
+    void add_run(Runs &runs, bool level, uint64_t us)
+    {
+        if (us == 0)
+        {
+            return;
+        }
+        if (!runs.empty() && runs.back().first == level)
+        {
+            runs.back().second += us;
+        }
+        else
+        {
+            runs.emplace_back(level, us);
+        }
+    }
+
+    // Gate of an RMT channel looping over its symbols, as (level, duration) runs
+    bool rmt_runs(const char *name, const ToneProgram &program, size_t loops, Runs &runs)
+    {
+        if (program.symbol_count > RMT_MAX_SYMBOLS)
+        {
+            fail(name, "too many RMT symbols");
+            return false;
+        }
+        for (size_t loop = 0; loop < loops; loop++)
+        {
+            for (size_t i = 0; i < program.symbol_count; i++)
+            {
+                const RmtSymbol symbol = program.symbols[i];
+                if (symbol.duration0() == 0 || symbol.duration1() == 0)
+                {
+                    fail(name, "zero duration would end the loop early");
+                    return false;
+                }
+                add_run(runs, symbol.level0(), symbol.duration0() * 1000000ULL / RMT_TICK_HZ);
+                add_run(runs, symbol.level1(), symbol.duration1() * 1000000ULL / RMT_TICK_HZ);
+            }
+        }
+        return true;
+    }
+
+    void check_tone(const char *name, const TonePattern &pattern)
+    {
+        ToneProgram program;
+        if (!compile(pattern, program))
+        {
+            fail(name, "does not compile");
+            return;
+        }
+
+        // The carrier splits each period into high and low counts of the source clock
+        const uint32_t half_period = RMT_SOURCE_HZ / (2 * program.carrier_hz);
+        if (half_period == 0 || half_period > UINT16_MAX)
+        {
+            fail(name, "carrier out of range");
+            return;
+        }
+        report(name, "pitch Hz", pattern.frequency_hz, RMT_SOURCE_HZ / (2.0 * half_period), pattern.frequency_hz * 0.001);
+
+        // Over three loops the runs must repeat the steps exactly, silence included
+        constexpr size_t LOOPS = 3;
+        Runs runs;
+        if (!rmt_runs(name, program, LOOPS, runs))
+        {
+            return;
+        }
+        Runs expected;
+        uint64_t loop_us = 0;
+        for (size_t loop = 0; loop < LOOPS; loop++)
+        {
+            for (size_t i = 0; i < pattern.step_count; i++)
+            {
+                add_run(expected, true, pattern.steps[i].on_ms * 1000ULL);
+                add_run(expected, false, pattern.steps[i].off_ms * 1000ULL);
+            }
+        }
+        for (const auto &run : runs)
+        {
+            loop_us += run.second;
+        }
+        if (runs != expected)
+        {
+            fail(name, "beep timing differs from the pattern");
+            return;
+        }
+
+        uint64_t beep_us = 0;
+        size_t beeps = 0;
+        for (const auto &run : runs)
+        {
+            beep_us += run.first ? run.second : 0;
+            beeps += run.first ? 1 : 0;
+        }
+        uint64_t pattern_beep_us = 0;
+        uint64_t pattern_loop_us = 0;
+        for (size_t i = 0; i < pattern.step_count; i++)
+        {
+            pattern_beep_us += pattern.steps[i].on_ms * 1000ULL;
+            pattern_loop_us += (pattern.steps[i].on_ms + pattern.steps[i].off_ms) * 1000ULL;
+        }
+        report(name, "loop ms", pattern_loop_us / 1000.0, loop_us / 1000.0 / LOOPS, 0.0);
+        report(name, "sounding ms/loop", pattern_beep_us / 1000.0, beep_us / 1000.0 / LOOPS, 0.0);
+        std::printf("%-22s %-16s %10s %10zu  (%zu beeps over %zu loops)\n", name, "RMT symbols", "",
+                    program.symbol_count, beeps, LOOPS);
+    }
+
+    void check_rejected(const char *name, bool compiled)
+    {
+        std::printf("%-22s %-16s %10s %10s  %s\n", name, "rejected", "yes", compiled ? "no" : "yes", compiled ? "FAIL" : "ok");
+        g_failures += compiled ? 1 : 0;
+    }
+}
+
+int main()
+{
+    std::printf("%-22s %-16s %10s %10s\n", "pattern", "check", "expected", "measured");
+
+    // The patterns the firmware plays
+    check_blink("LED_ALERT", LED_ALERT);
+    check_blink("LED_MULTI_ALERT", LED_MULTI_ALERT);
+    check_fade("LED_CLEAR after blink", LED_CLEAR, LED_ALERT);
+    check_fade("LED_CLEAR at boot", LED_CLEAR, LedPattern{});
+    check_tone("alert_tone(0)", alert_tone(0));
+    check_tone("alert_tone(1)", alert_tone(1));
+
+    // Long segments are split across symbols, odd half counts padded by a split
+    check_tone("long pause", TonePattern{2400, 1, {{50, 3000}}});
+    check_tone("odd halves", TonePattern{3000, 3, {{33, 0}, {0, 65}, {40, 40}}});
+    check_blink("1 Hz, 10% lit", LedPattern{LedMode::BLINK, 1000, 10, 0});
+
+    // What the peripherals cannot play is refused instead of played wrong
+    LedProgram led;
+    check_rejected("blink 300 ms", compile(LedPattern{LedMode::BLINK, 300, 50, 0}, LedPattern{}, led));
+    ToneProgram tone;
+    check_rejected("tone too long", compile(TonePattern{2000, 4, {{9000, 9000}, {9000, 9000}, {9000, 9000}, {9000, 9000}}}, tone));
+
+    std::printf("\n%s\n", g_failures == 0 ? "all patterns play on time" : "pattern timing FAILED");
+    return g_failures == 0 ? 0 : 1;
+}
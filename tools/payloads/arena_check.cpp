@@ -0,0 +1,232 @@
+/**
+ * @file arena_check.cpp
+ * @brief Checks the JsonArena allocator behind the telemetry and scratch documents
+ *
+ * Runs src/json_arena.cpp on the host against arenas over local buffers: the newest block
+ * grows in place, an older block is moved with its contents, freeing the newest block gives
+ * its space back, freeing the last live block empties the arena, and an allocation that does
+ * not fit goes to the heap and is counted. Finally a telemetry-shaped JsonDocument is built,
+ * serialized and dropped on an arena, which must give the same bytes as a heap document and
+ * leave the arena empty. Exits with 1 if any check fails.
+ */
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "esp_log.h"
+#include "json_arena.h"
+
+using pooaway::JsonArena;
+
+// esp_log.h from the soak shim, so the arena's overflow warning stays visible
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    std::printf("  %s %s: ", level == ESP_LOG_WARN ? "W" : "I", tag);
+    va_list args;
+    va_start(args, format);
+    std::vprintf(format, args);
+    va_end(args);
+    std::printf("\n");
+}
+
+uint32_t esp_log_timestamp(void) { return 0; }
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(const char *name, bool ok)
+    {
+        std::printf("%-52s %s\n", name, ok ? "ok" : "FAIL");
+        g_failures += ok ? 0 : 1;
+    }
+
+    // Header plus payload rounded up to 8, as the arena lays blocks out
+    constexpr size_t footprint(size_t size) { return 8 + ((size + 7) & ~size_t{7}); }
+
+    bool owned(const JsonArena &arena, const uint8_t *storage, const void *pointer)
+    {
+        const auto *p = static_cast<const uint8_t *>(pointer);
+        return p >= storage && p < storage + arena.get_stats().capacity;
+    }
+
+    void check_growth()
+    {
+        alignas(8) uint8_t storage[256];
+        JsonArena arena("growth", storage, sizeof(storage));
+
+        void *block = arena.allocate(16);
+        std::memset(block, 0x5a, 16);
+        void *grown = arena.reallocate(block, 64);
+        check("newest block grows in place", grown == block && arena.get_used() == footprint(64));
+
+        bool kept = true;
+        for (size_t i = 0; i < 16; i++)
+        {
+            kept = kept && static_cast<uint8_t *>(grown)[i] == 0x5a;
+        }
+        check("growth keeps the contents", kept);
+
+        void *shrunk = arena.reallocate(grown, 24);
+        check("newest block shrinks in place", shrunk == block && arena.get_used() == footprint(24));
+        arena.deallocate(shrunk);
+    }
+
+    void check_move()
+    {
+        alignas(8) uint8_t storage[256];
+        JsonArena arena("move", storage, sizeof(storage));
+
+        void *older = arena.allocate(16);
+        void *newer = arena.allocate(16);
+        for (size_t i = 0; i < 16; i++)
+        {
+            static_cast<uint8_t *>(older)[i] = static_cast<uint8_t>(i);
+        }
+
+        void *moved = arena.reallocate(older, 48);
+        bool kept = moved != older && owned(arena, storage, moved);
+        for (size_t i = 0; kept && i < 16; i++)
+        {
+            kept = static_cast<uint8_t *>(moved)[i] == i;
+        }
+        check("older block is moved with its contents", kept);
+        check("moved block is placed after the newest",
+              arena.get_used() == 2 * footprint(16) + footprint(48));
+
+        arena.deallocate(newer);
+        arena.deallocate(moved);
+        check("arena is empty after the move", arena.get_used() == 0);
+    }
+
+    void check_lifo()
+    {
+        alignas(8) uint8_t storage[256];
+        JsonArena arena("lifo", storage, sizeof(storage));
+
+        void *first = arena.allocate(16);
+        void *second = arena.allocate(32);
+        arena.deallocate(second);
+        check("freeing the newest block gives its space back", arena.get_used() == footprint(16));
+
+        void *again = arena.allocate(8);
+        check("the freed space is handed out again", again == second);
+
+        // Only the newest block is tracked: freeing an older one leaves the space in use
+        void *third = arena.allocate(8);
+        arena.deallocate(again);
+        check("freeing an older block keeps the space", arena.get_used() == footprint(16) + 2 * footprint(8));
+
+        arena.deallocate(first);
+        arena.deallocate(third);
+    }
+
+    void check_reset()
+    {
+        alignas(8) uint8_t storage[256];
+        JsonArena arena("reset", storage, sizeof(storage));
+
+        void *a = arena.allocate(40);
+        void *b = arena.allocate(40);
+        void *c = arena.allocate(40);
+        arena.deallocate(a);
+        arena.deallocate(c);
+        arena.deallocate(b);
+        check("freeing the last live block empties the arena",
+              arena.get_used() == 0 && arena.get_stats().resets == 1);
+        check("peak keeps the high-water mark", arena.get_stats().peak_used == 3 * footprint(40));
+        check("the next block starts at the beginning", arena.allocate(8) == storage + 8);
+    }
+
+    void check_heap_fallback()
+    {
+        alignas(8) uint8_t storage[64];
+        JsonArena arena("fallback", storage, sizeof(storage));
+
+        void *inside = arena.allocate(16);
+        void *outside = arena.allocate(100);
+        check("an oversized block comes from the heap",
+              outside && !owned(arena, storage, outside) && arena.get_stats().heap_fallbacks == 1);
+        check("the heap block leaves the arena untouched", arena.get_used() == footprint(16));
+
+        std::memset(outside, 0x33, 100);
+        void *grown = arena.reallocate(outside, 200);
+        check("a heap block is reallocated on the heap",
+              grown && !owned(arena, storage, grown) && static_cast<uint8_t *>(grown)[99] == 0x33);
+        arena.deallocate(grown);
+
+        std::memset(inside, 0x44, 16);
+        void *spilled = arena.reallocate(inside, 128);
+        check("a block that outgrows the arena spills to the heap",
+              spilled && !owned(arena, storage, spilled) && static_cast<uint8_t *>(spilled)[15] == 0x44 &&
+                  arena.get_stats().heap_fallbacks == 2 && arena.get_used() == 0);
+        arena.deallocate(spilled);
+    }
+
+    // The shape AlertManager builds once per interval
+    void build_telemetry(JsonDocument &doc, int cycle)
+    {
+        doc["timestamp"] = 1760000000 + cycle;
+        doc["alert_mask"] = cycle & 3;
+        JsonArray sensors = doc["sensors"].to<JsonArray>();
+        static const char *const NAMES[] = {"PEE", "POO"};
+        for (int i = 0; i < 2; i++)
+        {
+            JsonObject sensor = sensors.add<JsonObject>();
+            sensor["sensor"] = NAMES[i];
+            sensor["ppm"] = 100.0f + cycle * 0.25f + i;
+            sensor["baseline_ppm"] = 98.5f + i;
+            sensor["alert"] = ((cycle >> i) & 1) != 0;
+        }
+    }
+
+    void check_document()
+    {
+        alignas(8) static uint8_t storage[8192];
+        JsonArena arena("document", storage, sizeof(storage));
+
+        bool same = true;
+        bool emptied = true;
+        for (int cycle = 0; cycle < 100; cycle++)
+        {
+            { // Both documents are destroyed at the end of the cycle, as in AlertManager
+                JsonDocument on_arena(&arena);
+                JsonDocument on_heap;
+                build_telemetry(on_arena, cycle);
+                build_telemetry(on_heap, cycle);
+
+                char arena_bytes[512];
+                char heap_bytes[512];
+                const size_t arena_length = serializeJson(on_arena, arena_bytes);
+                const size_t heap_length = serializeJson(on_heap, heap_bytes);
+                same = same && arena_length > 0 && arena_length == heap_length &&
+                       std::memcmp(arena_bytes, heap_bytes, arena_length) == 0;
+            }
+            emptied = emptied && arena.get_used() == 0;
+        }
+        check("arena documents serialize like heap documents", same);
+        check("each dropped document empties the arena", emptied && arena.get_stats().resets >= 100);
+        check("documents never touch the heap", arena.get_stats().heap_fallbacks == 0);
+        std::printf("%-52s %zu of %zu bytes\n", "document peak", arena.get_stats().peak_used,
+                    arena.get_stats().capacity);
+    }
+}
+
+int main()
+{
+    check_growth();
+    check_move();
+    check_lifo();
+    check_reset();
+    check_heap_fallback();
+    check_document();
+
+    if (g_failures > 0)
+    {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file payload_bench.cpp
+ * @brief Measures serialization work per telemetry cycle with 1, 2 and 4 data publishers
+ *
+ * Builds the deferred telemetry document the way AlertManager does and runs the publishers'
+ * encoding step against it in two modes. "per-publisher" is the old path: every publisher
+ * builds its own payload document from the telemetry and serializes it into its own buffer.
+ * "shared" goes through PayloadCache (include/payload_cache.h), the code the firmware runs:
+ * each format is serialized once and the publishers only add their framing. Both modes must
+ * produce the same bytes; the bench checks that before timing anything.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "payload_cache.h"
+
+using namespace pooaway::alert;
+
+namespace
+{
+    constexpr size_t SENSORS = 2;
+    constexpr const char *NAMES[SENSORS] = {"PEE", "POO"};
+    constexpr const char *MODELS[SENSORS] = {"MQ137", "MQ4"};
+    constexpr const char *API_KEY = "ABCDEFGHIJKLMNOP";
+    constexpr const char *CREATED_AT = "2026-10-18 12:00:00";
+
+    enum class Publisher
+    {
+        MQTT,      // SENSOR_JSON per sensor, published as is
+        THINGSPEAK // THINGSPEAK_UPDATE per sensor, wrapped in the bulk_update envelope
+    };
+
+    struct CycleCost
+    {
+        uint64_t serialized_bytes{0}; // Bytes written by serializeJson
+        uint64_t framed_bytes{0};     // Bytes copied into a publisher's own envelope
+        uint64_t documents{0};        // Intermediate payload documents built
+    };
+
+    // Counts what the intermediate documents cost; backed by malloc
+    class CountingAllocator : public ArduinoJson::Allocator
+    {
+    public:
+        void *allocate(size_t size) override
+        {
+            m_allocations++;
+            m_bytes += size;
+            return std::malloc(size);
+        }
+        void deallocate(void *pointer) override { std::free(pointer); }
+        void *reallocate(void *pointer, size_t new_size) override
+        {
+            m_allocations++;
+            m_bytes += new_size;
+            return std::realloc(pointer, new_size);
+        }
+
+        uint64_t allocations() const { return m_allocations; }
+        uint64_t bytes() const { return m_bytes; }
+        void reset()
+        {
+            m_allocations = 0;
+            m_bytes = 0;
+        }
+
+    private:
+        uint64_t m_allocations{0};
+        uint64_t m_bytes{0};
+    };
+
+    CountingAllocator g_allocator;
+    volatile size_t g_sink; // Stands in for the transport, so the payload bytes are consumed
+
+    void consume(const char *data, size_t length)
+    {
+        g_sink = g_sink + length + static_cast<unsigned char>(data[length / 2]);
+    }
+
+    // Same shape as AlertManager::build_telemetry()
+    void build_telemetry(JsonDocument &doc, uint32_t cycle, bool with_diagnostics)
+    {
+        doc.clear();
+        doc["device_id"] = "40:4C:CA:00:00:01";
+        doc["timestamp"] = cycle * 1000UL;
+        doc["transition"] = false;
+        auto sensors = doc["sensors"].to<JsonArray>();
+        for (size_t i = 0; i < SENSORS; i++)
+        {
+            const float wobble = static_cast<float>(cycle % 97) * 0.013F;
+            auto sensor = sensors.add<JsonObject>();
+            sensor["index"] = i;
+            sensor["name"] = NAMES[i];
+            sensor["model"] = MODELS[i];
+            sensor["alert"] = (cycle % 50) == i;
+
+            auto readings = sensor["readings"].to<JsonObject>();
+            readings["value"] = 12.75F + wobble + i;
+            readings["baseline"] = 11.5F + i;
+            readings["voltage"] = 0.8123F + wobble / 10;
+            readings["rs"] = 30123.4F - wobble * 100;
+            readings["r0"] = 41250.0F;
+            readings["ratio"] = (30123.4F - wobble * 100) / 41250.0F;
+
+            auto calibration = sensor["calibration"].to<JsonObject>();
+            calibration["preheating_time"] = 180;
+            calibration["a"] = 102.2F;
+            calibration["b"] = -2.473F;
+
+            if (with_diagnostics)
+            {
+                auto diagnostics = sensor["diagnostics"].to<JsonObject>();
+                diagnostics["healthy"] = true;
+                diagnostics["reads"] = 864000U + cycle;
+                diagnostics["errors"] = 12U;
+                diagnostics["error_rate"] = 0.0012F;
+                diagnostics["mean"] = 12.9F;
+                diagnostics["stddev"] = 0.731F;
+                diagnostics["min"] = 9.2F;
+                diagnostics["max"] = 48.6F;
+                diagnostics["alerts"] = 31U;
+                diagnostics["calibrations"] = 1U;
+                diagnostics["voltage_jumps"] = 4U;
+                diagnostics["active_s"] = 86400U;
+            }
+        }
+    }
+
+    // The pre-PayloadCache publishers: a payload document and a serialization per publisher
+    void publish_per_publisher(const JsonDocument &telemetry, Publisher publisher, CycleCost &cost,
+                               std::vector<std::string> *out = nullptr)
+    {
+        const auto sensors = telemetry["sensors"].as<JsonArrayConst>();
+        for (JsonObjectConst sensor : sensors)
+        {
+            JsonDocument doc(&g_allocator);
+            char buffer[1024];
+            if (publisher == Publisher::MQTT)
+            {
+                PayloadCache::build_sensor_json(sensor, doc.to<JsonObject>());
+            }
+            else
+            {
+                doc["write_api_key"] = API_KEY;
+                PayloadCache::build_thingspeak_update(sensor, CREATED_AT,
+                                                      doc["updates"].to<JsonArray>().add<JsonObject>());
+            }
+            const size_t n = serializeJson(doc, buffer, sizeof(buffer));
+            cost.documents++;
+            cost.serialized_bytes += n;
+            consume(buffer, n);
+            if (out)
+            {
+                out->emplace_back(buffer, n);
+            }
+        }
+    }
+
+    void publish_shared(PayloadCache &payloads, Publisher publisher, CycleCost &cost,
+                        std::vector<std::string> *out = nullptr)
+    {
+        for (size_t i = 0; i < payloads.sensor_count(); i++)
+        {
+            if (publisher == Publisher::MQTT)
+            {
+                const PayloadView payload = payloads.get(PayloadFormat::SENSOR_JSON, i);
+                consume(payload.data, payload.length);
+                if (out)
+                {
+                    out->emplace_back(payload.data, payload.length);
+                }
+                continue;
+            }
+
+            // Same envelope ApiHandler::send_sensor_data() puts around the shared update
+            const PayloadView update = payloads.get(PayloadFormat::THINGSPEAK_UPDATE, i);
+            char buffer[512];
+            const int n = std::snprintf(buffer, sizeof(buffer), "{\"write_api_key\":\"%s\",\"updates\":[%.*s]}", API_KEY,
+                                        static_cast<int>(update.length), update.data);
+            cost.framed_bytes += static_cast<size_t>(n);
+            consume(buffer, static_cast<size_t>(n));
+            if (out)
+            {
+                out->emplace_back(buffer, static_cast<size_t>(n));
+            }
+        }
+    }
+
+    std::vector<Publisher> make_publishers(size_t count, bool mixed)
+    {
+        std::vector<Publisher> publishers;
+        for (size_t i = 0; i < count; i++)
+        {
+            publishers.push_back((mixed && (i % 2)) ? Publisher::THINGSPEAK : Publisher::MQTT);
+        }
+        return publishers;
+    }
+
+    bool outputs_match(JsonDocument &telemetry, PayloadCache &payloads)
+    {
+        for (const bool with_diagnostics : {false, true})
+        {
+            build_telemetry(telemetry, 7, with_diagnostics);
+            payloads.reset(telemetry, CREATED_AT);
+            for (const Publisher publisher : {Publisher::MQTT, Publisher::THINGSPEAK})
+            {
+                CycleCost ignored;
+                std::vector<std::string> expected, actual;
+                publish_per_publisher(telemetry, publisher, ignored, &expected);
+                publish_shared(payloads, publisher, ignored, &actual);
+                if (expected != actual)
+                {
+                    std::fprintf(stderr, "Payload mismatch (%s, diagnostics %d):\n  %s\n  %s\n",
+                                 publisher == Publisher::MQTT ? "mqtt" : "thingspeak", with_diagnostics,
+                                 expected.empty() ? "" : expected.front().c_str(),
+                                 actual.empty() ? "" : actual.front().c_str());
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void run(JsonDocument &telemetry, PayloadCache &payloads, size_t publisher_count, bool mixed, bool shared,
+             uint32_t cycles, uint32_t diagnostics_every)
+    {
+        const auto publishers = make_publishers(publisher_count, mixed);
+        CycleCost cost;
+        const PayloadCache::Stats before = payloads.get_stats();
+        g_allocator.reset();
+        uint64_t total_ns = 0;
+
+        for (uint32_t cycle = 0; cycle < cycles; cycle++)
+        {
+            // The telemetry document is built once per cycle in both modes, so it is not timed
+            build_telemetry(telemetry, cycle, diagnostics_every && (cycle % diagnostics_every) == 0);
+
+            const auto start = std::chrono::steady_clock::now();
+            if (shared)
+            {
+                payloads.reset(telemetry, CREATED_AT);
+                for (const Publisher publisher : publishers)
+                {
+                    publish_shared(payloads, publisher, cost);
+                }
+            }
+            else
+            {
+                for (const Publisher publisher : publishers)
+                {
+                    publish_per_publisher(telemetry, publisher, cost);
+                }
+            }
+            total_ns += static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        if (shared)
+        {
+            const auto &stats = payloads.get_stats();
+            cost.serialized_bytes = stats.bytes_encoded - before.bytes_encoded;
+            cost.documents = stats.encodes - before.encodes;
+        }
+
+        const double n = cycles;
+        std::printf("%10zu %-6s %-13s %10.0f %12.1f %12.1f %12.1f %10.2f %12.1f\n", publisher_count,
+                    mixed ? "mixed" : "mqtt", shared ? "shared" : "per-publisher", total_ns / n,
+                    cost.serialized_bytes / n, cost.framed_bytes / n, (cost.serialized_bytes + cost.framed_bytes) / n,
+                    cost.documents / n, g_allocator.bytes() / n);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t cycles = 20000;
+    uint32_t diagnostics_every = 60; // ALERT_INTERVAL 1 s, DIAGNOSTICS_INTERVAL_MS 60 s
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--cycles") == 0)
+            cycles = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (std::strcmp(argv[i], "--diagnostics-every") == 0)
+            diagnostics_every = static_cast<uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--cycles N] [--diagnostics-every N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cycles == 0)
+    {
+        return 2;
+    }
+
+    static char storage[4096];
+    JsonDocument telemetry;
+    PayloadCache payloads(storage, sizeof(storage), &g_allocator);
+
+    if (!outputs_match(telemetry, payloads))
+    {
+        return 1;
+    }
+
+    std::printf("%u cycles, %zu sensors, diagnostics every %u cycles; per-cycle means\n\n", cycles, SENSORS,
+                diagnostics_every);
+    std::printf("%10s %-6s %-13s %10s %12s %12s %12s %10s %12s\n", "publishers", "mix", "mode", "ns", "serialized_B",
+                "framed_B", "copied_B", "documents", "doc_alloc_B");
+    for (const bool mixed : {false, true})
+    {
+        for (const size_t count : {1, 2, 4})
+        {
+            run(telemetry, payloads, count, mixed, false, cycles, diagnostics_every);
+            run(telemetry, payloads, count, mixed, true, cycles, diagnostics_every);
+        }
+    }
+
+    const auto &stats = payloads.get_stats();
+    std::printf("\npayload buffer peak %zu of %zu bytes, %u overflows\n", stats.peak_used, stats.capacity,
+                stats.overflows);
+    return stats.overflows ? 1 : 0;
+}
@@ -0,0 +1,990 @@
+/**
+ * @file replay.cpp
+ * @brief Replays sensor traces through the firmware alert engines and compares them
+ *
+ * Runs ThresholdDetector and CusumDetector from include/sensors/change_detector.h behind the
+ * same EMA baseline BaseSensor::read() maintains. Synthetic traces carry ground truth, so
+ * detection delay, misses and false alarms are reported; collector CSV files have no labels,
+ * so only alarm rates and agreement between the engines are reported for them.
+ *
+ * --classify replays paired NH3/CH4 traces with labelled urine, feces and cleaning-spray
+ * events through EventFeatureExtractor (include/sensors/event_classifier.h), trains the
+ * fused linear model on half of the runs, and reports accuracy and inference cost of the
+ * float, fixed-point and embedded (include/sensors/event_model.h) models on the other half.
+ * --emit-model writes the trained model in the form event_model.h embeds it.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sensors/change_detector.h"
+#include "sensors/event_classifier.h"
+#include "sensors/event_model.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using pooaway::sensors::AlertEngine;
+using pooaway::sensors::CusumDetector;
+using pooaway::sensors::CusumParams;
+using pooaway::sensors::ThresholdDetector;
+using pooaway::sensors::EventClass;
+using pooaway::sensors::EventFeatureExtractor;
+using pooaway::sensors::EventFeatures;
+using pooaway::sensors::EventModel;
+
+namespace
+{
+    // Mirrors the BaseSensor constructor arguments of NH3Sensor and CH4Sensor
+    struct SensorProfile
+    {
+        const char *name;
+        float alpha;
+        float tolerance;
+        unsigned long min_detect_ms;
+        float clean_ppm; // Synthetic traces only
+    };
+
+    constexpr SensorProfile PROFILES[] = {
+        {"NH3", 0.1F, 0.3F, 5000, 5.0F},
+        {"CH4", 0.05F, 0.4F, 3000, 30.0F},
+    };
+
+    struct Sample
+    {
+        uint64_t t_ms;
+        float value;
+    };
+
+    struct Window
+    {
+        uint64_t start_ms;
+        uint64_t end_ms;
+    };
+
+    struct Trace
+    {
+        std::string label;
+        std::vector<Sample> samples;
+        std::vector<Window> events; // Empty for unlabelled traces
+    };
+
+    struct Options
+    {
+        double hours{24.0};
+        unsigned long period_ms{200};
+        double events_per_day{8.0};
+        unsigned runs{5};
+        unsigned seed{1};
+        float noise_ratio{0.03F};
+        CusumParams cusum{};
+        std::string csv;
+        bool classify{false};
+        AlertEngine classify_engine{AlertEngine::CUSUM}; // The threshold rule misses most synthetic events
+        std::string emit_model;
+    };
+
+    // Onsets of alarm episodes (rising edges of the detector output)
+    std::vector<uint64_t> run_engine(const Trace &trace, const SensorProfile &profile, AlertEngine engine,
+                                     const CusumParams &cusum_params, double *duty = nullptr)
+    {
+        ThresholdDetector threshold(profile.tolerance, profile.min_detect_ms);
+        CusumDetector cusum(cusum_params);
+        std::vector<uint64_t> onsets;
+
+        bool first = true;
+        bool alarm = false;
+        float baseline = 0.0F;
+        uint64_t alarm_ms = 0;
+        for (size_t i = 0; i < trace.samples.size(); i++)
+        {
+            const auto &sample = trace.samples[i];
+            bool now_alarm = false;
+
+            // Same order as BaseSensor: CUSUM sees the prediction residual, the threshold rule
+            // compares against the baseline after this sample was folded in
+            if (engine == AlertEngine::CUSUM)
+            {
+                now_alarm = cusum.update(sample.value, first ? sample.value : baseline);
+            }
+
+            baseline = first ? sample.value : profile.alpha * sample.value + (1.0F - profile.alpha) * baseline;
+            first = false;
+
+            if (engine == AlertEngine::THRESHOLD)
+            {
+                now_alarm = threshold.update(static_cast<unsigned long>(sample.t_ms), sample.value, baseline);
+            }
+
+            if (now_alarm && !alarm)
+            {
+                onsets.push_back(sample.t_ms);
+            }
+            if (now_alarm && i + 1 < trace.samples.size())
+            {
+                alarm_ms += trace.samples[i + 1].t_ms - sample.t_ms;
+            }
+            alarm = now_alarm;
+        }
+
+        if (duty && trace.samples.size() > 1)
+        {
+            *duty = static_cast<double>(alarm_ms) /
+                    static_cast<double>(trace.samples.back().t_ms - trace.samples.front().t_ms);
+        }
+        return onsets;
+    }
+
+    // Event shape: linear ramp, plateau, exponential decay
+    struct Visit
+    {
+        uint64_t start;
+        float ramp_ms, hold_ms, tau_ms, amplitude;
+
+        float excess(uint64_t t) const
+        {
+            const float dt = static_cast<float>(t - start);
+            if (dt < ramp_ms)
+                return amplitude * dt / ramp_ms;
+            if (dt < ramp_ms + hold_ms)
+                return amplitude;
+            return amplitude * std::exp(-(dt - ramp_ms - hold_ms) / tau_ms);
+        }
+
+        // Ground truth ends once the excess has decayed to a tenth of the peak
+        uint64_t end() const { return start + static_cast<uint64_t>(ramp_ms + hold_ms + tau_ms * std::log(10.0F)); }
+    };
+
+    Trace synthesize(const SensorProfile &profile, const Options &options, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0F, 1.0F);
+        std::uniform_real_distribution<float> uniform(0.0F, 1.0F);
+
+        Trace trace;
+        trace.label = std::string(profile.name) + " seed " + std::to_string(seed);
+
+        const uint64_t duration_ms = static_cast<uint64_t>(options.hours * 3600000.0);
+        const double event_gap_ms = 86400000.0 / std::max(options.events_per_day, 0.01);
+        std::exponential_distribution<double> gap(1.0 / event_gap_ms);
+
+        std::vector<Visit> visits;
+        for (double t = 600000.0 + gap(rng); t < static_cast<double>(duration_ms) - 600000.0; t += 300000.0 + gap(rng))
+        {
+            Visit v{static_cast<uint64_t>(t), 5000.0F + 25000.0F * uniform(rng), 20000.0F + 100000.0F * uniform(rng),
+                    60000.0F + 120000.0F * uniform(rng), profile.clean_ppm * (0.5F + 2.5F * uniform(rng))};
+            visits.push_back(v);
+            trace.events.push_back({v.start, v.end()});
+        }
+
+        float walk = 0.0F;
+        for (uint64_t t = 0; t < duration_ms; t += options.period_ms)
+        {
+            // Diurnal drift and a slow random walk of the clean-air level
+            const float day = static_cast<float>(t) / 86400000.0F;
+            walk = 0.9999F * walk + 0.0005F * noise(rng);
+            float value = profile.clean_ppm * (1.0F + 0.15F * std::sin(6.2831853F * day) + walk);
+
+            for (const auto &v : visits)
+            {
+                if (t < v.start)
+                {
+                    break;
+                }
+                value += v.excess(t);
+            }
+
+            value *= 1.0F + options.noise_ratio * noise(rng);
+            if (uniform(rng) < 1e-4F)
+            {
+                value *= 1.5F + 1.5F * uniform(rng); // Single-sample ADC glitch
+            }
+            trace.samples.push_back({t, std::max(value, 0.0F)});
+        }
+        return trace;
+    }
+
+    struct Score
+    {
+        unsigned events{0};
+        unsigned detected{0};
+        unsigned false_alarms{0};
+        double hours{0.0};
+        std::vector<double> delays_s;
+
+        void add(const Trace &trace, const std::vector<uint64_t> &onsets)
+        {
+            constexpr uint64_t TAIL_GRACE_MS = 120000; // Onsets just after an event belong to it
+            events += static_cast<unsigned>(trace.events.size());
+            hours += static_cast<double>(trace.samples.back().t_ms) / 3600000.0;
+
+            std::vector<bool> hit(trace.events.size(), false);
+            for (const auto onset : onsets)
+            {
+                bool matched = false;
+                for (size_t e = 0; e < trace.events.size(); e++)
+                {
+                    const auto &w = trace.events[e];
+                    if (onset >= w.start_ms && onset <= w.end_ms)
+                    {
+                        if (!hit[e])
+                        {
+                            hit[e] = true;
+                            detected++;
+                            delays_s.push_back(static_cast<double>(onset - w.start_ms) / 1000.0);
+                        }
+                        matched = true;
+                        break;
+                    }
+                    if (onset > w.end_ms && onset <= w.end_ms + TAIL_GRACE_MS)
+                    {
+                        matched = true;
+                        break;
+                    }
+                }
+                false_alarms += matched ? 0 : 1;
+            }
+        }
+
+        double percentile(double p) const
+        {
+            auto sorted = delays_s;
+            std::sort(sorted.begin(), sorted.end());
+            return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+        }
+    };
+
+    void run_synthetic(const Options &options)
+    {
+        std::printf("Synthetic traces: %u runs x %.1f h, %lu ms sample period, %.1f events/day, noise %.1f%%\n",
+                    options.runs, options.hours, options.period_ms, options.events_per_day,
+                    options.noise_ratio * 100.0F);
+        std::printf("CUSUM k=%.2f h=%.1f noise_alpha=%.3f min_sigma=%.1f%%\n\n", options.cusum.drift_k,
+                    options.cusum.threshold_h, options.cusum.noise_alpha, options.cusum.min_sigma_ratio * 100.0F);
+        std::printf("%-6s %-10s %8s %8s %10s %10s %10s %12s\n", "sensor", "engine", "events", "detect%",
+                    "delay p50", "delay p90", "false", "false/day");
+
+        for (const auto &profile : PROFILES)
+        {
+            Score scores[2];
+            for (unsigned run = 0; run < options.runs; run++)
+            {
+                const Trace trace = synthesize(profile, options, options.seed + run);
+                scores[0].add(trace, run_engine(trace, profile, AlertEngine::THRESHOLD, options.cusum));
+                scores[1].add(trace, run_engine(trace, profile, AlertEngine::CUSUM, options.cusum));
+            }
+
+            const char *names[] = {"threshold", "cusum"};
+            for (int i = 0; i < 2; i++)
+            {
+                const auto &s = scores[i];
+                char p50[16] = "-", p90[16] = "-";
+                if (!s.delays_s.empty())
+                {
+                    std::snprintf(p50, sizeof(p50), "%.1fs", s.percentile(0.5));
+                    std::snprintf(p90, sizeof(p90), "%.1fs", s.percentile(0.9));
+                }
+                std::printf("%-6s %-10s %8u %7.1f%% %10s %10s %10u %12.2f\n", profile.name, names[i], s.events,
+                            s.events ? 100.0 * s.detected / s.events : 0.0, p50, p90, s.false_alarms,
+                            s.hours > 0.0 ? s.false_alarms * 24.0 / s.hours : 0.0);
+            }
+        }
+    }
+
+    // Collector CSV: recv_us,device_id,device_ts,index,name,model,alert,value,baseline,...
+    bool load_csv(const std::string &path, std::map<std::string, Trace> &traces)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+            return false;
+        }
+
+        std::string line;
+        std::getline(in, line); // Header
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields;
+            std::stringstream row(line);
+            std::string field;
+            while (std::getline(row, field, ','))
+            {
+                fields.push_back(field);
+            }
+            if (fields.size() < 8)
+            {
+                continue;
+            }
+
+            auto &trace = traces[fields[1] + "/" + fields[4]];
+            trace.label = fields[1] + " " + fields[4];
+            trace.samples.push_back({std::strtoull(fields[2].c_str(), nullptr, 10),
+                                     std::strtof(fields[7].c_str(), nullptr)});
+        }
+
+        for (auto &entry : traces)
+        {
+            auto &samples = entry.second.samples;
+            std::stable_sort(samples.begin(), samples.end(),
+                             [](const Sample &a, const Sample &b)
+                             { return a.t_ms < b.t_ms; });
+        }
+        return true;
+    }
+
+    void run_csv(const Options &options)
+    {
+        std::map<std::string, Trace> traces;
+        if (!load_csv(options.csv, traces))
+        {
+            return;
+        }
+
+        std::printf("%-32s %8s %14s %14s %10s %10s %8s\n", "stream", "hours", "thr alarms/h", "cusum alarms/h",
+                    "thr duty", "cusum duty", "agree");
+        for (const auto &entry : traces)
+        {
+            const auto &trace = entry.second;
+            if (trace.samples.size() < 2)
+            {
+                continue;
+            }
+
+            // Pick the profile by sensor name prefix (PEE* = NH3, POO* = CH4)
+            const bool is_ch4 = entry.first.find("/POO") != std::string::npos;
+            const auto &profile = PROFILES[is_ch4 ? 1 : 0];
+
+            double thr_duty = 0.0, cusum_duty = 0.0;
+            const auto thr = run_engine(trace, profile, AlertEngine::THRESHOLD, options.cusum, &thr_duty);
+            const auto cusum = run_engine(trace, profile, AlertEngine::CUSUM, options.cusum, &cusum_duty);
+
+            // Share of threshold alarms that CUSUM also raised within 60 s either side
+            unsigned agreed = 0;
+            for (const auto t : thr)
+            {
+                agreed += std::any_of(cusum.begin(), cusum.end(), [t](uint64_t c)
+                                      { return (c > t ? c - t : t - c) <= 60000; })
+                              ? 1
+                              : 0;
+            }
+
+            const double hours = static_cast<double>(trace.samples.back().t_ms - trace.samples.front().t_ms) / 3600000.0;
+            std::printf("%-32s %8.2f %14.2f %14.2f %9.1f%% %9.1f%% %7.0f%%\n", trace.label.c_str(), hours,
+                        hours > 0 ? thr.size() / hours : 0.0, hours > 0 ? cusum.size() / hours : 0.0,
+                        thr_duty * 100.0, cusum_duty * 100.0, thr.empty() ? 100.0 : 100.0 * agreed / thr.size());
+        }
+    }
+
+    // Per-gas response to one event class, in multiples of the clean-air level and seconds
+    struct Range
+    {
+        float low, high;
+    };
+
+    struct GasShape
+    {
+        Range amplitude, ramp_s, hold_s, tau_s, delay_s;
+    };
+
+    constexpr size_t CLASS_COUNT = static_cast<size_t>(EventClass::COUNT);
+
+    // Indexed [class][gas]. Urine is NH3-led with little CH4; feces are CH4-led with a weaker,
+    // later NH3 response; sprays hit both MOS sensors within seconds and clear quickly.
+    constexpr GasShape CLASS_SHAPES[CLASS_COUNT][2] = {
+        {{{0.6F, 3.0F}, {5, 30}, {20, 120}, {60, 240}, {0, 0}},
+         {{0.0F, 0.25F}, {10, 40}, {10, 60}, {30, 120}, {0, 60}}},
+        {{{0.1F, 0.8F}, {10, 60}, {30, 120}, {60, 240}, {10, 90}},
+         {{0.6F, 3.0F}, {10, 40}, {30, 150}, {60, 180}, {0, 0}}},
+        {{{0.8F, 4.0F}, {1, 4}, {2, 15}, {10, 45}, {0, 3}},
+         {{0.8F, 4.0F}, {1, 4}, {2, 15}, {10, 45}, {0, 3}}},
+    };
+    constexpr float CLASS_SHARE[CLASS_COUNT] = {0.45F, 0.35F, 0.20F};
+
+    struct LabelledEvent
+    {
+        Window window;
+        EventClass event_class;
+    };
+
+    // One NH3/CH4 pair on a shared time base, as channels 0 and 1 on the device
+    struct PairTrace
+    {
+        std::vector<uint64_t> t_ms;
+        std::array<std::vector<float>, 2> values;
+        std::vector<LabelledEvent> events;
+    };
+
+    PairTrace synthesize_pair(const Options &options, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0F, 1.0F);
+        std::uniform_real_distribution<float> uniform(0.0F, 1.0F);
+        const auto draw = [&](Range range)
+        { return range.low + (range.high - range.low) * uniform(rng); };
+
+        PairTrace trace;
+        const uint64_t duration_ms = static_cast<uint64_t>(options.hours * 3600000.0);
+        const double event_gap_ms = 86400000.0 / std::max(options.events_per_day, 0.01);
+        std::exponential_distribution<double> gap(1.0 / event_gap_ms);
+
+        std::array<std::vector<Visit>, 2> visits;
+        for (double t = 600000.0 + gap(rng); t < static_cast<double>(duration_ms) - 600000.0; t += 300000.0 + gap(rng))
+        {
+            const float pick = uniform(rng);
+            const auto event_class = pick < CLASS_SHARE[0]                     ? EventClass::URINE
+                                     : pick < CLASS_SHARE[0] + CLASS_SHARE[1] ? EventClass::FECES
+                                                                              : EventClass::SPRAY;
+            const auto start = static_cast<uint64_t>(t);
+            uint64_t end = start;
+            for (size_t gas = 0; gas < 2; gas++)
+            {
+                const auto &shape = CLASS_SHAPES[static_cast<size_t>(event_class)][gas];
+                const Visit v{start + static_cast<uint64_t>(draw(shape.delay_s) * 1000.0F), draw(shape.ramp_s) * 1000.0F,
+                              draw(shape.hold_s) * 1000.0F, draw(shape.tau_s) * 1000.0F,
+                              PROFILES[gas].clean_ppm * draw(shape.amplitude)};
+                visits[gas].push_back(v);
+
+                // Only a response above the alert tolerance counts towards the labelled window
+                if (v.amplitude > PROFILES[gas].tolerance * PROFILES[gas].clean_ppm)
+                {
+                    end = std::max(end, v.end());
+                }
+            }
+            trace.events.push_back({{start, end}, event_class});
+        }
+
+        std::array<float, 2> walk{};
+        for (uint64_t t = 0; t < duration_ms; t += options.period_ms)
+        {
+            trace.t_ms.push_back(t);
+            const float day = static_cast<float>(t) / 86400000.0F;
+            for (size_t gas = 0; gas < 2; gas++)
+            {
+                walk[gas] = 0.9999F * walk[gas] + 0.0005F * noise(rng);
+                float value = PROFILES[gas].clean_ppm * (1.0F + 0.15F * std::sin(6.2831853F * day) + walk[gas]);
+                for (const auto &v : visits[gas])
+                {
+                    if (t < v.start)
+                    {
+                        break;
+                    }
+                    value += v.excess(t);
+                }
+
+                value *= 1.0F + options.noise_ratio * noise(rng);
+                if (uniform(rng) < 1e-4F)
+                {
+                    value *= 1.5F + 1.5F * uniform(rng);
+                }
+                trace.values[gas].push_back(std::max(value, 0.0F));
+            }
+        }
+        return trace;
+    }
+
+    struct ClassifiedEvent
+    {
+        EventFeatures features;
+        EventClass truth;
+        bool nh3_first; // NH3 alerted first, the only cue the firmware had before the classifier
+    };
+
+    // Segments alerts into events with EventDetector's rule (config::events) and extracts features
+    void collect_events(const PairTrace &trace, const Options &options, std::vector<ClassifiedEvent> &out,
+                        unsigned &unmatched)
+    {
+        constexpr uint64_t CLOSE_HOLDOFF_MS = 10000;
+        constexpr uint64_t MAX_DURATION_MS = 1800000;
+
+        ThresholdDetector thresholds[2] = {{PROFILES[0].tolerance, PROFILES[0].min_detect_ms},
+                                           {PROFILES[1].tolerance, PROFILES[1].min_detect_ms}};
+        CusumDetector cusums[2] = {CusumDetector(options.cusum), CusumDetector(options.cusum)};
+        std::array<float, 2> baselines{};
+        EventFeatureExtractor extractor;
+        bool active = false;
+        bool nh3_first = false;
+        uint64_t start_ms = 0;
+        uint64_t end_ms = 0;
+
+        for (size_t i = 0; i < trace.t_ms.size(); i++)
+        {
+            const uint64_t t = trace.t_ms[i];
+            std::array<bool, 2> alerts{};
+            for (size_t gas = 0; gas < 2; gas++)
+            {
+                // Same order as run_engine()
+                const float value = trace.values[gas][i];
+                if (options.classify_engine == AlertEngine::CUSUM)
+                {
+                    alerts[gas] = cusums[gas].update(value, i == 0 ? value : baselines[gas]);
+                }
+                baselines[gas] = (i == 0) ? value : PROFILES[gas].alpha * value + (1.0F - PROFILES[gas].alpha) * baselines[gas];
+                if (options.classify_engine == AlertEngine::THRESHOLD)
+                {
+                    alerts[gas] = thresholds[gas].update(static_cast<unsigned long>(t), value, baselines[gas]);
+                }
+                extractor.update(static_cast<unsigned long>(t), gas, value, baselines[gas]);
+            }
+            const bool any_alert = alerts[0] || alerts[1];
+
+            if (!active)
+            {
+                if (any_alert)
+                {
+                    active = true;
+                    nh3_first = alerts[0];
+                    start_ms = end_ms = t;
+                    extractor.begin(static_cast<unsigned long>(t), 2);
+                }
+                continue;
+            }
+
+            if (any_alert)
+            {
+                end_ms = t;
+                if (t - start_ms < MAX_DURATION_MS)
+                {
+                    continue;
+                }
+            }
+            else if (t - end_ms < CLOSE_HOLDOFF_MS)
+            {
+                continue;
+            }
+
+            active = false;
+            const EventFeatures features = extractor.finish(static_cast<unsigned long>(end_ms));
+
+            // Label with the ground-truth event that overlaps the detected one the most
+            uint64_t best_overlap = 0;
+            const LabelledEvent *label = nullptr;
+            for (const auto &event : trace.events)
+            {
+                const uint64_t from = std::max(start_ms, event.window.start_ms);
+                const uint64_t to = std::min(end_ms, event.window.end_ms);
+                if (to >= from && (!label || to - from > best_overlap))
+                {
+                    best_overlap = to - from;
+                    label = &event;
+                }
+            }
+            if (label)
+            {
+                out.push_back({features, label->event_class, nh3_first});
+            }
+            else
+            {
+                unmatched++;
+            }
+        }
+    }
+
+    // Softmax regression in floating point; the firmware only runs its quantized form
+    struct FloatModel
+    {
+        double weights[CLASS_COUNT][pooaway::sensors::FEATURE_COUNT]{};
+        double biases[CLASS_COUNT]{};
+
+        size_t predict(const EventFeatures &features) const
+        {
+            size_t best = 0;
+            double best_score = -1e300;
+            for (size_t c = 0; c < CLASS_COUNT; c++)
+            {
+                double score = biases[c];
+                for (size_t f = 0; f < features.size(); f++)
+                {
+                    score += weights[c][f] * features[f] / pooaway::sensors::FEATURE_ONE;
+                }
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = c;
+                }
+            }
+            return best;
+        }
+    };
+
+    FloatModel train(const std::vector<ClassifiedEvent> &data)
+    {
+        constexpr int EPOCHS = 4000;
+        constexpr double LEARNING_RATE = 0.3;
+        constexpr double L2 = 1e-3;
+        constexpr size_t N = pooaway::sensors::FEATURE_COUNT;
+
+        FloatModel model;
+        for (int epoch = 0; epoch < EPOCHS && !data.empty(); epoch++)
+        {
+            double grad_w[CLASS_COUNT][N]{};
+            double grad_b[CLASS_COUNT]{};
+            for (const auto &event : data)
+            {
+                double x[N];
+                for (size_t f = 0; f < N; f++)
+                {
+                    x[f] = static_cast<double>(event.features[f]) / pooaway::sensors::FEATURE_ONE;
+                }
+
+                double scores[CLASS_COUNT];
+                double top = -1e300;
+                for (size_t c = 0; c < CLASS_COUNT; c++)
+                {
+                    scores[c] = model.biases[c];
+                    for (size_t f = 0; f < N; f++)
+                    {
+                        scores[c] += model.weights[c][f] * x[f];
+                    }
+                    top = std::max(top, scores[c]);
+                }
+                double sum = 0.0;
+                for (auto &score : scores)
+                {
+                    score = std::exp(score - top);
+                    sum += score;
+                }
+                for (size_t c = 0; c < CLASS_COUNT; c++)
+                {
+                    const double error = scores[c] / sum - (static_cast<size_t>(event.truth) == c ? 1.0 : 0.0);
+                    grad_b[c] += error;
+                    for (size_t f = 0; f < N; f++)
+                    {
+                        grad_w[c][f] += error * x[f];
+                    }
+                }
+            }
+
+            const double n = static_cast<double>(data.size());
+            for (size_t c = 0; c < CLASS_COUNT; c++)
+            {
+                model.biases[c] -= LEARNING_RATE * grad_b[c] / n;
+                for (size_t f = 0; f < N; f++)
+                {
+                    model.weights[c][f] -= LEARNING_RATE * (grad_w[c][f] / n + L2 * model.weights[c][f]);
+                }
+            }
+        }
+        return model;
+    }
+
+    EventModel quantize(const FloatModel &model, unsigned &clamped)
+    {
+        using namespace pooaway::sensors;
+        EventModel fixed{};
+        for (size_t c = 0; c < CLASS_COUNT; c++)
+        {
+            for (size_t f = 0; f < FEATURE_COUNT; f++)
+            {
+                const long weight = std::lround(model.weights[c][f] * FEATURE_ONE);
+                const long limited = std::min<long>(std::max<long>(weight, -WEIGHT_LIMIT), WEIGHT_LIMIT);
+                clamped += (limited != weight) ? 1 : 0;
+                fixed.weights[c][f] = static_cast<int16_t>(limited);
+            }
+            fixed.biases[c] = static_cast<int32_t>(std::llround(model.biases[c] * FEATURE_ONE * FEATURE_ONE));
+        }
+        return fixed;
+    }
+
+    struct Confusion
+    {
+        unsigned counts[CLASS_COUNT][CLASS_COUNT]{}; // [truth][predicted]
+        unsigned total{0};
+        unsigned correct{0};
+
+        void add(EventClass truth, size_t predicted)
+        {
+            counts[static_cast<size_t>(truth)][predicted]++;
+            total++;
+            correct += (static_cast<size_t>(truth) == predicted) ? 1 : 0;
+        }
+
+        double recall(size_t c) const
+        {
+            unsigned row = 0;
+            for (const auto count : counts[c])
+            {
+                row += count;
+            }
+            return row ? 100.0 * counts[c][c] / row : 0.0;
+        }
+    };
+
+    inline void clobber()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    uint64_t tsc()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // Mean cost of one inference over the test set, repeated until it runs long enough to time
+    template <typename Classify>
+    void time_inference(const char *name, const std::vector<ClassifiedEvent> &data, Classify classify)
+    {
+        const size_t rounds = std::max<size_t>(1, 2000000 / std::max<size_t>(data.size(), 1));
+        volatile size_t sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t start_tsc = tsc();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            for (const auto &event : data)
+            {
+                clobber(); // Stops the compiler from hoisting the inference out of the rounds
+                sink = sink + classify(event.features);
+            }
+        }
+        const uint64_t ticks = tsc() - start_tsc;
+        const double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        const double inferences = static_cast<double>(rounds * data.size());
+        std::printf("  %-10s %8.1f ns %10.1f TSC ticks\n", name, ns / inferences, ticks / inferences);
+    }
+
+    bool emit_model(const std::string &path, const EventModel &model, const std::vector<ClassifiedEvent> &training,
+                    const char *summary)
+    {
+        using namespace pooaway::sensors;
+        FILE *out = std::fopen(path.c_str(), "w");
+        if (!out)
+        {
+            std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return false;
+        }
+
+        const char *names[CLASS_COUNT] = {"URINE", "FECES", "SPRAY"};
+        std::fprintf(out, "#pragma once\n#include \"sensors/event_classifier.h\"\n\n");
+        std::fprintf(out, "// Generated by tools/replay --classify --emit-model; retrain instead of editing by hand.\n");
+        std::fprintf(out, "// %s\n\n", summary);
+        std::fprintf(out, "namespace pooaway::sensors\n{\n");
+        std::fprintf(out, "    // Rows in EventClass order, columns in EventFeature order; weights Q8.8, biases Q16.16\n");
+        std::fprintf(out, "    constexpr EventModel EVENT_MODEL{\n        {{\n");
+        for (size_t c = 0; c < CLASS_COUNT; c++)
+        {
+            std::fprintf(out, "            {{");
+            for (size_t f = 0; f < FEATURE_COUNT; f++)
+            {
+                std::fprintf(out, "%s%d", f ? ", " : "", model.weights[c][f]);
+            }
+            std::fprintf(out, "}}, // %s\n", names[c]);
+        }
+        std::fprintf(out, "        }},\n        {{");
+        for (size_t c = 0; c < CLASS_COUNT; c++)
+        {
+            std::fprintf(out, "%s%ld", c ? ", " : "", static_cast<long>(model.biases[c]));
+        }
+        std::fprintf(out, "}},\n    };\n\n");
+
+        // The mean training event of each class must come out as that class, checked by the compiler
+        std::fprintf(out, "    // Mean training event of each class, classified at compile time\n");
+        for (size_t c = 0; c < CLASS_COUNT; c++)
+        {
+            double sums[FEATURE_COUNT]{};
+            unsigned count = 0;
+            for (const auto &event : training)
+            {
+                if (static_cast<size_t>(event.truth) != c)
+                {
+                    continue;
+                }
+                count++;
+                for (size_t f = 0; f < FEATURE_COUNT; f++)
+                {
+                    sums[f] += event.features[f];
+                }
+            }
+            if (count == 0)
+            {
+                continue;
+            }
+
+            EventFeatures mean{};
+            for (size_t f = 0; f < FEATURE_COUNT; f++)
+            {
+                mean[f] = static_cast<int16_t>(std::lround(sums[f] / count));
+            }
+            const bool holds = classify(model, mean).event_class == static_cast<EventClass>(c);
+            std::fprintf(out, "    %sstatic_assert(classify(EVENT_MODEL, EventFeatures{{", holds ? "" : "// ");
+            for (size_t f = 0; f < FEATURE_COUNT; f++)
+            {
+                std::fprintf(out, "%s%d", f ? ", " : "", mean[f]);
+            }
+            std::fprintf(out, "}}).event_class == EventClass::%s);\n", names[c]);
+            if (!holds)
+            {
+                std::fprintf(stderr, "warning: mean %s event is misclassified; its static_assert is commented out\n",
+                             names[c]);
+            }
+        }
+        std::fprintf(out, "} // namespace pooaway::sensors\n");
+        std::fclose(out);
+        return true;
+    }
+
+    void run_classify(const Options &options)
+    {
+        using pooaway::sensors::EVENT_MODEL;
+        std::vector<ClassifiedEvent> training, test;
+        unsigned unmatched = 0;
+        for (unsigned run = 0; run < options.runs; run++)
+        {
+            const PairTrace trace = synthesize_pair(options, options.seed + run);
+            collect_events(trace, options, (run % 2) ? test : training, unmatched);
+        }
+
+        std::printf("Classifier: %u runs x %.1f h, %.1f events/day, noise %.1f%%, %s events; even runs train, odd runs test\n",
+                    options.runs, options.hours, options.events_per_day, options.noise_ratio * 100.0F,
+                    options.classify_engine == AlertEngine::CUSUM ? "cusum" : "threshold");
+        std::printf("%zu training and %zu test events, %u detected events matched no labelled event\n\n",
+                    training.size(), test.size(), unmatched);
+        if (training.empty() || test.empty())
+        {
+            std::fprintf(stderr, "Not enough events; raise --runs or --events-per-day\n");
+            return;
+        }
+
+        const FloatModel float_model = train(training);
+        unsigned clamped = 0;
+        const EventModel fixed_model = quantize(float_model, clamped);
+
+        Confusion confusions[4];
+        for (const auto &event : test)
+        {
+            confusions[0].add(event.truth, static_cast<size_t>(event.nh3_first ? EventClass::URINE : EventClass::FECES));
+            confusions[1].add(event.truth, float_model.predict(event.features));
+            confusions[2].add(event.truth, static_cast<size_t>(classify(fixed_model, event.features).event_class));
+            confusions[3].add(event.truth, static_cast<size_t>(classify(EVENT_MODEL, event.features).event_class));
+        }
+
+        const char *models[] = {"first-alert", "float", "fixed", "embedded"};
+        std::printf("%-12s %9s %9s %9s %9s\n", "model", "accuracy", "urine", "feces", "spray");
+        for (size_t m = 0; m < 4; m++)
+        {
+            const auto &confusion = confusions[m];
+            std::printf("%-12s %8.1f%% %8.1f%% %8.1f%% %8.1f%%\n", models[m], 100.0 * confusion.correct / confusion.total,
+                        confusion.recall(0), confusion.recall(1), confusion.recall(2));
+        }
+        std::printf("(first-alert: urine if NH3 alerted first, else feces; per-class columns are recall)\n");
+        if (clamped)
+        {
+            std::printf("%u weights clamped to +-%d during quantization\n", clamped, pooaway::sensors::WEIGHT_LIMIT);
+        }
+
+        std::printf("\nFixed-point confusion (rows truth, columns predicted)\n%-8s %8s %8s %8s\n", "", "urine", "feces",
+                    "spray");
+        for (size_t t = 0; t < CLASS_COUNT; t++)
+        {
+            std::printf("%-8s %8u %8u %8u\n", to_string(static_cast<EventClass>(t)), confusions[2].counts[t][0],
+                        confusions[2].counts[t][1], confusions[2].counts[t][2]);
+        }
+
+        std::printf("\nInference cost per event (host; the C6 has no FPU, so float is far slower there)\n");
+        time_inference("fixed", test, [&](const EventFeatures &features)
+                       { return static_cast<size_t>(classify(fixed_model, features).event_class); });
+        time_inference("float", test, [&](const EventFeatures &features)
+                       { return float_model.predict(features); });
+
+        if (!options.emit_model.empty())
+        {
+            char summary[160];
+            std::snprintf(summary, sizeof(summary),
+                          "Trained on %zu synthetic events (%u runs x %.0f h, seed %u); fixed-point test accuracy %.1f%%",
+                          training.size(), options.runs, options.hours, options.seed,
+                          100.0 * confusions[2].correct / confusions[2].total);
+            if (emit_model(options.emit_model, fixed_model, training, summary))
+            {
+                std::printf("\nModel written to %s\n", options.emit_model.c_str());
+            }
+        }
+    }
+
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--csv telemetry.csv] [--hours H] [--period-ms MS] [--events-per-day N]\n"
+                     "          [--runs N] [--seed S] [--noise R] [--k K] [--h H]\n"
+                     "       %s --classify [--engine cusum|threshold] [--emit-model event_model.h] [--runs N] ...\n",
+                     argv0, argv0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (!std::strcmp(arg, "--classify"))
+        {
+            options.classify = true;
+            continue;
+        }
+
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (!std::strcmp(arg, "--csv"))
+            options.csv = value;
+        else if (!std::strcmp(arg, "--hours"))
+            options.hours = std::atof(value);
+        else if (!std::strcmp(arg, "--period-ms"))
+            options.period_ms = std::strtoul(value, nullptr, 10);
+        else if (!std::strcmp(arg, "--events-per-day"))
+            options.events_per_day = std::atof(value);
+        else if (!std::strcmp(arg, "--runs"))
+            options.runs = static_cast<unsigned>(std::atoi(value));
+        else if (!std::strcmp(arg, "--seed"))
+            options.seed = static_cast<unsigned>(std::atoi(value));
+        else if (!std::strcmp(arg, "--noise"))
+            options.noise_ratio = static_cast<float>(std::atof(value));
+        else if (!std::strcmp(arg, "--k"))
+            options.cusum.drift_k = static_cast<float>(std::atof(value));
+        else if (!std::strcmp(arg, "--h"))
+            options.cusum.threshold_h = static_cast<float>(std::atof(value));
+        else if (!std::strcmp(arg, "--emit-model"))
+            options.emit_model = value;
+        else if (!std::strcmp(arg, "--engine"))
+            options.classify_engine = std::strcmp(value, "threshold") ? AlertEngine::CUSUM : AlertEngine::THRESHOLD;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (options.period_ms == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (options.classify)
+        run_classify(options);
+    else if (options.csv.empty())
+        run_synthetic(options);
+    else
+        run_csv(options);
+    return 0;
+}
@@ -0,0 +1,588 @@
+/**
+ * @file heap_tracker.cpp
+ * @brief Allocator interposition, subsystem attribution and the device heap model
+ */
+
+#include "heap_tracker.h"
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *ptr);
+}
+
+namespace soak::heap
+{
+    namespace
+    {
+        // Only the harness thread allocates, so plain flags are enough. g_busy also keeps the
+        // tracker's own allocations (maps, backtrace, demangling) out of the statistics.
+        bool g_busy = false;
+        bool g_paused = false;
+        bool g_started = false;
+        uint32_t g_epoch = 0;
+
+        struct Block
+        {
+            uintptr_t ptr;
+            uint32_t size;
+            uint32_t device_offset;
+            uint32_t device_size; // 0 when not placed in the device model
+            uint32_t epoch;
+            Subsystem subsystem;
+        };
+
+        // Open-addressed table of live blocks, mapped directly so it never recurses into malloc
+        constexpr size_t BLOCK_SLOTS = size_t{1} << 18;
+        Block *g_blocks = nullptr;
+        size_t g_block_count = 0;
+
+        template <typename T>
+        T *map_table(size_t slots)
+        {
+            void *memory = mmap(nullptr, slots * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+            {
+                std::fputs("soak: cannot map tracker table\n", stderr);
+                std::abort();
+            }
+            return static_cast<T *>(memory); // Zero-filled: every slot starts empty
+        }
+
+        size_t slot_of(uintptr_t ptr, size_t slots)
+        {
+            return static_cast<size_t>(((ptr >> 4) * 0x9E3779B97F4A7C15ULL) >> 20) & (slots - 1);
+        }
+
+        Block *insert_block(uintptr_t ptr)
+        {
+            if (!g_blocks)
+            {
+                g_blocks = map_table<Block>(BLOCK_SLOTS);
+            }
+            if (g_block_count >= BLOCK_SLOTS * 3 / 4)
+            {
+                std::fputs("soak: too many live blocks for the tracker table\n", stderr);
+                std::abort();
+            }
+
+            size_t slot = slot_of(ptr, BLOCK_SLOTS);
+            while (g_blocks[slot].ptr != 0)
+            {
+                slot = (slot + 1) & (BLOCK_SLOTS - 1);
+            }
+            g_blocks[slot].ptr = ptr;
+            g_block_count++;
+            return &g_blocks[slot];
+        }
+
+        Block *find_block(uintptr_t ptr)
+        {
+            if (!g_blocks)
+            {
+                return nullptr;
+            }
+            for (size_t slot = slot_of(ptr, BLOCK_SLOTS); g_blocks[slot].ptr != 0; slot = (slot + 1) & (BLOCK_SLOTS - 1))
+            {
+                if (g_blocks[slot].ptr == ptr)
+                {
+                    return &g_blocks[slot];
+                }
+            }
+            return nullptr;
+        }
+
+        // Linear-probing delete: shift later entries of the cluster back into the hole
+        void erase_block(Block *block)
+        {
+            size_t hole = static_cast<size_t>(block - g_blocks);
+            g_blocks[hole] = Block{};
+            g_block_count--;
+            for (size_t slot = (hole + 1) & (BLOCK_SLOTS - 1); g_blocks[slot].ptr != 0; slot = (slot + 1) & (BLOCK_SLOTS - 1))
+            {
+                const size_t home = slot_of(g_blocks[slot].ptr, BLOCK_SLOTS);
+                const bool movable = (hole <= slot) ? (home <= hole || home > slot) : (home <= hole && home > slot);
+                if (movable)
+                {
+                    g_blocks[hole] = g_blocks[slot];
+                    g_blocks[slot] = Block{};
+                    hole = slot;
+                }
+            }
+        }
+
+        /**
+         * Best-fit allocator over one contiguous region with immediate coalescing, a stand-in
+         * for the TLSF heap in ESP-IDF. Each block pays a 4-byte header and 4-byte alignment.
+         */
+        class DeviceModel
+        {
+        public:
+            static constexpr uint32_t HEADER = 4;
+            static constexpr uint32_t MIN_BLOCK = 16;
+
+            void reset(size_t capacity)
+            {
+                m_by_offset.clear();
+                m_by_size.clear();
+                m_allocated.clear();
+                m_failures = 0;
+                m_capacity = static_cast<uint32_t>(capacity);
+                m_free = m_capacity;
+                m_min_free = m_capacity;
+                add_free(0, m_capacity);
+                m_window_min_largest = largest();
+            }
+
+            static uint32_t block_size(size_t request)
+            {
+                const auto rounded = static_cast<uint32_t>((request + HEADER + 3) & ~size_t{3});
+                return rounded < MIN_BLOCK ? MIN_BLOCK : rounded;
+            }
+
+            bool allocate(uint32_t size, uint32_t &offset)
+            {
+                const auto it = m_by_size.lower_bound({size, 0});
+                if (it == m_by_size.end())
+                {
+                    m_failures++;
+                    return false;
+                }
+
+                const uint32_t block_offset = it->second;
+                const uint32_t block_size = it->first;
+                remove_free(block_offset, block_size);
+                if (block_size - size >= MIN_BLOCK)
+                {
+                    add_free(block_offset + size, block_size - size);
+                }
+                else
+                {
+                    size = block_size; // Remainder too small to split off
+                }
+
+                offset = block_offset;
+                m_allocated[block_offset] = size;
+                m_free -= size;
+                if (m_free < m_min_free)
+                {
+                    m_min_free = m_free;
+                }
+                const uint32_t now_largest = largest();
+                if (now_largest < m_window_min_largest)
+                {
+                    m_window_min_largest = now_largest;
+                }
+                return true;
+            }
+
+            void release(uint32_t offset)
+            {
+                const auto it = m_allocated.find(offset);
+                if (it == m_allocated.end())
+                {
+                    return;
+                }
+                uint32_t size = it->second;
+                m_allocated.erase(it);
+                m_free += size;
+
+                // Merge with the free neighbours on either side
+                const auto next = m_by_offset.find(offset + size);
+                if (next != m_by_offset.end())
+                {
+                    const uint32_t next_size = next->second;
+                    remove_free(offset + size, next_size);
+                    size += next_size;
+                }
+                auto previous = m_by_offset.lower_bound(offset);
+                if (previous != m_by_offset.begin())
+                {
+                    --previous;
+                    if (previous->first + previous->second == offset)
+                    {
+                        const uint32_t previous_offset = previous->first;
+                        const uint32_t previous_size = previous->second;
+                        remove_free(previous_offset, previous_size);
+                        offset = previous_offset;
+                        size += previous_size;
+                    }
+                }
+                add_free(offset, size);
+            }
+
+            uint32_t largest() const { return m_by_size.empty() ? 0 : m_by_size.rbegin()->first; }
+
+            DeviceHeapInfo info() const
+            {
+                return {m_capacity, m_free, largest(), m_min_free, m_window_min_largest, m_failures};
+            }
+
+            void reset_window() { m_window_min_largest = largest(); }
+
+        private:
+            void add_free(uint32_t offset, uint32_t size)
+            {
+                m_by_offset[offset] = size;
+                m_by_size.insert({size, offset});
+            }
+
+            void remove_free(uint32_t offset, uint32_t size)
+            {
+                m_by_offset.erase(offset);
+                m_by_size.erase({size, offset});
+            }
+
+            std::map<uint32_t, uint32_t> m_by_offset;           // Free blocks
+            std::set<std::pair<uint32_t, uint32_t>> m_by_size;  // Free blocks as (size, offset)
+            std::map<uint32_t, uint32_t> m_allocated;           // Offset to block size
+            uint32_t m_capacity{0};
+            uint32_t m_free{0};
+            uint32_t m_min_free{0};
+            uint32_t m_window_min_largest{0};
+            uint32_t m_failures{0};
+        };
+
+        DeviceModel *g_device = nullptr;
+        SubsystemStats g_stats[SUBSYSTEM_COUNT];
+        uint64_t g_total_allocations = 0;
+        int64_t g_live_bytes = 0;
+        int64_t g_peak_live_bytes = 0;
+
+        // Return address to classification: 0 unknown yet, 1 not a subsystem frame, 2 + subsystem
+        constexpr size_t FRAME_SLOTS = size_t{1} << 16;
+        struct FrameClass
+        {
+            uintptr_t address;
+            uint8_t value;
+        };
+        FrameClass *g_frames = nullptr;
+
+        constexpr uint8_t TRANSPARENT = 1;
+
+        struct Prefix
+        {
+            const char *text;
+            uint8_t value;
+        };
+
+        constexpr uint8_t classify_as(Subsystem subsystem) { return static_cast<uint8_t>(2 + static_cast<uint8_t>(subsystem)); }
+
+        // Checked in order. Helpers that only pass work through are transparent, so an
+        // allocation inside them is charged to whoever called them.
+        constexpr Prefix PREFIXES[] = {
+            {"pooaway::alert::AlertManager::", classify_as(Subsystem::ALERT_MANAGER)},
+            {"pooaway::alert::MqttHandler::", classify_as(Subsystem::MQTT_HANDLER)},
+            {"pooaway::alert::ApiHandler::", classify_as(Subsystem::API_HANDLER)},
+            {"pooaway::WiFiManager::", classify_as(Subsystem::WIFI_MANAGER)},
+            {"pooaway::sensors::", classify_as(Subsystem::SENSORS)},
+            {"pooaway::StateStore::", classify_as(Subsystem::STATE_STORE)},
+            {"pooaway::MetricsServer::", classify_as(Subsystem::METRICS_SERVER)},
+            {"pooaway::metrics::", classify_as(Subsystem::METRICS_SERVER)},
+            {"pooaway::JsonArena::", TRANSPARENT},
+            {"pooaway::BootPipeline::", TRANSPARENT},
+            {"pooaway::alert::AlertHandler::", TRANSPARENT},
+            {"pooaway::", classify_as(Subsystem::OTHER)},
+            {"setup", classify_as(Subsystem::OTHER)},
+            {"loop", classify_as(Subsystem::OTHER)},
+        };
+
+        uint8_t classify_symbol(const char *name)
+        {
+            for (const auto &prefix : PREFIXES)
+            {
+                const size_t length = std::strlen(prefix.text);
+                if (std::strncmp(name, prefix.text, length) == 0)
+                {
+                    // "setup" and "loop" must be the whole name, not a prefix of another function
+                    const bool whole_word = prefix.text[length - 1] == ':' || name[length] == '\0' || name[length] == '(';
+                    if (whole_word)
+                    {
+                        return prefix.value;
+                    }
+                }
+            }
+            return TRANSPARENT;
+        }
+
+        uint8_t classify_frame(uintptr_t address)
+        {
+            if (!g_frames)
+            {
+                g_frames = map_table<FrameClass>(FRAME_SLOTS);
+            }
+
+            size_t slot = slot_of(address, FRAME_SLOTS);
+            while (g_frames[slot].address != 0 && g_frames[slot].address != address)
+            {
+                slot = (slot + 1) & (FRAME_SLOTS - 1);
+            }
+            if (g_frames[slot].address == address)
+            {
+                return g_frames[slot].value;
+            }
+
+            uint8_t value = TRANSPARENT;
+            Dl_info info;
+            // The return address points after the call; step back into the calling instruction
+            if (dladdr(reinterpret_cast<void *>(address - 1), &info) && info.dli_sname)
+            {
+                int status = 0;
+                char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                value = classify_symbol(status == 0 && demangled ? demangled : info.dli_sname);
+                std::free(demangled);
+            }
+            g_frames[slot] = {address, value};
+            return value;
+        }
+
+        Subsystem attribute()
+        {
+            constexpr int MAX_FRAMES = 48;
+            void *frames[MAX_FRAMES];
+            const int depth = backtrace(frames, MAX_FRAMES);
+            for (int i = 2; i < depth; i++) // Skip attribute() and the allocator entry point
+            {
+                const uint8_t value = classify_frame(reinterpret_cast<uintptr_t>(frames[i]));
+                if (value != TRANSPARENT)
+                {
+                    return static_cast<Subsystem>(value - 2);
+                }
+            }
+            return Subsystem::OTHER;
+        }
+
+        void place(Block &block)
+        {
+            const uint32_t size = DeviceModel::block_size(block.size);
+            if (g_device->allocate(size, block.device_offset))
+            {
+                block.device_size = size;
+            }
+        }
+
+        void track_alloc(void *ptr, size_t size)
+        {
+            g_busy = true;
+            Block &block = *insert_block(reinterpret_cast<uintptr_t>(ptr));
+            block.size = static_cast<uint32_t>(size);
+            block.epoch = g_epoch;
+            block.subsystem = attribute();
+            if (g_started)
+            {
+                place(block);
+            }
+
+            auto &stats = g_stats[static_cast<size_t>(block.subsystem)];
+            stats.allocations++;
+            stats.bytes_allocated += size;
+            stats.live_bytes += static_cast<int64_t>(size);
+            stats.live_blocks++;
+            if (stats.live_bytes > stats.peak_live_bytes)
+            {
+                stats.peak_live_bytes = stats.live_bytes;
+            }
+            g_total_allocations++;
+            g_live_bytes += static_cast<int64_t>(size);
+            if (g_live_bytes > g_peak_live_bytes)
+            {
+                g_peak_live_bytes = g_live_bytes;
+            }
+            g_busy = false;
+        }
+
+        void track_free(void *ptr)
+        {
+            g_busy = true;
+            Block *block = find_block(reinterpret_cast<uintptr_t>(ptr));
+            if (block)
+            {
+                auto &stats = g_stats[static_cast<size_t>(block->subsystem)];
+                stats.frees++;
+                stats.live_bytes -= block->size;
+                stats.live_blocks--;
+                g_live_bytes -= block->size;
+                if (block->device_size)
+                {
+                    g_device->release(block->device_offset);
+                }
+                erase_block(block);
+            }
+            g_busy = false;
+        }
+
+        bool tracking() { return !g_busy && !g_paused; }
+    } // namespace
+
+    const char *subsystem_name(Subsystem subsystem)
+    {
+        static constexpr const char *NAMES[] = {"AlertManager", "MqttHandler", "ApiHandler", "WiFiManager",
+                                                "Sensors", "StateStore", "MetricsServer", "Other"};
+        return NAMES[static_cast<size_t>(subsystem)];
+    }
+
+    void start(size_t device_heap_bytes)
+    {
+        g_busy = true;
+        if (!g_device)
+        {
+            g_device = new DeviceModel();
+        }
+        g_device->reset(device_heap_bytes);
+
+        // Blocks from before main() with no firmware frame belong to the host C++ runtime
+        // (exception pool, stdio buffers) and are forgotten; firmware constructors keep theirs
+        for (size_t slot = 0; g_blocks && slot < BLOCK_SLOTS;)
+        {
+            Block &block = g_blocks[slot];
+            if (block.ptr != 0 && block.subsystem == Subsystem::OTHER)
+            {
+                auto &stats = g_stats[static_cast<size_t>(Subsystem::OTHER)];
+                stats.allocations--;
+                stats.bytes_allocated -= block.size;
+                stats.live_bytes -= block.size;
+                stats.live_blocks--;
+                g_total_allocations--;
+                g_live_bytes -= block.size;
+                erase_block(&block); // May shift another block into this slot, so look again
+                continue;
+            }
+            slot++;
+        }
+        for (size_t slot = 0; g_blocks && slot < BLOCK_SLOTS; slot++)
+        {
+            if (g_blocks[slot].ptr != 0)
+            {
+                place(g_blocks[slot]);
+            }
+        }
+        g_peak_live_bytes = g_live_bytes;
+        for (auto &stats : g_stats)
+        {
+            stats.peak_live_bytes = stats.live_bytes;
+        }
+        g_started = true;
+        g_busy = false;
+    }
+
+    bool started() { return g_started; }
+
+    const SubsystemStats &stats(Subsystem subsystem) { return g_stats[static_cast<size_t>(subsystem)]; }
+
+    uint64_t total_allocations() { return g_total_allocations; }
+
+    int64_t peak_live_bytes() { return g_peak_live_bytes; }
+
+    DeviceHeapInfo device_info()
+    {
+        return g_device ? g_device->info() : DeviceHeapInfo{};
+    }
+
+    void reset_window()
+    {
+        if (g_device)
+        {
+            g_device->reset_window();
+        }
+    }
+
+    void set_epoch(uint32_t epoch) { g_epoch = epoch; }
+
+    void count_survivors(uint32_t since_epoch, uint64_t blocks[SUBSYSTEM_COUNT], uint64_t bytes[SUBSYSTEM_COUNT])
+    {
+        for (size_t i = 0; i < SUBSYSTEM_COUNT; i++)
+        {
+            blocks[i] = 0;
+            bytes[i] = 0;
+        }
+        for (size_t slot = 0; g_blocks && slot < BLOCK_SLOTS; slot++)
+        {
+            const Block &block = g_blocks[slot];
+            if (block.ptr != 0 && block.epoch >= since_epoch)
+            {
+                blocks[static_cast<size_t>(block.subsystem)]++;
+                bytes[static_cast<size_t>(block.subsystem)] += block.size;
+            }
+        }
+    }
+
+    Pause::Pause() : m_was_paused(g_paused) { g_paused = true; }
+    Pause::~Pause() { g_paused = m_was_paused; }
+} // namespace soak::heap
+
+extern "C"
+{
+    void *malloc(size_t size)
+    {
+        void *ptr = __libc_malloc(size);
+        if (ptr && soak::heap::tracking())
+        {
+            soak::heap::track_alloc(ptr, size);
+        }
+        return ptr;
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        void *ptr = __libc_calloc(count, size);
+        if (ptr && soak::heap::tracking())
+        {
+            soak::heap::track_alloc(ptr, count * size);
+        }
+        return ptr;
+    }
+
+    void *realloc(void *old_ptr, size_t size)
+    {
+        if (old_ptr && soak::heap::tracking())
+        {
+            soak::heap::track_free(old_ptr);
+        }
+        void *ptr = __libc_realloc(old_ptr, size);
+        if (ptr && soak::heap::tracking())
+        {
+            soak::heap::track_alloc(ptr, size);
+        }
+        return ptr;
+    }
+
+    void free(void *ptr)
+    {
+        if (ptr && soak::heap::tracking())
+        {
+            soak::heap::track_free(ptr);
+        }
+        __libc_free(ptr);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        void *ptr = __libc_memalign(alignment, size);
+        if (ptr && soak::heap::tracking())
+        {
+            soak::heap::track_alloc(ptr, size);
+        }
+        return ptr;
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+
+    int posix_memalign(void **out, size_t alignment, size_t size)
+    {
+        *out = memalign(alignment, size);
+        return *out ? 0 : 12; // ENOMEM
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief malloc/free interposer that attributes every heap block to a firmware subsystem
+ *
+ * Replaces the C allocator for the whole soak binary (operator new ends up here too). Each
+ * allocation is charged to the innermost stack frame that belongs to a known firmware class,
+ * found with backtrace() and cached per return address. Live blocks are also replayed into a
+ * model of the device heap, so fragmentation shows up as a shrinking largest free block.
+ */
+namespace soak::heap
+{
+    enum class Subsystem : uint8_t
+    {
+        ALERT_MANAGER,
+        MQTT_HANDLER,
+        API_HANDLER,
+        WIFI_MANAGER,
+        SENSORS,
+        STATE_STORE,
+        METRICS_SERVER,
+        OTHER, // main.cpp, local handlers, libraries called from outside the classes above
+        COUNT
+    };
+
+    constexpr size_t SUBSYSTEM_COUNT = static_cast<size_t>(Subsystem::COUNT);
+    const char *subsystem_name(Subsystem subsystem);
+
+    struct SubsystemStats
+    {
+        uint64_t allocations{0};
+        uint64_t frees{0};
+        uint64_t bytes_allocated{0};
+        int64_t live_bytes{0};
+        int64_t live_blocks{0};
+        int64_t peak_live_bytes{0};
+    };
+
+    // Simulated device heap, in device bytes (block header and alignment included)
+    struct DeviceHeapInfo
+    {
+        size_t capacity;
+        size_t free_bytes;
+        size_t largest_free_block;
+        size_t min_free_bytes;       // Low-water mark since start()
+        size_t min_largest_free;     // Smallest largest-free-block since the last reset_window()
+        uint32_t failed_allocations; // Requests no free block could satisfy
+    };
+
+    // Starts the device model; blocks already live (static constructors) are placed first
+    void start(size_t device_heap_bytes);
+    bool started();
+
+    const SubsystemStats &stats(Subsystem subsystem);
+    uint64_t total_allocations();
+    int64_t peak_live_bytes(); // All subsystems together
+    DeviceHeapInfo device_info();
+    void reset_window();
+
+    // Blocks are stamped with the current epoch (the soak uses one per simulated day)
+    void set_epoch(uint32_t epoch);
+    // Live blocks per subsystem that were allocated in or after an epoch
+    void count_survivors(uint32_t since_epoch, uint64_t blocks[SUBSYSTEM_COUNT], uint64_t bytes[SUBSYSTEM_COUNT]);
+
+    // Suspends tracking in the harness's own bookkeeping, which has no device counterpart
+    class Pause
+    {
+    public:
+        Pause();
+        ~Pause();
+        Pause(const Pause &) = delete;
+        Pause &operator=(const Pause &) = delete;
+
+    private:
+        bool m_was_paused;
+    };
+} // namespace soak::heap
@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+// Host stand-in for the parts of the Arduino core the firmware uses. Time comes from the
+// soak virtual clock (tools/soak/sim.h); pins and ADC go to the simulated board, and LEDC and
+// RMT programs are only counted.
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define CHANGE 0x03
+
+#define digitalPinToInterrupt(pin) (pin)
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+// LEDC and RMT, as far as the pattern players use them (include/pattern_player.h)
+typedef union
+{
+    struct
+    {
+        uint32_t duration0 : 15;
+        uint32_t level0 : 1;
+        uint32_t duration1 : 15;
+        uint32_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_data_t;
+
+typedef enum
+{
+    RMT_RX_MODE = 0,
+    RMT_TX_MODE = 1
+} rmt_ch_dir_t;
+
+typedef enum
+{
+    RMT_MEM_NUM_BLOCKS_1 = 1
+} rmt_reserve_memsize_t;
+
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+uint32_t ledcChangeFrequency(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+bool ledcFade(uint8_t pin, uint32_t start_duty, uint32_t target_duty, int max_fade_time_ms);
+bool rmtInit(int pin, rmt_ch_dir_t channel_direction, rmt_reserve_memsize_t memsize, uint32_t frequency_Hz);
+bool rmtSetCarrier(int pin, bool carrier_en, bool carrier_level, uint32_t frequency_Hz, float duty_percent);
+bool rmtWriteAsync(int pin, rmt_data_t *data, size_t num_rmt_symbols);
+bool rmtWriteLooping(int pin, rmt_data_t *data, size_t num_rmt_symbols);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+void configTzTime(const char *tz, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+// Heap-backed like the Arduino String, so its allocations show up in the soak report
+class String
+{
+public:
+    String(const char *text = "") : m_text(text ? text : "") {}
+    String(const std::string &text) : m_text(text) {}
+    String(char c) : m_text(1, c) {}
+    String(int value) : m_text(std::to_string(value)) {}
+    String(unsigned int value) : m_text(std::to_string(value)) {}
+    String(long value) : m_text(std::to_string(value)) {}
+    String(unsigned long value) : m_text(std::to_string(value)) {}
+    String(float value, unsigned int decimals = 2) : String(static_cast<double>(value), decimals) {}
+    String(double value, unsigned int decimals = 2)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(decimals), value);
+        m_text = buffer;
+    }
+
+    const char *c_str() const { return m_text.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(m_text.size()); }
+    bool reserve(unsigned int size)
+    {
+        m_text.reserve(size);
+        return true;
+    }
+    bool concat(const char *text)
+    {
+        m_text += text ? text : "";
+        return true;
+    }
+    bool concat(const char *text, unsigned int length)
+    {
+        m_text.append(text, length);
+        return true;
+    }
+    void toLowerCase()
+    {
+        std::transform(m_text.begin(), m_text.end(), m_text.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+    }
+
+    String &operator+=(const String &other)
+    {
+        m_text += other.m_text;
+        return *this;
+    }
+    String &operator+=(const char *text)
+    {
+        m_text += text ? text : "";
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        m_text += c;
+        return *this;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a.m_text + b.m_text); }
+    friend String operator+(const String &a, const char *b) { return String(a.m_text + (b ? b : "")); }
+
+    bool operator==(const String &other) const { return m_text == other.m_text; }
+    bool operator==(const char *text) const { return m_text == (text ? text : ""); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+    bool operator<(const String &other) const { return m_text < other.m_text; }
+
+private:
+    std::string m_text;
+};
+
+class Print
+{
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+        {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long timeout_ms) { m_timeout_ms = timeout_ms; }
+
+protected:
+    unsigned long m_timeout_ms{1000};
+};
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long) {}
+    size_t write(const uint8_t *, size_t size) { return size; }
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap(); // Free bytes of the simulated device heap
+};
+extern EspClass ESP;
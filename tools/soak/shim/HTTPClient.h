@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_ACCEPTED 202
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Body of the last response, read back like the TLS stream it stands in for
+class HttpResponseStream : public WiFiClient
+{
+public:
+    void reset(const char *body);
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size) override;
+    int peek() override;
+
+private:
+    const char *m_body{""};
+    size_t m_position{0};
+};
+
+// Requests are answered by the soak network model after a simulated round trip
+class HTTPClient
+{
+public:
+    bool begin(WiFiClient &client, const String &url);
+    void addHeader(const String &name, const String &value);
+    void setTimeout(uint16_t timeout_ms) { m_timeout_ms = timeout_ms; }
+    int POST(uint8_t *payload, size_t size);
+    String getString();
+    WiFiClient *getStreamPtr() { return &m_stream; }
+    int getSize();
+    void end();
+
+private:
+    String m_url;
+    String m_headers;
+    const char *m_response{""};
+    HttpResponseStream m_stream;
+    uint16_t m_timeout_ms{5000};
+    bool m_begun{false};
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+
+class IPAddress
+{
+public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : m_octets{a, b, c, d} {}
+    explicit IPAddress(uint32_t address) { std::memcpy(m_octets, &address, sizeof(m_octets)); }
+
+    operator uint32_t() const
+    {
+        uint32_t address;
+        std::memcpy(&address, m_octets, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int index) const { return m_octets[index]; }
+    bool operator==(const IPAddress &other) const { return std::memcmp(m_octets, other.m_octets, sizeof(m_octets)) == 0; }
+
+    String toString() const
+    {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%u.%u.%u.%u", m_octets[0], m_octets[1], m_octets[2], m_octets[3]);
+        return String(text);
+    }
+
+private:
+    uint8_t m_octets[4]{};
+};
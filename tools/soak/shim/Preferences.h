@@ -0,0 +1,17 @@
+#pragma once
+#include <Arduino.h>
+
+// In-memory NVS namespace; contents live for the whole soak run
+class Preferences
+{
+public:
+    bool begin(const char *name, bool read_only = false);
+    void end() {}
+    float getFloat(const char *key, float default_value = 0.0F);
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buffer, size_t length);
+    size_t putBytes(const char *key, const void *value, size_t length);
+
+private:
+    char m_namespace[16]{};
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1
+} wifi_mode_t;
+
+// Station driven by the soak network model: drops out and reassociates on its own
+class WiFiClass
+{
+public:
+    bool mode(wifi_mode_t mode);
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+    wl_status_t begin(const char *ssid, const char *passphrase, int32_t channel, const uint8_t *bssid,
+                      bool connect = true);
+    bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+                IPAddress dns2 = IPAddress());
+    bool disconnect(bool wifi_off = false, bool erase_ap = false);
+    wl_status_t status();
+    String macAddress();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    uint8_t *BSSID();
+    int32_t channel();
+    int hostByName(const char *host, IPAddress &result);
+};
+extern WiFiClass WiFi;
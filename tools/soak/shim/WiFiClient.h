@@ -0,0 +1,45 @@
+#pragma once
+#include "Client.h"
+
+/**
+ * @brief TCP client backed by a simulated peer (MQTT broker or metrics scraper)
+ *
+ * Copies share the connection, as with the real WiFiClient; the peer itself lives in a
+ * fixed table in the soak harness so the harness's bookkeeping does not touch the heap.
+ */
+class WiFiClient : public Client
+{
+public:
+    WiFiClient() = default;
+    explicit WiFiClient(int peer) : m_peer(peer) {}
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+    void setNoDelay(bool) {}
+
+protected:
+    int m_peer{-1};
+};
+
+class WiFiServer
+{
+public:
+    explicit WiFiServer(uint16_t port = 80) : m_port(port) {}
+    void begin() { m_listening = true; }
+    void setNoDelay(bool) {}
+    WiFiClient accept(); // A pending scrape, or an unconnected client
+
+private:
+    uint16_t m_port;
+    bool m_listening{false};
+};
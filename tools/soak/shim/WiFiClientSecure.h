@@ -0,0 +1,11 @@
+#pragma once
+#include "WiFiClient.h"
+
+class WiFiClientSecure : public WiFiClient
+{
+public:
+    using WiFiClient::connect;
+    void setInsecure() {}
+    int connect(IPAddress ip, uint16_t port, const char *host, const char *ca_cert, const char *cert,
+                const char *private_key);
+};
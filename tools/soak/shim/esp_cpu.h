@@ -0,0 +1,4 @@
+#pragma once
+#include <cstdint>
+
+uint32_t esp_cpu_get_cycle_count(); // Virtual cycles at 160 MHz
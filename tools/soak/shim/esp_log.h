@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+uint32_t esp_log_timestamp(void);
+
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL 3 // As in platformio.ini, so the same log calls run as on the device
+#endif
+
+#define SOAK_LOG(level, tag, format, ...) esp_log_write(level, tag, format, ##__VA_ARGS__)
+#define ESP_LOGE(tag, format, ...) SOAK_LOG(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) SOAK_LOG(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) SOAK_LOG(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#if CORE_DEBUG_LEVEL >= 4
+#define ESP_LOGD(tag, format, ...) SOAK_LOG(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOGD(tag, format, ...) ((void)0)
+#endif
+#if CORE_DEBUG_LEVEL >= 5
+#define ESP_LOGV(tag, format, ...) SOAK_LOG(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOGV(tag, format, ...) ((void)0)
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <sys/time.h>
+
+// SNTP is modelled by configTzTime() in the soak harness: first sync after SNTP_US, then
+// one per sync interval while associated, each reported through the notification callback
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void sntp_set_sync_interval(uint32_t interval_ms);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
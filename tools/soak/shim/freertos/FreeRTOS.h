@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// Host stand-in for the FreeRTOS calls the event loop makes. There is one task and no
+// preemption; blocking moves the soak virtual clock, with 1 ms ticks as on the device.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
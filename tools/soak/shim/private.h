@@ -0,0 +1,20 @@
+#pragma once
+
+// Placeholder credentials; the soak network model accepts anything
+
+#define WIFI_SSID "soak"
+#define WIFI_PASS "soak"
+
+#define MQTT_USERNAME "soak"
+#define MQTT_PASSWORD "soak"
+#define MQTT_CLIENT_ID "pooaway-soak"
+#define MQTT_FEED_PREFIX "soak/feeds"
+
+#define AIO_USERNAME "soak"
+#define AIO_KEY "soak"
+#define API_PATH "/soak"
+
+#define THINGSPEAK_NH3_API_KEY "SOAKNH3KEY"
+#define THINGSPEAK_CH4_API_KEY "SOAKCH4KEY"
+#define THINGSPEAK_USER_API_KEY "SOAKUSERKEY"
+#define THINGSPEAK_ALERTS_API_KEY "SOAKALERTKEY"
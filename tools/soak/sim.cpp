@@ -0,0 +1,1038 @@
+/**
+ * @file sim.cpp
+ * @brief The simulated world and the shim functions that expose it to the firmware
+ */
+
+#include "sim.h"
+#include "heap_tracker.h"
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_rom_crc.h>
+#include <esp_sntp.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "config.h"
+
+namespace soak
+{
+    namespace
+    {
+        Options g_options;
+        Counters g_counters{};
+        uint64_t g_now_us = 0;
+        std::mt19937_64 g_random;
+
+        constexpr uint64_t US_PER_S = 1000000;
+        constexpr uint64_t US_PER_DAY = 86400 * US_PER_S;
+        constexpr uint64_t NEVER = UINT64_MAX;
+
+        // Events scheduled as exponential inter-arrival times from a daily rate
+        uint64_t next_after(double per_day)
+        {
+            return per_day > 0.0 ? g_now_us + static_cast<uint64_t>(random_exponential(US_PER_DAY / per_day)) : NEVER;
+        }
+
+        double log_uniform(double low, double high)
+        {
+            return low * std::pow(high / low, random_unit());
+        }
+
+        // Access point and station. Arduino reconnects on its own once the AP is back.
+        struct Network
+        {
+            bool begun = false;
+            bool ap_up = true;
+            uint64_t next_drop_us = NEVER;
+            uint64_t ap_back_us = 0;
+            uint64_t associated_at_us = NEVER;
+            uint64_t time_sync_at_us = NEVER;
+            uint64_t epoch_offset_s = 0; // Set by the first SNTP sync
+            uint64_t sync_interval_us = 3600 * US_PER_S;
+            sntp_sync_time_cb_t on_sync = nullptr;
+
+            static constexpr uint64_t ASSOCIATE_US = 1800000;     // Scan of every channel, then join
+            static constexpr uint64_t FAST_ASSOCIATE_US = 300000; // Known BSSID and channel
+            static constexpr uint64_t SNTP_US = 700000;
+            static constexpr uint64_t SYNCED_EPOCH_S = 1767225600; // 2026-01-01
+
+            void update()
+            {
+                if (ap_up && g_now_us >= next_drop_us)
+                {
+                    ap_up = false;
+                    ap_back_us = g_now_us + static_cast<uint64_t>(log_uniform(5.0, g_options.wifi_outage_max_s) * US_PER_S);
+                    associated_at_us = NEVER;
+                    g_counters.wifi_drops++;
+                }
+                if (!ap_up && g_now_us >= ap_back_us)
+                {
+                    ap_up = true;
+                    next_drop_us = next_after(g_options.wifi_drops_per_day);
+                    associated_at_us = begun ? g_now_us + ASSOCIATE_US : NEVER;
+                }
+                if (time_sync_at_us != NEVER && g_now_us >= time_sync_at_us && associated())
+                {
+                    epoch_offset_s = SYNCED_EPOCH_S;
+                    time_sync_at_us = g_now_us + sync_interval_us;
+                    if (on_sync)
+                    {
+                        timeval tv{};
+                        tv.tv_sec = static_cast<time_t>(epoch_offset_s + g_now_us / US_PER_S);
+                        tv.tv_usec = static_cast<suseconds_t>(g_now_us % US_PER_S);
+                        on_sync(&tv);
+                    }
+                }
+            }
+
+            bool associated() const { return begun && ap_up && g_now_us >= associated_at_us; }
+        };
+
+        Network g_network;
+
+        // Remote end of a WiFiClient
+        enum class PeerKind : uint8_t
+        {
+            FREE,
+            BROKER,
+            SCRAPER
+        };
+
+        struct Peer
+        {
+            PeerKind kind;
+            bool open;
+            uint64_t close_at_us; // Remote side goes away (broker drop, stream client leaving)
+            uint64_t last_rx_us;  // Last bytes from the device, for the broker's keepalive
+            uint8_t in[2048];     // Bytes from the device not yet parsed
+            size_t in_length;
+            uint8_t out[512];     // Bytes queued for the device
+            size_t out_length;
+            size_t out_position;
+        };
+
+        constexpr int MAX_PEERS = 8;
+        Peer g_peers[MAX_PEERS];
+
+        int open_peer(PeerKind kind)
+        {
+            for (int i = 0; i < MAX_PEERS; i++)
+            {
+                if (g_peers[i].kind == PeerKind::FREE)
+                {
+                    Peer &peer = g_peers[i];
+                    peer.kind = kind;
+                    peer.open = true;
+                    peer.close_at_us = NEVER;
+                    peer.last_rx_us = g_now_us;
+                    peer.in_length = 0;
+                    peer.out_length = 0;
+                    peer.out_position = 0;
+                    return i;
+                }
+            }
+            g_counters.peer_table_full++;
+            return -1;
+        }
+
+        void queue(Peer &peer, const uint8_t *data, size_t length)
+        {
+            if (peer.out_position == peer.out_length)
+            {
+                peer.out_position = peer.out_length = 0;
+            }
+            const size_t room = sizeof(peer.out) - peer.out_length;
+            std::memcpy(peer.out + peer.out_length, data, length < room ? length : room);
+            peer.out_length += length < room ? length : room;
+        }
+
+        bool peer_alive(Peer &peer)
+        {
+            g_network.update();
+            if (peer.open && (!g_network.associated() || g_now_us >= peer.close_at_us))
+            {
+                if (peer.kind == PeerKind::BROKER)
+                {
+                    g_counters.mqtt_drops++;
+                }
+                peer.open = false;
+            }
+            // A broker gives up on a client silent for 1.5 keepalive periods (MQTT 3.1.1, 3.1.2.10)
+            if (peer.open && peer.kind == PeerKind::BROKER &&
+                g_now_us - peer.last_rx_us > config::mqtt::KEEPALIVE_S * US_PER_S * 3 / 2)
+            {
+                g_counters.mqtt_keepalive_drops++;
+                peer.open = false;
+            }
+            return peer.open;
+        }
+
+        // Minimal MQTT 3.1.1 broker: acknowledges what MqttHandler sends and discards payloads
+        void broker_receive(Peer &peer)
+        {
+            for (;;)
+            {
+                if (peer.in_length < 2)
+                {
+                    return;
+                }
+                size_t remaining = 0, header = 1;
+                for (int shift = 0; header < peer.in_length; shift += 7)
+                {
+                    const uint8_t digit = peer.in[header++];
+                    remaining |= static_cast<size_t>(digit & 0x7F) << shift;
+                    if (!(digit & 0x80))
+                    {
+                        break;
+                    }
+                    if (header >= peer.in_length)
+                    {
+                        return; // Length not complete yet
+                    }
+                }
+                if (header + remaining > peer.in_length)
+                {
+                    return;
+                }
+
+                const uint8_t type = peer.in[0] >> 4;
+                const uint8_t *body = peer.in + header;
+                switch (type)
+                {
+                case 1: // CONNECT
+                {
+                    static constexpr uint8_t CONNACK[] = {0x20, 0x02, 0x00, 0x00};
+                    queue(peer, CONNACK, sizeof(CONNACK));
+                    g_counters.mqtt_sessions++;
+                    peer.close_at_us = next_after(g_options.mqtt_drops_per_day);
+                    break;
+                }
+                case 3: // PUBLISH
+                {
+                    g_counters.mqtt_publishes++;
+                    const uint8_t qos = (peer.in[0] >> 1) & 0x03;
+                    const size_t topic_length = (static_cast<size_t>(body[0]) << 8) | body[1];
+                    if (qos > 0 && remaining >= topic_length + 4)
+                    {
+                        const uint8_t puback[] = {0x40, 0x02, body[2 + topic_length], body[3 + topic_length]};
+                        queue(peer, puback, sizeof(puback));
+                    }
+                    break;
+                }
+                case 8: // SUBSCRIBE
+                {
+                    const uint8_t suback[] = {0x90, 0x03, body[0], body[1], 0x00};
+                    queue(peer, suback, sizeof(suback));
+                    break;
+                }
+                case 12: // PINGREQ
+                {
+                    static constexpr uint8_t PINGRESP[] = {0xD0, 0x00};
+                    queue(peer, PINGRESP, sizeof(PINGRESP));
+                    break;
+                }
+                case 14: // DISCONNECT
+                    peer.open = false;
+                    break;
+                default:
+                    break;
+                }
+
+                const size_t consumed = header + remaining;
+                std::memmove(peer.in, peer.in + consumed, peer.in_length - consumed);
+                peer.in_length -= consumed;
+            }
+        }
+
+        // Clients that connect to MetricsServer on their own schedule
+        struct Scrapers
+        {
+            uint64_t next_scrape_us = NEVER;
+            uint64_t next_stream_us = NEVER;
+
+            static constexpr uint64_t STREAM_STAY_US = 120 * US_PER_S;
+
+            int accept()
+            {
+                g_network.update();
+                if (!g_network.associated())
+                {
+                    return -1;
+                }
+
+                const char *request = nullptr;
+                uint64_t close_at = NEVER;
+                if (g_now_us >= next_scrape_us)
+                {
+                    next_scrape_us += g_options.scrape_interval_s * US_PER_S;
+                    request = "GET /metrics HTTP/1.0\r\nHost: pooaway\r\n\r\n";
+                    g_counters.scrapes++;
+                }
+                else if (g_now_us >= next_stream_us)
+                {
+                    next_stream_us += g_options.stream_interval_s * US_PER_S;
+                    request = "GET /stream HTTP/1.1\r\nHost: pooaway\r\nAccept: text/event-stream\r\n\r\n";
+                    close_at = g_now_us + STREAM_STAY_US;
+                    g_counters.streams++;
+                }
+                if (!request)
+                {
+                    return -1;
+                }
+
+                const int index = open_peer(PeerKind::SCRAPER);
+                if (index >= 0)
+                {
+                    g_peers[index].close_at_us = close_at;
+                    queue(g_peers[index], reinterpret_cast<const uint8_t *>(request), std::strlen(request));
+                }
+                return index;
+            }
+        };
+
+        Scrapers g_scrapers;
+
+        // NH3 and CH4 sensors on their divider: Rs follows a daily cycle, a slow drift and
+        // gas events, and is read back through the load resistor as a 12-bit ADC value. The
+        // config::mux pairs sit behind a 16-input mux on COM_PIN; a read before the selected
+        // input has settled still sees the previous one
+        struct Board
+        {
+            static constexpr uint64_t ADC_READ_US = 40; // One analogRead() on the ESP32-C6
+
+            struct Channel
+            {
+                int pin;
+                double load_ohms;  // Same as the sensor class's RL
+                double clean_rs;   // Rs in clean air at boot
+                int mux_input{-1}; // -1: wired straight to pin
+                double event_factor{1.0};
+                uint64_t event_start_us{0};
+                uint64_t event_end_us{0};
+            };
+
+            std::vector<Channel> channels;
+            uint64_t next_event_us = NEVER;
+            std::normal_distribution<double> noise{0.0, 3.0};
+            uint8_t select_bits{0};
+            int selected_input{-1};
+            int previous_input{-1};
+            uint64_t selected_at_us{0};
+
+            void wire()
+            {
+                channels = {{config::hardware::PEE_SENSOR_PIN, 47000.0, 30000.0},
+                            {config::hardware::POO_SENSOR_PIN, 4700.0, 10000.0}};
+                for (int pair = 0; pair < config::mux::PAIR_COUNT; pair++)
+                {
+                    channels.push_back({config::mux::COM_PIN, 47000.0, 30000.0, pair * 2});
+                    channels.push_back({config::mux::COM_PIN, 4700.0, 10000.0, pair * 2 + 1});
+                }
+            }
+
+            void write_select(uint8_t pin, uint8_t level)
+            {
+                for (size_t bit = 0; bit < 4; bit++)
+                {
+                    if (pin != config::mux::SELECT_PINS[bit])
+                    {
+                        continue;
+                    }
+                    select_bits = static_cast<uint8_t>((select_bits & ~(1U << bit)) | ((level ? 1U : 0U) << bit));
+                    if (select_bits != selected_input)
+                    {
+                        previous_input = selected_input;
+                        selected_input = select_bits;
+                        selected_at_us = g_now_us;
+                    }
+                }
+            }
+
+            uint16_t read(int pin)
+            {
+                advance_us(ADC_READ_US);
+                g_counters.adc_reads++;
+
+                int input = -1;
+                if (pin == config::mux::COM_PIN && config::mux::PAIR_COUNT > 0)
+                {
+                    input = selected_input;
+                    if (g_now_us - selected_at_us < config::mux::SETTLE_US)
+                    {
+                        g_counters.unsettled_reads++;
+                        input = previous_input;
+                    }
+                }
+
+                if (g_now_us >= next_event_us)
+                {
+                    Channel &channel = channels[static_cast<size_t>(random_unit() * channels.size())];
+                    channel.event_factor = 0.25 + 0.35 * random_unit(); // Rs falls with gas
+                    channel.event_start_us = g_now_us;
+                    channel.event_end_us = g_now_us + static_cast<uint64_t>((60.0 + 540.0 * random_unit()) * US_PER_S);
+                    next_event_us = next_after(g_options.gas_events_per_day);
+                    g_counters.gas_events++;
+                }
+
+                for (auto &channel : channels)
+                {
+                    if (channel.pin != pin || channel.mux_input != input)
+                    {
+                        continue;
+                    }
+                    const double days = static_cast<double>(g_now_us) / US_PER_DAY;
+                    double rs = channel.clean_rs * (1.0 + 0.04 * std::sin(2.0 * M_PI * days)) * (1.0 + 0.002 * days);
+                    if (g_now_us < channel.event_end_us)
+                    {
+                        // 30 s rise, then hold until the event ends
+                        const double rise = std::min(1.0, static_cast<double>(g_now_us - channel.event_start_us) / (30.0 * US_PER_S));
+                        rs *= 1.0 - rise * (1.0 - channel.event_factor);
+                    }
+                    const double raw = 4095.0 * channel.load_ohms / (channel.load_ohms + rs) + noise(g_random);
+                    return static_cast<uint16_t>(std::clamp(raw, 0.0, 4095.0));
+                }
+                return static_cast<uint16_t>(std::clamp(200.0 + noise(g_random), 0.0, 4095.0));
+            }
+        };
+
+        Board g_board;
+
+        // ThingSpeak connections are TLS, the largest allocations on the device. mbedTLS keeps
+        // its record buffers for the life of the connection and frees handshake state at the end.
+        constexpr size_t TLS_IN_BUFFER = 16384 + 325;
+        constexpr size_t TLS_OUT_BUFFER = 4096 + 325;
+        constexpr size_t TLS_HANDSHAKE_BLOCKS = 4;
+        constexpr size_t TLS_HANDSHAKE_MAX = 6144;
+
+        struct TlsSession
+        {
+            void *in_buffer = nullptr;
+            void *out_buffer = nullptr;
+
+            void open()
+            {
+                close();
+                void *handshake[TLS_HANDSHAKE_BLOCKS];
+                for (auto &block : handshake)
+                {
+                    block = std::malloc(512 + static_cast<size_t>(random_unit() * (TLS_HANDSHAKE_MAX - 512)));
+                }
+                in_buffer = std::malloc(TLS_IN_BUFFER);
+                out_buffer = std::malloc(TLS_OUT_BUFFER);
+                for (auto *block : handshake)
+                {
+                    std::free(block);
+                }
+            }
+
+            void close()
+            {
+                std::free(in_buffer);
+                std::free(out_buffer);
+                in_buffer = out_buffer = nullptr;
+            }
+        };
+
+        // One per HTTPClient; the firmware has a single one in ApiHandler
+        std::map<const HTTPClient *, TlsSession> *g_tls_sessions = nullptr;
+
+        TlsSession &tls_session(const HTTPClient *client)
+        {
+            heap::Pause pause;
+            if (!g_tls_sessions)
+            {
+                g_tls_sessions = new std::map<const HTTPClient *, TlsSession>();
+            }
+            return (*g_tls_sessions)[client];
+        }
+
+        std::map<std::string, std::vector<uint8_t>> &nvs()
+        {
+            static std::map<std::string, std::vector<uint8_t>> storage;
+            return storage;
+        }
+
+        std::string nvs_key(const char *space, const char *key)
+        {
+            return std::string(space) + "/" + key;
+        }
+
+        // NVS file: per entry, u32 key length, key, u32 value length, value (host byte order)
+        void load_nvs(const char *path)
+        {
+            FILE *file = std::fopen(path, "rb");
+            if (!file)
+            {
+                return; // First boot: flash is erased
+            }
+            uint32_t length = 0;
+            while (std::fread(&length, sizeof(length), 1, file) == 1)
+            {
+                std::string key(length, '\0');
+                std::vector<uint8_t> value;
+                if (std::fread(&key[0], 1, length, file) != length || std::fread(&length, sizeof(length), 1, file) != 1)
+                {
+                    break;
+                }
+                value.resize(length);
+                if (std::fread(value.data(), 1, length, file) != length)
+                {
+                    break;
+                }
+                nvs()[key] = std::move(value);
+            }
+            std::fclose(file);
+        }
+
+        void save_nvs(const char *path)
+        {
+            FILE *file = std::fopen(path, "wb");
+            if (!file)
+            {
+                std::fprintf(stderr, "cannot write %s\n", path);
+                return;
+            }
+            for (const auto &entry : nvs())
+            {
+                const auto key_length = static_cast<uint32_t>(entry.first.size());
+                const auto value_length = static_cast<uint32_t>(entry.second.size());
+                std::fwrite(&key_length, sizeof(key_length), 1, file);
+                std::fwrite(entry.first.data(), 1, key_length, file);
+                std::fwrite(&value_length, sizeof(value_length), 1, file);
+                std::fwrite(entry.second.data(), 1, value_length, file);
+            }
+            std::fclose(file);
+        }
+    } // namespace
+
+    Options &options() { return g_options; }
+
+    uint64_t now_us() { return g_now_us; }
+
+    void advance_us(uint64_t us) { g_now_us += us; }
+
+    double random_unit() { return std::uniform_real_distribution<double>(0.0, 1.0)(g_random); }
+
+    double random_exponential(double mean) { return std::exponential_distribution<double>(1.0 / mean)(g_random); }
+
+    Counters &counters() { return g_counters; }
+
+    void start_world()
+    {
+        heap::Pause pause;
+        g_random.seed(g_options.seed);
+        if (g_options.nvs_path)
+        {
+            load_nvs(g_options.nvs_path);
+        }
+        g_network.next_drop_us = next_after(g_options.wifi_drops_per_day);
+        if (g_options.boot_outage_s > 0.0)
+        {
+            g_network.ap_up = false;
+            g_network.ap_back_us = g_now_us + static_cast<uint64_t>(g_options.boot_outage_s * US_PER_S);
+        }
+        g_board.wire();
+        g_board.next_event_us = next_after(g_options.gas_events_per_day);
+        g_scrapers.next_scrape_us = g_options.scrape_interval_s ? g_now_us + g_options.scrape_interval_s * US_PER_S : NEVER;
+        g_scrapers.next_stream_us = g_options.stream_interval_s ? g_now_us + g_options.stream_interval_s * US_PER_S : NEVER;
+    }
+
+    void stop_world()
+    {
+        heap::Pause pause;
+        if (g_options.nvs_path)
+        {
+            save_nvs(g_options.nvs_path);
+        }
+    }
+} // namespace soak
+
+using namespace soak;
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+unsigned long millis()
+{
+    // 32 bits, as on the device, so rollover is exercised with --start-ms
+    return static_cast<uint32_t>(g_options.start_ms + g_now_us / 1000);
+}
+
+unsigned long micros() { return static_cast<uint32_t>(g_options.start_ms * 1000 + g_now_us); }
+
+void delay(uint32_t ms) { advance_ms(ms); }
+
+void delayMicroseconds(uint32_t us) { advance_us(us); }
+
+void yield() { advance_us(100); }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t level) { g_board.write_select(pin, level); }
+
+int digitalRead(uint8_t) { return HIGH; } // Calibration button never pressed
+
+uint16_t analogRead(uint8_t pin)
+{
+    heap::Pause pause;
+    return g_board.read(pin);
+}
+
+bool ledcAttach(uint8_t, uint32_t, uint8_t) { return true; }
+
+uint32_t ledcChangeFrequency(uint8_t, uint32_t freq, uint8_t) { return freq; }
+
+// Each LED pattern change is one duty write or one fade
+bool ledcWrite(uint8_t, uint32_t)
+{
+    g_counters.led_programs++;
+    return true;
+}
+
+bool ledcFade(uint8_t, uint32_t, uint32_t, int)
+{
+    g_counters.led_programs++;
+    return true;
+}
+
+bool rmtInit(int, rmt_ch_dir_t, rmt_reserve_memsize_t, uint32_t) { return true; }
+
+bool rmtSetCarrier(int, bool, bool, uint32_t, float) { return true; }
+
+bool rmtWriteAsync(int, rmt_data_t *, size_t)
+{
+    g_counters.tone_programs++;
+    return true;
+}
+
+bool rmtWriteLooping(int, rmt_data_t *, size_t)
+{
+    g_counters.tone_programs++;
+    return true;
+}
+
+void attachInterrupt(uint8_t, void (*)(), int) {} // Never fires: the button is never pressed
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return &g_now_us; }
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks_to_wait)
+{
+    // Nothing can notify the loop task, so every wait runs to its timeout
+    advance_ms(ticks_to_wait == portMAX_DELAY ? 1000 : ticks_to_wait);
+    return 0;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *) {}
+
+int64_t esp_timer_get_time() { return static_cast<int64_t>(g_now_us); }
+
+uint32_t esp_cpu_get_cycle_count() { return static_cast<uint32_t>(g_now_us * 160); }
+
+esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t)
+{
+    static constexpr uint8_t STATION_MAC[6] = {0x58, 0xCF, 0x79, 0x00, 0x50, 0x0A};
+    std::memcpy(mac, STATION_MAC, sizeof(STATION_MAC));
+    return ESP_OK;
+}
+
+uint32_t EspClass::getFreeHeap() { return static_cast<uint32_t>(heap::device_info().free_bytes); }
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    g_counters.logs[level]++;
+    if (static_cast<int>(level) > g_options.log_level)
+    {
+        return;
+    }
+
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    const uint64_t seconds = g_now_us / US_PER_S;
+    std::fprintf(stderr, "[%3llud %02llu:%02llu:%02llu] %c %s: %s\n", static_cast<unsigned long long>(seconds / 86400),
+                 static_cast<unsigned long long>(seconds / 3600 % 24), static_cast<unsigned long long>(seconds / 60 % 60),
+                 static_cast<unsigned long long>(seconds % 60), "NEWIDV"[level], tag, text);
+}
+
+uint32_t esp_log_timestamp() { return static_cast<uint32_t>(millis()); }
+
+// Wall clock for the firmware: seconds since boot until SNTP has synced, as on the device
+extern "C" time_t time(time_t *out)
+{
+    g_network.update();
+    const auto now = static_cast<time_t>(g_network.epoch_offset_s + g_now_us / US_PER_S);
+    if (out)
+    {
+        *out = now;
+    }
+    return now;
+}
+
+void configTzTime(const char *, const char *, const char *, const char *)
+{
+    g_network.time_sync_at_us = g_now_us + Network::SNTP_US;
+}
+
+void sntp_set_sync_interval(uint32_t interval_ms) { g_network.sync_interval_us = interval_ms * 1000ULL; }
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) { g_network.on_sync = callback; }
+
+bool getLocalTime(struct tm *info, uint32_t ms)
+{
+    const uint64_t give_up = g_now_us + static_cast<uint64_t>(ms) * 1000;
+    for (;;)
+    {
+        const time_t now = time(nullptr);
+        if (now >= 1000000000)
+        {
+            gmtime_r(&now, info);
+            return true;
+        }
+        if (g_now_us >= give_up)
+        {
+            return false;
+        }
+        delay(10);
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t) { return true; }
+
+wl_status_t WiFiClass::begin(const char *, const char *)
+{
+    g_network.update();
+    if (!g_network.begun || !g_network.associated())
+    {
+        g_network.begun = true;
+        g_network.associated_at_us = g_network.ap_up ? g_now_us + Network::ASSOCIATE_US : NEVER;
+    }
+    return status();
+}
+
+wl_status_t WiFiClass::status()
+{
+    g_network.update();
+    if (!g_network.begun)
+    {
+        return WL_IDLE_STATUS;
+    }
+    return g_network.associated() ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::begin(const char *, const char *, int32_t, const uint8_t *, bool)
+{
+    g_network.update();
+    if (!g_network.begun || !g_network.associated())
+    {
+        g_network.begun = true;
+        g_network.associated_at_us = g_network.ap_up ? g_now_us + Network::FAST_ASSOCIATE_US : NEVER;
+    }
+    return status();
+}
+
+bool WiFiClass::config(IPAddress, IPAddress, IPAddress, IPAddress, IPAddress) { return true; }
+
+bool WiFiClass::disconnect(bool, bool)
+{
+    g_network.associated_at_us = NEVER;
+    return true;
+}
+
+String WiFiClass::macAddress() { return String("58:CF:79:00:50:0A"); }
+
+IPAddress WiFiClass::localIP() { return g_network.associated() ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+
+IPAddress WiFiClass::gatewayIP() { return g_network.associated() ? IPAddress(192, 168, 1, 1) : IPAddress(); }
+
+IPAddress WiFiClass::subnetMask() { return g_network.associated() ? IPAddress(255, 255, 255, 0) : IPAddress(); }
+
+IPAddress WiFiClass::dnsIP(uint8_t) { return g_network.associated() ? IPAddress(192, 168, 1, 1) : IPAddress(); }
+
+uint8_t *WiFiClass::BSSID()
+{
+    static uint8_t bssid[6] = {0x24, 0x4B, 0xFE, 0x12, 0x34, 0x56};
+    return g_network.associated() ? bssid : nullptr;
+}
+
+int32_t WiFiClass::channel() { return g_network.associated() ? 6 : 0; }
+
+int WiFiClass::hostByName(const char *, IPAddress &result)
+{
+    g_network.update();
+    g_counters.dns_lookups++;
+    if (!g_network.associated())
+    {
+        advance_ms(5000); // Resolver timeout
+        return 0;
+    }
+    advance_ms(static_cast<uint64_t>(log_uniform(20.0, 120.0)));
+    result = IPAddress(203, 0, 113, 10);
+    return 1;
+}
+
+int WiFiClient::connect(IPAddress, uint16_t) { return connect("", 0); }
+
+int WiFiClientSecure::connect(IPAddress, uint16_t, const char *, const char *, const char *, const char *)
+{
+    // Opened ahead of HTTPClient, which models the handshake itself in POST()
+    g_network.update();
+    if (!g_network.associated())
+    {
+        advance_ms(3000);
+        return 0;
+    }
+    advance_ms(40);
+    return 1;
+}
+
+int WiFiClient::connect(const char *, uint16_t)
+{
+    stop();
+    g_network.update();
+    g_counters.tcp_connects++;
+    if (!g_network.associated() || random_unit() < g_options.tcp_connect_failure_rate)
+    {
+        g_counters.tcp_connect_failures++;
+        advance_ms(3000); // Connect timeout
+        return 0;
+    }
+    advance_ms(40);
+    m_peer = open_peer(PeerKind::BROKER);
+    return m_peer >= 0;
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    if (m_peer < 0 || !peer_alive(g_peers[m_peer]))
+    {
+        return 0;
+    }
+
+    Peer &peer = g_peers[m_peer];
+    if (peer.kind == PeerKind::SCRAPER)
+    {
+        g_counters.scrape_bytes += size;
+        return size;
+    }
+
+    peer.last_rx_us = g_now_us;
+    const size_t room = sizeof(peer.in) - peer.in_length;
+    const size_t accepted = size < room ? size : room;
+    std::memcpy(peer.in + peer.in_length, buffer, accepted);
+    peer.in_length += accepted;
+    broker_receive(peer);
+    return accepted;
+}
+
+int WiFiClient::available()
+{
+    if (m_peer < 0 || !peer_alive(g_peers[m_peer]))
+    {
+        return 0;
+    }
+    const Peer &peer = g_peers[m_peer];
+    return static_cast<int>(peer.out_length - peer.out_position);
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+    const int ready = available();
+    if (ready <= 0)
+    {
+        return -1;
+    }
+    Peer &peer = g_peers[m_peer];
+    const size_t count = size < static_cast<size_t>(ready) ? size : static_cast<size_t>(ready);
+    std::memcpy(buffer, peer.out + peer.out_position, count);
+    peer.out_position += count;
+    return static_cast<int>(count);
+}
+
+int WiFiClient::peek()
+{
+    return available() > 0 ? g_peers[m_peer].out[g_peers[m_peer].out_position] : -1;
+}
+
+void WiFiClient::stop()
+{
+    if (m_peer >= 0)
+    {
+        g_peers[m_peer].kind = PeerKind::FREE;
+        g_peers[m_peer].open = false;
+        m_peer = -1;
+    }
+}
+
+uint8_t WiFiClient::connected()
+{
+    return m_peer >= 0 && peer_alive(g_peers[m_peer]);
+}
+
+WiFiClient WiFiServer::accept()
+{
+    return m_listening ? WiFiClient(g_scrapers.accept()) : WiFiClient();
+}
+
+bool HTTPClient::begin(WiFiClient &, const String &url)
+{
+    m_url = url;
+    m_begun = true;
+    return true;
+}
+
+void HTTPClient::addHeader(const String &name, const String &value)
+{
+    m_headers += name + ": " + value + "\r\n";
+}
+
+int HTTPClient::POST(uint8_t *, size_t)
+{
+    if (!m_begun)
+    {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    g_network.update();
+    g_counters.http_posts++;
+    if (!g_network.associated() || random_unit() < g_options.tcp_connect_failure_rate)
+    {
+        g_counters.http_failures++;
+        advance_ms(3000);
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    tls_session(this).open();
+    advance_ms(static_cast<uint64_t>(log_uniform(250.0, 1500.0))); // Handshake and round trip
+
+    const double outcome = random_unit();
+    if (outcome < g_options.http_timeout_rate)
+    {
+        g_counters.http_failures++;
+        advance_ms(m_timeout_ms);
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    if (outcome < g_options.http_timeout_rate + g_options.http_error_rate)
+    {
+        g_counters.http_failures++;
+        return 500;
+    }
+    m_response = "{\"success\":true}";
+    m_stream.reset(m_response);
+    return HTTP_CODE_OK;
+}
+
+String HTTPClient::getString() { return String(m_response); }
+
+int HTTPClient::getSize() { return static_cast<int>(std::strlen(m_response)); }
+
+void HttpResponseStream::reset(const char *body)
+{
+    m_body = body;
+    m_position = 0;
+}
+
+int HttpResponseStream::available() { return static_cast<int>(std::strlen(m_body + m_position)); }
+
+int HttpResponseStream::read()
+{
+    return m_body[m_position] != '\0' ? static_cast<uint8_t>(m_body[m_position++]) : -1;
+}
+
+int HttpResponseStream::read(uint8_t *buffer, size_t size)
+{
+    const size_t length = std::min(size, static_cast<size_t>(available()));
+    std::memcpy(buffer, m_body + m_position, length);
+    m_position += length;
+    return static_cast<int>(length);
+}
+
+int HttpResponseStream::peek() { return m_body[m_position] != '\0' ? static_cast<uint8_t>(m_body[m_position]) : -1; }
+
+void HTTPClient::end()
+{
+    tls_session(this).close();
+    m_url = String();
+    m_headers = String();
+    m_response = "";
+    m_stream.reset(m_response);
+    m_begun = false;
+}
+
+bool Preferences::begin(const char *name, bool)
+{
+    std::snprintf(m_namespace, sizeof(m_namespace), "%s", name);
+    return true;
+}
+
+float Preferences::getFloat(const char *key, float default_value)
+{
+    float value = default_value;
+    return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : default_value;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    heap::Pause pause;
+    const auto it = nvs().find(nvs_key(m_namespace, key));
+    return it == nvs().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t length)
+{
+    heap::Pause pause;
+    const auto it = nvs().find(nvs_key(m_namespace, key));
+    if (it == nvs().end() || it->second.size() > length)
+    {
+        return 0;
+    }
+    std::memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+    heap::Pause pause;
+    const auto *bytes = static_cast<const uint8_t *>(value);
+    nvs()[nvs_key(m_namespace, key)].assign(bytes, bytes + length);
+    advance_ms(20); // Flash write
+    return length;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Simulated world behind the Arduino shims: a virtual clock that only moves when the firmware
+ * waits (delay(), timeouts, network round trips), a flaky access point, MQTT broker and
+ * ThingSpeak endpoint, a metrics scraper, and two gas sensors with occasional events.
+ */
+namespace soak
+{
+    struct Options
+    {
+        uint32_t days = 30;
+        uint32_t seed = 1;
+        uint32_t device_heap_kb = 160;    // Free heap left to the application after WiFi and TLS init
+        uint64_t start_ms = 0;            // Boot time on the 32-bit millis() clock, to test rollover
+        double wifi_drops_per_day = 4.0;  // Access point outages
+        double wifi_outage_max_s = 900.0; // Outage lengths are log-uniform from 5 s up to this
+        double http_timeout_rate = 0.03;  // ThingSpeak POST times out
+        double http_error_rate = 0.02;    // ThingSpeak answers 5xx
+        double tcp_connect_failure_rate = 0.05;
+        double mqtt_drops_per_day = 12.0; // Broker closes an established session
+        double gas_events_per_day = 8.0;
+        uint32_t scrape_interval_s = 15;  // Prometheus scrape of /metrics, 0 to disable
+        uint32_t stream_interval_s = 3600; // A /stream client that stays 2 minutes, 0 to disable
+        const char *nvs_path = nullptr;   // NVS read at boot and written at exit, so a second run is a reboot
+        double boot_outage_s = 0.0;       // Access point down for this long from boot
+        int log_level = 1;                // esp_log_level_t printed to stderr
+    };
+
+    Options &options();
+
+    // Virtual clock, in microseconds since boot
+    uint64_t now_us();
+    void advance_us(uint64_t us);
+    inline void advance_ms(uint64_t ms) { advance_us(ms * 1000); }
+
+    double random_unit(); // Uniform in [0, 1)
+    double random_exponential(double mean);
+
+    struct Counters
+    {
+        uint32_t wifi_drops;
+        uint32_t tcp_connects;
+        uint32_t tcp_connect_failures;
+        uint32_t dns_lookups;
+        uint32_t mqtt_sessions;
+        uint32_t mqtt_publishes;
+        uint32_t mqtt_drops;
+        uint32_t mqtt_keepalive_drops; // Sessions the broker closed after 1.5 keepalives of silence
+        uint32_t http_posts;
+        uint32_t http_failures;
+        uint32_t scrapes;
+        uint32_t streams;
+        uint64_t scrape_bytes;
+        uint32_t gas_events;
+        uint32_t adc_reads;
+        uint32_t unsettled_reads; // Mux reads taken before the selected input had settled
+        uint32_t led_programs;  // LEDC writes, one per LED pattern change
+        uint32_t tone_programs; // RMT writes, one per buzzer pattern change
+        uint32_t peer_table_full;
+        uint32_t logs[6]; // By esp_log_level_t
+    };
+
+    Counters &counters();
+
+    // Starts the schedules (outages, gas events, scrapes) from the current virtual time
+    void start_world();
+    // Writes NVS back to Options::nvs_path
+    void stop_world();
+} // namespace soak
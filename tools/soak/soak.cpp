@@ -0,0 +1,349 @@
+/**
+ * @file soak.cpp
+ * @brief Runs the firmware's setup() and loop() for simulated weeks and reports heap behaviour
+ *
+ * The firmware sources are compiled unchanged against the shims in tools/soak/shim. Time only
+ * advances when the firmware waits, so a month of uptime takes minutes. Every heap block is
+ * charged to a subsystem (see heap_tracker.h); at the end of each simulated day the live bytes
+ * per subsystem and the state of the device heap model are recorded. A subsystem whose live
+ * bytes keep growing after the first day is reported as leaking.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "heap_tracker.h"
+#include "sim.h"
+#include "alert_manager.h"
+#include "sensor_manager.h"
+#include "config.h"
+#if POOAWAY_WITH_NETWORK
+#include "network_cache.h"
+#include "wifi_manager.h"
+#endif
+
+void setup();
+void loop();
+
+using namespace soak;
+using heap::Subsystem;
+using heap::SUBSYSTEM_COUNT;
+
+namespace
+{
+    constexpr uint64_t US_PER_DAY = 86400ULL * 1000000ULL;
+    constexpr double LEAK_BYTES_PER_DAY = 16.0; // Slope above which a subsystem is flagged
+
+    // Alert mask transitions seen by the local handlers, counted from the first alert on
+    struct AlertTally
+    {
+        uint32_t mask;
+        uint32_t episodes;     // Alerts that cleared again
+        uint32_t mask_changes; // Any channel starting or stopping, episodes included
+        bool started;
+        uint32_t led_base;     // Pattern programs before the first alert (boot, first refresh)
+        uint32_t tone_base;
+    };
+
+    void tally_alerts(AlertTally &tally, uint32_t led_before, uint32_t tone_before)
+    {
+        const uint32_t mask = pooaway::alert::AlertManager::instance().get_alert_mask();
+        if (mask == tally.mask)
+        {
+            return;
+        }
+        if (!tally.started)
+        {
+            tally.started = true;
+            tally.led_base = led_before;
+            tally.tone_base = tone_before;
+        }
+        tally.mask_changes++;
+        tally.episodes += mask == 0 ? 1 : 0;
+        tally.mask = mask;
+    }
+
+    // Each alert programs the LED and the buzzer once when it starts and once when it clears;
+    // a second channel joining or leaving may add one more. Anything else is a dropped or
+    // repeated write
+    bool check_patterns(const AlertTally &tally)
+    {
+        const Counters &c = counters();
+        const uint32_t led = c.led_programs - (tally.started ? tally.led_base : c.led_programs);
+        const uint32_t tone = c.tone_programs - (tally.started ? tally.tone_base : c.tone_programs);
+        const uint32_t least = 2 * tally.episodes + (tally.mask != 0 ? 1 : 0);
+        const uint32_t most = tally.mask_changes;
+        const bool ok = (tally.episodes > 0 || c.gas_events == 0) && led >= least && led <= most && tone >= least && tone <= most;
+        std::printf("alerts: %u cleared, %u mask changes; pattern programs since the first: LED %u, buzzer %u"
+                    " (expected %u to %u)%s\n",
+                    tally.episodes, tally.mask_changes, led, tone, least, most,
+                    ok ? "" : tally.episodes ? "  MISMATCH" : "  NO ALERTS FROM GAS EVENTS");
+        return ok;
+    }
+
+    struct DayRecord
+    {
+        uint64_t loops;
+        uint64_t allocations;
+        uint32_t max_allocations_per_loop;
+        heap::DeviceHeapInfo device;
+        int64_t live_bytes[SUBSYSTEM_COUNT];
+    };
+
+    void usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--days N] [--seed N] [--heap-kb N] [--start-ms N] [--wifi-drops N]\n"
+                     "          [--mqtt-drops N] [--http-timeouts P] [--gas-events N] [--scrape-s N]\n"
+                     "          [--nvs FILE] [--boot-outage-s N] [--log LEVEL]\n",
+                     program);
+    }
+
+    bool parse(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const char *arg = argv[i];
+            const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            const auto take = [&]() -> const char *
+            {
+                i++;
+                return value;
+            };
+
+            if (!value)
+                return false;
+            else if (std::strcmp(arg, "--days") == 0)
+                options.days = static_cast<uint32_t>(std::strtoul(take(), nullptr, 10));
+            else if (std::strcmp(arg, "--seed") == 0)
+                options.seed = static_cast<uint32_t>(std::strtoul(take(), nullptr, 10));
+            else if (std::strcmp(arg, "--heap-kb") == 0)
+                options.device_heap_kb = static_cast<uint32_t>(std::strtoul(take(), nullptr, 10));
+            else if (std::strcmp(arg, "--start-ms") == 0)
+                options.start_ms = std::strtoull(take(), nullptr, 10);
+            else if (std::strcmp(arg, "--wifi-drops") == 0)
+                options.wifi_drops_per_day = std::strtod(take(), nullptr);
+            else if (std::strcmp(arg, "--mqtt-drops") == 0)
+                options.mqtt_drops_per_day = std::strtod(take(), nullptr);
+            else if (std::strcmp(arg, "--http-timeouts") == 0)
+                options.http_timeout_rate = std::strtod(take(), nullptr);
+            else if (std::strcmp(arg, "--gas-events") == 0)
+                options.gas_events_per_day = std::strtod(take(), nullptr);
+            else if (std::strcmp(arg, "--scrape-s") == 0)
+                options.scrape_interval_s = static_cast<uint32_t>(std::strtoul(take(), nullptr, 10));
+            else if (std::strcmp(arg, "--nvs") == 0)
+                options.nvs_path = take();
+            else if (std::strcmp(arg, "--boot-outage-s") == 0)
+                options.boot_outage_s = std::strtod(take(), nullptr);
+            else if (std::strcmp(arg, "--log") == 0)
+                options.log_level = std::atoi(take());
+            else
+                return false;
+        }
+        return options.days > 0;
+    }
+
+    // Least-squares slope of live bytes over the days after the first
+    double slope_per_day(const std::vector<DayRecord> &days, size_t subsystem)
+    {
+        const size_t n = days.size() > 1 ? days.size() - 1 : 0;
+        if (n < 2)
+        {
+            return 0.0;
+        }
+        double sum_x = 0, sum_y = 0, sum_xy = 0, sum_xx = 0;
+        for (size_t i = 1; i < days.size(); i++)
+        {
+            const double x = static_cast<double>(i);
+            const double y = static_cast<double>(days[i].live_bytes[subsystem]);
+            sum_x += x;
+            sum_y += y;
+            sum_xy += x * y;
+            sum_xx += x * x;
+        }
+        const double denominator = n * sum_xx - sum_x * sum_x;
+        return denominator != 0.0 ? (n * sum_xy - sum_x * sum_y) / denominator : 0.0;
+    }
+
+    void print_days(const std::vector<DayRecord> &days)
+    {
+        std::printf("\n%4s %10s %11s %9s %10s %10s %11s %11s %6s %10s\n", "day", "loops", "allocs/loop", "max/loop",
+                    "free", "min_free", "largest", "min_largest", "frag%", "live");
+        for (size_t i = 0; i < days.size(); i++)
+        {
+            const DayRecord &day = days[i];
+            int64_t live = 0;
+            for (size_t s = 0; s < SUBSYSTEM_COUNT; s++)
+            {
+                live += day.live_bytes[s];
+            }
+            const double fragmentation =
+                day.device.free_bytes ? 100.0 * (1.0 - static_cast<double>(day.device.largest_free_block) / day.device.free_bytes) : 0.0;
+            std::printf("%4zu %10" PRIu64 " %11.3f %9u %10zu %10zu %11zu %11zu %6.1f %10" PRId64 "\n", i + 1, day.loops,
+                        day.loops ? static_cast<double>(day.allocations) / day.loops : 0.0, day.max_allocations_per_loop,
+                        day.device.free_bytes, day.device.min_free_bytes, day.device.largest_free_block,
+                        day.device.min_largest_free, fragmentation, live);
+        }
+    }
+
+    bool print_subsystems(const std::vector<DayRecord> &days, uint64_t total_loops, const uint32_t max_per_loop[])
+    {
+        uint64_t survivor_blocks[SUBSYSTEM_COUNT], survivor_bytes[SUBSYSTEM_COUNT];
+        heap::count_survivors(2, survivor_blocks, survivor_bytes);
+
+        std::printf("\n%-14s %12s %10s %9s %12s %10s %10s %10s %11s %10s\n", "subsystem", "allocations", "per_1k_loop",
+                    "max/loop", "bytes", "peak_live", "live_d1", "live_end", "slope_B/d", "survivors");
+        bool leaking = false;
+        for (size_t s = 0; s < SUBSYSTEM_COUNT; s++)
+        {
+            const auto &stats = heap::stats(static_cast<Subsystem>(s));
+            const double slope = slope_per_day(days, s);
+            const bool leak = days.size() > 2 && slope > LEAK_BYTES_PER_DAY &&
+                              days.back().live_bytes[s] > days[1].live_bytes[s];
+            leaking |= leak;
+            std::printf("%-14s %12" PRIu64 " %10.2f %9u %12" PRIu64 " %10" PRId64 " %10" PRId64 " %10" PRId64
+                        " %11.1f %4" PRIu64 "/%-6" PRIu64 "%s\n",
+                        heap::subsystem_name(static_cast<Subsystem>(s)), stats.allocations,
+                        total_loops ? 1000.0 * stats.allocations / total_loops : 0.0, max_per_loop[s],
+                        stats.bytes_allocated, stats.peak_live_bytes, days.front().live_bytes[s], days.back().live_bytes[s],
+                        slope, survivor_blocks[s], survivor_bytes[s], leak ? "  LEAK" : "");
+        }
+        std::printf("(survivors: blocks/bytes allocated after day 1 and still live)\n");
+        return leaking;
+    }
+
+    void print_world()
+    {
+        const Counters &c = counters();
+        std::printf("\nworld: wifi drops %u, tcp connects %u (%u failed), mqtt sessions %u, publishes %u, drops %u"
+                    " (%u keepalive)\n",
+                    c.wifi_drops, c.tcp_connects, c.tcp_connect_failures, c.mqtt_sessions, c.mqtt_publishes, c.mqtt_drops,
+                    c.mqtt_keepalive_drops);
+        std::printf("       http posts %u (%u failed), scrapes %u (%" PRIu64 " bytes), streams %u, gas events %u\n",
+                    c.http_posts, c.http_failures, c.scrapes, c.scrape_bytes, c.streams, c.gas_events);
+        std::printf("       logs E %u W %u I %u%s\n", c.logs[1], c.logs[2], c.logs[3],
+                    c.peer_table_full ? ", peer table full!" : "");
+        std::printf("       pattern programs: LED %u, buzzer %u\n", c.led_programs, c.tone_programs);
+
+        // Scan throughput through the mux settle scheduler; build with -DPOOAWAY_MUX_PAIRS=N
+        const auto &sensors = pooaway::sensors::SensorManager::instance();
+        const auto &scan = sensors.get_scan_stats();
+        const double mean_scan_ms = scan.completed_scans ? scan.total_scan_us / 1000.0 / scan.completed_scans : 0.0;
+        std::printf("scan: %zu channels (%d on the mux), %u full scans, mean %.2f ms, max %.2f ms, %.0f channels/s\n",
+                    sensors.get_channel_count(), 2 * config::mux::PAIR_COUNT, scan.completed_scans, mean_scan_ms,
+                    scan.max_scan_us / 1000.0, mean_scan_ms > 0.0 ? sensors.get_channel_count() * 1000.0 / mean_scan_ms : 0.0);
+        std::printf("      adc reads %u, %u before the mux input settled, %u failed reads\n", c.adc_reads,
+                    c.unsettled_reads, scan.failed_reads);
+
+#if POOAWAY_WITH_NETWORK
+        // Device side of the same reconnects: which path each took and what it cost
+        const auto &wifi = pooaway::WiFiManager::instance().get_connect_stats();
+        const auto &net = pooaway::NetworkCache::instance().get_stats();
+        std::printf("network: wifi joins %u cached (last %u ms), %u scanned (last %u ms), %u fast failures\n",
+                    wifi.fast_connects, wifi.last_fast_ms, wifi.scan_connects, wifi.last_scan_ms, wifi.fast_failures);
+        std::printf("         dns %u cached, %u looked up (%u on the wire), %u failed, %u forgotten\n", net.dns_hits,
+                    net.dns_misses, c.dns_lookups, net.dns_failures, net.stale_forgotten);
+        const auto mean_ms = [](const pooaway::NetworkCache::FirstByteStats &s)
+        { return s.count ? static_cast<double>(s.total_ms) / s.count : 0.0; };
+        std::printf("         first byte: cached %u (mean %.0f ms, max %u ms), resolved %u (mean %.0f ms, max %u ms)\n",
+                    net.first_byte_cached.count, mean_ms(net.first_byte_cached), net.first_byte_cached.max_ms,
+                    net.first_byte_resolved.count, mean_ms(net.first_byte_resolved), net.first_byte_resolved.max_ms);
+#endif
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options &opts = options();
+    if (!parse(argc, argv, opts))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::printf("PooAway soak: %u days, seed %u, device heap %u KB, millis() starts at %" PRIu64 ", handlers:",
+                opts.days, opts.seed, opts.device_heap_kb, opts.start_ms);
+
+    start_world();
+    heap::start(static_cast<size_t>(opts.device_heap_kb) * 1024);
+
+    setup();
+    auto &alert_manager = pooaway::alert::AlertManager::instance();
+    for (size_t i = 0; i < alert_manager.get_handler_count(); i++)
+    {
+        std::printf(" %s", alert_manager.get_handler_stats(i).name);
+    }
+    std::printf("\n");
+
+    std::vector<DayRecord> days;
+    {
+        heap::Pause pause;
+        days.reserve(opts.days);
+    }
+
+    uint32_t max_per_loop[SUBSYSTEM_COUNT] = {};
+    uint64_t total_loops = 0;
+    AlertTally alerts{};
+    uint64_t day_end = US_PER_DAY;
+    DayRecord day{};
+    heap::set_epoch(1);
+    heap::reset_window();
+
+    while (days.size() < opts.days)
+    {
+        uint64_t before[SUBSYSTEM_COUNT];
+        for (size_t s = 0; s < SUBSYSTEM_COUNT; s++)
+        {
+            before[s] = heap::stats(static_cast<Subsystem>(s)).allocations;
+        }
+        const uint64_t total_before = heap::total_allocations();
+        const uint32_t led_before = counters().led_programs;
+        const uint32_t tone_before = counters().tone_programs;
+
+        loop();
+        tally_alerts(alerts, led_before, tone_before);
+
+        const auto in_loop = static_cast<uint32_t>(heap::total_allocations() - total_before);
+        day.loops++;
+        day.allocations += in_loop;
+        day.max_allocations_per_loop = std::max(day.max_allocations_per_loop, in_loop);
+        if (in_loop)
+        {
+            for (size_t s = 0; s < SUBSYSTEM_COUNT; s++)
+            {
+                const auto delta = static_cast<uint32_t>(heap::stats(static_cast<Subsystem>(s)).allocations - before[s]);
+                max_per_loop[s] = std::max(max_per_loop[s], delta);
+            }
+        }
+
+        if (now_us() >= day_end)
+        {
+            day.device = heap::device_info();
+            for (size_t s = 0; s < SUBSYSTEM_COUNT; s++)
+            {
+                day.live_bytes[s] = heap::stats(static_cast<Subsystem>(s)).live_bytes;
+            }
+            days.push_back(day);
+            total_loops += day.loops;
+            day = DayRecord{};
+            day_end += US_PER_DAY;
+            heap::set_epoch(static_cast<uint32_t>(days.size() + 1));
+            heap::reset_window();
+            std::fprintf(stderr, "\rday %zu/%u", days.size(), opts.days);
+        }
+    }
+    std::fprintf(stderr, "\n");
+
+    print_days(days);
+    const bool leaking = print_subsystems(days, total_loops, max_per_loop);
+    print_world();
+    const bool patterns_ok = check_patterns(alerts);
+    stop_world();
+
+    const auto device = heap::device_info();
+    std::printf("\npeak live bytes %" PRId64 ", device heap: min free %zu of %zu, %u allocations would have failed\n",
+                heap::peak_live_bytes(), device.min_free_bytes, device.capacity, device.failed_allocations);
+    return (leaking || device.failed_allocations || !patterns_ok) ? 1 : 0;
+}
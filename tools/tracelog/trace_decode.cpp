@@ -0,0 +1,161 @@
+/**
+ * @file trace_decode.cpp
+ * @brief Decodes binary TRACE_LOGx frames captured from the device serial port
+ *
+ * With config::trace::BINARY_OUTPUT the firmware writes each deferred log record as a raw
+ * frame: FRAME_MAGIC followed by a pooaway::trace::Record. Format and tag strings are stored
+ * by address, so they are looked up in the firmware ELF that produced the capture. Bytes that
+ * are not part of a valid frame (ordinary ESP_LOGx text) are passed through unchanged, so the
+ * output reads like the normal serial log.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "trace_ring.h"
+
+using namespace pooaway::trace;
+
+namespace
+{
+    // Allocated sections of a little-endian ELF32 image, enough to map addresses to bytes
+    class ElfImage
+    {
+    public:
+        bool load(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            static constexpr uint8_t ELF_MAGIC[] = {0x7F, 'E', 'L', 'F'};
+            constexpr uint8_t ELFCLASS32 = 1;
+            constexpr uint8_t ELFDATA2LSB = 1;
+            if (m_data.size() < 52 || std::memcmp(m_data.data(), ELF_MAGIC, sizeof(ELF_MAGIC)) != 0 ||
+                m_data[4] != ELFCLASS32 || m_data[5] != ELFDATA2LSB)
+            {
+                std::fprintf(stderr, "%s: not a little-endian ELF32 file\n", path.c_str());
+                return false;
+            }
+
+            const uint32_t shoff = u32(0x20);
+            const uint16_t shentsize = u16(0x2E);
+            const uint16_t shnum = u16(0x30);
+            for (uint16_t i = 0; i < shnum; i++)
+            {
+                const size_t sh = shoff + static_cast<size_t>(i) * shentsize;
+                if (sh + 40 > m_data.size())
+                {
+                    break;
+                }
+
+                constexpr uint32_t SHT_PROGBITS = 1;
+                constexpr uint32_t SHF_ALLOC = 2;
+                const uint32_t type = u32(sh + 4);
+                const uint32_t flags = u32(sh + 8);
+                const Section section{u32(sh + 12), u32(sh + 16), u32(sh + 20)};
+                if (type == SHT_PROGBITS && (flags & SHF_ALLOC) && section.address != 0 &&
+                    section.offset + section.size <= m_data.size())
+                {
+                    m_sections.push_back(section);
+                }
+            }
+            return !m_sections.empty();
+        }
+
+        const char *string_at(uint32_t address) const
+        {
+            for (const auto &section : m_sections)
+            {
+                if (address >= section.address && address - section.address < section.size)
+                {
+                    const auto *text = reinterpret_cast<const char *>(m_data.data()) + section.offset +
+                                       (address - section.address);
+                    // Must be terminated inside the section
+                    const size_t room = section.size - (address - section.address);
+                    return std::memchr(text, '\0', room) ? text : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        struct Section
+        {
+            uint32_t address;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        uint16_t u16(size_t at) const { return static_cast<uint16_t>(m_data[at] | (m_data[at + 1] << 8)); }
+        uint32_t u32(size_t at) const { return u16(at) | (static_cast<uint32_t>(u16(at + 2)) << 16); }
+
+        std::vector<uint8_t> m_data;
+        std::vector<Section> m_sections;
+    };
+
+    const char *resolve_elf(uint32_t address, void *context)
+    {
+        return static_cast<const ElfImage *>(context)->string_at(address);
+    }
+
+    bool valid_frame(const Record &record)
+    {
+        return record.level <= static_cast<uint8_t>(Level::VERBOSE) && record.arg_count <= MAX_ARGS &&
+               checksum(record) == record.checksum;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "Usage: %s firmware.elf capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    ElfImage elf;
+    if (!elf.load(argv[1]))
+    {
+        return 1;
+    }
+
+    std::ifstream in(argv[2], std::ios::binary);
+    const std::vector<uint8_t> capture((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!in && capture.empty())
+    {
+        std::fprintf(stderr, "Cannot read %s\n", argv[2]);
+        return 1;
+    }
+
+    unsigned long frames = 0, rejected = 0;
+    char text[512];
+    constexpr size_t FRAME_SIZE = sizeof(FRAME_MAGIC) + sizeof(Record);
+    for (size_t i = 0; i < capture.size();)
+    {
+        if (i + FRAME_SIZE <= capture.size() && capture[i] == FRAME_MAGIC[0] && capture[i + 1] == FRAME_MAGIC[1])
+        {
+            Record record;
+            std::memcpy(&record, &capture[i + sizeof(FRAME_MAGIC)], sizeof(record));
+            if (valid_frame(record))
+            {
+                format_record(record, resolve_elf, &elf, text, sizeof(text));
+                const char *tag = elf.string_at(record.tag);
+                std::printf("%c (%lu.%03lu) %s: %s\n", level_letter(record.level),
+                            static_cast<unsigned long>(record.timestamp_us / 1000),
+                            static_cast<unsigned long>(record.timestamp_us % 1000), tag ? tag : "?", text);
+                frames++;
+                i += FRAME_SIZE;
+                continue;
+            }
+            rejected++;
+        }
+
+        std::putchar(capture[i++]); // Plain log text between frames
+    }
+
+    std::fprintf(stderr, "%lu frames decoded, %lu candidate frames rejected\n", frames, rejected);
+    return 0;
+}